@@ -0,0 +1,418 @@
+// Freeze engine benchmark (Linux).
+//
+// Forks a child holding structures of FIELDS_PER_STRUCT adjacent 4-byte fields, selects and freezes
+// field_count of them with distinct values, and times one pass of the first MAX_RESULTS frozen
+// entries written one by one with change_process_memory (parsing and logging every value)
+// against the compiled freeze plan. The plan of every entry, coalesced into one write per
+// structure, is then applied in full, then read and compared so only drifted bytes are rewritten,
+// before and after fields of the child drift. Last, the freeze engine runs at several intervals
+// down to 1 ms, unconditionally and then only rewriting drift within a per-tick time budget while
+// fields keep drifting; it reports its tick rate, write latency, wake-up jitter and bytes
+// rewritten per tick, and every field of the child must hold its frozen value. Last, with the
+// engine running every 1 ms, rounds of edits to many rows are each published as one new plan while
+// the freeze thread applies the previous ones; retired plans must be reclaimed as the thread moves on.
+// Then object_count objects of the child, reached through a root pointer and a table of object
+// pointers, get CHAIN_FIELDS fields each frozen through their pointer chains: a tick with nothing
+// cached, one with every pointer cached and one after objects moved are compared to resolving every
+// chain on its own, then the engine runs every 1 ms, only rewriting drift, while objects keep moving.
+//
+// Usage: bench_freeze [field_count] [seconds_per_rate] [object_count]
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "memory.h"
+
+#define FIELDS_PER_STRUCT 8
+#define STRUCT_STRIDE 64 // Fields fill the first 32 bytes
+#define DRIFT_EVERY 97   // One field in DRIFT_EVERY drifts at once
+#define BUDGET_US 200
+#define PUBLISH_ROUNDS 50
+#define EDIT_EVERY 10 // Rows edited by a round of publication
+#define CHAIN_FIELDS 4
+#define OBJECT_SIZE 64
+#define MOVE_EVERY 100 // One object in MOVE_EVERY moves at once
+
+typedef struct
+{
+    uint32_t interval_ms;
+    bool conditional;
+    uint32_t budget_us;
+} FreezeRate;
+
+static const FreezeRate freeze_rates[] = {{100, false, 0}, {10, false, 0}, {1, false, 0}, {10, true, BUDGET_US}, {1, true, BUDGET_US}};
+
+static uintptr_t field_offset(size_t field)
+{
+    return field / FIELDS_PER_STRUCT * STRUCT_STRIDE + field % FIELDS_PER_STRUCT * sizeof(uint32_t);
+}
+
+static void run_target(size_t size, int ready_fd)
+{
+    uint8_t *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+        _exit(1);
+    memset(buffer, 0, size);
+
+    uintptr_t base = (uintptr_t)buffer;
+    if (write(ready_fd, &base, sizeof(base)) != sizeof(base))
+        _exit(1);
+    while (1)
+        pause();
+}
+
+static uint32_t field_value(size_t field)
+{
+    return (uint32_t)(field * 3 + 1);
+}
+
+static size_t target_size(size_t field_count)
+{
+    return (field_count + FIELDS_PER_STRUCT - 1) / FIELDS_PER_STRUCT * STRUCT_STRIDE;
+}
+
+// Objects follow the fields: the root pointer, the table of object pointers it points to, then two
+// slots per object, one of which holds it
+static uintptr_t object_table(uintptr_t objects)
+{
+    return objects + OBJECT_SIZE;
+}
+
+static uintptr_t object_slot(uintptr_t objects, size_t object_count, size_t slot)
+{
+    return object_table(objects) + (object_count * sizeof(uintptr_t) + OBJECT_SIZE - 1) / OBJECT_SIZE * OBJECT_SIZE + slot * OBJECT_SIZE;
+}
+
+static size_t objects_size(size_t object_count)
+{
+    return object_slot(0, object_count, object_count * 2);
+}
+
+static uint32_t object_value(size_t object, size_t field)
+{
+    return (uint32_t)(0x40000000 + object * CHAIN_FIELDS + field);
+}
+
+// Fields of the child that do not hold their frozen value, after clearing them all when clear is set
+static size_t check_fields(HANDLE process, uintptr_t base, size_t field_count, bool clear)
+{
+    size_t size = target_size(field_count), bytes = 0, wrong = 0;
+    uint8_t *copy = calloc(size, 1);
+
+    platform_read_memory(process, base, copy, size, &bytes);
+    for (size_t f = 0; f < field_count; f++)
+    {
+        uint32_t value;
+        memcpy(&value, copy + field_offset(f), sizeof(value));
+        wrong += bytes != size || value != field_value(f);
+    }
+    if (clear)
+    {
+        memset(copy, 0, size);
+        platform_write_memory(process, base, copy, size, &bytes);
+    }
+    free(copy);
+    return wrong;
+}
+
+// Changes one field in DRIFT_EVERY of the child, starting at field first, as the target itself would
+static size_t drift_fields(HANDLE process, uintptr_t base, size_t field_count, size_t first)
+{
+    size_t drifted = 0;
+    for (size_t f = first % DRIFT_EVERY; f < field_count; f += DRIFT_EVERY)
+    {
+        uint32_t value = ~field_value(f);
+        size_t written = 0;
+        platform_write_memory(process, base + field_offset(f), &value, sizeof(value), &written);
+        drifted += written == sizeof(value);
+    }
+    return drifted;
+}
+
+// Sets the value of a row of the selection, as the table does when it is edited
+static void set_entry_value(SelectionEntry *entry, uint32_t value)
+{
+    entry->length = snprintf(entry->value, MAX_NAME_LEN, "%u", value);
+}
+
+// Fields of objects that do not hold their frozen value where the table says the objects are
+static size_t check_objects(HANDLE process, uintptr_t objects, size_t object_count)
+{
+    size_t size = objects_size(object_count), bytes = 0, wrong = 0;
+    uint8_t *copy = calloc(size, 1);
+
+    platform_read_memory(process, objects, copy, size, &bytes);
+    for (size_t o = 0; o < object_count; o++)
+    {
+        uintptr_t object;
+        memcpy(&object, copy + (object_table(objects) - objects) + o * sizeof(uintptr_t), sizeof(object));
+        for (size_t f = 0; f < CHAIN_FIELDS; f++)
+        {
+            uint32_t value = 0;
+            bool inside = object >= objects && object - objects + (f + 1) * sizeof(uint32_t) <= size;
+            if (inside)
+                memcpy(&value, copy + (object - objects) + f * sizeof(uint32_t), sizeof(value));
+            wrong += bytes != size || value != object_value(o, f);
+        }
+    }
+    free(copy);
+    return wrong;
+}
+
+// Moves one object in MOVE_EVERY, starting at object first, to its other slot, freshly set up with
+// other values, and points the table at it, as the target reallocating them would
+static size_t move_objects(HANDLE process, uintptr_t objects, size_t object_count, size_t first)
+{
+    size_t moved = 0, written = 0;
+    for (size_t o = first % MOVE_EVERY; o < object_count; o += MOVE_EVERY)
+    {
+        uintptr_t entry = object_table(objects) + o * sizeof(uintptr_t), object = 0;
+        platform_read_memory(process, entry, &object, sizeof(object), &written);
+        uintptr_t other = object == object_slot(objects, object_count, o * 2) ? object_slot(objects, object_count, o * 2 + 1)
+                                                                             : object_slot(objects, object_count, o * 2);
+        uint8_t fresh[OBJECT_SIZE];
+        memset(fresh, 0xA5, sizeof(fresh));
+        platform_write_memory(process, other, fresh, sizeof(fresh), &written);
+        platform_write_memory(process, entry, &other, sizeof(other), &written);
+        moved += written == sizeof(other);
+    }
+    return moved;
+}
+
+static void apply_chains_once(FreezePlan *plan, FreezeTick *tick, const char *name)
+{
+    uint64_t start = platform_time_ns();
+    freeze_plan_apply(plan, tick);
+    double seconds = (platform_time_ns() - start) / 1e9;
+    fprintf(stderr, "  %-28s time=%8.3f ms  node reads=%zu  moved=%zu  writes=%zu  bytes written=%zu  failed=%zu\n", name,
+            seconds * 1e3, tick->pointer_reads, tick->moved_nodes, tick->writes, tick->bytes_written, tick->failed_writes);
+}
+
+// Freezes the fields of objects through pointer chains; false when one ended up wrong
+static bool run_chains(HANDLE process, uintptr_t objects, size_t object_count, double seconds)
+{
+    size_t written = 0;
+    uintptr_t table = object_table(objects);
+    platform_write_memory(process, objects, &table, sizeof(table), &written);
+    for (size_t o = 0; o < object_count; o++)
+    {
+        uintptr_t object = object_slot(objects, object_count, o * 2);
+        platform_write_memory(process, table + o * sizeof(uintptr_t), &object, sizeof(object), &written);
+    }
+
+    clear_selection_table(&selection_table);
+    for (size_t o = 0; o < object_count; o++)
+    {
+        for (size_t f = 0; f < CHAIN_FIELDS; f++)
+        {
+            FreezeChain chain = {objects, 2, {(int32_t)(o * sizeof(uintptr_t)), (int32_t)(f * sizeof(uint32_t))}};
+            char value[32];
+            snprintf(value, sizeof(value), "%u", object_value(o, f));
+            add_selection_value(&selection_table, NULL, &chain, VALUE_4BYTES, value);
+            selection_table.selection[selection_table.selection_count - 1].freeze = true;
+        }
+    }
+
+    // What following every chain on its own costs
+    size_t entries = selection_table.selection_count;
+    uint64_t start = platform_time_ns();
+    for (size_t i = 0; i < entries; i++)
+    {
+        uintptr_t address;
+        freeze_chain_resolve(process, selection_table.selection[i].chain, &address);
+    }
+    double resolve_seconds = (platform_time_ns() - start) / 1e9;
+
+    FreezePlan *plan = malloc(sizeof(FreezePlan));
+    size_t skipped = compile_freeze_plan(process, &selection_table, plan);
+    fprintf(stderr, "%zu fields on %zu objects: one by one resolve=%8.3f ms (%zu pointers)  plan: %zu nodes in %u levels, %zu targets\n",
+            entries, object_count, resolve_seconds * 1e3, entries * 2, plan->nodes.size, plan->level_count, plan->targets.size);
+
+    FreezeTick tick;
+    freeze_tick_init(&tick, false, 0);
+    apply_chains_once(plan, &tick, "nothing cached");
+    bool ok = skipped == 0 && check_objects(process, objects, object_count) == 0;
+    apply_chains_once(plan, &tick, "cached");
+    size_t moved = move_objects(process, objects, object_count, 0);
+    fprintf(stderr, "  %zu objects moved\n", moved);
+    apply_chains_once(plan, &tick, "moved");
+    ok = ok && check_objects(process, objects, object_count) == 0;
+    tick.conditional = true;
+    apply_chains_once(plan, &tick, "cached, drifted only");
+    freeze_tick_free(&tick);
+
+    // Objects move every 10 ms while the engine follows them every 1 ms
+    FreezeStatsView stats;
+    freeze_engine_publish(&freeze_engine, plan);
+    freeze_engine_set_interval(&freeze_engine, 1);
+    freeze_engine_set_mode(&freeze_engine, true, 0);
+    ok = freeze_engine_start(&freeze_engine) && ok;
+    size_t move_rounds = (size_t)(seconds * 100);
+    for (size_t m = 0; m < move_rounds; m++)
+    {
+        move_objects(process, objects, object_count, m + 1);
+        platform_sleep_ms(10);
+    }
+    platform_sleep_ms(100);
+    freeze_engine_stop(&freeze_engine);
+    freeze_engine_read_stats(&freeze_engine, &stats);
+
+    size_t wrong = check_objects(process, objects, object_count);
+    fprintf(stderr, "every   1 ms (drifted only, objects moving): ticks=%6llu  write mean=%8.1f us max=%8.1f us  node reads/tick=%8.0f  "
+                    "moved=%llu  bytes/tick=%8.0f  wrong=%zu\n",
+            (unsigned long long)stats.ticks, stats.mean_apply_us, stats.max_apply_us, stats.mean_pointer_reads,
+            (unsigned long long)stats.moved_nodes, stats.mean_bytes_written, wrong);
+    return ok && wrong == 0 && stats.ticks > 0;
+}
+
+static void apply_once(FreezePlan *plan, bool conditional, const char *name)
+{
+    FreezeTick tick;
+    freeze_tick_init(&tick, conditional, 0);
+    uint64_t start = platform_time_ns();
+    freeze_plan_apply(plan, &tick);
+    double seconds = (platform_time_ns() - start) / 1e9;
+    fprintf(stderr, "  %-28s time=%8.3f ms  spans=%zu  writes=%zu  bytes written=%zu  failed=%zu\n", name, seconds * 1e3, tick.spans,
+            tick.writes, tick.bytes_written, tick.failed_writes);
+    freeze_tick_free(&tick);
+}
+
+int main(int argc, char **argv)
+{
+    size_t field_count = argc > 1 ? (size_t)atoi(argv[1]) : 100000;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    size_t object_count = argc > 3 ? (size_t)atoi(argv[3]) : 5000;
+    int pipe_fds[2];
+
+    field_count = max(field_count, 1);
+    object_count = max(object_count, 1);
+    if (pipe(pipe_fds) != 0)
+    {
+        perror("pipe");
+        return 1;
+    }
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(pipe_fds[0]);
+        run_target(target_size(field_count) + objects_size(object_count), pipe_fds[1]);
+    }
+    close(pipe_fds[1]);
+
+    uintptr_t base;
+    if (read(pipe_fds[0], &base, sizeof(base)) != sizeof(base))
+    {
+        fprintf(stderr, "Target process failed to start\n");
+        return 1;
+    }
+    HANDLE process = platform_open_process((uint32_t)child);
+
+    init_selection_table(&selection_table);
+    freeze_engine_init(&freeze_engine);
+    for (size_t f = 0; f < field_count; f++)
+    {
+        char value[32];
+        snprintf(value, sizeof(value), "%u", field_value(f));
+        add_selection_value(&selection_table, (void *)(base + field_offset(f)), NULL, VALUE_4BYTES, value);
+        selection_table.selection[f].freeze = true;
+    }
+
+    // What a tick used to cost: every entry parsed, written and logged on its own
+    size_t one_by_one = min(field_count, (size_t)MAX_RESULTS);
+    uint64_t start = platform_time_ns();
+    for (size_t i = 0; i < one_by_one; i++)
+    {
+        const SelectionEntry *entry = &selection_table.selection[i];
+        change_process_memory(process, entry->address, entry->value, entry->type);
+    }
+    double per_entry_seconds = (platform_time_ns() - start) / 1e9;
+    check_fields(process, base, field_count, true);
+
+    FreezePlan *plan = malloc(sizeof(FreezePlan));
+    start = platform_time_ns();
+    size_t skipped = compile_freeze_plan(process, &selection_table, plan);
+    double compile_seconds = (platform_time_ns() - start) / 1e9;
+    fprintf(stderr, "%zu frozen fields: %zu one by one=%8.3f ms (%.0f ms for all)  plan: compile=%8.3f ms  %zu spans in %zu windows, %zu bytes\n",
+            field_count, one_by_one, per_entry_seconds * 1e3, per_entry_seconds * 1e3 * field_count / one_by_one,
+            compile_seconds * 1e3, plan->writes.size, plan->windows.size, plan->bytes.size);
+
+    // In full, then only what drifted: nothing, then the drift
+    apply_once(plan, false, "all spans");
+    bool ok = skipped == 0 && check_fields(process, base, field_count, false) == 0;
+    apply_once(plan, true, "drifted, none");
+    size_t drifted = drift_fields(process, base, field_count, 0);
+    fprintf(stderr, "  %zu fields drifted (%zu bytes)\n", drifted, drifted * sizeof(uint32_t));
+    apply_once(plan, true, "drifted");
+    ok = ok && check_fields(process, base, field_count, true) == 0;
+
+    freeze_engine_publish(&freeze_engine, plan);
+    for (size_t r = 0; r < sizeof(freeze_rates) / sizeof(freeze_rates[0]); r++)
+    {
+        const FreezeRate *rate = &freeze_rates[r];
+        FreezeStatsView stats;
+        freeze_engine_set_interval(&freeze_engine, rate->interval_ms);
+        freeze_engine_set_mode(&freeze_engine, rate->conditional, rate->budget_us);
+        ok = freeze_engine_start(&freeze_engine) && ok;
+
+        // Fields drift every 10 ms meanwhile, then the engine gets time for a few passes
+        size_t drift_rounds = (size_t)(seconds * 100);
+        for (size_t d = 0; d < drift_rounds; d++)
+        {
+            drift_fields(process, base, field_count, d);
+            platform_sleep_ms(10);
+        }
+        platform_sleep_ms(max(rate->interval_ms * 4, 100));
+        freeze_engine_stop(&freeze_engine);
+        freeze_engine_read_stats(&freeze_engine, &stats);
+
+        size_t wrong = check_fields(process, base, field_count, true);
+        ok = ok && wrong == 0 && stats.failed_writes == 0 && stats.ticks > 0;
+        fprintf(stderr, "every %3u ms%s: ticks=%6llu  write mean=%8.1f us max=%8.1f us  late mean=%8.1f us max=%8.1f us  "
+                        "spans/tick=%8.0f  bytes/tick=%8.0f  failed=%llu  wrong=%zu\n",
+                rate->interval_ms, rate->conditional ? " (drifted only, 200 us budget)" : "", (unsigned long long)stats.ticks,
+                stats.mean_apply_us, stats.max_apply_us, stats.mean_jitter_us, stats.max_jitter_us,
+                stats.ticks ? (double)stats.spans / stats.ticks : 0.0, stats.mean_bytes_written,
+                (unsigned long long)stats.failed_writes, wrong);
+    }
+
+    // Rounds of edits to every EDIT_EVERY-th row, each published at once, the last one restoring every row
+    freeze_engine_set_interval(&freeze_engine, 1);
+    freeze_engine_set_mode(&freeze_engine, false, 0);
+    ok = freeze_engine_start(&freeze_engine) && ok;
+    double compile_total = 0, publish_max = 0;
+    size_t retired_max = 0;
+    for (size_t edit_round = 0; edit_round <= PUBLISH_ROUNDS; edit_round++)
+    {
+        bool last = edit_round == PUBLISH_ROUNDS;
+        for (size_t f = last ? 0 : edit_round % EDIT_EVERY; f < field_count; f += last ? 1 : EDIT_EVERY)
+            set_entry_value(&selection_table.selection[f], last ? field_value(f) : (uint32_t)(field_value(f) + edit_round + 1));
+
+        start = platform_time_ns();
+        update_freeze_plan(process);
+        uint64_t compiled = platform_time_ns();
+        compile_total += (compiled - start) / 1e9;
+        publish_max = max(publish_max, (compiled - start) / 1e9);
+        retired_max = max(retired_max, freeze_engine.retired.size);
+        platform_sleep_ms(edit_round % 4 == 0 ? 5 : 0);
+    }
+    platform_sleep_ms(50);
+    size_t retired_left = freeze_engine_reclaim(&freeze_engine);
+    freeze_engine_stop(&freeze_engine);
+    size_t wrong = check_fields(process, base, field_count, false);
+    ok = ok && wrong == 0 && retired_left == 0 && freeze_engine.retired.size == 0;
+    fprintf(stderr, "%d publications of %zu edited rows each: compile and publish mean=%8.3f ms max=%8.3f ms  retired at most=%zu  left=%zu  wrong=%zu\n",
+            PUBLISH_ROUNDS + 1, (field_count + EDIT_EVERY - 1) / EDIT_EVERY, compile_total * 1e3 / (PUBLISH_ROUNDS + 1),
+            publish_max * 1e3, retired_max, retired_left, wrong);
+
+    ok = run_chains(process, base + target_size(field_count), object_count, seconds) && ok;
+
+    freeze_engine_destroy(&freeze_engine);
+    clear_selection_table(&selection_table);
+    free(selection_table.selection);
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,399 @@
+// Match kernel microbenchmark.
+//
+// Runs every match kernel supported by this CPU (each comparison and value size) over a
+// synthetic buffer of random bytes with values planted at fixed positions and reports
+// throughput per kernel, both for the bare mask computation and for the full find_matches
+// path (masks + emission). Delta kernels run against a perturbed copy of the buffer and report
+// mask throughput. Integer kernels run for unsigned, signed and big-endian values, float and
+// double kernels over the same bytes read as IEEE values. Pattern kernels search planted ASCII
+// and UTF-16 text with and without case, then signatures with wildcards over that text. Every kernel's match count is checked against the
+// scalar kernel.
+//
+// Usage: bench_kernels [size_mib]
+
+#include "scan_kernels.h"
+
+#define PLANT_STRIDE 4099
+#define STRING_PLANT_STRIDE 8191
+#define MIN_BENCH_NS 300000000ull
+
+static uint64_t mask_sink;
+
+static double bench_masks(MatchKernel kernel, const uint8_t *data, size_t block_count, const ScanOperands *operands)
+{
+    uint64_t masks[64];
+    uint64_t start = platform_time_ns();
+    uint64_t elapsed;
+    size_t passes = 0;
+
+    do
+    {
+        for (size_t block = 0; block < block_count; block += 64)
+        {
+            size_t count = min(64, block_count - block);
+            kernel(data + block * SCAN_BLOCK_SIZE, count, operands, masks);
+            mask_sink ^= masks[0] ^ masks[count - 1];
+        }
+        passes++;
+        elapsed = platform_time_ns() - start;
+    } while (elapsed < MIN_BENCH_NS);
+
+    return (double)block_count * SCAN_BLOCK_SIZE * passes / (double)elapsed;
+}
+
+static double bench_matches(MatchKernel kernel, ScanNumber number, CompareOp op, const uint8_t *data, size_t offset_count,
+                            const ScanOperands *operands, size_t value_size, size_t *match_count)
+{
+    DynamicArray matches;
+    uint64_t start = platform_time_ns();
+    uint64_t elapsed;
+    size_t passes = 0;
+
+    create_array(&matches, 1 << 20, sizeof(LPVOID));
+    do
+    {
+        matches.size = 0;
+        *match_count = find_matches(kernel, number, op, data, offset_count, operands, value_size, 0, &matches);
+        passes++;
+        elapsed = platform_time_ns() - start;
+    } while (elapsed < MIN_BENCH_NS);
+    free_array(&matches);
+
+    return (double)offset_count * passes / (double)elapsed;
+}
+
+static double bench_delta(DeltaKernel kernel, const uint8_t *current, const uint8_t *previous, size_t block_count,
+                          const ScanOperands *operands, size_t *match_count)
+{
+    uint64_t masks[64];
+    uint64_t start = platform_time_ns();
+    uint64_t elapsed;
+    size_t passes = 0;
+
+    do
+    {
+        *match_count = 0;
+        for (size_t block = 0; block < block_count; block += 64)
+        {
+            size_t count = min(64, block_count - block);
+            kernel(current + block * SCAN_BLOCK_SIZE, previous + block * SCAN_BLOCK_SIZE, count, operands, masks);
+            for (size_t i = 0; i < count; i++)
+                *match_count += (size_t)platform_popcount64(masks[i]);
+        }
+        passes++;
+        elapsed = platform_time_ns() - start;
+    } while (elapsed < MIN_BENCH_NS);
+
+    return (double)block_count * SCAN_BLOCK_SIZE * passes / (double)elapsed;
+}
+
+static double bench_pattern(PatternKernel kernel, const uint8_t *data, size_t block_count, const BytePattern *pattern,
+                           size_t *match_count)
+{
+    uint64_t masks[64];
+    uint64_t start = platform_time_ns();
+    uint64_t elapsed;
+    size_t passes = 0;
+
+    do
+    {
+        *match_count = 0;
+        for (size_t block = 0; block < block_count; block += 64)
+        {
+            size_t count = min(64, block_count - block);
+            kernel(data + block * SCAN_BLOCK_SIZE, count, pattern, masks);
+            for (size_t i = 0; i < count; i++)
+                *match_count += (size_t)platform_popcount64(masks[i]);
+        }
+        passes++;
+        elapsed = platform_time_ns() - start;
+    } while (elapsed < MIN_BENCH_NS);
+
+    return (double)block_count * SCAN_BLOCK_SIZE * passes / (double)elapsed;
+}
+
+// Runs the pattern kernel of every ISA, checking their match counts against the scalar one
+static bool bench_pattern_kernels(const uint8_t *buffer, size_t size, const BytePattern *pattern, const char *label)
+{
+    size_t reference = 0;
+    bool ok = true;
+
+    for (int isa = SCAN_ISA_SCALAR; isa < SCAN_ISA_COUNT; isa++)
+    {
+        PatternKernel kernel = get_pattern_kernel((ScanIsa)isa);
+        if (!kernel)
+            continue;
+
+        size_t match_count = 0;
+        double rate = bench_pattern(kernel, buffer, (size - pattern->length + 1) / SCAN_BLOCK_SIZE, pattern, &match_count);
+
+        if (isa == SCAN_ISA_SCALAR)
+            reference = match_count;
+        else if (match_count != reference)
+            ok = false;
+
+        printf("%-8s %-20s %12.2f %12zu%s\n", get_scan_isa_name((ScanIsa)isa), label, rate, match_count,
+               match_count == reference ? "" : "  MISMATCH");
+    }
+    return ok;
+}
+
+static const ScanNumber integer_numbers[] = {SCAN_NUMBER_UNSIGNED, SCAN_NUMBER_SIGNED, SCAN_NUMBER_UNSIGNED_BE, SCAN_NUMBER_SIGNED_BE};
+
+// "u32", "i16", "u64be" ...
+static void integer_label(ScanNumber number, size_t value_size, char *label, size_t label_size)
+{
+    bool is_signed = number == SCAN_NUMBER_SIGNED || number == SCAN_NUMBER_SIGNED_BE;
+    bool big_endian = number == SCAN_NUMBER_UNSIGNED_BE || number == SCAN_NUMBER_SIGNED_BE;
+    snprintf(label, label_size, "%c%zu%s", is_signed ? 'i' : 'u', value_size * 8, big_endian ? "be" : "");
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = (size_t)(argc > 1 ? atoi(argv[1]) : 256) * 1024 * 1024;
+    uint8_t *buffer = malloc(size + 8);
+    uint8_t *previous = malloc(size + 8);
+    static const uint8_t value[8] = {0x34, 0x12, 0xED, 0x5E, 0x78, 0x56, 0xAB, 0xC0};
+    bool ok = true;
+
+    if (!buffer || !previous)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < size + 8; i += 8)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        memcpy(buffer + i, &state, 8);
+    }
+    for (size_t offset = 0; offset + sizeof(value) <= size; offset += PLANT_STRIDE)
+        memcpy(buffer + offset, value, sizeof(value));
+
+    // Planted value for exact scans; the range operands are set on the top byte so that about
+    // 6% (greater, less) and 3% (between) of the offsets match and emission gets exercised
+    static const char *op_names[COMPARE_OP_COUNT] = {"equal", "greater", "less", "between"};
+    ScanOperands operands[COMPARE_OP_COUNT] = {0};
+    memcpy(operands[COMPARE_EQUAL].value, value, sizeof(value));
+    memset(operands[COMPARE_GREATER].value, 0xF0, 8);
+    memset(operands[COMPARE_LESS].value, 0x10, 8);
+    memset(operands[COMPARE_BETWEEN].value, 0x40, 8);
+    memset(operands[COMPARE_BETWEEN].upper, 0x47, 8);
+
+    printf("Buffer: %zu MiB, best ISA: %s\n\n", size >> 20, get_scan_isa_name(get_best_scan_isa()));
+    printf("%-8s %-8s %-5s %12s %14s %12s\n", "kernel", "compare", "size", "masks GB/s", "matches GB/s", "matches");
+
+    for (int op = COMPARE_EQUAL; op < COMPARE_OP_COUNT; op++)
+    {
+        for (size_t value_size = 1; value_size <= 8; value_size *= 2)
+        {
+            for (size_t n = 0; n < sizeof(integer_numbers) / sizeof(integer_numbers[0]); n++)
+            {
+                ScanNumber number = integer_numbers[n];
+                size_t offset_count = size - value_size + 1;
+                size_t reference = 0;
+                char label[8];
+
+                if (value_size == 1 && number >= SCAN_NUMBER_UNSIGNED_BE)
+                    continue;
+                integer_label(number, value_size, label, sizeof(label));
+
+                for (int isa = SCAN_ISA_SCALAR; isa < SCAN_ISA_COUNT; isa++)
+                {
+                    MatchKernel kernel = get_match_kernel((ScanIsa)isa, number, (CompareOp)op, value_size);
+                    if (!kernel)
+                        continue;
+
+                    size_t match_count = 0;
+                    double masks_rate = bench_masks(kernel, buffer, offset_count / SCAN_BLOCK_SIZE, &operands[op]);
+                    double matches_rate = bench_matches(kernel, number, (CompareOp)op, buffer, offset_count, &operands[op], value_size, &match_count);
+
+                    if (isa == SCAN_ISA_SCALAR)
+                        reference = match_count;
+                    else if (match_count != reference)
+                        ok = false;
+
+                    printf("%-8s %-8s %-5s %12.2f %14.2f %12zu%s\n", get_scan_isa_name((ScanIsa)isa), op_names[op], label,
+                           masks_rate, matches_rate, match_count, match_count == reference ? "" : "  MISMATCH");
+                }
+            }
+        }
+    }
+
+    // Floating point kernels over the same random bytes, which include NaNs, infinities and
+    // denormals; the operands are typed so the range comparisons match a few percent of offsets
+    ScanOperands float_operands[2][COMPARE_OP_COUNT] = {0};
+    for (int d = 0; d < 2; d++)
+    {
+        double bounds[COMPARE_OP_COUNT][2] = {{0, 0}, {1e30, 0}, {-1e30, 0}, {0.5, 2.0}};
+        for (int op = COMPARE_GREATER; op < COMPARE_OP_COUNT; op++)
+        {
+            if (d == 0)
+            {
+                float lo = (float)bounds[op][0], hi = (float)bounds[op][1];
+                memcpy(float_operands[d][op].value, &lo, sizeof(lo));
+                memcpy(float_operands[d][op].upper, &hi, sizeof(hi));
+            }
+            else
+            {
+                memcpy(float_operands[d][op].value, &bounds[op][0], sizeof(double));
+                memcpy(float_operands[d][op].upper, &bounds[op][1], sizeof(double));
+            }
+        }
+        memcpy(float_operands[d][COMPARE_EQUAL].value, value, sizeof(value));
+    }
+
+    for (int op = COMPARE_EQUAL; op < COMPARE_OP_COUNT; op++)
+    {
+        for (size_t value_size = 4; value_size <= 8; value_size *= 2)
+        {
+            const ScanOperands *float_operand = &float_operands[value_size == 8][op];
+            size_t offset_count = size - value_size + 1;
+            size_t reference = 0;
+
+            for (int isa = SCAN_ISA_SCALAR; isa < SCAN_ISA_COUNT; isa++)
+            {
+                MatchKernel kernel = get_match_kernel((ScanIsa)isa, SCAN_NUMBER_FLOAT, (CompareOp)op, value_size);
+                if (!kernel)
+                    continue;
+
+                size_t match_count = 0;
+                double masks_rate = bench_masks(kernel, buffer, offset_count / SCAN_BLOCK_SIZE, float_operand);
+                double matches_rate = bench_matches(kernel, SCAN_NUMBER_FLOAT, (CompareOp)op, buffer, offset_count, float_operand, value_size, &match_count);
+
+                if (isa == SCAN_ISA_SCALAR)
+                    reference = match_count;
+                else if (match_count != reference)
+                    ok = false;
+
+                printf("%-8s %-8s %-5s %12.2f %14.2f %12zu%s\n", get_scan_isa_name((ScanIsa)isa), op_names[op],
+                       value_size == 4 ? "f32" : "f64", masks_rate, matches_rate, match_count, match_count == reference ? "" : "  MISMATCH");
+            }
+        }
+    }
+
+    // Previous snapshot: same bytes with some bumped up and some down
+    memcpy(previous, buffer, size + 8);
+    for (size_t i = 0; i < size; i += 61)
+        previous[i] += 3;
+    for (size_t i = 0; i < size; i += 97)
+        previous[i] -= 3;
+
+    static const char *delta_names[DELTA_OP_COUNT] = {"changed", "unchanged", "increased", "decreased", "inc by", "dec by"};
+    ScanOperands delta_operands = {.value = {3}};
+
+    printf("\n%-8s %-10s %-5s %12s %12s\n", "kernel", "delta", "size", "masks GB/s", "matches");
+
+    for (int op = DELTA_CHANGED; op < DELTA_OP_COUNT; op++)
+    {
+        for (size_t value_size = 1; value_size <= 8; value_size *= 2)
+        {
+            for (size_t n = 0; n < sizeof(integer_numbers) / sizeof(integer_numbers[0]); n++)
+            {
+                ScanNumber number = integer_numbers[n];
+                size_t block_count = (size - value_size + 1) / SCAN_BLOCK_SIZE;
+                size_t reference = 0;
+                char label[8];
+
+                // Changed/unchanged only compare bytes and are the same kernels for every integer
+                if ((value_size == 1 && number >= SCAN_NUMBER_UNSIGNED_BE) ||
+                    ((op == DELTA_CHANGED || op == DELTA_UNCHANGED) && number != SCAN_NUMBER_UNSIGNED))
+                    continue;
+                integer_label(number, value_size, label, sizeof(label));
+
+                for (int isa = SCAN_ISA_SCALAR; isa < SCAN_ISA_COUNT; isa++)
+                {
+                    DeltaKernel kernel = get_delta_kernel((ScanIsa)isa, number, (DeltaOp)op, value_size);
+                    if (!kernel)
+                        continue;
+
+                    size_t match_count = 0;
+                    double rate = bench_delta(kernel, buffer, previous, block_count, &delta_operands, &match_count);
+
+                    if (isa == SCAN_ISA_SCALAR)
+                        reference = match_count;
+                    else if (match_count != reference)
+                        ok = false;
+
+                    printf("%-8s %-10s %-5s %12.2f %12zu%s\n", get_scan_isa_name((ScanIsa)isa), delta_names[op], label,
+                           rate, match_count, match_count == reference ? "" : "  MISMATCH");
+                }
+            }
+        }
+    }
+
+    // Floating point differences: a bumped low byte moves a float by a few ulps at most, so the
+    // increased/decreased-by ranges cover every difference of a non-zero magnitude below 1
+    ScanOperands float_delta_operands[2] = {0};
+    float float_lo = 0.0f, float_hi = 1.0f;
+    double double_lo = 0.0, double_hi = 1.0;
+    memcpy(float_delta_operands[0].value, &float_lo, sizeof(float));
+    memcpy(float_delta_operands[0].upper, &float_hi, sizeof(float));
+    memcpy(float_delta_operands[1].value, &double_lo, sizeof(double));
+    memcpy(float_delta_operands[1].upper, &double_hi, sizeof(double));
+
+    for (int op = DELTA_CHANGED; op < DELTA_OP_COUNT; op++)
+    {
+        for (size_t value_size = 4; value_size <= 8; value_size *= 2)
+        {
+            size_t block_count = (size - value_size + 1) / SCAN_BLOCK_SIZE;
+            size_t reference = 0;
+
+            for (int isa = SCAN_ISA_SCALAR; isa < SCAN_ISA_COUNT; isa++)
+            {
+                DeltaKernel kernel = get_delta_kernel((ScanIsa)isa, SCAN_NUMBER_FLOAT, (DeltaOp)op, value_size);
+                if (!kernel)
+                    continue;
+
+                size_t match_count = 0;
+                double rate = bench_delta(kernel, buffer, previous, block_count, &float_delta_operands[value_size == 8], &match_count);
+
+                if (isa == SCAN_ISA_SCALAR)
+                    reference = match_count;
+                else if (match_count != reference)
+                    ok = false;
+
+                printf("%-8s %-10s %-5s %12.2f %12zu%s\n", get_scan_isa_name((ScanIsa)isa), delta_names[op],
+                       value_size == 4 ? "f32" : "f64", rate, match_count, match_count == reference ? "" : "  MISMATCH");
+            }
+        }
+    }
+
+    // Pattern kernels over the same buffer with text planted in both cases and both encodings
+    static const char *planted[] = {"PlayerHealth", "PLAYERhealth"};
+    BytePattern plant;
+    for (size_t offset = 0, i = 0; offset + 2 * strlen(planted[0]) <= size; offset += STRING_PLANT_STRIDE, i++)
+    {
+        string_pattern_init(&plant, planted[i % 2], (i / 2) % 2 == 1, true);
+        memcpy(buffer + offset, plant.bytes, plant.length);
+    }
+
+    printf("\n%-8s %-20s %12s %12s\n", "kernel", "pattern", "masks GB/s", "matches");
+    for (int utf16 = 0; utf16 < 2; utf16++)
+    {
+        for (int case_sensitive = 1; case_sensitive >= 0; case_sensitive--)
+        {
+            BytePattern pattern;
+            char label[24];
+
+            string_pattern_init(&pattern, planted[0], utf16, case_sensitive);
+            snprintf(label, sizeof(label), "%s%s", utf16 ? "utf16" : "ascii", case_sensitive ? "" : " nocase");
+            ok = bench_pattern_kernels(buffer, size, &pattern, label) && ok;
+        }
+    }
+
+    // Signatures over the planted ASCII text: fixed bytes, whole byte and nibble wildcards
+    static const char *signatures[] = {"50 6C 61 79 65 72", "50 ?? 61 79 ?? 72 48", "5? 4C 41 59 ?5 52"};
+    for (size_t i = 0; i < sizeof(signatures) / sizeof(signatures[0]); i++)
+    {
+        BytePattern pattern;
+        ok = signature_pattern_init(&pattern, signatures[i]) && bench_pattern_kernels(buffer, size, &pattern, signatures[i]) && ok;
+    }
+
+    free(buffer);
+    free(previous);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,360 @@
+// Pointer scanner benchmark (Linux).
+//
+// Forks a child that fills a heap of nodes with pointers to each other, then hangs chains of one
+// to CHAIN_COUNT pointers with known offsets from a static array of this program down to a target
+// in that heap. Builds the reverse pointer map of the child, searches the static paths to every
+// target on one thread and on the pool, and checks the known chain is among them and every path
+// found leads to its target. The map is then saved, opened back from its file and searched again.
+// Last, a second child stands for a restart of the first, with other noise and chains elsewhere:
+// the paths of the first run are intersected with its saved map, offline, and must keep the chain.
+// Many variants of the chains that survived are then revalidated in the live restart at once, and
+// must resolve as they do one by one.
+//
+// Usage: bench_pointer_scan [heap_mib] [max_threads]
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "pointer_scan.h"
+
+#define NODE_SIZE 128
+#define CHAIN_COUNT 4
+#define SEARCH_DEPTH 5
+#define SEARCH_OFFSET 0x200
+#define VALIDATED_PATHS 1000 // Paths resolved again in the target for every chain
+#define REVALIDATED_PATHS 200000 // Variants of the chains revalidated after the restart
+#define MAP_PATH "/tmp/bench_pointer_scan.map"
+#define RESTART_MAP_PATH "/tmp/bench_pointer_scan_restart.map"
+
+// Static bases of the chains, in the data of the program (and so of its fork)
+static void *chain_roots[CHAIN_COUNT] = {(void *)1, (void *)1, (void *)1, (void *)1};
+
+// Offset added after the level-th pointer of chain
+static int32_t chain_offset(int chain, int level)
+{
+    return 0x10 * (level + 1) + 8 * chain;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Run 0 and its restarts differ in noise and in the nodes chains go through
+static void run_target(size_t size, int run, int ready_fd)
+{
+    uint8_t *heap = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (heap == MAP_FAILED)
+        _exit(1);
+
+    // A quarter of every node's words point somewhere into another node, the rest is noise
+    size_t node_count = size / NODE_SIZE;
+    uint64_t state = 0x9E3779B97F4A7C15ull + (uint64_t)run * 0x1234567ull;
+    for (size_t i = 0; i < size; i += sizeof(uintptr_t))
+    {
+        uint64_t random = next_random(&state);
+        uintptr_t word = random % 4 == 0 ? (uintptr_t)(heap + (random >> 8) % node_count * NODE_SIZE + (random >> 4) % 8 * 8)
+                                         : (uintptr_t)(random >> 16);
+        memcpy(heap + i, &word, sizeof(word));
+    }
+
+    // Chain c reads c + 1 pointers: root -> node -> ... -> target, each node its own
+    uintptr_t targets[CHAIN_COUNT];
+    for (int c = 0; c < CHAIN_COUNT; c++)
+    {
+        uint8_t *node = heap + ((size_t)(c + 1) * (node_count / (CHAIN_COUNT + 1)) + (size_t)run * 7) * NODE_SIZE;
+        chain_roots[c] = node;
+        for (int level = 0; level < c; level++)
+        {
+            uint8_t *next = node + 64 * NODE_SIZE;
+            memcpy(node + chain_offset(c, level), &next, sizeof(next));
+            node = next;
+        }
+        targets[c] = (uintptr_t)node + chain_offset(c, c);
+    }
+
+    if (write(ready_fd, targets, sizeof(targets)) != sizeof(targets))
+        _exit(1);
+    while (1)
+        pause();
+}
+
+static bool is_chain_path(const DynamicArray *modules, const PointerPath *path, int chain)
+{
+    const ModuleInfo *module = (const ModuleInfo *)modules->data + path->module;
+    if (module->base + path->base_offset != (uintptr_t)&chain_roots[chain] || path->depth != (uint32_t)chain + 1)
+        return false;
+    for (int level = 0; level <= chain; level++)
+    {
+        if (path->offsets[level] != chain_offset(chain, level))
+            return false;
+    }
+    return true;
+}
+
+// Forks run of the target and reads the addresses of its chain targets, 0 on failure
+static pid_t start_target(size_t size, int run, uintptr_t *targets)
+{
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0)
+    {
+        perror("pipe");
+        return 0;
+    }
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(pipe_fds[0]);
+        run_target(size, run, pipe_fds[1]);
+    }
+    close(pipe_fds[1]);
+    bool started = child > 0 && read(pipe_fds[0], targets, CHAIN_COUNT * sizeof(uintptr_t)) == CHAIN_COUNT * sizeof(uintptr_t);
+    close(pipe_fds[0]);
+    if (!started)
+    {
+        fprintf(stderr, "Target process failed to start\n");
+        if (child > 0)
+            kill(child, SIGKILL);
+        return 0;
+    }
+    return child;
+}
+
+static void stop_target(pid_t child)
+{
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+}
+
+static bool build_map(pid_t child, ThreadPool *pool, PointerMap *map)
+{
+    RegionFilter filter;
+    region_filter_init(&filter);
+    uint64_t start = platform_time_ns();
+    bool ok = pointer_map_build(platform_open_process((uint32_t)child), &filter, pool, map);
+    double seconds = (platform_time_ns() - start) / 1e9;
+    region_filter_free(&filter);
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to build the pointer map of pid %d\n", (int)child);
+        return false;
+    }
+    fprintf(stderr, "pointer map of pid %d: time=%8.3f s  scanned=%.1f MiB  throughput=%6.2f GB/s  pointers=%zu  map=%.1f MiB  modules=%zu\n",
+            (int)child, seconds, map->scanned_bytes / (1024.0 * 1024.0), map->scanned_bytes / seconds / 1e9, map->count,
+            map->count * (sizeof(PointerMapEntry) + sizeof(uint32_t)) / (1024.0 * 1024.0), map->modules.size);
+    return true;
+}
+
+// Revalidates variants of the chains of paths in process, sharing prefixes with them: a changed
+// last offset only changes where they lead, earlier ones or the base make them read elsewhere
+static bool revalidate_variants(HANDLE process, const DynamicArray *modules, const DynamicArray *paths, const uintptr_t *targets,
+                                ThreadPool *pool)
+{
+    DynamicArray variants, loaded;
+    uint64_t state = 0xD1B54A32D192ED03ull;
+    size_t unchanged = 0;
+
+    create_array(&variants, REVALIDATED_PATHS, sizeof(PointerPath));
+    for (size_t v = 0; v < REVALIDATED_PATHS; v++)
+    {
+        int c = (int)(v % CHAIN_COUNT);
+        const PointerPath *chain = NULL;
+        for (size_t p = 0; p < paths[c].size && !chain; p++)
+        {
+            if (is_chain_path(modules, (const PointerPath *)paths[c].data + p, c))
+                chain = (const PointerPath *)paths[c].data + p;
+        }
+        if (!chain)
+            return false;
+
+        PointerPath variant = *chain;
+        uint64_t random = next_random(&state);
+        uint32_t level = (uint32_t)(random % (chain->depth + 1));
+        if (level < chain->depth)
+            variant.offsets[level] = (int32_t)((random >> 8) % 64 * 8);
+        if ((random >> 16) % 16 == 0)
+            variant.base_offset += (random >> 20) % 64 * 8;
+        unchanged += memcmp(&variant, chain, sizeof(PointerPath)) == 0;
+        append(&variants, &variant);
+    }
+
+    uintptr_t *resolved = malloc(variants.size * sizeof(uintptr_t));
+    PointerRevalidateStats stats;
+    uint64_t start = platform_time_ns();
+    pointer_paths_revalidate(process, modules, &variants, pool, resolved, &stats);
+    double seconds = (platform_time_ns() - start) / 1e9;
+
+    // The same paths resolved one by one, with modules as loaded now
+    create_array(&loaded, 64, sizeof(ModuleInfo));
+    platform_query_modules(process, &loaded);
+    size_t mismatches = 0, leading = 0, one_by_one_survivors = 0;
+    start = platform_time_ns();
+    for (size_t v = 0; v < variants.size; v++)
+    {
+        const PointerPath *variant = (const PointerPath *)variants.data + v;
+        uintptr_t address = 0;
+        if (!pointer_path_resolve(process, &loaded, variant, &address))
+            address = 0;
+        one_by_one_survivors += address != 0;
+        mismatches += address != resolved[v];
+        leading += resolved[v] == targets[v % CHAIN_COUNT];
+    }
+    double one_by_one_seconds = (platform_time_ns() - start) / 1e9;
+
+    size_t reads = 0;
+    for (int level = 0; level < POINTER_MAX_DEPTH; level++)
+        reads += stats.reads[level];
+    fprintf(stderr, "revalidation: paths=%zu  survivors=%zu  to target=%zu  time=%8.3f s  reads=%zu (%zu %zu %zu %zu)  calls=%zu  "
+                    "one by one=%8.3f s  reads=%zu  mismatches=%zu\n",
+            variants.size, stats.survivors, leading, seconds, reads, stats.reads[0], stats.reads[1], stats.reads[2], stats.reads[3],
+            stats.system_calls, one_by_one_seconds, stats.path_reads, mismatches);
+
+    bool ok = mismatches == 0 && stats.survivors == one_by_one_survivors && leading >= unchanged && reads < stats.path_reads;
+    free(resolved);
+    free_array(&variants);
+    free_array(&loaded);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = (size_t)(argc > 1 ? atoi(argv[1]) : 64) * 1024 * 1024;
+    int max_threads = argc > 2 ? atoi(argv[2]) : platform_cpu_count();
+    uintptr_t targets[CHAIN_COUNT], restart_targets[CHAIN_COUNT];
+    DynamicArray chain_paths[CHAIN_COUNT];
+    ThreadPool pool;
+    PointerMap map;
+
+    pid_t child = start_target(size, 0, targets);
+    if (!child)
+        return 1;
+    HANDLE process = platform_open_process((uint32_t)child);
+    if (!thread_pool_create(&pool, max_threads) || !build_map(child, &pool, &map))
+    {
+        stop_target(child);
+        return 1;
+    }
+    fprintf(stderr, "Target pid %d: %zu MiB heap\n", (int)child, size >> 20);
+
+    bool ok = true;
+    uint64_t start;
+    PointerScanOptions options = {SEARCH_DEPTH, SEARCH_OFFSET, 0};
+    for (int c = 0; c < CHAIN_COUNT; c++)
+    {
+        DynamicArray serial;
+        DynamicArray *parallel = &chain_paths[c];
+        create_array(&serial, 64, sizeof(PointerPath));
+        create_array(parallel, 64, sizeof(PointerPath));
+
+        start = platform_time_ns();
+        pointer_scan_find(&map, targets[c], &options, NULL, &serial);
+        double serial_seconds = (platform_time_ns() - start) / 1e9;
+        start = platform_time_ns();
+        pointer_scan_find(&map, targets[c], &options, &pool, parallel);
+        double parallel_seconds = (platform_time_ns() - start) / 1e9;
+
+        // Both searches sort their paths the same way
+        bool same = serial.size == parallel->size && memcmp(serial.data, parallel->data, serial.size * sizeof(PointerPath)) == 0;
+        bool chain_found = false;
+        size_t wrong = 0;
+        for (size_t p = 0; p < parallel->size; p++)
+        {
+            const PointerPath *path = (const PointerPath *)parallel->data + p;
+            uintptr_t resolved = 0;
+            chain_found = chain_found || is_chain_path(&map.modules, path, c);
+            if (p < VALIDATED_PATHS)
+                wrong += !pointer_path_resolve(process, &map.modules, path, &resolved) || resolved != targets[c];
+        }
+        ok = ok && same && chain_found && wrong == 0;
+
+        char first[256] = "none";
+        if (parallel->size > 0)
+            format_pointer_path(&map.modules, (const PointerPath *)parallel->data, first, sizeof(first));
+        fprintf(stderr, "chain of %d: paths=%zu  serial=%8.3f s  threads=%d %8.3f s  same=%d  found=%d  wrong=%zu  first: %s\n", c + 1,
+                parallel->size, serial_seconds, max_threads, parallel_seconds, same, chain_found, wrong, first);
+        free_array(&serial);
+    }
+
+    // The saved map, opened as a mapping of its file, finds the same paths
+    PointerMap opened;
+    start = platform_time_ns();
+    bool saved = pointer_map_save(&map, MAP_PATH);
+    double save_seconds = (platform_time_ns() - start) / 1e9;
+    start = platform_time_ns();
+    bool loaded = saved && pointer_map_open(&opened, MAP_PATH);
+    double open_seconds = (platform_time_ns() - start) / 1e9;
+    bool file_same = loaded && opened.count == map.count && opened.modules.size == map.modules.size;
+    for (int c = 0; c < CHAIN_COUNT && file_same; c++)
+    {
+        DynamicArray paths;
+        create_array(&paths, 64, sizeof(PointerPath));
+        pointer_scan_find(&opened, targets[c], &options, &pool, &paths);
+        file_same = paths.size == chain_paths[c].size && memcmp(paths.data, chain_paths[c].data, paths.size * sizeof(PointerPath)) == 0;
+        free_array(&paths);
+    }
+    fprintf(stderr, "map file: save=%8.3f s  open=%8.6f s  size=%.1f MiB  same paths=%d\n", save_seconds, open_seconds,
+            loaded ? opened.file_size / (1024.0 * 1024.0) : 0.0, file_same);
+    ok = ok && file_same;
+    if (loaded)
+        pointer_map_free(&opened);
+    pointer_map_free(&map);
+    stop_target(child);
+
+    // A restart of the target, mapped to file as well: the paths of the first run that still lead
+    // to the target are found from the two files alone
+    PointerMap first_run, restart;
+    child = start_target(size, 1, restart_targets);
+    ok = ok && child && build_map(child, &pool, &map) && pointer_map_save(&map, RESTART_MAP_PATH);
+    if (child)
+    {
+        pointer_map_free(&map);
+        process = platform_open_process((uint32_t)child);
+    }
+    loaded = ok && pointer_map_open(&first_run, MAP_PATH);
+    if (loaded && !pointer_map_open(&restart, RESTART_MAP_PATH))
+    {
+        pointer_map_free(&first_run);
+        loaded = false;
+    }
+    ok = ok && loaded;
+    for (int c = 0; c < CHAIN_COUNT && loaded; c++)
+    {
+        size_t before = chain_paths[c].size;
+        start = platform_time_ns();
+        size_t kept = pointer_paths_intersect(&chain_paths[c], &first_run.modules, &restart, restart_targets[c]);
+        double seconds = (platform_time_ns() - start) / 1e9;
+
+        bool chain_kept = false;
+        size_t wrong = 0;
+        for (size_t p = 0; p < kept; p++)
+        {
+            const PointerPath *path = (const PointerPath *)chain_paths[c].data + p;
+            uintptr_t resolved = 0;
+            chain_kept = chain_kept || is_chain_path(&first_run.modules, path, c);
+            wrong += !pointer_path_resolve(process, &first_run.modules, path, &resolved) || resolved != restart_targets[c];
+        }
+        ok = ok && chain_kept && wrong == 0;
+        fprintf(stderr, "chain of %d after restart: paths=%zu -> %zu  time=%8.6f s  chain kept=%d  wrong=%zu\n", c + 1, before,
+                kept, seconds, chain_kept, wrong);
+    }
+    ok = ok && loaded && revalidate_variants(process, &first_run.modules, chain_paths, restart_targets, &pool);
+    if (loaded)
+    {
+        pointer_map_free(&first_run);
+        pointer_map_free(&restart);
+    }
+
+    for (int c = 0; c < CHAIN_COUNT; c++)
+        free_array(&chain_paths[c]);
+    remove(MAP_PATH);
+    remove(RESTART_MAP_PATH);
+    thread_pool_destroy(&pool);
+    if (child)
+        stop_target(child);
+    return ok ? 0 : 1;
+}
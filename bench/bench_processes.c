@@ -0,0 +1,170 @@
+// Process catalog benchmark (Linux).
+//
+// Forks child_count idle children, then times a refresh of a fresh catalog, which looks up the name
+// of every process as listing them from scratch does, against refreshes of a warm catalog where
+// nothing changed. Some children are then replaced by new ones: the next refresh must drop the
+// ones gone and add the new ones, looking up only their names. Last, the catalog thread refreshes
+// every REFRESH_MS while more children start, and the time until a poll lists them all is reported.
+//
+// Usage: bench_processes [child_count] [warm_refreshes]
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "process.h"
+
+#define REPLACED_EVERY 10 // One child in REPLACED_EVERY is replaced by a new one
+#define LATE_CHILDREN 16  // Started while the catalog thread runs
+#define REFRESH_MS 20
+
+static pid_t spawn_child()
+{
+    pid_t child = fork();
+    if (child == 0)
+    {
+        while (1)
+            pause();
+    }
+    return child;
+}
+
+static void stop_child(pid_t child)
+{
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+}
+
+static const ProcessInfo *find_process(const DynamicArray *list, uint32_t pid)
+{
+    for (size_t i = 0; i < list->size; i++)
+    {
+        const ProcessInfo *info = (const ProcessInfo *)list->data + i;
+        if (info->pid == pid)
+            return info;
+    }
+    return NULL;
+}
+
+// Children of children [first, first + count) missing from list, or listed under another name
+static size_t missing_children(const DynamicArray *list, const pid_t *children, size_t count, const char *name)
+{
+    size_t missing = 0;
+    for (size_t c = 0; c < count; c++)
+    {
+        const ProcessInfo *info = find_process(list, (uint32_t)children[c]);
+        missing += !info || strcmp(info->name, name) != 0;
+    }
+    return missing;
+}
+
+static double refresh_ms(ProcessCatalog *catalog)
+{
+    uint64_t start = platform_time_ns();
+    process_catalog_refresh(catalog);
+    return (platform_time_ns() - start) / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    size_t child_count = argc > 1 ? (size_t)atoi(argv[1]) : 200;
+    size_t warm_refreshes = argc > 2 ? (size_t)atoi(argv[2]) : 20;
+    pid_t *children = malloc((child_count + LATE_CHILDREN + 1) * sizeof(pid_t));
+    bool ok = true;
+
+    warm_refreshes = max(warm_refreshes, 1);
+    for (size_t c = 0; c < child_count; c++)
+        children[c] = spawn_child();
+
+    // The name every child is listed under: the file name of this executable
+    ProcessCatalog catalog;
+    process_catalog_init(&catalog);
+    process_catalog_refresh(&catalog);
+    const ProcessInfo *self = find_process(&catalog.entries, (uint32_t)getpid());
+    char name[MAX_NAME_LEN];
+    strncpy_s(name, sizeof(name), self ? self->name : "?", _TRUNCATE);
+    process_catalog_destroy(&catalog);
+
+    // Listed from scratch: every name looked up
+    double cold_total = 0;
+    for (size_t r = 0; r < warm_refreshes; r++)
+    {
+        process_catalog_init(&catalog);
+        cold_total += refresh_ms(&catalog);
+        process_catalog_destroy(&catalog);
+    }
+
+    process_catalog_init(&catalog);
+    process_catalog_refresh(&catalog);
+    int64_t version = 0;
+    DynamicArray list;
+    create_array(&list, 256, sizeof(ProcessInfo));
+    ok = process_catalog_poll(&catalog, &list, &version) && missing_children(&list, children, child_count, name) == 0;
+    size_t listed = list.size;
+
+    double warm_total = 0;
+    int64_t added_before = platform_atomic_load64(&catalog.stats.added);
+    for (size_t r = 0; r < warm_refreshes; r++)
+        warm_total += refresh_ms(&catalog);
+    int64_t warm_added = platform_atomic_load64(&catalog.stats.added) - added_before;
+    fprintf(stderr, "%zu processes (%zu children): cold refresh=%8.3f ms  warm refresh=%8.3f ms  names looked up while warm=%lld\n",
+            listed, child_count, cold_total / warm_refreshes, warm_total / warm_refreshes, (long long)warm_added);
+
+    // Replace some children: the gone ones must leave the list, the new ones join it
+    size_t replaced = 0;
+    added_before = platform_atomic_load64(&catalog.stats.added);
+    int64_t removed_before = platform_atomic_load64(&catalog.stats.removed);
+    pid_t *gone = malloc((child_count / REPLACED_EVERY + 1) * sizeof(pid_t));
+    for (size_t c = 0; c < child_count; c += REPLACED_EVERY)
+    {
+        stop_child(children[c]);
+        gone[replaced++] = children[c];
+        children[c] = spawn_child();
+    }
+    double churn_ms = refresh_ms(&catalog);
+    int64_t added = platform_atomic_load64(&catalog.stats.added) - added_before;
+    int64_t removed = platform_atomic_load64(&catalog.stats.removed) - removed_before;
+    process_catalog_poll(&catalog, &list, &version);
+    size_t still_listed = 0;
+    for (size_t g = 0; g < replaced; g++)
+    {
+        // A pid handed out again belongs to one of the new children, under the same name
+        bool reused = false;
+        for (size_t c = 0; c < child_count; c++)
+            reused = reused || children[c] == gone[g];
+        still_listed += !reused && find_process(&list, (uint32_t)gone[g]) != NULL;
+    }
+    size_t missing = missing_children(&list, children, child_count, name);
+    ok = ok && missing == 0 && still_listed == 0 && added >= (int64_t)replaced && removed >= (int64_t)replaced;
+    fprintf(stderr, "%zu children replaced: refresh=%8.3f ms  added=%lld  removed=%lld  missing=%zu  gone but listed=%zu\n", replaced,
+            churn_ms, (long long)added, (long long)removed, missing, still_listed);
+    ok = ok && !process_catalog_poll(&catalog, &list, &version);
+
+    // The catalog thread picks up children started meanwhile
+    ok = process_catalog_start(&catalog, REFRESH_MS) && ok;
+    platform_sleep_ms(REFRESH_MS * 2);
+    uint64_t start = platform_time_ns();
+    for (size_t c = child_count; c < child_count + LATE_CHILDREN; c++)
+        children[c] = spawn_child();
+    size_t late_missing = LATE_CHILDREN;
+    while (late_missing > 0 && platform_time_ns() - start < 2000000000ull)
+    {
+        if (process_catalog_poll(&catalog, &list, &version))
+            late_missing = missing_children(&list, children + child_count, LATE_CHILDREN, name);
+        platform_sleep_ms(1);
+    }
+    double seen_ms = (platform_time_ns() - start) / 1e6;
+    process_catalog_stop(&catalog);
+    ok = ok && late_missing == 0;
+    fprintf(stderr, "%d children started with the catalog thread every %d ms: listed after %8.3f ms  missing=%zu  refreshes=%lld  last refresh=%8.3f ms\n",
+            LATE_CHILDREN, REFRESH_MS, seen_ms, late_missing, (long long)platform_atomic_load64(&catalog.stats.refreshes),
+            platform_atomic_load64(&catalog.stats.last_refresh_ns) / 1e6);
+
+    for (size_t c = 0; c < child_count + LATE_CHILDREN; c++)
+        stop_child(children[c]);
+    process_catalog_destroy(&catalog);
+    free_array(&list);
+    free(children);
+    free(gone);
+    return ok ? 0 : 1;
+}
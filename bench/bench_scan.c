@@ -0,0 +1,634 @@
+// First scan thread scaling benchmark (Linux).
+//
+// Forks a child that maps a buffer of random bytes with a known value planted at fixed
+// positions, then runs scan_process_memory against it with 1, 2, 4 ... N worker threads,
+// checking every planted address is found and reporting the throughput of each run,
+// then times a next scan over the results. Finally runs an unknown initial value scan and
+// follows the planted values with changed/unchanged refinements while the child bumps them.
+// Then runs the first scan on the background scan thread: once cancelled early, once to the end
+// while streamed matches fill a results table. Last, repeats the first scan with region filters
+// (writable data only, then the planted buffer's address range) and reports the bytes they skip,
+// finds the planted values once more as floats matched by a rounded typed value and as
+// big-endian integers, and searches text planted across page boundaries as ASCII and UTF-16,
+// with and without case, and as signatures. Last, a signature of its own code is searched in
+// executable images, once in full and once up to the first match, and all of them again in one
+// pass among generated signatures, compiled into and loaded from a cache file. Ends with a group
+// scan for planted structures.
+//
+// Usage: bench_scan [size_mib] [max_threads]
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "memory.h"
+
+#define PLANT_STRIDE (64 * 1024 + 7)
+#define TEXT_PAGE 4096
+#define TEXT_SHIFT 5 // Bytes of planted text before the page boundary it straddles
+#define BATCH_SIGNATURES 300
+#define GROUP_STRIDE (37 * TEXT_PAGE)
+#define GROUP_OFFSET 1000 // Into its page, away from the text planted across page boundaries
+#define GROUP_SPAN 64
+
+static const uint32_t planted_value = 0x5EED1234u;
+
+// Text planted across a page boundary, which chunk boundaries are: ASCII and UTF-16, as typed and
+// in another case in turns. False where the text would cover a planted value.
+static bool planted_text_at(size_t page, size_t size, size_t *offset, BytePattern *text)
+{
+    string_pattern_init(text, page % 4 < 2 ? "ShadowEngine" : "SHADOWengine", page % 2 == 1, true);
+    *offset = page * TEXT_PAGE - TEXT_SHIFT;
+    size_t value_offset = *offset / PLANT_STRIDE * PLANT_STRIDE;
+    return page > 0 && *offset + text->length <= size && value_offset + sizeof(planted_value) <= *offset &&
+           value_offset + PLANT_STRIDE >= *offset + text->length;
+}
+
+// Structure planted every GROUP_STRIDE bytes: HP (4 bytes, 100), Level (2 bytes at +6, 12, or 13 in
+// every third one, which must not match), MaxHP (4 bytes, 100) moving around the next 32 bytes and a
+// float (1.5) at +48. False where it would cover a planted value.
+static bool planted_group_at(size_t index, size_t size, size_t *offset, bool *matching)
+{
+    *offset = index * GROUP_STRIDE + GROUP_OFFSET;
+    *matching = index % 3 != 2;
+    size_t value_offset = (*offset + GROUP_SPAN) / PLANT_STRIDE * PLANT_STRIDE;
+    return *offset + GROUP_SPAN <= size && (value_offset + sizeof(planted_value) <= *offset || value_offset >= *offset + GROUP_SPAN);
+}
+
+static void plant_group(uint8_t *buffer, size_t index, size_t offset, bool matching)
+{
+    uint32_t hp = 100;
+    uint16_t level = matching ? 12 : 13;
+    float speed = 1.5f;
+
+    memcpy(buffer + offset, &hp, sizeof(hp));
+    memcpy(buffer + offset + 6, &level, sizeof(level));
+    memcpy(buffer + offset + 12 + index % 8 * 4, &hp, sizeof(hp));
+    memcpy(buffer + offset + 48, &speed, sizeof(speed));
+}
+
+static uint8_t *target_buffer;
+static size_t target_size;
+static int target_fd;
+
+// SIGUSR1 in the child: increment every planted value, then acknowledge through the pipe
+static void bump_planted_values(int signal_number)
+{
+    for (size_t offset = 0; offset + sizeof(planted_value) <= target_size; offset += PLANT_STRIDE)
+    {
+        uint32_t value;
+        memcpy(&value, target_buffer + offset, sizeof(value));
+        value++;
+        memcpy(target_buffer + offset, &value, sizeof(value));
+    }
+    if (write(target_fd, "", 1) != 1)
+        _exit(1);
+}
+
+static void run_target(size_t size, int ready_fd)
+{
+    uint8_t *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+        _exit(1);
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i + 8 <= size; i += 8)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        memcpy(buffer + i, &state, 8);
+    }
+
+    for (size_t offset = 0; offset + sizeof(planted_value) <= size; offset += PLANT_STRIDE)
+        memcpy(buffer + offset, &planted_value, sizeof(planted_value));
+
+    for (size_t page = 0; page < size / TEXT_PAGE; page++)
+    {
+        size_t offset;
+        BytePattern text;
+        if (planted_text_at(page, size, &offset, &text))
+            memcpy(buffer + offset, text.bytes, text.length);
+    }
+
+    for (size_t index = 0; index < size / GROUP_STRIDE; index++)
+    {
+        size_t offset;
+        bool matching;
+        if (planted_group_at(index, size, &offset, &matching))
+            plant_group(buffer, index, offset, matching);
+    }
+
+    target_buffer = buffer;
+    target_size = size;
+    target_fd = ready_fd;
+    signal(SIGUSR1, bump_planted_values);
+
+    uintptr_t base = (uintptr_t)buffer;
+    if (write(ready_fd, &base, sizeof(base)) != sizeof(base))
+        _exit(1);
+
+    while (1)
+        pause();
+}
+
+static bool contains_address(uintptr_t address)
+{
+    return result_set_contains(&scan_results, address);
+}
+
+static uint64_t candidate_count()
+{
+    return scan_snapshot.active ? scan_snapshot.candidate_count : scan_results.count;
+}
+
+static void bump_target(pid_t child, int ack_fd)
+{
+    char ack;
+    kill(child, SIGUSR1);
+    if (read(ack_fd, &ack, 1) != 1)
+    {
+        fprintf(stderr, "Target process did not acknowledge\n");
+        exit(1);
+    }
+}
+
+static double timed_refine(HANDLE process, ScanType scan_type, uint32_t operand)
+{
+    uint64_t start = platform_time_ns();
+    refine_results(process, scan_type, &operand, NULL, VALUE_4BYTES);
+    return (platform_time_ns() - start) / 1e9;
+}
+
+static size_t readable_bytes(HANDLE process)
+{
+    DynamicArray regions;
+    size_t total = 0;
+
+    create_array(&regions, 256, sizeof(MemoryRegion));
+    platform_query_regions(process, &regions);
+    for (size_t i = 0; i < regions.size; i++)
+    {
+        const MemoryRegion *region = (const MemoryRegion *)get(&regions, i);
+        if (region->protection & REGION_READ)
+            total += region->size;
+    }
+    free_array(&regions);
+    return total;
+}
+
+// First scan under scan_region_filter: every planted value must still be found
+static bool timed_filtered_scan(HANDLE process, const char *label, uint32_t value, uintptr_t base, size_t size)
+{
+    DynamicArray regions, kept;
+    RegionFilterStats stats;
+    uint64_t skipped = 0;
+
+    create_array(&regions, 256, sizeof(MemoryRegion));
+    create_array(&kept, 256, sizeof(MemoryRegion));
+    platform_query_regions(process, &regions);
+    region_filter_apply(&scan_region_filter, process, &regions, &kept, &stats);
+    for (int rule = 0; rule < FILTER_RULE_COUNT; rule++)
+        skipped += stats.skipped_bytes[rule];
+    free_array(&regions);
+    free_array(&kept);
+
+    result_set_clear(&scan_results, 1);
+    uint64_t start = platform_time_ns();
+    scan_process_memory(process, SCAN_EXACT_VALUE, &value, NULL, VALUE_4BYTES);
+    double seconds = (platform_time_ns() - start) / 1e9;
+
+    size_t missing = 0;
+    for (size_t offset = 0; offset + sizeof(value) <= size; offset += PLANT_STRIDE)
+    {
+        if (!contains_address(base + offset))
+            missing++;
+    }
+
+    fprintf(stderr, "%s: time=%8.3f s  scanned=%.1f MiB  skipped=%.1f MiB  matches=%llu  missing=%zu\n", label, seconds,
+            stats.kept_bytes / (1024.0 * 1024.0), skipped / (1024.0 * 1024.0), (unsigned long long)scan_results.count, missing);
+    return missing == 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = (size_t)(argc > 1 ? atoi(argv[1]) : 512) * 1024 * 1024;
+    int max_threads = argc > 2 ? atoi(argv[2]) : platform_cpu_count();
+    int pipe_fds[2];
+
+    if (pipe(pipe_fds) != 0)
+    {
+        perror("pipe");
+        return 1;
+    }
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(pipe_fds[0]);
+        run_target(size, pipe_fds[1]);
+    }
+
+    close(pipe_fds[1]);
+    uintptr_t base;
+    if (read(pipe_fds[0], &base, sizeof(base)) != sizeof(base))
+    {
+        fprintf(stderr, "Target process failed to start\n");
+        return 1;
+    }
+
+    HANDLE process = platform_open_process((uint32_t)child);
+    size_t total_bytes = readable_bytes(process);
+    size_t planted = (size - sizeof(planted_value)) / PLANT_STRIDE + 1;
+    bool ok = true;
+
+    result_set_init(&scan_results, 1);
+    region_filter_init(&scan_region_filter);
+
+    fprintf(stderr, "Target pid %d: %zu MiB buffer, %.1f MiB readable, %zu planted values\n",
+            (int)child, size >> 20, total_bytes / (1024.0 * 1024.0), planted);
+
+    scan_thread_count = max_threads;
+    uint64_t calibration_start = platform_time_ns();
+    calibrate_chunk_size();
+    fprintf(stderr, "calibration: time=%8.3f s  chunk=%zu KiB\n", (platform_time_ns() - calibration_start) / 1e9,
+            scan_chunk_size / 1024);
+
+    for (int threads = 1;; threads = min(threads * 2, max_threads))
+    {
+        scan_thread_count = threads;
+        result_set_clear(&scan_results, 1);
+
+        uint64_t start = platform_time_ns();
+        scan_process_memory(process, SCAN_EXACT_VALUE, &planted_value, NULL, VALUE_4BYTES);
+        double seconds = (platform_time_ns() - start) / 1e9;
+
+        size_t missing = 0;
+        for (size_t offset = 0; offset + sizeof(planted_value) <= size; offset += PLANT_STRIDE)
+        {
+            if (!contains_address(base + offset))
+                missing++;
+        }
+        ok = ok && missing == 0;
+
+        fprintf(stderr, "threads=%-3d time=%8.3f s  throughput=%6.2f GB/s  matches=%llu  missing=%zu  results=%.1f KiB\n",
+                threads, seconds, total_bytes / seconds / 1e9, (unsigned long long)scan_results.count, missing,
+                result_set_footprint(&scan_results) / 1024.0);
+
+        if (threads == max_threads)
+            break;
+    }
+
+    // Next scan over the surviving addresses with an unchanged value must keep all of them
+    uint64_t before_refine = scan_results.count;
+    uint64_t start = platform_time_ns();
+    refine_results(process, SCAN_EXACT_VALUE, &planted_value, NULL, VALUE_4BYTES);
+    double seconds = (platform_time_ns() - start) / 1e9;
+    ok = ok && scan_results.count == before_refine;
+
+    fprintf(stderr, "refine: time=%8.3f s  candidates=%llu  kept=%llu\n", seconds, (unsigned long long)before_refine,
+            (unsigned long long)scan_results.count);
+
+    // Unknown initial value: nothing changed yet, then every planted value goes up by one twice
+    result_set_clear(&scan_results, 1);
+    start = platform_time_ns();
+    scan_process_memory(process, SCAN_UNKNOWN_INITIAL, NULL, NULL, VALUE_4BYTES);
+    seconds = (platform_time_ns() - start) / 1e9;
+    uint64_t initial = candidate_count();
+    fprintf(stderr, "unknown: time=%8.3f s  candidates=%llu  snapshot=%.1f MiB\n",
+            seconds, (unsigned long long)initial, snapshot_footprint(&scan_snapshot) / (1024.0 * 1024.0));
+
+    seconds = timed_refine(process, SCAN_UNCHANGED, 0);
+    ok = ok && candidate_count() == initial;
+    fprintf(stderr, "unchanged: time=%8.3f s  kept=%llu\n", seconds, (unsigned long long)candidate_count());
+
+    bump_target(child, pipe_fds[0]);
+    seconds = timed_refine(process, SCAN_INCREASED, 0);
+    fprintf(stderr, "increased: time=%8.3f s  kept=%llu  snapshot=%.1f MiB\n", seconds,
+            (unsigned long long)candidate_count(), snapshot_footprint(&scan_snapshot) / (1024.0 * 1024.0));
+
+    bump_target(child, pipe_fds[0]);
+    seconds = timed_refine(process, SCAN_INCREASED_BY, 1);
+    size_t missing = 0;
+    for (size_t offset = 0; offset + sizeof(planted_value) <= size; offset += PLANT_STRIDE)
+    {
+        if (!contains_address(base + offset))
+            missing++;
+    }
+    ok = ok && !scan_snapshot.active && scan_results.count == planted && missing == 0;
+    fprintf(stderr, "increased by 1: time=%8.3f s  kept=%llu  missing=%zu\n", seconds, (unsigned long long)scan_results.count, missing);
+
+    // Background scan cancelled as soon as it made progress: no results, cancelled state.
+    // The planted values have been bumped twice by now.
+    ScanRequest request = {.refine = false, .process_handle = process, .scan_type = SCAN_EXACT_VALUE,
+                           .value = planted_value + 2, .value_type = VALUE_4BYTES};
+    ScanProgressView progress;
+    result_set_clear(&scan_results, 1);
+    start_scan_thread(&request);
+    while (platform_atomic_load64(&scan_progress.work_done) == 0 && platform_atomic_load64(&scan_progress.state) == SCAN_STATE_RUNNING)
+        platform_sleep_ms(1);
+    cancel_scan_thread();
+    bool found = wait_scan_thread();
+    scan_progress_read(&scan_progress, &progress);
+    ok = ok && !found && progress.state == SCAN_STATE_CANCELLED && scan_results.count == 0;
+    fprintf(stderr, "background cancelled: time=%8.3f s  done=%.0f%%  state=%d  kept=%llu\n", progress.elapsed,
+            progress.fraction * 100, (int)progress.state, (unsigned long long)scan_results.count);
+
+    // Background scan to the end, polled like the UI does every frame: matches are streamed into the
+    // table while it runs, then replaced by the first rows of the complete results
+    ResultsTable table = {0};
+    size_t polls = 0;
+    double first_rows_at = -1.0;
+    init_results_table(&table);
+    result_set_clear(&scan_results, 1);
+    start_scan_thread(&request);
+    while (scan_thread_running())
+    {
+        poll_memory_scan(&table);
+        scan_progress_read(&scan_progress, &progress);
+        if (first_rows_at < 0 && table.result_count > 0 && scan_thread_running())
+            first_rows_at = progress.fraction;
+        polls++;
+        platform_sleep_ms(1);
+    }
+    scan_progress_read(&scan_progress, &progress);
+
+    size_t listed = 0;
+    for (size_t i = 0; i < table.result_count; i++)
+        listed += contains_address((uintptr_t)table.results[i].address);
+    ok = ok && progress.state == SCAN_STATE_DONE && progress.fraction == 1.0 && progress.matches == scan_results.count &&
+         progress.regions_done == progress.regions_total && scan_results.count >= planted &&
+         table.result_count == min(scan_results.count, (uint64_t)MAX_RESULTS) && listed == table.result_count;
+    fprintf(stderr, "background: time=%8.3f s  throughput=%6.2f GB/s  regions=%llu/%llu  matches=%llu  polls=%zu  first rows at %.0f%%\n",
+            progress.elapsed, progress.throughput / 1e9, (unsigned long long)progress.regions_done,
+            (unsigned long long)progress.regions_total, (unsigned long long)progress.matches, polls, first_rows_at * 100);
+    clear_results_table(&table);
+    free(table.results);
+
+    // Region filters: the planted buffer is private writable memory outside of any module
+    scan_region_filter.writable_only = true;
+    scan_region_filter.exclude_executable = true;
+    region_filter_exclude_module(&scan_region_filter, "bench_scan");
+    ok = timed_filtered_scan(process, "filter writable", (uint32_t)request.value, base, size) && ok;
+
+    region_filter_reset(&scan_region_filter);
+    region_filter_add_range(&scan_region_filter, base, base + size);
+    ok = timed_filtered_scan(process, "filter range", (uint32_t)request.value, base, size) && ok;
+    ok = ok && scan_results.count == planted;
+    region_filter_reset(&scan_region_filter);
+
+    // Floating point: the planted bits read as a float and typed with 3 significant digits; the
+    // rounded match range of that text must keep every planted address
+    uint32_t planted_bits = (uint32_t)request.value;
+    float planted_float;
+    char typed[32];
+    uint64_t lower, upper;
+    memcpy(&planted_float, &planted_bits, sizeof(planted_float));
+    snprintf(typed, sizeof(typed), "%.3g", planted_float);
+    ok = float_match_range(typed, VALUE_FLOAT, FLOAT_COMPARE_ROUNDED, 0.0, &lower, &upper) && ok;
+    result_set_clear(&scan_results, 1);
+    start = platform_time_ns();
+    scan_process_memory(process, SCAN_VALUE_BETWEEN, &lower, &upper, VALUE_FLOAT);
+    seconds = (platform_time_ns() - start) / 1e9;
+    size_t missing_float = 0;
+    for (size_t offset = 0; offset + sizeof(planted_value) <= size; offset += PLANT_STRIDE)
+    {
+        if (!contains_address(base + offset))
+            missing_float++;
+    }
+    ok = ok && missing_float == 0;
+    fprintf(stderr, "float rounded %s: time=%8.3f s  matches=%llu  missing=%zu\n", typed, seconds,
+            (unsigned long long)scan_results.count, missing_float);
+
+    // Big-endian: the planted bytes typed as the decimal of a big-endian value must find every
+    // planted address; a signed range around it finds the same addresses
+    char typed_be[32];
+    uint32_t value_be, lower_be, upper_be;
+    snprintf(typed_be, sizeof(typed_be), "%u", platform_bswap32(planted_bits));
+    ok = parse_value(typed_be, VALUE_4BYTES_BE, &value_be) && value_be == planted_bits && ok;
+    result_set_clear(&scan_results, 1);
+    start = platform_time_ns();
+    scan_process_memory(process, SCAN_EXACT_VALUE, &value_be, NULL, VALUE_4BYTES_BE);
+    seconds = (platform_time_ns() - start) / 1e9;
+    size_t missing_be = 0;
+    for (size_t offset = 0; offset + sizeof(planted_value) <= size; offset += PLANT_STRIDE)
+    {
+        if (!contains_address(base + offset))
+            missing_be++;
+    }
+    ok = ok && missing_be == 0;
+    fprintf(stderr, "big-endian %s: time=%8.3f s  matches=%llu  missing=%zu\n", typed_be, seconds,
+            (unsigned long long)scan_results.count, missing_be);
+
+    char typed_lower[32], typed_upper[32];
+    snprintf(typed_lower, sizeof(typed_lower), "%d", (int32_t)platform_bswap32(planted_bits) - 1);
+    snprintf(typed_upper, sizeof(typed_upper), "%d", (int32_t)platform_bswap32(planted_bits) + 1);
+    ok = parse_value(typed_lower, VALUE_4BYTES_SIGNED_BE, &lower_be) && parse_value(typed_upper, VALUE_4BYTES_SIGNED_BE, &upper_be) && ok;
+    uint64_t before_signed = scan_results.count;
+    refine_results(process, SCAN_VALUE_BETWEEN, &lower_be, &upper_be, VALUE_4BYTES_SIGNED_BE);
+    ok = ok && scan_results.count >= planted && scan_results.count <= before_signed;
+    fprintf(stderr, "signed big-endian [%s, %s]: kept=%llu\n", typed_lower, typed_upper, (unsigned long long)scan_results.count);
+
+    // Strings: every planted text of the searched encoding (and case) is found in the planted buffer
+    region_filter_add_range(&scan_region_filter, base, base + size);
+    for (int kind = 0; kind < 4; kind++)
+    {
+        bool utf16 = (kind & 1) != 0;
+        bool case_sensitive = kind < 2;
+        size_t expected = 0, missing_text = 0;
+
+        result_set_clear(&scan_results, 1);
+        start = platform_time_ns();
+        scan_process_memory(process, SCAN_EXACT_VALUE, "ShadowEngine", NULL, get_string_value_type(utf16, case_sensitive));
+        seconds = (platform_time_ns() - start) / 1e9;
+        for (size_t page = 0; page < size / TEXT_PAGE; page++)
+        {
+            size_t offset;
+            BytePattern text;
+            if (!planted_text_at(page, size, &offset, &text) || (page % 2 == 1) != utf16 || (case_sensitive && page % 4 >= 2))
+                continue;
+            expected++;
+            missing_text += !contains_address(base + offset);
+        }
+        ok = ok && missing_text == 0 && scan_results.count == expected;
+        fprintf(stderr, "string %s%s: time=%8.3f s  throughput=%6.2f GB/s  matches=%llu  missing=%zu\n", utf16 ? "utf16" : "ascii",
+                case_sensitive ? "" : " nocase", seconds, size / seconds / 1e9, (unsigned long long)scan_results.count, missing_text);
+    }
+
+    // Signatures over the planted text: a wildcard byte finds the typed ASCII text, a wildcard
+    // nibble the uppercase one
+    static const char *text_signatures[] = {"53 68 61 ?? 6F 77 45 6E", "5? 48 41 44 4F 57"};
+    for (int i = 0; i < 2; i++)
+    {
+        size_t expected = 0, missing_signature = 0;
+
+        result_set_clear(&scan_results, 1);
+        start = platform_time_ns();
+        scan_process_memory(process, SCAN_EXACT_VALUE, text_signatures[i], NULL, VALUE_SIGNATURE);
+        seconds = (platform_time_ns() - start) / 1e9;
+        for (size_t page = 0; page < size / TEXT_PAGE; page++)
+        {
+            size_t offset;
+            BytePattern text;
+            if (!planted_text_at(page, size, &offset, &text) || page % 4 != (size_t)i * 2)
+                continue;
+            expected++;
+            missing_signature += !contains_address(base + offset);
+        }
+        ok = ok && missing_signature == 0 && scan_results.count == expected;
+        fprintf(stderr, "signature %s: time=%8.3f s  throughput=%6.2f GB/s  matches=%llu  missing=%zu\n", text_signatures[i],
+                seconds, size / seconds / 1e9, (unsigned long long)scan_results.count, missing_signature);
+    }
+    region_filter_reset(&scan_region_filter);
+
+    // Code signature: the first bytes of a function of the target (a fork of this process), with
+    // a wildcarded displacement, searched in executable images only and then up to its first match
+    const uint8_t *code = (const uint8_t *)(uintptr_t)planted_text_at;
+    char code_signature[64] = "";
+    for (int k = 0; k < 16; k++)
+    {
+        char byte[4] = "??";
+        if (k < 4 || k >= 8)
+            snprintf(byte, sizeof(byte), "%02X", code[k]);
+        snprintf(code_signature + strlen(code_signature), sizeof(code_signature) - strlen(code_signature), "%s%s", k ? " " : "", byte);
+    }
+    scan_region_filter.executable_only = true;
+    scan_region_filter.types = REGION_TYPE_BIT(REGION_IMAGE);
+    result_set_clear(&scan_results, 1);
+    start = platform_time_ns();
+    scan_process_memory(process, SCAN_EXACT_VALUE, code_signature, NULL, VALUE_SIGNATURE);
+    seconds = (platform_time_ns() - start) / 1e9;
+    uint64_t code_matches = scan_results.count;
+    bool code_found = contains_address((uintptr_t)code);
+    ok = ok && code_found;
+    fprintf(stderr, "code signature: time=%8.3f s  matches=%llu  found=%d\n", seconds, (unsigned long long)code_matches, code_found);
+
+    scan_stop_at_first_match = true;
+    result_set_clear(&scan_results, 1);
+    start = platform_time_ns();
+    scan_process_memory(process, SCAN_EXACT_VALUE, code_signature, NULL, VALUE_SIGNATURE);
+    seconds = (platform_time_ns() - start) / 1e9;
+    ok = ok && scan_results.count >= 1 && (code_matches > 1 || contains_address((uintptr_t)code));
+    fprintf(stderr, "code signature first match: time=%8.3f s  matches=%llu\n", seconds, (unsigned long long)scan_results.count);
+    scan_stop_at_first_match = false;
+    region_filter_reset(&scan_region_filter);
+
+    // Batch of BATCH_SIGNATURES signatures in one pass: the text and code signatures above among
+    // generated ones, compiled once into a cache file and loaded back from it
+    static char batch_text[BATCH_SIGNATURES][64];
+    const char *batch[BATCH_SIGNATURES];
+    uint64_t state = 0xD1B54A32D192ED03ull;
+    for (int i = 0; i < BATCH_SIGNATURES; i++)
+    {
+        batch[i] = batch_text[i];
+        if (i < 3)
+        {
+            snprintf(batch_text[i], sizeof(batch_text[i]), "%s", i < 2 ? text_signatures[i] : code_signature);
+            continue;
+        }
+        for (int k = 0; k < 8 + i % 5; k++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            char byte[4];
+            snprintf(byte, sizeof(byte), k == 3 ? "??" : k == 5 && i % 2 ? "%X?" : "%02X", (unsigned)(k == 5 && i % 2 ? state & 0xF : state & 0xFF));
+            snprintf(batch_text[i] + strlen(batch_text[i]), sizeof(batch_text[i]) - strlen(batch_text[i]), "%s%s", k ? " " : "", byte);
+        }
+    }
+
+    SignatureSet signatures;
+    const char *cache_path = "/tmp/bench_scan_signatures.cache";
+    remove(cache_path);
+    start = platform_time_ns();
+    ok = signature_set_load_or_compile(&signatures, cache_path, batch, BATCH_SIGNATURES) && ok;
+    double compile_seconds = (platform_time_ns() - start) / 1e9;
+    size_t compiled_anchors = signatures.anchor_count;
+    signature_set_free(&signatures);
+    start = platform_time_ns();
+    bool cached = signature_set_load(&signatures, cache_path, batch, BATCH_SIGNATURES);
+    double load_seconds = (platform_time_ns() - start) / 1e9;
+    ok = ok && cached && signatures.anchor_count == compiled_anchors;
+    fprintf(stderr, "signature batch: %d signatures, %zu table entries, compile=%.3f ms  cached load=%.3f ms\n",
+            BATCH_SIGNATURES, compiled_anchors, compile_seconds * 1e3, load_seconds * 1e3);
+
+    SignatureResults batch_results;
+    size_t missing_batch = 0;
+    signature_results_init(&batch_results, BATCH_SIGNATURES);
+    region_filter_add_range(&scan_region_filter, base, base + size);
+    start = platform_time_ns();
+    scan_signatures(process, &signatures, &batch_results);
+    seconds = (platform_time_ns() - start) / 1e9;
+    for (int i = 0; i < 2; i++)
+    {
+        const DynamicArray *found = &batch_results.addresses[i];
+        size_t expected = 0, hits = 0;
+        for (size_t page = 0; page < size / TEXT_PAGE; page++)
+        {
+            size_t offset;
+            BytePattern text;
+            if (!planted_text_at(page, size, &offset, &text) || page % 4 != (size_t)i * 2)
+                continue;
+            expected++;
+            // Addresses are ascending and so are the planted offsets
+            while (hits < found->size && ((const uintptr_t *)found->data)[hits] < base + offset)
+                hits++;
+            missing_batch += hits == found->size || ((const uintptr_t *)found->data)[hits] != base + offset;
+        }
+        ok = ok && found->size == expected;
+    }
+    ok = ok && missing_batch == 0;
+    fprintf(stderr, "signature batch (planted buffer): time=%8.3f s  throughput=%6.2f GB/s  missing=%zu\n", seconds,
+            size / seconds / 1e9, missing_batch);
+    signature_results_free(&batch_results);
+
+    signature_results_init(&batch_results, BATCH_SIGNATURES);
+    region_filter_reset(&scan_region_filter);
+    scan_region_filter.executable_only = true;
+    scan_region_filter.types = REGION_TYPE_BIT(REGION_IMAGE);
+    start = platform_time_ns();
+    scan_signatures(process, &signatures, &batch_results);
+    seconds = (platform_time_ns() - start) / 1e9;
+    const DynamicArray *code_hits = &batch_results.addresses[2];
+    bool batch_code_found = false;
+    for (size_t h = 0; h < code_hits->size; h++)
+        batch_code_found = batch_code_found || ((const uintptr_t *)code_hits->data)[h] == (uintptr_t)code;
+    ok = ok && batch_code_found && code_hits->size == code_matches;
+    fprintf(stderr, "signature batch (code): time=%8.3f s  code matches=%zu  found=%d\n", seconds, code_hits->size, batch_code_found);
+    signature_results_free(&batch_results);
+    signature_set_free(&signatures);
+    remove(cache_path);
+    region_filter_reset(&scan_region_filter);
+
+    // Group scan: found at the Level field, anchored on the fixed HP field 6 bytes before it, with
+    // MaxHP and the float anywhere in the window starting at Level
+    const char *group_text = "2:12 4:100@-6 4:100 f:1.5 w:58";
+    size_t expected_groups = 0, missing_groups = 0;
+    region_filter_add_range(&scan_region_filter, base, base + size);
+    result_set_clear(&scan_results, 1);
+    start = platform_time_ns();
+    scan_process_memory(process, SCAN_EXACT_VALUE, group_text, NULL, VALUE_GROUP);
+    seconds = (platform_time_ns() - start) / 1e9;
+    for (size_t index = 0; index < size / GROUP_STRIDE; index++)
+    {
+        size_t offset;
+        bool matching;
+        if (!planted_group_at(index, size, &offset, &matching) || !matching)
+            continue;
+        expected_groups++;
+        missing_groups += !contains_address(base + offset + 6);
+    }
+    ok = ok && missing_groups == 0 && scan_results.count == expected_groups;
+    fprintf(stderr, "group %s: time=%8.3f s  throughput=%6.2f GB/s  matches=%llu  missing=%zu\n", group_text, seconds,
+            size / seconds / 1e9, (unsigned long long)scan_results.count, missing_groups);
+    region_filter_reset(&scan_region_filter);
+
+    shutdown_scan_workers();
+    region_filter_free(&scan_region_filter);
+    result_set_free(&scan_results);
+    free_array(&memory_values);
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    return ok ? 0 : 1;
+}
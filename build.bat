@@ -32,7 +32,7 @@ fxc.exe %PS_FLAGS% %PS_SHADER_INPUT%
 
 :: Compiler Flags for Main Program
 set CL_FLAGS=/nologo /W4 /O2 /fp:precise /Gm-
-set CL_INPUT=src/main.c src/process.c src/memory.c src/dynamic_array.c src/utils.c
+set CL_INPUT=src/main.c src/process.c src/memory.c src/dynamic_array.c src/utils.c src/platform.c src/thread_pool.c src/scan_kernels.c src/snapshot.c src/result_set.c src/packed_offsets.c src/scan_progress.c src/result_stream.c src/buffer_pool.c src/read_ahead.c src/region_filter.c src/signature_set.c src/pointer_scan.c src/freeze.c
 set CL_OUTPUT="bin/Shadow Engine.exe"
 set CL_LIBS=user32.lib dxguid.lib d3d11.lib shell32.lib
 
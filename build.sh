@@ -0,0 +1,17 @@
+#!/bin/sh
+# Headless Linux build of the scanner core and its benchmarks.
+# The GUI (main.c, nuklear, D3D11) is Windows only and is built with build.bat.
+set -e
+
+cd "$(dirname "$0")"
+mkdir -p bin
+
+CC=${CC:-gcc}
+CFLAGS="-O2 -g -std=gnu11 -Wall -Wextra -Wno-unused-parameter -pthread"
+ENGINE_SRC="src/process.c src/memory.c src/dynamic_array.c src/platform.c src/thread_pool.c src/scan_kernels.c src/snapshot.c src/result_set.c src/packed_offsets.c src/scan_progress.c src/result_stream.c src/buffer_pool.c src/read_ahead.c src/region_filter.c src/signature_set.c src/pointer_scan.c src/freeze.c"
+
+$CC $CFLAGS -Isrc -o bin/bench_scan bench/bench_scan.c $ENGINE_SRC -lm
+$CC $CFLAGS -Isrc -o bin/bench_kernels bench/bench_kernels.c src/scan_kernels.c src/platform.c src/dynamic_array.c
+$CC $CFLAGS -Isrc -o bin/bench_pointer_scan bench/bench_pointer_scan.c src/pointer_scan.c src/region_filter.c src/thread_pool.c src/platform.c src/dynamic_array.c
+$CC $CFLAGS -Isrc -o bin/bench_freeze bench/bench_freeze.c $ENGINE_SRC -lm
+$CC $CFLAGS -Isrc -o bin/bench_processes bench/bench_processes.c src/process.c src/platform.c src/dynamic_array.c
@@ -0,0 +1,66 @@
+#include "buffer_pool.h"
+
+bool buffer_pool_create(BufferPool *pool, size_t count, size_t buffer_size)
+{
+    memset(pool, 0, sizeof(BufferPool));
+    pool->buffers = calloc(count, sizeof(uint8_t *));
+    pool->free_buffers = calloc(count, sizeof(uint8_t *));
+    if (!pool->buffers || !pool->free_buffers)
+    {
+        free(pool->buffers);
+        free(pool->free_buffers);
+        return false;
+    }
+
+    // Round up so every buffer also ends on a page boundary
+    buffer_size = (buffer_size + BUFFER_POOL_ALIGNMENT - 1) & ~(size_t)(BUFFER_POOL_ALIGNMENT - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        pool->buffers[i] = platform_aligned_alloc(buffer_size, BUFFER_POOL_ALIGNMENT);
+        if (!pool->buffers[i])
+        {
+            pool->count = i;
+            buffer_pool_destroy(pool);
+            return false;
+        }
+        pool->free_buffers[i] = pool->buffers[i];
+    }
+
+    pool->count = count;
+    pool->available = count;
+    pool->buffer_size = buffer_size;
+    platform_mutex_init(&pool->lock);
+    return true;
+}
+
+void buffer_pool_destroy(BufferPool *pool)
+{
+    if (!pool->buffers)
+        return;
+
+    for (size_t i = 0; i < pool->count; i++)
+        platform_aligned_free(pool->buffers[i]);
+    free(pool->buffers);
+    free(pool->free_buffers);
+    if (pool->buffer_size)
+        platform_mutex_destroy(&pool->lock);
+    memset(pool, 0, sizeof(BufferPool));
+}
+
+uint8_t *buffer_pool_acquire(BufferPool *pool)
+{
+    uint8_t *buffer = NULL;
+
+    platform_mutex_lock(&pool->lock);
+    if (pool->available > 0)
+        buffer = pool->free_buffers[--pool->available];
+    platform_mutex_unlock(&pool->lock);
+    return buffer;
+}
+
+void buffer_pool_release(BufferPool *pool, uint8_t *buffer)
+{
+    platform_mutex_lock(&pool->lock);
+    pool->free_buffers[pool->available++] = buffer;
+    platform_mutex_unlock(&pool->lock);
+}
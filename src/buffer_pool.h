@@ -0,0 +1,26 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include "platform.h"
+
+#define BUFFER_POOL_ALIGNMENT 4096 // Page aligned: reads land on whole pages and kernels load aligned vectors
+
+// Fixed set of equally sized, aligned buffers handed out and taken back across scans, so the chunk
+// buffers are allocated once instead of on every scan
+typedef struct
+{
+    uint8_t **buffers;      // Every buffer, for the release of the pool
+    uint8_t **free_buffers; // free_buffers[0, available) are not in use
+    size_t count;
+    size_t buffer_size;
+    size_t available;
+    PlatformMutex lock;
+} BufferPool;
+
+bool buffer_pool_create(BufferPool *pool, size_t count, size_t buffer_size);
+void buffer_pool_destroy(BufferPool *pool);
+// NULL when every buffer is in use
+uint8_t *buffer_pool_acquire(BufferPool *pool);
+void buffer_pool_release(BufferPool *pool, uint8_t *buffer);
+
+#endif
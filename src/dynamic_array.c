@@ -51,6 +51,39 @@ void append(DynamicArray *array, const void *value)
     array->size++;
 }
 
+// Function to add several contiguous elements to the array at once
+void append_many(DynamicArray *array, const void *values, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (array->size + count > array->capacity)
+    {
+        size_t new_capacity = (size_t)(array->capacity * 1.5);
+        reserve_array(array, new_capacity > array->size + count ? new_capacity : array->size + count);
+    }
+    memcpy((char *)array->data + (array->size * array->element_size), values, count * array->element_size);
+    array->size += count;
+}
+
+// Function to grow the allocated capacity to at least the given number of elements
+void reserve_array(DynamicArray *array, size_t capacity)
+{
+    if (capacity <= array->capacity)
+    {
+        return;
+    }
+    void *new_data = realloc(array->data, capacity * array->element_size);
+    if (!new_data)
+    {
+        perror("Failed to reallocate memory");
+        exit(EXIT_FAILURE);
+    }
+    array->data = new_data;
+    array->capacity = capacity;
+}
+
 // Function to get an element from the array
 void *get(DynamicArray *array, size_t index)
 {
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct
 {
@@ -16,6 +17,8 @@ void clear_array(DynamicArray *array, size_t new_initial_capacity, size_t new_el
 void create_array(DynamicArray *array, size_t initial_capacity, size_t element_size);
 void transfer_array(DynamicArray *dest, DynamicArray *src);
 void append(DynamicArray *array, const void *value);
+void append_many(DynamicArray *array, const void *values, size_t count);
+void reserve_array(DynamicArray *array, size_t capacity);
 void *get(DynamicArray *array, size_t index);
 void resize_array(DynamicArray *array);
 void free_array(DynamicArray *array);
@@ -0,0 +1,817 @@
+#include "freeze.h"
+
+#define FREEZE_BATCH_WINDOWS 256 // Most windows applied between two looks at the clock
+#define FREEZE_BATCH_SPANS 1024  // Spans after which a batch of windows ends
+
+void freeze_plan_init(FreezePlan *plan, HANDLE process)
+{
+    plan->process = process;
+    plan->entry_count = 0;
+    create_array(&plan->writes, 64, sizeof(FreezeWrite));
+    create_array(&plan->bytes, 256, sizeof(uint8_t));
+    create_array(&plan->windows, 16, sizeof(FreezeWindow));
+    create_array(&plan->chains, 16, sizeof(FreezeChain));
+    create_array(&plan->nodes, 16, sizeof(FreezeNode));
+    create_array(&plan->node_reads, 16, sizeof(FreezeChainRead));
+    create_array(&plan->targets, 16, sizeof(FreezeTarget));
+    create_array(&plan->target_reads, 16, sizeof(FreezeChainRead));
+    create_array(&plan->target_bytes, 64, sizeof(uint8_t));
+    plan->level_count = 0;
+    plan->read_bytes = 0;
+}
+
+void freeze_plan_add(FreezePlan *plan, uintptr_t address, const void *bytes, size_t size)
+{
+    FreezeWrite write = {address, (uint32_t)size, (uint32_t)plan->bytes.size};
+    append_many(&plan->bytes, bytes, size);
+    append(&plan->writes, &write);
+    plan->entry_count++;
+}
+
+void freeze_plan_add_chain(FreezePlan *plan, const FreezeChain *chain, const void *bytes, size_t size)
+{
+    if (chain->depth == 0)
+    {
+        freeze_plan_add(plan, chain->base, bytes, size);
+        return;
+    }
+
+    // Offsets past the depth are cleared, they take part in the trie order
+    FreezeChain copy = *chain;
+    memset(copy.offsets + copy.depth, 0, (POINTER_MAX_DEPTH - copy.depth) * sizeof(int32_t));
+    FreezeTarget target = {(uint32_t)plan->chains.size, chain->offsets[chain->depth - 1], (uint32_t)size, (uint32_t)plan->target_bytes.size, 0};
+    append_many(&plan->target_bytes, bytes, size);
+    append(&plan->chains, &copy);
+    append(&plan->targets, &target);
+    plan->entry_count++;
+}
+
+bool freeze_chain_from_path(const DynamicArray *modules, const PointerPath *path, FreezeChain *chain)
+{
+    if (path->module >= modules->size || path->depth == 0 || path->depth > POINTER_MAX_DEPTH)
+        return false;
+
+    memset(chain, 0, sizeof(FreezeChain));
+    chain->base = ((const ModuleInfo *)modules->data)[path->module].base + path->base_offset;
+    chain->depth = path->depth;
+    memcpy(chain->offsets, path->offsets, path->depth * sizeof(int32_t));
+    return true;
+}
+
+bool freeze_chain_resolve(HANDLE process, const FreezeChain *chain, uintptr_t *address)
+{
+    uintptr_t current = chain->base;
+    for (uint32_t level = 0; level < chain->depth; level++)
+    {
+        uintptr_t pointer = 0;
+        size_t bytes_read = 0;
+        if (!platform_read_memory(process, current, &pointer, sizeof(pointer), &bytes_read) || bytes_read != sizeof(pointer))
+            return false;
+        current = pointer + (intptr_t)chain->offsets[level];
+    }
+    *address = current;
+    return true;
+}
+
+// Trie order: chains with the same base and first offsets are next to each other, by ascending offset
+static int compare_chains(const void *a, const void *b)
+{
+    const FreezeChain *x = *(const FreezeChain *const *)a, *y = *(const FreezeChain *const *)b;
+    if (x->base != y->base)
+        return x->base < y->base ? -1 : 1;
+    for (uint32_t level = 0; level < POINTER_MAX_DEPTH; level++)
+    {
+        if (x->offsets[level] != y->offsets[level])
+            return x->offsets[level] < y->offsets[level] ? -1 : 1;
+    }
+    return 0;
+}
+
+static int compare_targets(const void *a, const void *b)
+{
+    const FreezeTarget *x = *(const FreezeTarget *const *)a, *y = *(const FreezeTarget *const *)b;
+    if (x->node != y->node)
+        return x->node < y->node ? -1 : 1;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+// Extends the last read of reads over item when it is below the same parent, a short gap after it
+// and the read stays within FREEZE_WINDOW_MAX, else starts a new read. Items come in ascending order.
+static void place_read(DynamicArray *reads, uint32_t parent, uintptr_t start, uint32_t size, uint32_t item)
+{
+    FreezeChainRead *last = reads->size > 0 ? (FreezeChainRead *)reads->data + reads->size - 1 : NULL;
+    if (last && last->parent == parent && (intptr_t)(start - (last->start + last->size)) <= FREEZE_READ_GAP &&
+        start + size - last->start <= FREEZE_WINDOW_MAX)
+    {
+        last->size = (uint32_t)max(last->size, start + size - last->start);
+        last->count++;
+        return;
+    }
+    FreezeChainRead read = {start, parent, size, 0, item, 1};
+    append(reads, &read);
+}
+
+// Places reads one after the other in the read buffer of a tick, returns its size
+static size_t place_buffer(DynamicArray *reads, size_t at)
+{
+    FreezeChainRead *all = (FreezeChainRead *)reads->data;
+    for (size_t r = 0; r < reads->size; r++)
+    {
+        all[r].at = (uint32_t)at;
+        at += all[r].size;
+    }
+    return at;
+}
+
+// Merges the targets of every node that touch or overlap, the last one added winning where they overlap
+static void merge_targets(FreezePlan *plan)
+{
+    FreezeTarget *targets = (FreezeTarget *)plan->targets.data;
+    size_t count = plan->targets.size;
+    const FreezeTarget **order = malloc((count + 1) * sizeof(const FreezeTarget *));
+    uint32_t *merged_into = malloc((count + 1) * sizeof(uint32_t));
+    DynamicArray merged, bytes;
+
+    if (!order || !merged_into)
+    {
+        perror("Failed to allocate the freeze plan targets");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t t = 0; t < count; t++)
+        order[t] = &targets[t];
+    qsort(order, count, sizeof(const FreezeTarget *), compare_targets);
+
+    create_array(&merged, count / 2 + 16, sizeof(FreezeTarget));
+    for (size_t o = 0; o < count; o++)
+    {
+        const FreezeTarget *target = order[o];
+        FreezeTarget *last = merged.size > 0 ? (FreezeTarget *)merged.data + merged.size - 1 : NULL;
+        if (last && last->node == target->node && target->offset <= (int64_t)last->offset + last->size)
+            last->size = (uint32_t)max((int64_t)last->size, (int64_t)target->offset + target->size - last->offset);
+        else
+            append(&merged, target);
+        merged_into[target - targets] = (uint32_t)merged.size - 1;
+    }
+
+    FreezeTarget *first = (FreezeTarget *)merged.data;
+    size_t merged_bytes = 0;
+    for (size_t m = 0; m < merged.size; m++)
+    {
+        first[m].value = (uint32_t)merged_bytes;
+        merged_bytes += first[m].size;
+    }
+    create_array(&bytes, merged_bytes + 1, sizeof(uint8_t));
+    bytes.size = merged_bytes;
+    for (size_t t = 0; t < count; t++)
+    {
+        const FreezeTarget *into = &first[merged_into[t]];
+        memcpy((uint8_t *)bytes.data + into->value + (targets[t].offset - into->offset),
+               (const uint8_t *)plan->target_bytes.data + targets[t].value, targets[t].size);
+    }
+
+    free_array(&plan->targets);
+    free_array(&plan->target_bytes);
+    plan->targets = merged;
+    plan->target_bytes = bytes;
+    free(order);
+    free(merged_into);
+}
+
+// Builds the nodes of the chains level after level, points every target at the last node of its
+// chain, then groups nodes and targets into reads
+static void finish_chains(FreezePlan *plan)
+{
+    const FreezeChain *chains = (const FreezeChain *)plan->chains.data;
+    FreezeTarget *targets = (FreezeTarget *)plan->targets.data;
+    size_t count = plan->chains.size;
+    const FreezeChain **order = malloc((count + 1) * sizeof(const FreezeChain *));
+    uint32_t *chain_node = malloc((count + 1) * sizeof(uint32_t));
+
+    if (!order || !chain_node)
+    {
+        perror("Failed to allocate the freeze plan chains");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < count; i++)
+        order[i] = &chains[i];
+    qsort(order, count, sizeof(const FreezeChain *), compare_chains);
+
+    plan->nodes.size = 0;
+    plan->node_reads.size = 0;
+    plan->level_count = 0;
+    for (uint32_t level = 0; level < POINTER_MAX_DEPTH; level++)
+    {
+        // One node for every run of chains in trie order that read the same pointers so far
+        size_t level_start = plan->nodes.size;
+        const FreezeChain *previous = NULL;
+        for (size_t o = 0; o < count; o++)
+        {
+            const FreezeChain *chain = order[o];
+            size_t i = (size_t)(chain - chains);
+            if (chain->depth <= level)
+                continue;
+            if (!previous || previous->base != chain->base || memcmp(previous->offsets, chain->offsets, level * sizeof(int32_t)) != 0)
+            {
+                FreezeNode node = {chain->base, level > 0 ? chain_node[i] : FREEZE_NO_PARENT, level > 0 ? chain->offsets[level - 1] : 0, 0};
+                append(&plan->nodes, &node);
+                if (level == 0)
+                    place_read(&plan->node_reads, FREEZE_NO_PARENT, node.base, sizeof(uintptr_t), (uint32_t)plan->nodes.size - 1);
+                else
+                    place_read(&plan->node_reads, node.parent, (uintptr_t)(intptr_t)node.offset, sizeof(uintptr_t), (uint32_t)plan->nodes.size - 1);
+            }
+            chain_node[i] = (uint32_t)plan->nodes.size - 1;
+            previous = chain;
+        }
+        if (plan->nodes.size == level_start)
+            break;
+        plan->level_end[level] = (uint32_t)plan->node_reads.size;
+        plan->level_count = level + 1;
+    }
+
+    for (size_t t = 0; t < plan->targets.size; t++)
+        targets[t].node = chain_node[targets[t].node];
+    merge_targets(plan);
+    targets = (FreezeTarget *)plan->targets.data;
+    plan->target_reads.size = 0;
+    for (size_t t = 0; t < plan->targets.size; t++)
+        place_read(&plan->target_reads, targets[t].node, (uintptr_t)(intptr_t)targets[t].offset, targets[t].size, (uint32_t)t);
+
+    // Where every node and target lands in the read buffer
+    plan->read_bytes = place_buffer(&plan->target_reads, place_buffer(&plan->node_reads, 0));
+    FreezeNode *nodes = (FreezeNode *)plan->nodes.data;
+    const FreezeChainRead *reads = (const FreezeChainRead *)plan->node_reads.data;
+    for (size_t r = 0; r < plan->node_reads.size; r++)
+    {
+        for (uint32_t n = reads[r].first; n < reads[r].first + reads[r].count; n++)
+        {
+            uintptr_t start = reads[r].parent == FREEZE_NO_PARENT ? nodes[n].base : (uintptr_t)(intptr_t)nodes[n].offset;
+            nodes[n].at = reads[r].at + (uint32_t)(start - reads[r].start);
+        }
+    }
+    reads = (const FreezeChainRead *)plan->target_reads.data;
+    for (size_t r = 0; r < plan->target_reads.size; r++)
+    {
+        for (uint32_t t = reads[r].first; t < reads[r].first + reads[r].count; t++)
+            targets[t].at = reads[r].at + (uint32_t)((uintptr_t)(intptr_t)targets[t].offset - reads[r].start);
+    }
+
+    free(order);
+    free(chain_node);
+}
+
+// Entry of a plan being finished, in address order
+typedef struct
+{
+    uintptr_t address;
+    uintptr_t end;
+} FreezeEntryRange;
+
+static int compare_entry_ranges(const void *a, const void *b)
+{
+    uintptr_t x = ((const FreezeEntryRange *)a)->address, y = ((const FreezeEntryRange *)b)->address;
+    return x < y ? -1 : x > y;
+}
+
+// Last span starting at or before address
+static const FreezeWrite *find_span(const DynamicArray *spans, uintptr_t address)
+{
+    const FreezeWrite *first = (const FreezeWrite *)spans->data;
+    size_t low = 0, high = spans->size;
+
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (first[mid].address <= address)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return &first[low - 1];
+}
+
+void freeze_plan_finish(FreezePlan *plan)
+{
+    const FreezeWrite *entries = (const FreezeWrite *)plan->writes.data;
+    size_t count = plan->writes.size;
+    FreezeEntryRange *ranges = malloc((count + 1) * sizeof(FreezeEntryRange));
+    DynamicArray spans, bytes;
+
+    if (!ranges)
+    {
+        perror("Failed to allocate the freeze plan spans");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < count; i++)
+        ranges[i] = (FreezeEntryRange){entries[i].address, entries[i].address + entries[i].size};
+    qsort(ranges, count, sizeof(FreezeEntryRange), compare_entry_ranges);
+
+    // Entries that touch or overlap make one span
+    create_array(&spans, count / 4 + 16, sizeof(FreezeWrite));
+    size_t span_bytes = 0;
+    for (size_t i = 0; i < count;)
+    {
+        uintptr_t end = ranges[i].end;
+        size_t next = i + 1;
+        for (; next < count && ranges[next].address <= end; next++)
+            end = max(end, ranges[next].end);
+
+        FreezeWrite span = {ranges[i].address, (uint32_t)(end - ranges[i].address), (uint32_t)span_bytes};
+        append(&spans, &span);
+        span_bytes += span.size;
+        i = next;
+    }
+    free(ranges);
+
+    // Copied in the order they were added, the last entry over an earlier one wins
+    create_array(&bytes, span_bytes + 1, sizeof(uint8_t));
+    bytes.size = span_bytes;
+    for (size_t i = 0; i < count; i++)
+    {
+        const FreezeWrite *span = find_span(&spans, entries[i].address);
+        memcpy((uint8_t *)bytes.data + span->offset + (entries[i].address - span->address),
+               (const uint8_t *)plan->bytes.data + entries[i].offset, entries[i].size);
+    }
+    free_array(&plan->writes);
+    free_array(&plan->bytes);
+    plan->writes = spans;
+    plan->bytes = bytes;
+
+    // Spans a short gap apart are read together, up to FREEZE_WINDOW_MAX
+    const FreezeWrite *first = (const FreezeWrite *)spans.data;
+    plan->windows.size = 0;
+    for (size_t i = 0; i < spans.size;)
+    {
+        FreezeWindow window = {first[i].address, first[i].size, (uint32_t)i, 1};
+        for (i++; i < spans.size; i++)
+        {
+            uintptr_t window_end = window.address + window.size;
+            uintptr_t span_end = first[i].address + first[i].size;
+            if (first[i].address - window_end > FREEZE_READ_GAP || span_end - window.address > FREEZE_WINDOW_MAX)
+                break;
+            window.size = (uint32_t)(span_end - window.address);
+            window.span_count++;
+        }
+        append(&plan->windows, &window);
+    }
+    finish_chains(plan);
+}
+
+void freeze_plan_free(FreezePlan *plan)
+{
+    free_array(&plan->writes);
+    free_array(&plan->bytes);
+    free_array(&plan->windows);
+    free_array(&plan->chains);
+    free_array(&plan->nodes);
+    free_array(&plan->node_reads);
+    free_array(&plan->targets);
+    free_array(&plan->target_reads);
+    free_array(&plan->target_bytes);
+}
+
+void freeze_tick_init(FreezeTick *tick, bool conditional, uint64_t budget_ns)
+{
+    memset(tick, 0, sizeof(FreezeTick));
+    tick->conditional = conditional;
+    tick->budget_ns = budget_ns;
+    create_array(&tick->buffer, FREEZE_WINDOW_MAX, sizeof(uint8_t));
+    create_array(&tick->read_batch, FREEZE_BATCH_WINDOWS, sizeof(MemoryReadRequest));
+    create_array(&tick->write_batch, FREEZE_BATCH_WINDOWS, sizeof(MemoryWriteRequest));
+    create_array(&tick->node_values, 16, sizeof(uintptr_t));
+    create_array(&tick->node_changed, 16, sizeof(uint8_t));
+}
+
+void freeze_tick_reset(FreezeTick *tick)
+{
+    tick->cursor = 0;
+    tick->node_values.size = 0;
+    tick->node_changed.size = 0;
+}
+
+void freeze_tick_free(FreezeTick *tick)
+{
+    free_array(&tick->buffer);
+    free_array(&tick->read_batch);
+    free_array(&tick->write_batch);
+    free_array(&tick->node_values);
+    free_array(&tick->node_changed);
+}
+
+// Queues the bytes of span that differ from current, from the first to the last that does
+static void queue_drifted(FreezeTick *tick, const FreezeWrite *span, const uint8_t *wanted, const uint8_t *current)
+{
+    if (memcmp(wanted, current, span->size) == 0)
+        return;
+
+    size_t low = 0, high = span->size;
+    while (wanted[low] == current[low])
+        low++;
+    while (wanted[high - 1] == current[high - 1])
+        high--;
+    MemoryWriteRequest request = {span->address + low, wanted + low, high - low, 0};
+    append(&tick->write_batch, &request);
+}
+
+// Reads the windows [first, first + count) and queues what drifted in their spans
+static void check_windows(const FreezePlan *plan, FreezeTick *tick, size_t first, size_t count)
+{
+    const FreezeWindow *windows = (const FreezeWindow *)plan->windows.data + first;
+    const FreezeWrite *spans = (const FreezeWrite *)plan->writes.data;
+    const uint8_t *bytes = (const uint8_t *)plan->bytes.data;
+    size_t total = 0;
+
+    for (size_t w = 0; w < count; w++)
+        total += windows[w].size;
+    reserve_array(&tick->buffer, total);
+    reserve_array(&tick->read_batch, count);
+
+    MemoryReadRequest *reads = (MemoryReadRequest *)tick->read_batch.data;
+    uint8_t *buffer = (uint8_t *)tick->buffer.data;
+    for (size_t w = 0, offset = 0; w < count; offset += windows[w].size, w++)
+        reads[w] = (MemoryReadRequest){windows[w].address, buffer + offset, windows[w].size, 0};
+    platform_read_memory_batch(plan->process, reads, count);
+
+    for (size_t w = 0; w < count; w++)
+    {
+        const FreezeWindow *window = &windows[w];
+        for (uint32_t s = window->first_span; s < window->first_span + window->span_count; s++)
+        {
+            size_t at = spans[s].address - window->address;
+            if (reads[w].bytes_read < at + spans[s].size)
+                tick->failed_writes++;
+            else
+                queue_drifted(tick, &spans[s], bytes + spans[s].offset, (const uint8_t *)reads[w].buffer + at);
+        }
+    }
+}
+
+// Writes the queued batch and counts it
+static void flush_writes(const FreezePlan *plan, FreezeTick *tick)
+{
+    MemoryWriteRequest *writes = (MemoryWriteRequest *)tick->write_batch.data;
+    platform_write_memory_batch(plan->process, writes, tick->write_batch.size);
+    for (size_t i = 0; i < tick->write_batch.size; i++)
+    {
+        tick->failed_writes += writes[i].bytes_written != writes[i].size;
+        tick->bytes_written += writes[i].bytes_written;
+    }
+    tick->writes += tick->write_batch.size;
+    tick->write_batch.size = 0;
+}
+
+static void resize_cache(DynamicArray *array, size_t count)
+{
+    reserve_array(array, count);
+    memset(array->data, 0, count * array->element_size);
+    array->size = count;
+}
+
+// Where offset leads from the pointer of node, 0 when it could not be read
+static uintptr_t follow(const uintptr_t *values, uint32_t node, intptr_t offset)
+{
+    return values[node] ? values[node] + offset : 0;
+}
+
+// Request of read, from where the pointer of its parent leads; unreachable reads keep an empty
+// request, which reads nothing and fails the checks
+static MemoryReadRequest chain_request(const FreezeChainRead *read, const uintptr_t *values, uint8_t *buffer)
+{
+    uintptr_t address = read->parent == FREEZE_NO_PARENT ? read->start : follow(values, read->parent, (intptr_t)read->start);
+    return (MemoryReadRequest){address, buffer + read->at, address ? read->size : 0, 0};
+}
+
+// Reads again those of reads [first, first + count) whose parent changed, into their requests
+static size_t reread_moved(const FreezePlan *plan, FreezeTick *tick, const FreezeChainRead *reads, MemoryReadRequest *requests,
+                           size_t count, MemoryReadRequest *again)
+{
+    const uintptr_t *values = (const uintptr_t *)tick->node_values.data;
+    const uint8_t *changed = (const uint8_t *)tick->node_changed.data;
+    uint8_t *buffer = (uint8_t *)tick->buffer.data;
+    size_t stale = 0;
+
+    for (size_t r = 0; r < count; r++)
+    {
+        if (reads[r].parent != FREEZE_NO_PARENT && changed[reads[r].parent])
+            again[stale++] = chain_request(&reads[r], values, buffer);
+    }
+    if (stale == 0)
+        return 0;
+
+    platform_read_memory_batch(plan->process, again, stale);
+    for (size_t r = 0, a = 0; r < count; r++)
+    {
+        if (reads[r].parent != FREEZE_NO_PARENT && changed[reads[r].parent])
+            requests[r] = again[a++];
+    }
+    return stale;
+}
+
+// Resolves the chains of plan and writes their targets. Every node read is issued in one batch from
+// where the cached pointers lead, along with the target reads of a conditional tick. Then, level
+// after level, only the reads below a pointer that changed are issued again, from where it leads now.
+static void apply_chains(const FreezePlan *plan, FreezeTick *tick)
+{
+    const FreezeNode *nodes = (const FreezeNode *)plan->nodes.data;
+    const FreezeTarget *targets = (const FreezeTarget *)plan->targets.data;
+    const FreezeChainRead *node_reads = (const FreezeChainRead *)plan->node_reads.data;
+    const FreezeChainRead *target_reads = (const FreezeChainRead *)plan->target_reads.data;
+    const uint8_t *wanted = (const uint8_t *)plan->target_bytes.data;
+    size_t node_read_count = plan->node_reads.size, target_read_count = plan->target_reads.size;
+    size_t first_reads = node_read_count + (tick->conditional ? target_read_count : 0);
+
+    if (tick->node_values.size != plan->nodes.size)
+    {
+        resize_cache(&tick->node_values, plan->nodes.size);
+        resize_cache(&tick->node_changed, plan->nodes.size);
+    }
+    reserve_array(&tick->buffer, plan->read_bytes);
+    reserve_array(&tick->read_batch, first_reads * 2);
+
+    uintptr_t *values = (uintptr_t *)tick->node_values.data;
+    uint8_t *changed = (uint8_t *)tick->node_changed.data;
+    uint8_t *buffer = (uint8_t *)tick->buffer.data;
+    MemoryReadRequest *requests = (MemoryReadRequest *)tick->read_batch.data;
+    MemoryReadRequest *target_requests = requests + node_read_count;
+    MemoryReadRequest *again = requests + first_reads;
+
+    for (size_t r = 0; r < node_read_count; r++)
+    {
+        requests[r] = chain_request(&node_reads[r], values, buffer);
+        tick->pointer_reads += requests[r].size != 0;
+    }
+    for (size_t r = 0; tick->conditional && r < target_read_count; r++)
+        target_requests[r] = chain_request(&target_reads[r], values, buffer);
+    platform_read_memory_batch(plan->process, requests, first_reads);
+
+    for (uint32_t level = 0; level < plan->level_count; level++)
+    {
+        size_t begin = level > 0 ? plan->level_end[level - 1] : 0, end = plan->level_end[level];
+        tick->pointer_reads += reread_moved(plan, tick, node_reads + begin, requests + begin, end - begin, again);
+
+        for (size_t r = begin; r < end; r++)
+        {
+            for (uint32_t n = node_reads[r].first; n < node_reads[r].first + node_reads[r].count; n++)
+            {
+                uintptr_t value = 0;
+                if (requests[r].bytes_read >= nodes[n].at - node_reads[r].at + sizeof(uintptr_t))
+                    memcpy(&value, buffer + nodes[n].at, sizeof(value));
+                changed[n] = value != values[n];
+                tick->moved_nodes += changed[n];
+                values[n] = value;
+            }
+        }
+    }
+    if (tick->conditional)
+        reread_moved(plan, tick, target_reads, target_requests, target_read_count, again);
+
+    tick->write_batch.size = 0;
+    for (size_t r = 0; r < target_read_count; r++)
+    {
+        for (uint32_t t = target_reads[r].first; t < target_reads[r].first + target_reads[r].count; t++)
+        {
+            FreezeWrite target = {follow(values, targets[t].node, targets[t].offset), targets[t].size, targets[t].value};
+            bool read = !tick->conditional || target_requests[r].bytes_read >= targets[t].at - target_reads[r].at + target.size;
+            if (target.address == 0 || !read)
+                tick->failed_writes++;
+            else if (tick->conditional)
+                queue_drifted(tick, &target, wanted + target.offset, buffer + targets[t].at);
+            else
+            {
+                MemoryWriteRequest request = {target.address, wanted + target.offset, target.size, 0};
+                append(&tick->write_batch, &request);
+            }
+        }
+    }
+    flush_writes(plan, tick);
+}
+
+void freeze_plan_apply(const FreezePlan *plan, FreezeTick *tick)
+{
+    const FreezeWindow *windows = (const FreezeWindow *)plan->windows.data;
+    const FreezeWrite *spans = (const FreezeWrite *)plan->writes.data;
+    const uint8_t *bytes = (const uint8_t *)plan->bytes.data;
+    size_t window_count = plan->windows.size;
+    uint64_t start = platform_time_ns();
+
+    tick->spans = tick->writes = tick->failed_writes = tick->bytes_written = 0;
+    tick->pointer_reads = tick->moved_nodes = 0;
+    if (plan->targets.size > 0)
+        apply_chains(plan, tick);
+    if (tick->cursor >= window_count)
+        tick->cursor = 0;
+
+    // Batches of windows from the cursor on, around the plan at most once, until the budget is spent
+    for (size_t done = 0; done < window_count;)
+    {
+        size_t first = tick->cursor;
+        size_t limit = min(min((size_t)FREEZE_BATCH_WINDOWS, window_count - first), window_count - done);
+        size_t count = 0;
+        for (size_t batch_spans = 0; count < limit && batch_spans < FREEZE_BATCH_SPANS; count++)
+            batch_spans += windows[first + count].span_count;
+
+        tick->write_batch.size = 0;
+        if (tick->conditional)
+            check_windows(plan, tick, first, count);
+        else
+        {
+            for (uint32_t s = windows[first].first_span; s < windows[first + count - 1].first_span + windows[first + count - 1].span_count; s++)
+            {
+                MemoryWriteRequest request = {spans[s].address, bytes + spans[s].offset, spans[s].size, 0};
+                append(&tick->write_batch, &request);
+            }
+        }
+        tick->spans += windows[first + count - 1].first_span + windows[first + count - 1].span_count - windows[first].first_span;
+        flush_writes(plan, tick);
+
+        tick->cursor = (first + count) % window_count;
+        done += count;
+        if (tick->budget_ns && platform_time_ns() - start >= tick->budget_ns)
+            break;
+    }
+}
+
+static void record_max(volatile int64_t *field, int64_t value)
+{
+    // Only the freeze thread writes the stats
+    if (value > platform_atomic_load64(field))
+        platform_atomic_store64(field, value);
+}
+
+static void freeze_thread_proc(void *param)
+{
+    FreezeEngine *engine = (FreezeEngine *)param;
+    uint64_t deadline = platform_time_ns();
+    int64_t applied_generation = -1;
+    FreezeTick tick;
+    PlatformTimer timer;
+
+    platform_timer_create(&timer);
+    freeze_tick_init(&tick, false, 0);
+    while (platform_atomic_load64(&engine->running))
+    {
+        uint64_t interval = (uint64_t)platform_atomic_load64(&engine->interval_ns);
+        deadline += interval;
+        platform_sleep_until_ns(&timer, deadline);
+        if (!platform_atomic_load64(&engine->running))
+            break;
+
+        uint64_t woke = platform_time_ns();
+        tick.conditional = platform_atomic_load64(&engine->conditional) != 0;
+        tick.budget_ns = (uint64_t)platform_atomic_load64(&engine->budget_ns);
+
+        // The generation is loaded first: a plan replaced after it is kept until a later tick ends
+        int64_t generation = platform_atomic_load64(&engine->generation);
+        FreezePlan *plan = (FreezePlan *)platform_atomic_load_ptr((void *volatile *)&engine->plan);
+        if (generation != applied_generation)
+            freeze_tick_reset(&tick);
+        tick.spans = tick.writes = tick.failed_writes = tick.bytes_written = 0;
+        tick.pointer_reads = tick.moved_nodes = 0;
+        if (plan)
+            freeze_plan_apply(plan, &tick);
+        applied_generation = generation;
+        platform_atomic_store64(&engine->quiescent_generation, generation);
+        uint64_t done = platform_time_ns();
+
+        FreezeStats *stats = &engine->stats;
+        int64_t jitter = woke > deadline ? (int64_t)(woke - deadline) : 0;
+        int64_t apply = (int64_t)(done - woke);
+        platform_atomic_add64(&stats->writes, (int64_t)tick.writes);
+        platform_atomic_add64(&stats->failed_writes, (int64_t)tick.failed_writes);
+        platform_atomic_add64(&stats->bytes_written, (int64_t)tick.bytes_written);
+        platform_atomic_store64(&stats->last_bytes_written, (int64_t)tick.bytes_written);
+        platform_atomic_add64(&stats->spans, (int64_t)tick.spans);
+        platform_atomic_add64(&stats->pointer_reads, (int64_t)tick.pointer_reads);
+        platform_atomic_add64(&stats->moved_nodes, (int64_t)tick.moved_nodes);
+        platform_atomic_store64(&stats->last_apply_ns, apply);
+        platform_atomic_add64(&stats->total_apply_ns, apply);
+        record_max(&stats->max_apply_ns, apply);
+        platform_atomic_store64(&stats->last_jitter_ns, jitter);
+        platform_atomic_add64(&stats->total_jitter_ns, jitter);
+        record_max(&stats->max_jitter_ns, jitter);
+        platform_atomic_add64(&stats->ticks, 1);
+
+        // A tick that overran the next one starts the schedule over instead of bursting to catch up
+        if (done > deadline + interval)
+            deadline = done;
+    }
+    freeze_tick_free(&tick);
+    platform_timer_destroy(&timer);
+}
+
+void freeze_engine_init(FreezeEngine *engine)
+{
+    memset(engine, 0, sizeof(FreezeEngine));
+    engine->interval_ns = (int64_t)FREEZE_DEFAULT_INTERVAL_MS * 1000000;
+    create_array(&engine->retired, 4, sizeof(RetiredPlan));
+}
+
+void freeze_engine_destroy(FreezeEngine *engine)
+{
+    freeze_engine_stop(engine);
+    freeze_engine_publish(engine, NULL);
+    free_array(&engine->retired);
+}
+
+bool freeze_engine_start(FreezeEngine *engine)
+{
+    if (platform_atomic_load64(&engine->running))
+        return true;
+
+    printf("[DEBUG] Starting freeze thread \n");
+    memset((void *)&engine->stats, 0, sizeof(FreezeStats));
+    platform_atomic_store64(&engine->running, 1);
+    if (!platform_thread_start(&engine->thread, freeze_thread_proc, engine))
+    {
+        fprintf(stderr, "[ERROR] Failed to start freeze thread\n");
+        platform_atomic_store64(&engine->running, 0);
+        return false;
+    }
+    return true;
+}
+
+void freeze_engine_stop(FreezeEngine *engine)
+{
+    if (!platform_atomic_load64(&engine->running))
+        return;
+
+    printf("[DEBUG] Stopping freeze thread \n");
+    platform_atomic_store64(&engine->running, 0);
+    platform_thread_join(&engine->thread);
+    freeze_engine_reclaim(engine);
+}
+
+bool freeze_engine_running(FreezeEngine *engine)
+{
+    return platform_atomic_load64(&engine->running) != 0;
+}
+
+void freeze_engine_set_interval(FreezeEngine *engine, uint32_t milliseconds)
+{
+    platform_atomic_store64(&engine->interval_ns, (int64_t)max(milliseconds, FREEZE_MIN_INTERVAL_MS) * 1000000);
+}
+
+void freeze_engine_set_mode(FreezeEngine *engine, bool conditional, uint32_t budget_us)
+{
+    platform_atomic_store64(&engine->conditional, conditional);
+    platform_atomic_store64(&engine->budget_ns, (int64_t)budget_us * 1000);
+}
+
+static void free_plan(FreezePlan *plan)
+{
+    freeze_plan_free(plan);
+    free(plan);
+}
+
+void freeze_engine_publish(FreezeEngine *engine, FreezePlan *plan)
+{
+    FreezePlan *previous = (FreezePlan *)platform_atomic_exchange_ptr((void *volatile *)&engine->plan, plan);
+    int64_t generation = platform_atomic_add64(&engine->generation, 1) + 1;
+
+    if (previous)
+    {
+        RetiredPlan retired = {previous, generation};
+        append(&engine->retired, &retired);
+    }
+    freeze_engine_reclaim(engine);
+}
+
+size_t freeze_engine_reclaim(FreezeEngine *engine)
+{
+    RetiredPlan *retired = (RetiredPlan *)engine->retired.data;
+    bool idle = !platform_atomic_load64(&engine->running);
+    int64_t quiescent = platform_atomic_load64(&engine->quiescent_generation);
+    size_t kept = 0;
+
+    // Stopping joins the thread, so when it does not run nothing can hold a plan
+    for (size_t i = 0; i < engine->retired.size; i++)
+    {
+        if (idle || quiescent >= retired[i].generation)
+            free_plan(retired[i].plan);
+        else
+            retired[kept++] = retired[i];
+    }
+    engine->retired.size = kept;
+    return kept;
+}
+
+void freeze_engine_read_stats(FreezeEngine *engine, FreezeStatsView *view)
+{
+    FreezeStats *stats = &engine->stats;
+    uint64_t ticks = (uint64_t)platform_atomic_load64(&stats->ticks);
+
+    view->ticks = ticks;
+    view->writes = (uint64_t)platform_atomic_load64(&stats->writes);
+    view->failed_writes = (uint64_t)platform_atomic_load64(&stats->failed_writes);
+    view->bytes_written = (uint64_t)platform_atomic_load64(&stats->bytes_written);
+    view->last_bytes_written = (uint64_t)platform_atomic_load64(&stats->last_bytes_written);
+    view->mean_bytes_written = ticks ? (double)view->bytes_written / ticks : 0.0;
+    view->spans = (uint64_t)platform_atomic_load64(&stats->spans);
+    view->mean_pointer_reads = ticks ? (double)platform_atomic_load64(&stats->pointer_reads) / ticks : 0.0;
+    view->moved_nodes = (uint64_t)platform_atomic_load64(&stats->moved_nodes);
+    view->last_apply_us = platform_atomic_load64(&stats->last_apply_ns) / 1e3;
+    view->mean_apply_us = ticks ? platform_atomic_load64(&stats->total_apply_ns) / 1e3 / ticks : 0.0;
+    view->max_apply_us = platform_atomic_load64(&stats->max_apply_ns) / 1e3;
+    view->last_jitter_us = platform_atomic_load64(&stats->last_jitter_ns) / 1e3;
+    view->mean_jitter_us = ticks ? platform_atomic_load64(&stats->total_jitter_ns) / 1e3 / ticks : 0.0;
+    view->max_jitter_us = platform_atomic_load64(&stats->max_jitter_ns) / 1e3;
+}
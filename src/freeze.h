@@ -0,0 +1,222 @@
+#ifndef FREEZE_H
+#define FREEZE_H
+
+#include "platform.h"
+#include "pointer_scan.h"
+
+#define FREEZE_DEFAULT_INTERVAL_MS 100
+#define FREEZE_MIN_INTERVAL_MS 1
+#define FREEZE_READ_GAP 256            // Spans closer than this are read together by conditional ticks
+#define FREEZE_WINDOW_MAX (64 * 1024)  // Largest read of a conditional tick
+
+// One write of a plan: size bytes at offset in the bytes of the plan, to address
+typedef struct
+{
+    uintptr_t address;
+    uint32_t size;
+    uint32_t offset;
+} FreezeWrite;
+
+// Consecutive spans of a plan read at once, from the address of the first to the end of the last
+typedef struct
+{
+    uintptr_t address;
+    uint32_t size;
+    uint32_t first_span;
+    uint32_t span_count;
+} FreezeWindow;
+
+// Pointer chain to a frozen value on an object that moves: read the pointer at base, add
+// offsets[0], read the pointer there ... until offsets[depth - 1] gives the address written
+typedef struct
+{
+    uintptr_t base;
+    uint32_t depth; // 0 for a fixed address, base
+    int32_t offsets[POINTER_MAX_DEPTH];
+} FreezeChain;
+
+// Chain of path, found in a process whose modules are modules, false when its module is not there
+bool freeze_chain_from_path(const DynamicArray *modules, const PointerPath *path, FreezeChain *chain);
+// Follows chain in the process as it is now, false when one of its pointers cannot be read
+bool freeze_chain_resolve(HANDLE process, const FreezeChain *chain, uintptr_t *address);
+
+#define FREEZE_NO_PARENT UINT32_MAX
+
+// Pointer read by the chains of a plan. Chains with the same base and first offsets share the
+// nodes of those offsets, so every pointer is read once per tick however many chains go through it.
+typedef struct
+{
+    uintptr_t base;  // Address read, at the first level
+    uint32_t parent; // Node whose pointer plus offset is read at the next ones, FREEZE_NO_PARENT at the first
+    int32_t offset;
+    uint32_t at;     // Where the pointer lands in the read buffer of a tick
+} FreezeNode;
+
+// Value written at the pointer read by node, plus offset. Targets of a node that touch or overlap
+// are merged like spans.
+typedef struct
+{
+    uint32_t node;  // Index in the chains of the plan until it is finished
+    int32_t offset;
+    uint32_t size;
+    uint32_t value; // Offset in the target bytes of the plan
+    uint32_t at;    // Where a conditional tick reads it in its read buffer
+} FreezeTarget;
+
+// One read of a tick over the nodes or targets below one pointer that lie close to each other, or
+// over the first-level nodes close to each other
+typedef struct
+{
+    uintptr_t start; // Address at the first level, else offset from the pointer of parent
+    uint32_t parent; // FREEZE_NO_PARENT at the first level
+    uint32_t size;
+    uint32_t at;     // In the read buffer of a tick
+    uint32_t first;  // First node or target read
+    uint32_t count;
+} FreezeChainRead;
+
+// Writes the freeze thread applies every tick, compiled once from the frozen entries so a tick
+// only copies bytes into the process. Entries are added in any order; finishing the plan sorts
+// them by address and merges adjacent and overlapping ones into spans (the last entry added wins
+// where they overlap), then groups spans into windows. Entries behind pointer chains become a
+// trie of nodes, level after level, and the targets its leaves lead to, both grouped into reads.
+typedef struct
+{
+    HANDLE process;
+    DynamicArray writes;  // FreezeWrite: the entries as added, then the spans
+    DynamicArray bytes;   // uint8_t, the values of every write back to back
+    DynamicArray windows; // FreezeWindow, once finished
+    size_t entry_count;
+
+    DynamicArray chains;       // FreezeChain, as added
+    DynamicArray nodes;        // FreezeNode, once finished
+    DynamicArray node_reads;   // FreezeChainRead, level after level
+    uint32_t level_end[POINTER_MAX_DEPTH]; // Node reads before the end of every level
+    uint32_t level_count;
+    DynamicArray targets;      // FreezeTarget: the entries as added, then merged in node and offset order
+    DynamicArray target_reads; // FreezeChainRead
+    DynamicArray target_bytes; // uint8_t
+    size_t read_bytes;         // Read buffer of a tick, node reads then target reads
+} FreezePlan;
+
+void freeze_plan_init(FreezePlan *plan, HANDLE process);
+void freeze_plan_add(FreezePlan *plan, uintptr_t address, const void *bytes, size_t size);
+void freeze_plan_add_chain(FreezePlan *plan, const FreezeChain *chain, const void *bytes, size_t size);
+void freeze_plan_finish(FreezePlan *plan);
+void freeze_plan_free(FreezePlan *plan);
+
+// How ticks apply a plan, and the state they carry from one to the next
+typedef struct
+{
+    bool conditional;   // Read the spans and only write the bytes that drifted from the plan
+    uint64_t budget_ns; // Time a tick may spend before it stops, 0 for the whole plan every tick
+    size_t cursor;      // Window the next tick starts at, when the last one ran out of budget
+    DynamicArray buffer;       // uint8_t, windows read by a conditional tick
+    DynamicArray read_batch;   // MemoryReadRequest
+    DynamicArray write_batch;  // MemoryWriteRequest
+
+    // Pointers last read at the nodes of the plan, 0 when they could not be read. Every tick
+    // reads all nodes at once from where their cached parents lead, and only reads again the nodes
+    // below a pointer that changed.
+    DynamicArray node_values;  // uintptr_t
+    DynamicArray node_changed; // uint8_t, set when the pointer of the node changed this tick
+
+    // What the last tick did
+    size_t spans;         // Spans checked or written
+    size_t writes;
+    size_t failed_writes; // Includes spans that could not be read and targets that could not be reached
+    size_t bytes_written;
+    size_t pointer_reads; // Reads of nodes, the first ones and those again below a pointer that changed
+    size_t moved_nodes;   // Nodes whose pointer changed
+} FreezeTick;
+
+void freeze_tick_init(FreezeTick *tick, bool conditional, uint64_t budget_ns);
+void freeze_tick_reset(FreezeTick *tick); // Forgets the cursor and cached pointers, before applying another plan
+void freeze_tick_free(FreezeTick *tick);
+// Applies finished plan with tick: every chain target, then from tick->cursor on within
+// tick->budget_ns, in batches of windows
+void freeze_plan_apply(const FreezePlan *plan, FreezeTick *tick);
+
+// Figures of the freeze thread since it started. Written by the freeze thread and read by anyone
+// without locking: every field is a 64-bit atomic updated on its own.
+typedef struct
+{
+    volatile int64_t ticks;
+    volatile int64_t writes;
+    volatile int64_t failed_writes;
+    volatile int64_t bytes_written;
+    volatile int64_t last_bytes_written; // By the last tick
+    volatile int64_t spans;
+    volatile int64_t pointer_reads;
+    volatile int64_t moved_nodes;
+    volatile int64_t last_apply_ns; // Time spent writing the plan
+    volatile int64_t max_apply_ns;
+    volatile int64_t total_apply_ns;
+    volatile int64_t last_jitter_ns; // How late the tick woke up after its deadline
+    volatile int64_t max_jitter_ns;
+    volatile int64_t total_jitter_ns;
+} FreezeStats;
+
+typedef struct
+{
+    uint64_t ticks;
+    uint64_t writes;
+    uint64_t failed_writes;
+    uint64_t bytes_written;
+    uint64_t last_bytes_written;
+    double mean_bytes_written; // Per tick
+    uint64_t spans;            // Checked or written since the start
+    double mean_pointer_reads; // Per tick
+    uint64_t moved_nodes;
+    double last_apply_us;
+    double mean_apply_us;
+    double max_apply_us;
+    double last_jitter_us;
+    double mean_jitter_us;
+    double max_jitter_us;
+} FreezeStatsView;
+
+// Plan replaced while the freeze thread may still be applying it
+typedef struct
+{
+    FreezePlan *plan;
+    int64_t generation; // Of the publication that replaced it
+} RetiredPlan;
+
+// Thread applying the published plan at a fixed rate. Ticks are scheduled on absolute deadlines
+// and waited for on the high resolution timer, so the rate does not drift with the time spent
+// writing; ticks missed by more than an interval are dropped, not caught up. A tick over budget
+// leaves the rest of the plan to the next ones.
+//
+// Plans are published read-copy-update style: the freeze thread never locks, it loads the current
+// plan at the start of a tick and tells once the tick is over which generation it began at. A
+// replaced plan is freed by a later publication (or freeze_engine_reclaim) once the thread finished
+// a tick begun after the replacement, or right away when the thread is not running. Publishing,
+// reclaiming, starting and stopping must all happen on one thread.
+typedef struct
+{
+    PlatformThread thread;
+    volatile int64_t running;
+    volatile int64_t interval_ns;
+    volatile int64_t conditional;
+    volatile int64_t budget_ns;
+    FreezePlan *volatile plan;             // NULL when nothing is frozen
+    volatile int64_t generation;           // Publications so far
+    volatile int64_t quiescent_generation; // Generation the freeze thread began its last finished tick at
+    DynamicArray retired;                  // RetiredPlan, only touched by the publishing thread
+    FreezeStats stats;
+} FreezeEngine;
+
+void freeze_engine_init(FreezeEngine *engine);
+void freeze_engine_destroy(FreezeEngine *engine); // Stops the thread and frees the plan
+bool freeze_engine_start(FreezeEngine *engine);   // Clears the stats, does nothing when it runs already
+void freeze_engine_stop(FreezeEngine *engine);
+bool freeze_engine_running(FreezeEngine *engine);
+void freeze_engine_set_interval(FreezeEngine *engine, uint32_t milliseconds); // From the next tick, at least FREEZE_MIN_INTERVAL_MS
+void freeze_engine_set_mode(FreezeEngine *engine, bool conditional, uint32_t budget_us); // From the next tick, budget 0 for none
+// Replaces the plan with plan (finished, allocated with malloc, NULL for none), which the engine then owns
+void freeze_engine_publish(FreezeEngine *engine, FreezePlan *plan);
+size_t freeze_engine_reclaim(FreezeEngine *engine); // Frees the replaced plans no longer in use, returns how many are left
+void freeze_engine_read_stats(FreezeEngine *engine, FreezeStatsView *view);
+
+#endif
@@ -137,6 +137,33 @@ bool check_freeze(const SelectionTable *s_table)
     return false;
 }
 
+// The scan thread and the freeze thread work through current_process_handle: both let go of it,
+// and the freeze plan compiled against it is withdrawn, before it is closed or replaced
+void release_current_process()
+{
+    cancel_scan_thread();
+    wait_scan_thread();
+    stop_freeze_thread();
+    freeze_engine_publish(&freeze_engine, NULL);
+}
+
+// Freezes the selection again once released is open again (it failed to be replaced). The addresses
+// of the selection mean nothing in another process: there nothing stays frozen.
+void resume_freeze(const ProcessInfo *released)
+{
+    if (current_process.pid != released->pid || current_process.start_time != released->start_time)
+    {
+        for (size_t i = 0; i < selection_table.selection_count; i++)
+            selection_table.selection[i].freeze = false;
+        return;
+    }
+    if (current_process_handle && check_freeze(&selection_table))
+    {
+        update_freeze_plan(current_process_handle);
+        start_freeze_thread();
+    }
+}
+
 /* GUI Functions Declarations */
 void show_menubar(struct nk_context *ctx);
 void show_combobox(struct nk_context *ctx);
@@ -161,11 +188,18 @@ void show_menubar(struct nk_context *ctx)
         {
             show_processes_list = 1;
         }
-        if (nk_menu_item_label(ctx, "Close current", NK_TEXT_LEFT))
+        // A running scan reads through the current handle: it is cancelled or waited for first
+        bool scanning = scan_thread_running();
+        if (scanning)
+            nk_widget_disable_begin(ctx);
+        if (nk_menu_item_label(ctx, "Close current", NK_TEXT_LEFT) && !scanning)
         {
-            strcpy_s(current_process_name, sizeof(MAX_NAME_LEN), "");
-            selected_process = -1;
+            strcpy_s(current_process_name, MAX_NAME_LEN, "");
+            release_current_process();
+            close_current_process();
         }
+        if (scanning)
+            nk_widget_disable_end(ctx);
         nk_menu_end(ctx);
     }
 
@@ -197,14 +231,70 @@ void show_combobox(struct nk_context *ctx)
 
     // Scan Type Combobox
     static const char *scan_types[] = {"Exact Value", "Bigger than...", "Smaller than...",
-                                       "Value between...", "Unknown initial value"};
+                                       "Value between...", "Unknown initial value", "Changed value",
+                                       "Unchanged value", "Increased value", "Decreased value",
+                                       "Increased value by...", "Decreased value by..."};
     selected_scan_type = nk_combo(ctx, scan_types, NK_LEN(scan_types), selected_scan_type, 25,
                                   nk_vec2(200, 200));
 
-    // Value Type Combobox
-    static const char *value_types[] = {"Byte", "2 bytes", "4 bytes", "8 bytes"};
-    selected_value_type = nk_combo(ctx, value_types, NK_LEN(value_types), selected_value_type, 25,
-                                   nk_vec2(200, 150));
+    // Value Type Combobox: the integer widths take their signedness and byte order from the checkboxes,
+    // strings their encoding and case sensitivity
+    static const char *value_types[] = {"Byte", "2 bytes", "4 bytes", "8 bytes", "Float", "Double", "String", "Signature", "Group"};
+    static const int string_kind = 6;
+    static const int signature_kind = 7;
+    static const int group_kind = 8;
+    static int value_kind = VALUE_4BYTES;
+    static nk_bool value_signed = nk_false;
+    static nk_bool value_big_endian = nk_false;
+    static nk_bool string_utf16 = nk_false;
+    static nk_bool string_case_sensitive = nk_true;
+    value_kind = nk_combo(ctx, value_types, NK_LEN(value_types), value_kind, 25, nk_vec2(200, 200));
+
+    if (value_kind <= VALUE_8BYTES)
+    {
+        nk_checkbox_label(ctx, "Signed", &value_signed);
+        if (value_kind != VALUE_BYTE)
+            nk_checkbox_label(ctx, "Big-endian", &value_big_endian);
+        selected_value_type = get_integer_value_type((size_t)1 << value_kind, value_signed, value_big_endian);
+    }
+    else if (value_kind == string_kind)
+    {
+        nk_checkbox_label(ctx, "UTF-16", &string_utf16);
+        nk_checkbox_label(ctx, "Case sensitive", &string_case_sensitive);
+        selected_value_type = get_string_value_type(string_utf16, string_case_sensitive);
+    }
+    else if (value_kind == signature_kind)
+    {
+        // A unique signature is resolved as soon as it is found
+        nk_bool first_only = scan_stop_at_first_match;
+        nk_checkbox_label(ctx, "First match only", &first_only);
+        scan_stop_at_first_match = first_only;
+        selected_value_type = VALUE_SIGNATURE;
+    }
+    else if (value_kind == group_kind)
+    {
+        // Typed as "4:100 4:100@4 2:12 w:64": size:value fields, @offset from the first one or anywhere in the window
+        nk_label(ctx, "size:value[@offset] w:window", NK_TEXT_LEFT);
+        selected_value_type = VALUE_GROUP;
+    }
+    else
+        selected_value_type = value_kind;
+
+    if (value_kind != signature_kind)
+        scan_stop_at_first_match = false;
+
+    // How a typed float or double matches the values in memory
+    if (selected_value_type == VALUE_FLOAT || selected_value_type == VALUE_DOUBLE)
+    {
+        static const char *float_modes[] = {"Exact", "Rounded", "Truncated", "Epsilon"};
+        selected_float_mode = nk_combo(ctx, float_modes, NK_LEN(float_modes), selected_float_mode, 25,
+                                       nk_vec2(200, 150));
+        if (selected_float_mode == FLOAT_COMPARE_EPSILON)
+        {
+            nk_edit_string(ctx, NK_EDIT_FIELD, search_epsilon, &search_epsilon_len, MAX_NAME_LEN - 1, nk_filter_float);
+            search_epsilon[search_epsilon_len] = '\0';
+        }
+    }
 
     if (width >= 825)
     {
@@ -212,24 +302,88 @@ void show_combobox(struct nk_context *ctx)
     }
 
     // Value text input
-    nk_edit_string(ctx, NK_EDIT_FIELD, search_value, &search_value_len, MAX_NAME_LEN, nk_filter_ascii);
+    nk_edit_string(ctx, NK_EDIT_FIELD, search_value, &search_value_len, MAX_NAME_LEN - 1,
+                   is_string_type(selected_value_type) ? nk_filter_default : nk_filter_ascii);
+    search_value[search_value_len] = '\0';
+
+    // Upper bound text input for range scans
+    if (selected_scan_type == SCAN_VALUE_BETWEEN)
+    {
+        nk_edit_string(ctx, NK_EDIT_FIELD, search_upper_value, &search_upper_value_len, MAX_NAME_LEN - 1, nk_filter_ascii);
+        search_upper_value[search_upper_value_len] = '\0';
+    }
+
+    // A running scan owns the results: show its progress and let it be cancelled instead
+    if (scan_thread_running())
+    {
+        ScanProgressView progress;
+        char progress_str[160];
+
+        scan_progress_read(&scan_progress, &progress);
+        if (progress.regions_total > 0)
+            snprintf(progress_str, sizeof(progress_str), "%.0f%% - %llu/%llu regions, %llu matches, %.0f MB/s, ETA %.0f s",
+                     progress.fraction * 100, (unsigned long long)progress.regions_done, (unsigned long long)progress.regions_total,
+                     (unsigned long long)progress.matches, progress.throughput / 1e6, max(progress.eta, 0.0));
+        else
+            snprintf(progress_str, sizeof(progress_str), "%.0f%% - %llu matches, %.0f MB/s, ETA %.0f s", progress.fraction * 100,
+                     (unsigned long long)progress.matches, progress.throughput / 1e6, max(progress.eta, 0.0));
+
+        if (nk_button_label(ctx, "Cancel"))
+            cancel_scan_thread();
+        nk_label(ctx, progress_str, NK_TEXT_LEFT);
+        return;
+    }
 
     // Buttons for scan operations
     if (nk_button_label(ctx, "Scan"))
     {
-        if (selected_process >= 0 && strlen(search_value) > 0)
-        {
-            HANDLE process_handle = processes[selected_process].handle;
-            start_memory_scan(process_handle, &results_table);
-        }
+        if (current_process_handle && (strlen(search_value) > 0 || !scan_type_needs_value(selected_scan_type)))
+            start_memory_scan(current_process_handle, &results_table);
     }
     if (nk_button_label(ctx, "Next Scan"))
     {
-        if (selected_process >= 0 && strlen(search_value) > 0)
-        {
-            HANDLE process_handle = processes[selected_process].handle;
-            refine_memory_scan(process_handle, &results_table);
-        }
+        if (current_process_handle && (strlen(search_value) > 0 || !scan_type_needs_value(selected_scan_type)))
+            refine_memory_scan(current_process_handle, &results_table);
+    }
+
+    // Regions read by the next first scan (the filter is only read by the scan thread while it runs)
+    nk_bool writable_only = scan_region_filter.writable_only;
+    nk_bool exclude_executable = scan_region_filter.exclude_executable;
+    nk_bool code_only = scan_region_filter.executable_only;
+    nk_checkbox_label(ctx, "Writable only", &writable_only);
+    nk_checkbox_label(ctx, "Skip executable", &exclude_executable);
+    nk_checkbox_label(ctx, "Code only", &code_only);
+    scan_region_filter.writable_only = writable_only;
+    scan_region_filter.exclude_executable = exclude_executable;
+    scan_region_filter.executable_only = code_only;
+    scan_region_filter.types = code_only ? REGION_TYPE_BIT(REGION_IMAGE) : REGION_TYPES_ALL; // Executable images
+
+    if (platform_atomic_load64(&scan_progress.state) == SCAN_STATE_CANCELLED)
+        nk_label(ctx, "Last scan cancelled", NK_TEXT_LEFT);
+
+    // Memory held by an unknown initial value scan until its candidates fit in a list
+    if (scan_snapshot.active)
+    {
+        char snapshot_str[96];
+        snprintf(snapshot_str, sizeof(snapshot_str), "Snapshot: %llu candidates, %.1f MiB",
+                 (unsigned long long)scan_snapshot.candidate_count, snapshot_footprint(&scan_snapshot) / (1024.0 * 1024.0));
+        nk_label(ctx, snapshot_str, NK_TEXT_LEFT);
+    }
+
+    // Results beyond the table capacity are shown one page at a time
+    if (!scan_snapshot.active && scan_results.count > MAX_RESULTS && current_process_handle)
+    {
+        HANDLE process_handle = current_process_handle;
+        char page_str[96];
+
+        if (nk_button_label(ctx, "Previous page") && results_first_row > 0)
+            show_results_page(process_handle, &results_table, results_first_row - min(results_first_row, MAX_RESULTS));
+        if (nk_button_label(ctx, "Next page") && results_first_row + MAX_RESULTS < scan_results.count)
+            show_results_page(process_handle, &results_table, results_first_row + MAX_RESULTS);
+
+        snprintf(page_str, sizeof(page_str), "Results %llu-%llu of %llu", (unsigned long long)results_first_row + 1,
+                 (unsigned long long)min(results_first_row + MAX_RESULTS, scan_results.count), (unsigned long long)scan_results.count);
+        nk_label(ctx, page_str, NK_TEXT_LEFT);
     }
 }
 
@@ -351,21 +505,11 @@ void show_tables(struct nk_context *ctx, ResultsTable *r_table, SelectionTable *
 
                 if (nk_menu_item_label(ctx, "Add to Selection", NK_TEXT_LEFT))
                 {
-                    if (context_menu_row < r_table->result_count && s_table->selection_count < s_table->selection_capacity)
+                    // The entry keeps the type the row was scanned as, whatever the combo box says later
+                    if (context_menu_row < r_table->result_count)
                     {
-                        SelectionEntry entry = {
-                            .address = r_table->results[context_menu_row].address,
-                            .freeze = false,
-                            .value = r_table->results[context_menu_row].value ? strdup(r_table->results[context_menu_row].value) : strdup(""),
-                        };
-
-                        entry.length = strlen(entry.value);
-
-                        if (entry.value)
-                        {
-                            s_table->selection[s_table->selection_count] = entry;
-                            s_table->selection_count++;
-                        }
+                        const ResultEntry *result = &r_table->results[context_menu_row];
+                        add_selection_value(s_table, result->address, NULL, result->type, result->value);
                     }
 
                     context_menu_row = -1;
@@ -380,10 +524,37 @@ void show_tables(struct nk_context *ctx, ResultsTable *r_table, SelectionTable *
         }
     }
 
-    // Editable table for selected addresses
+    // Editable table for selected addresses. The freeze thread never reads the table: frozen entries
+    // are compiled into a new plan once per frame when any of them changed, however many rows did,
+    // and published to the thread without locking.
+    static int freeze_interval_ms = FREEZE_DEFAULT_INTERVAL_MS;
+    static int freeze_budget_us = 0;
+    static nk_bool freeze_only_drifted = nk_false;
+    bool freeze_changed = false;
     nk_layout_row_dynamic(ctx, 200, 1);
     if (nk_group_begin(ctx, "Selected Addresses", NK_WINDOW_BORDER | NK_WINDOW_TITLE))
     {
+        // Large freeze lists: write only what drifted, and spread a pass over ticks of a bounded time
+        nk_layout_row_dynamic(ctx, 25, 4);
+        nk_property_int(ctx, "Freeze every (ms)", FREEZE_MIN_INTERVAL_MS, &freeze_interval_ms, 1000, 1, 1);
+        nk_property_int(ctx, "Budget (us, 0: none)", 0, &freeze_budget_us, 100000, 100, 10);
+        nk_checkbox_label(ctx, "Only drifted", &freeze_only_drifted);
+        freeze_engine_set_interval(&freeze_engine, (uint32_t)freeze_interval_ms);
+        freeze_engine_set_mode(&freeze_engine, freeze_only_drifted, (uint32_t)freeze_budget_us);
+        if (freeze_engine_running(&freeze_engine))
+        {
+            FreezeStatsView stats;
+            char stats_str[192];
+            freeze_engine_read_stats(&freeze_engine, &stats);
+            snprintf(stats_str, sizeof(stats_str),
+                     "%llu ticks, write %.0f us (max %.0f), late %.0f us (max %.0f), %.0f B/tick, %.0f pointer reads/tick, %llu failed",
+                     (unsigned long long)stats.ticks, stats.mean_apply_us, stats.max_apply_us, stats.mean_jitter_us, stats.max_jitter_us,
+                     stats.mean_bytes_written, stats.mean_pointer_reads, (unsigned long long)stats.failed_writes);
+            nk_label(ctx, stats_str, NK_TEXT_LEFT);
+        }
+        else
+            nk_label(ctx, "Nothing frozen", NK_TEXT_LEFT);
+
         nk_layout_row_dynamic(ctx, 25, 3);
         nk_label(ctx, "Address", NK_TEXT_CENTERED);
         nk_label(ctx, "Value", NK_TEXT_CENTERED);
@@ -394,9 +565,9 @@ void show_tables(struct nk_context *ctx, ResultsTable *r_table, SelectionTable *
             SelectionEntry *entry = &s_table->selection[i];
             nk_layout_row_dynamic(ctx, 25, 3);
 
-            // Memory address
-            char addr_str[20];
-            snprintf(addr_str, sizeof(addr_str), "0x%p", entry->address);
+            // Memory address, where its pointer chain last led for an entry that follows one
+            char addr_str[32];
+            snprintf(addr_str, sizeof(addr_str), entry->chain ? "P-> 0x%p" : "0x%p", entry->address);
             nk_label(ctx, addr_str, NK_TEXT_CENTERED);
 
             // Editable Value
@@ -406,24 +577,26 @@ void show_tables(struct nk_context *ctx, ResultsTable *r_table, SelectionTable *
             if (enter_key_pressed && (result & NK_EDIT_ACTIVE))
             {
                 printf("Row %d text changed to: '%s' (Length: %d)\n", i, entry->value, entry->length);
-                HANDLE process_handle = processes[selected_process].handle;
-                change_process_memory(process_handle, entry->address, entry->value, selected_value_type);
+                write_selection_entry(current_process_handle, entry);
+                freeze_changed = freeze_changed || entry->freeze;
             }
 
             // Freeze Checkbox
-            nk_checkbox_label_align(ctx, "", &entry->freeze, NK_WIDGET_CENTERED, NK_TEXT_CENTERED);
-
-            if (entry->freeze)
-            {
-                start_freeze_thread();
-            }
-            else if (check_freeze(&s_table) == false)
-            {
-                stop_freeze_thread();
-            }
+            if (nk_checkbox_label_align(ctx, "", &entry->freeze, NK_WIDGET_CENTERED, NK_TEXT_CENTERED))
+                freeze_changed = true;
         }
         nk_group_end(ctx);
     }
+
+    freeze_engine_reclaim(&freeze_engine);
+    if (freeze_changed && current_process_handle)
+    {
+        update_freeze_plan(current_process_handle);
+        if (check_freeze(s_table))
+            start_freeze_thread();
+        else
+            stop_freeze_thread();
+    }
 }
 
 void show_processes_selector(struct nk_context *ctx)
@@ -433,7 +606,11 @@ void show_processes_selector(struct nk_context *ctx)
         if (nk_popup_begin(ctx, NK_POPUP_STATIC, "Processes Selector", NK_WINDOW_CLOSABLE,
                            nk_rect(modal_x, modal_y, modal_width, modal_height)))
         {
-            get_running_processes();
+            // The catalog thread refreshes the list while the popup is open, the frame only copies it
+            // when it changed. The chosen process is kept by pid and start time across refreshes.
+            static ProcessInfo chosen;
+            process_catalog_start(&process_catalog, CATALOG_REFRESH_MS);
+            process_catalog_poll(&process_catalog, &process_list, &process_list_version);
 
             // Dynamic Process List
             nk_layout_row_dynamic(ctx, modal_height - (height / 6), 1);
@@ -441,34 +618,48 @@ void show_processes_selector(struct nk_context *ctx)
             // Flexible layout for the list
             if (nk_group_begin(ctx, "Process List", NK_WINDOW_BORDER))
             {
-                for (int i = 0; i < process_count; ++i)
+                for (size_t i = 0; i < process_list.size; ++i)
                 {
+                    const ProcessInfo *info = (const ProcessInfo *)process_list.data + i;
+                    char label[MAX_NAME_LEN + 16];
+                    snprintf(label, sizeof(label), "%s (%u)", info->name, info->pid);
                     nk_layout_row_dynamic(ctx, 30, 1);
-                    if (nk_select_label(ctx, processes[i].name, NK_TEXT_LEFT, selected_process == i))
+                    if (nk_select_label(ctx, label, NK_TEXT_LEFT, chosen.pid == info->pid && chosen.start_time == info->start_time))
                     {
-                        selected_process = i;
+                        chosen = *info;
                     }
                 }
                 nk_group_end(ctx);
             }
 
-            // "Open" Button
+            // "Open" Button: the only handle opened is the one to the chosen process, not while a
+            // scan reads through the current one
             nk_layout_row_dynamic(ctx, 30, 1);
-            if (nk_button_label(ctx, "Open"))
+            bool scanning = scan_thread_running();
+            if (scanning)
+                nk_widget_disable_begin(ctx);
+            if (nk_button_label(ctx, "Open") && !scanning)
             {
-                if (selected_process >= 0)
+                ProcessInfo released = current_process;
+                release_current_process();
+                if (chosen.pid != 0 && open_current_process(&chosen))
                 {
-                    strncpy_s(current_process_name, MAX_NAME_LEN, processes[selected_process].name, _TRUNCATE);
+                    strncpy_s(current_process_name, MAX_NAME_LEN, current_process.name, _TRUNCATE);
                 }
+                resume_freeze(&released);
                 show_processes_list = 0;
+                process_catalog_stop(&process_catalog);
                 nk_popup_close(ctx);
             }
+            if (scanning)
+                nk_widget_disable_end(ctx);
 
             nk_popup_end(ctx);
         }
         else
         {
             show_processes_list = 0; // Hide modal
+            process_catalog_stop(&process_catalog);
         }
     }
 }
@@ -570,9 +761,13 @@ int main(void)
     show_processes_list = 0;
     current_process_name = malloc(MAX_NAME_LEN);
 
-    create_array(&memory_addresses, 100000, sizeof(LPVOID));
+    result_set_init(&scan_results, 1);
+    region_filter_init(&scan_region_filter);
+    calibrate_chunk_size();
     init_selection_table(&selection_table);
     init_results_table(&results_table);
+    init_process_list();
+    freeze_engine_init(&freeze_engine);
 
     bg.r = 0.10f, bg.g = 0.18f, bg.b = 0.24f, bg.a = 1.0f;
     while (running)
@@ -601,6 +796,9 @@ int main(void)
         modal_x = (width - modal_width) / 2;
         modal_y = (height - modal_height) / 2;
 
+        /* Results of a background scan that just ended */
+        poll_memory_scan(&results_table);
+
         /* GUI */
         if (nk_begin(ctx, "Shadow Engine", nk_rect(0, 0, (float)width, (float)height),
                      NK_WINDOW_BORDER | NK_WINDOW_NO_SCROLLBAR))
@@ -632,7 +830,14 @@ int main(void)
     }
 
     free(current_process_name);
-    free_array(&memory_addresses);
+    freeze_engine_destroy(&freeze_engine);
+    cancel_scan_thread();
+    wait_scan_thread();
+    shutdown_scan_workers();
+    result_set_free(&scan_results);
+    region_filter_free(&scan_region_filter);
+    free_array(&memory_values);
+    snapshot_free(&scan_snapshot);
     clear_results_table(&results_table);
     clear_selection_table(&selection_table);
     free(results_table.results);
@@ -1,57 +1,49 @@
-#include "memory.h"
+#include <errno.h>
+#include <math.h>
 
-DynamicArray memory_addresses;
+#include "memory.h"
+#include "buffer_pool.h"
+#include "read_ahead.h"
+#include "scan_kernels.h"
+#include "result_stream.h"
+#include "signature_set.h"
+#include "thread_pool.h"
+
+ResultSet scan_results;
+DynamicArray memory_values;
+MemorySnapshot scan_snapshot;
+ScanProgress scan_progress;
+RegionFilter scan_region_filter;
 ResultsTable results_table;
 SelectionTable selection_table;
 
 char previous_search_value[MAX_NAME_LEN] = "N/A";
 char search_value[MAX_NAME_LEN] = {0};
 int search_value_len = 0;
+char search_upper_value[MAX_NAME_LEN] = {0};
+int search_upper_value_len = 0;
 int selected_value_type = VALUE_4BYTES;
+int selected_float_mode = FLOAT_COMPARE_ROUNDED;
+char search_epsilon[MAX_NAME_LEN] = "0.001";
+int search_epsilon_len = 5;
 int selected_scan_type = SCAN_EXACT_VALUE;
+int scan_thread_count = 0;
+bool scan_stop_at_first_match = false;
+size_t scan_chunk_size = CHUNK_SIZE;
+uint64_t results_first_row = 0;
 
-volatile bool freeze_thread_running = false;
-
-DWORD WINAPI freeze_thread_proc(LPVOID param)
-{
-    while (freeze_thread_running)
-    {
-        for (size_t i = 0; i < selection_table.selection_count; i++)
-        {
-            SelectionEntry *entry = &selection_table.selection[i];
-            if (entry->freeze)
-            {
-                HANDLE process_handle = processes[selected_process].handle;
-                change_process_memory(process_handle, entry->address, entry->value, selected_value_type);
-            }
-        }
-        Sleep(100); // Freeze every 100 ms
-    }
-    return 0;
-}
+static ValueType memory_value_type = VALUE_4BYTES; // Type of the values recorded in memory_values and scan_snapshot
 
-HANDLE freeze_thread_handle = NULL;
+FreezeEngine freeze_engine;
 
 void start_freeze_thread()
 {
-    if (!freeze_thread_running)
-    {
-        printf("[DEBUG] Starting freeze thread \n");
-        freeze_thread_running = true;
-        freeze_thread_handle = CreateThread(NULL, 0, freeze_thread_proc, NULL, 0, NULL);
-    }
+    freeze_engine_start(&freeze_engine);
 }
 
 void stop_freeze_thread()
 {
-    if (freeze_thread_running)
-    {
-        printf("[DEBUG] Stopping freeze thread \n");
-        freeze_thread_running = false;
-        WaitForSingleObject(freeze_thread_handle, INFINITE);
-        CloseHandle(freeze_thread_handle);
-        freeze_thread_handle = NULL;
-    }
+    freeze_engine_stop(&freeze_engine);
 }
 
 void init_results_table(ResultsTable *table)
@@ -93,383 +85,2123 @@ void init_selection_table(SelectionTable *table)
     table->selection = malloc(table->selection_capacity * sizeof(SelectionEntry));
 }
 
+void add_selection_entry(SelectionTable *table, const SelectionEntry *entry)
+{
+    if (table->selection_count == table->selection_capacity)
+    {
+        size_t capacity = max(table->selection_capacity * 2, (size_t)MAX_RESULTS);
+        SelectionEntry *selection = realloc(table->selection, capacity * sizeof(SelectionEntry));
+        if (!selection)
+        {
+            perror("Failed to grow the selection table");
+            exit(EXIT_FAILURE);
+        }
+        table->selection = selection;
+        table->selection_capacity = capacity;
+    }
+    table->selection[table->selection_count++] = *entry;
+}
+
+bool add_selection_value(SelectionTable *table, void *address, const FreezeChain *chain, ValueType type, const char *value)
+{
+    // The value is edited in place, so it gets the whole buffer the edit box may fill
+    SelectionEntry entry = {address, calloc(MAX_NAME_LEN, 1), 0, false, type, NULL};
+    if (chain)
+        entry.chain = malloc(sizeof(FreezeChain));
+    if (!entry.value || (chain && !entry.chain))
+    {
+        free(entry.value);
+        free(entry.chain);
+        return false;
+    }
+
+    strncpy_s(entry.value, MAX_NAME_LEN, value ? value : "", _TRUNCATE);
+    entry.length = (int)strlen(entry.value);
+    if (chain)
+        *entry.chain = *chain;
+    add_selection_entry(table, &entry);
+    return true;
+}
+
 void clear_selection_table(SelectionTable *table)
 {
     for (size_t i = 0; i < table->selection_count; i++)
     {
         free(table->selection[i].value);
+        free(table->selection[i].chain);
         table->selection[i].value = NULL;
+        table->selection[i].chain = NULL;
         table->selection[i].length = 0;
     }
     table->selection_count = 0;
 }
 
-void format_value(const void *value, size_t size, char *output, size_t output_size)
+// Width and interpretation of every ValueType, indexed by type
+typedef struct
 {
-    const unsigned char *bytes = (const unsigned char *)value;
+    size_t size; // 0 for strings, signatures and groups, whose size is the length of the searched pattern or group
+    ScanNumber number;
+    bool string;
+    bool utf16;
+    bool case_sensitive;
+    bool signature;
+    bool group;
+} ValueTypeInfo;
+
+static const ValueTypeInfo value_type_info[VALUE_TYPE_COUNT] = {
+    [VALUE_BYTE] = {1, SCAN_NUMBER_UNSIGNED},
+    [VALUE_2BYTES] = {2, SCAN_NUMBER_UNSIGNED},
+    [VALUE_4BYTES] = {4, SCAN_NUMBER_UNSIGNED},
+    [VALUE_8BYTES] = {8, SCAN_NUMBER_UNSIGNED},
+    [VALUE_FLOAT] = {4, SCAN_NUMBER_FLOAT},
+    [VALUE_DOUBLE] = {8, SCAN_NUMBER_FLOAT},
+    [VALUE_BYTE_SIGNED] = {1, SCAN_NUMBER_SIGNED},
+    [VALUE_2BYTES_SIGNED] = {2, SCAN_NUMBER_SIGNED},
+    [VALUE_4BYTES_SIGNED] = {4, SCAN_NUMBER_SIGNED},
+    [VALUE_8BYTES_SIGNED] = {8, SCAN_NUMBER_SIGNED},
+    [VALUE_2BYTES_BE] = {2, SCAN_NUMBER_UNSIGNED_BE},
+    [VALUE_4BYTES_BE] = {4, SCAN_NUMBER_UNSIGNED_BE},
+    [VALUE_8BYTES_BE] = {8, SCAN_NUMBER_UNSIGNED_BE},
+    [VALUE_2BYTES_SIGNED_BE] = {2, SCAN_NUMBER_SIGNED_BE},
+    [VALUE_4BYTES_SIGNED_BE] = {4, SCAN_NUMBER_SIGNED_BE},
+    [VALUE_8BYTES_SIGNED_BE] = {8, SCAN_NUMBER_SIGNED_BE},
+    [VALUE_STRING] = {0, SCAN_NUMBER_UNSIGNED, true, false, true},
+    [VALUE_STRING_NOCASE] = {0, SCAN_NUMBER_UNSIGNED, true, false, false},
+    [VALUE_STRING_UTF16] = {0, SCAN_NUMBER_UNSIGNED, true, true, true},
+    [VALUE_STRING_UTF16_NOCASE] = {0, SCAN_NUMBER_UNSIGNED, true, true, false},
+    [VALUE_SIGNATURE] = {0, SCAN_NUMBER_UNSIGNED, .signature = true},
+    [VALUE_GROUP] = {0, SCAN_NUMBER_UNSIGNED, .group = true},
+};
+
+static bool is_signed_type(ValueType type)
+{
+    ScanNumber number = value_type_info[type].number;
+    return number == SCAN_NUMBER_SIGNED || number == SCAN_NUMBER_SIGNED_BE;
+}
+
+static bool is_big_endian_type(ValueType type)
+{
+    ScanNumber number = value_type_info[type].number;
+    return number == SCAN_NUMBER_UNSIGNED_BE || number == SCAN_NUMBER_SIGNED_BE;
+}
 
+// Integer bytes as stored in memory <-> the host value, both ways
+static uint64_t swap_integer(uint64_t value, size_t size)
+{
     switch (size)
     {
-    case 1:
-        snprintf(output, output_size, "%u", *(uint8_t *)bytes);
-        break;
     case 2:
-        snprintf(output, output_size, "%u", *(uint16_t *)bytes);
-        break;
+        return platform_bswap16((uint16_t)value);
     case 4:
-        snprintf(output, output_size, "%u", *(uint32_t *)bytes);
-        break;
+        return platform_bswap32((uint32_t)value);
     case 8:
-        snprintf(output, output_size, "%llu", *(uint64_t *)bytes);
-        break;
+        return platform_bswap64(value);
     default:
-        strncpy_s(output, output_size, "???", 4);
+        return value;
     }
 }
 
-bool scan_process_memory(HANDLE process_handle, LPCVOID target_value, SIZE_T value_size)
+ValueType get_integer_value_type(size_t value_size, bool is_signed, bool big_endian)
 {
-    printf("[DEBUG] Starting memory scan for value size: %zu bytes\n", value_size);
+    ScanNumber number = is_signed ? (big_endian ? SCAN_NUMBER_SIGNED_BE : SCAN_NUMBER_SIGNED)
+                                  : (big_endian ? SCAN_NUMBER_UNSIGNED_BE : SCAN_NUMBER_UNSIGNED);
+    if (value_size == 1)
+        number = is_signed ? SCAN_NUMBER_SIGNED : SCAN_NUMBER_UNSIGNED;
 
-    // Parameter validation
-    if (process_handle == NULL || process_handle == INVALID_HANDLE_VALUE)
+    for (int type = 0; type < VALUE_TYPE_COUNT; type++)
     {
-        const char *handle_state = process_handle == NULL ? "NULL" : "INVALID_HANDLE_VALUE";
-        fprintf(stderr, "[ERROR] Invalid process handle (%s)\n", handle_state);
-        return false;
+        if (value_type_info[type].size == value_size && value_type_info[type].number == number)
+            return (ValueType)type;
     }
+    return VALUE_4BYTES;
+}
 
-    if (target_value == NULL)
-    {
-        fprintf(stderr, "[ERROR] Target value pointer is NULL\n");
-        return false;
-    }
+ValueType get_string_value_type(bool utf16, bool case_sensitive)
+{
+    if (utf16)
+        return case_sensitive ? VALUE_STRING_UTF16 : VALUE_STRING_UTF16_NOCASE;
+    return case_sensitive ? VALUE_STRING : VALUE_STRING_NOCASE;
+}
 
-    if (value_size == 0 || value_size > 8)
-    {
-        fprintf(stderr, "[ERROR] Invalid value size: %zu (must be 1-8 bytes)\n", value_size);
-        return false;
-    }
+bool is_string_type(int type)
+{
+    return type >= 0 && type < VALUE_TYPE_COUNT && value_type_info[type].string;
+}
 
-    MEMORY_BASIC_INFORMATION mbi;
-    LPVOID current_address = 0;
-    SIZE_T total_regions = 0;
-    SIZE_T scanned_chunks = 0;
-    SIZE_T read_errors = 0;
-    SIZE_T matches_found = 0;
-    SIZE_T skipped_regions = 0;
-    SIZE_T partial_reads = 0;
+bool is_text_target_type(int type)
+{
+    return is_string_type(type) ||
+           (type >= 0 && type < VALUE_TYPE_COUNT && (value_type_info[type].signature || value_type_info[type].group));
+}
 
-    printf("[DEBUG] Beginning memory enumeration...\n");
+// Byte pattern searched for the text typed as a string or signature
+static bool text_pattern_for_type(BytePattern *pattern, const char *text, ValueType type)
+{
+    if (type == VALUE_SIGNATURE)
+        return signature_pattern_init(pattern, text);
+    return is_string_type(type) && string_pattern_init(pattern, text, value_type_info[type].utf16, value_type_info[type].case_sensitive);
+}
 
-    while (1)
+void format_value(const void *value, ValueType type, char *output, size_t output_size)
+{
+    const unsigned char *bytes = (const unsigned char *)value;
+
+    if (type >= 0 && type < VALUE_TYPE_COUNT && value_type_info[type].number != SCAN_NUMBER_FLOAT && !is_text_target_type(type))
     {
-        SIZE_T bytes_returned = VirtualQueryEx(process_handle, current_address, &mbi, sizeof(mbi));
+        size_t size = value_type_info[type].size;
+        uint64_t number = 0;
+        memcpy(&number, bytes, size);
+        if (is_big_endian_type(type))
+            number = swap_integer(number, size);
 
-        // Region enumeration error handling
-        if (bytes_returned == 0)
+        if (is_signed_type(type))
         {
-            DWORD error = GetLastError();
-
-            if (error == ERROR_INVALID_PARAMETER)
-            {
-                printf("[DEBUG] Reached end of process memory space\n");
-                break;
-            }
-
-            fprintf(stderr, "[ERROR] VirtualQueryEx failed at 0x%p (Error 0x%lx: %s)\n",
-                    current_address, error, get_error_string(error));
-            return false;
+            // Sign-extend from the top bit of the value
+            int shift = 64 - (int)size * 8;
+            snprintf(output, output_size, "%lld", (long long)((int64_t)(number << shift) >> shift));
         }
+        else
+            snprintf(output, output_size, "%llu", (unsigned long long)number);
+        return;
+    }
 
-        total_regions++;
-        printf("[DEBUG] Region %zu: 0x%p-0x%p (%zu bytes) State: 0x%lx Protect: 0x%lx\n",
-               total_regions, mbi.BaseAddress,
-               (LPVOID)((ULONG_PTR)mbi.BaseAddress + mbi.RegionSize),
-               mbi.RegionSize, mbi.State, mbi.Protect);
+    switch (type)
+    {
+    case VALUE_FLOAT:
+    {
+        float number;
+        memcpy(&number, bytes, sizeof(number));
+        snprintf(output, output_size, "%.9g", number);
+        break;
+    }
+    case VALUE_DOUBLE:
+    {
+        double number;
+        memcpy(&number, bytes, sizeof(number));
+        snprintf(output, output_size, "%.17g", number);
+        break;
+    }
+    default:
+        strncpy_s(output, output_size, "???", 4);
+    }
+}
 
-        // Skip uncommitted or reserved memory regions
-        if (mbi.State != MEM_COMMIT || (mbi.Protect & (PAGE_NOACCESS | PAGE_GUARD)) != 0)
-        {
-            skipped_regions++;
-            printf("[DEBUG] Skipping region (State: 0x%lx, Protect: 0x%lx)\n", mbi.State, mbi.Protect);
-            current_address = (LPVOID)((ULONG_PTR)mbi.BaseAddress + mbi.RegionSize);
-            continue;
-        }
+static ScanNumber get_value_number(ValueType type)
+{
+    return type >= 0 && type < VALUE_TYPE_COUNT ? value_type_info[type].number : SCAN_NUMBER_UNSIGNED;
+}
 
-        // Process the region in manageable chunks
-        printf("[DEBUG] Scanning committed region of %zu bytes\n", mbi.RegionSize);
-        for (SIZE_T offset = 0; offset < mbi.RegionSize; offset += CHUNK_SIZE)
-        {
-            SIZE_T chunk_size = min(CHUNK_SIZE, mbi.RegionSize - offset);
-            LPVOID chunk_address = (LPVOID)((ULONG_PTR)mbi.BaseAddress + offset);
-            BYTE *buffer = malloc(chunk_size);
+#define GROUP_FIELDS_MAX 16
+#define GROUP_WINDOW_DEFAULT 64
 
-            if (!buffer)
-            {
-                fprintf(stderr, "[ERROR] Failed to allocate %zu bytes for chunk buffer\n", chunk_size);
-                continue;
-            }
+// One field of a group scan, compared like an exact value (or rounded float) scan of its type
+typedef struct
+{
+    ScanNumber number;
+    CompareOp op;
+    ScanOperands operands;
+    size_t size;
+    int32_t first; // Offsets from the group address the field may start at, the same for a fixed field
+    int32_t last;
+} GroupField;
+
+typedef struct
+{
+    GroupField fields[GROUP_FIELDS_MAX];
+    int count;
+    int anchor;          // Fixed field run by the match kernel, the others only verify its matches
+    int32_t start;       // Offset of the first byte of a group from its address, <= 0
+    size_t span;         // Bytes of a group: the value size of its scan
+    uint64_t fixed[(SCAN_PATTERN_MAX + 63) / 64]; // Offsets from start taken by fixed fields
+} ScanGroup;
+
+#define SCAN_TASK_BYTES (8 * 1024 * 1024)    // Bytes of consecutive jobs run by one pool task, read ahead of each other
+#define CALIBRATION_BYTES (32 * 1024 * 1024) // Buffer scanned by calibrate_chunk_size for every candidate
+
+typedef struct
+{
+    uintptr_t address; // First address owned by this job
+    size_t size;       // Bytes owned by this job (at most scan_chunk_size)
+    size_t read_size;  // Bytes to read: size plus the overlap needed by values straddling the next job
+    size_t region;     // Index of the region the job belongs to
+} ScanJob;
 
-            SIZE_T bytes_read;
-            if (!ReadProcessMemory(process_handle, chunk_address, buffer, chunk_size, &bytes_read))
-            {
-                DWORD error = GetLastError();
-                fprintf(stderr, "[ERROR] ReadProcessMemory failed at 0x%p (Error 0x%lx: %s)\n", chunk_address, error, get_error_string(error));
-                read_errors++;
-                free(buffer);
-                continue;
-            }
+typedef struct
+{
+    uint64_t *masks;   // One bit per offset of the current job
+    BYTE *buffers[2];  // Chunk being scanned and chunk being read ahead, from chunk_buffers
+    SIZE_T scanned_chunks;
+    SIZE_T read_errors;
+    SIZE_T partial_reads;
+} ScanWorkerState;
+
+typedef struct
+{
+    HANDLE process_handle;
+    ScanNumber number;
+    CompareOp op;
+    ScanOperands operands;
+    SIZE_T value_size;
+    MatchKernel kernel; // NULL for value sizes without a dedicated kernel
+    const BytePattern *pattern; // Set by string and signature scans, which run pattern_kernel instead of kernel
+    PatternKernel pattern_kernel;
+    const ScanGroup *group; // Set by group scans: kernel matches its anchor field, offsets are group starts
+    SIZE_T anchor_offset;   // From an offset to the value kernel compares, the anchor field of a group
+    SIZE_T result_shift;    // From an offset to the address reported, the first field of a group
+    const SignatureSet *signatures; // Set by batch signature scans, which collect signature_hits instead of segments
+    DynamicArray *signature_hits;   // SignatureMatch of every job, indexed like jobs
+    const ScanJob *jobs;
+    size_t job_count;
+    size_t jobs_per_task;
+    ResultSegment *segments; // Matches of every job, indexed like jobs
+    volatile int64_t *region_jobs; // Jobs of every region not done yet, for the progress
+    ScanProgress *progress;
+    ScanWorkerState *workers;
+    bool stop_at_first_match;
+    volatile int64_t first_match_ns; // When a job first found a match, 0 until then
+} ScanContext;
+
+static ThreadPool scan_pool;
+static bool scan_pool_ready = false;
+static ResultStream result_stream; // Matches handed to the UI while the scan runs
+static BufferPool chunk_buffers;   // Two chunk buffers per scan worker, kept across scans
+static size_t chunk_buffers_chunk_size = 0;
+static ReadAhead *scan_readers;    // Read-ahead thread of every scan worker
+static int scan_reader_count = 0;
+
+static int scan_worker_count()
+{
+    return scan_thread_count > 0 ? scan_thread_count : platform_cpu_count();
+}
 
-            if (bytes_read != chunk_size)
-            {
-                partial_reads++;
-                printf("[WARNING] Partial read at 0x%p (%zu/%zu bytes)\n", chunk_address, bytes_read, chunk_size);
-            }
+// Returns the persistent scan pool, (re)starting it when the requested thread count changed
+static ThreadPool *get_scan_pool()
+{
+    int wanted = scan_worker_count();
 
-            // Scan the chunk content
-            for (SIZE_T i = 0; i <= bytes_read - value_size; i++)
-            {
-                if (memcmp(buffer + i, target_value, value_size) == 0)
-                {
-                    LPVOID found_addr = (LPVOID)((ULONG_PTR)chunk_address + i);
-                    append(&memory_addresses, &found_addr);
-                    matches_found++;
-                }
-            }
+    if (scan_pool_ready && scan_pool.worker_count != wanted)
+    {
+        thread_pool_destroy(&scan_pool);
+        scan_pool_ready = false;
+    }
 
-            scanned_chunks++;
-            free(buffer);
-        }
-        current_address = (LPVOID)((ULONG_PTR)mbi.BaseAddress + mbi.RegionSize);
+    if (!scan_pool_ready)
+    {
+        scan_pool_ready = thread_pool_create(&scan_pool, wanted);
     }
-    printf("[DEBUG] Memory scan complete\n"
-           "  Total regions processed: %zu\n"
-           "  Skipped regions: %zu\n"
-           "  Scanned chunks: %zu\n"
-           "  Read errors: %zu\n"
-           "  Total matches found: %zu\n",
-           total_regions, skipped_regions, scanned_chunks,
-           read_errors, matches_found);
 
-    printf("Number of addresses found: %zu\n", memory_addresses.size);
-    return memory_addresses.size > 0;
+    return scan_pool_ready ? &scan_pool : NULL;
 }
 
-bool parse_value(const char *input, int type, void *output)
+static void stop_scan_readers()
 {
-    char *endptr;
-    unsigned long long tmp;
-
-    // Handle hex format
-    if (input[0] == '0' && (input[1] == 'x' || input[1] == 'X'))
-        tmp = strtoull(input, &endptr, 16);
-    else
-        tmp = strtoull(input, &endptr, 10);
+    for (int i = 0; i < scan_reader_count; i++)
+        read_ahead_stop(&scan_readers[i]);
+    free(scan_readers);
+    scan_readers = NULL;
+    scan_reader_count = 0;
+}
 
-    if (endptr == input || *endptr != '\0')
-        return false;
+// Sizes the chunk buffers and read-ahead threads for worker_count workers scanning chunks of
+// scan_chunk_size bytes; they are only rebuilt when either changed since the previous scan
+static bool prepare_scan_buffers(int worker_count)
+{
+    // Room for the overlap of the longest value (a searched pattern) and a kernel reading a few bytes past it
+    size_t buffer_size = scan_chunk_size + SCAN_PATTERN_MAX;
 
-    // Validate type ranges
-    switch (type)
+    if (chunk_buffers.count != (size_t)worker_count * 2 || chunk_buffers_chunk_size != scan_chunk_size)
     {
-    case VALUE_BYTE:
-        if (tmp > UINT8_MAX)
-            return false;
-        *(uint8_t *)output = (uint8_t)tmp;
-        break;
-    case VALUE_2BYTES:
-        if (tmp > UINT16_MAX)
-            return false;
-        *(uint16_t *)output = (uint16_t)tmp;
-        break;
-    case VALUE_4BYTES:
-        if (tmp > UINT32_MAX)
+        chunk_buffers_chunk_size = scan_chunk_size;
+        buffer_pool_destroy(&chunk_buffers);
+        if (!buffer_pool_create(&chunk_buffers, (size_t)worker_count * 2, buffer_size))
+        {
+            fprintf(stderr, "[ERROR] Failed to allocate %d chunk buffers of %zu bytes\n", worker_count * 2, buffer_size);
             return false;
-        *(uint32_t *)output = (uint32_t)tmp;
-        break;
-    case VALUE_8BYTES:
-        *(uint64_t *)output = (uint64_t)tmp;
-        break;
-    default:
-        return false;
+        }
+    }
+
+    if (scan_reader_count != worker_count)
+    {
+        stop_scan_readers();
+        scan_readers = calloc((size_t)worker_count, sizeof(ReadAhead));
+        if (!scan_readers)
+        {
+            perror("Failed to allocate read-ahead threads");
+            exit(EXIT_FAILURE);
+        }
+        scan_reader_count = worker_count;
+        for (int i = 0; i < worker_count; i++)
+        {
+            // Without its thread a reader reads in place, the scan just loses the overlap
+            if (!read_ahead_start(&scan_readers[i]))
+                printf("[WARNING] Read-ahead thread %d failed to start, reading synchronously\n", i);
+        }
     }
     return true;
 }
 
-bool get_value_size(int type, size_t *value_size)
+void shutdown_scan_workers()
 {
-    switch (type)
+    if (scan_pool_ready)
     {
-    case VALUE_BYTE:
-        *value_size = 1;
-        return true;
-    case VALUE_2BYTES:
-        *value_size = 2;
-        return true;
-    case VALUE_4BYTES:
-        *value_size = 4;
-        return true;
-    case VALUE_8BYTES:
-        *value_size = 8;
-        return true;
-    default:
-        return false;
+        thread_pool_destroy(&scan_pool);
+        scan_pool_ready = false;
     }
+    stop_scan_readers();
+    buffer_pool_destroy(&chunk_buffers);
+    result_stream_free(&result_stream);
 }
 
-void start_memory_scan(HANDLE process_handle, ResultsTable *table)
+// One ring per pool worker, and a last one for the scan thread itself (next scans over a list)
+static void prepare_result_stream()
 {
-    uint64_t parsed_value;
-    size_t value_size;
+    int wanted = scan_worker_count() + 1;
 
-    // Parse input value
-    if (!parse_value(search_value, selected_value_type, &parsed_value))
+    if (result_stream.ring_count != wanted)
     {
-        fprintf(stderr, "Invalid input value!\n");
-        return;
+        result_stream_free(&result_stream);
+        result_stream_init(&result_stream, wanted, MAX_RESULTS);
     }
+    result_stream_reset(&result_stream);
+}
 
-    if (!get_value_size(selected_value_type, &value_size))
+static void stream_result(int producer, uintptr_t address, const void *value, SIZE_T value_size)
+{
+    if (result_stream_reserve(&result_stream, 1) > 0)
     {
-        fprintf(stderr, "Invalid value type!\n");
-        return;
+        uint64_t streamed = 0;
+        memcpy(&streamed, value, value_size);
+        result_stream_push(&result_stream, producer, address, streamed);
     }
+}
 
-    // Clear previous results
-    table->result_count = 0;
-    memset(table->results, 0, table->result_capacity * sizeof(ResultEntry));
-    clear_array(&memory_addresses, 100000, sizeof(LPVOID));
-    char previous_search_value[MAX_NAME_LEN] = "N/A";
+// Hands the first matches of a scanned chunk to the UI, while the stream budget lasts; values holds
+// the value of the match at base_address + offset at offset
+static void stream_chunk_matches(uintptr_t base_address, const ScanWorkerState *state, const BYTE *values, int worker_index,
+                                 size_t match_count, SIZE_T value_size)
+{
+    size_t streamed = result_stream_reserve(&result_stream, match_count);
 
-    // Start the scan
-    if (!scan_process_memory(process_handle, &parsed_value, value_size))
+    for (size_t word = 0; streamed > 0; word++)
     {
-        fprintf(stderr, "No matching values found!\n");
-        return;
+        for (uint64_t bits = state->masks[word]; bits && streamed > 0; bits &= bits - 1, streamed--)
+        {
+            size_t offset = word * SCAN_BLOCK_SIZE + (size_t)platform_ctz64(bits);
+            uint64_t value = 0;
+            memcpy(&value, values + offset, min(value_size, sizeof(value)));
+            result_stream_push(&result_stream, worker_index, base_address + offset, value);
+        }
     }
+}
 
-    clear_results_table(table);
-
-    if (!load_results(process_handle, table, search_value, previous_search_value))
+// Whether the group starting at span (its anchor field already matched) has all its other fields
+static bool group_matches(const ScanGroup *group, const BYTE *span)
+{
+    for (int f = 0; f < group->count; f++)
     {
-        fprintf(stderr, "Failed to load results addresses!\n");
-        return;
+        const GroupField *field = &group->fields[f];
+        bool found = f == group->anchor;
+
+        for (int32_t offset = field->first; offset <= field->last && !found; offset++)
+        {
+            // A field found anywhere in the window is not one of the fixed fields
+            size_t at = (size_t)(offset - group->start);
+            if (field->first != field->last && (group->fixed[at / 64] >> (at % 64) & 1))
+                continue;
+            found = compare_value(field->number, field->op, span + at, &field->operands, field->size);
+        }
+        if (!found)
+            return false;
     }
+    return true;
+}
 
-    strncpy_s(previous_search_value, sizeof(previous_search_value), search_value, _TRUNCATE);
+// Keeps the offsets of masks whose whole group matches; the kernel only checked the anchor field
+static void confirm_group_matches(const ScanGroup *group, const BYTE *buffer, SIZE_T offset_count, uint64_t *masks)
+{
+    for (size_t word = 0; word * SCAN_BLOCK_SIZE < offset_count; word++)
+    {
+        for (uint64_t bits = masks[word]; bits; bits &= bits - 1)
+        {
+            int bit = platform_ctz64(bits);
+            if (!group_matches(group, buffer + word * SCAN_BLOCK_SIZE + bit))
+                masks[word] &= ~((uint64_t)1 << bit);
+        }
+    }
 }
 
-void refine_memory_scan(HANDLE process_handle, ResultsTable *table)
+// Scans one chunk read into buffer (ok, bytes_read and error: the outcome of its read)
+static void scan_chunk(ScanContext *ctx, size_t job_index, ScanWorkerState *state, const BYTE *buffer,
+                       bool ok, SIZE_T bytes_read, DWORD error)
 {
-    uint64_t parsed_value;
-    size_t value_size;
+    const ScanJob *job = &ctx->jobs[job_index];
+    SIZE_T value_size = ctx->value_size;
 
-    // Parse input value
-    if (!parse_value(search_value, selected_value_type, &parsed_value))
+    if (!ok)
     {
-        fprintf(stderr, "Invalid input value!\n");
+        fprintf(stderr, "[ERROR] ReadProcessMemory failed at 0x%p (Error 0x%lx: %s)\n",
+                (LPVOID)job->address, (unsigned long)error, get_error_string(error));
+        state->read_errors++;
         return;
     }
 
-    if (!get_value_size(selected_value_type, &value_size))
+    if (bytes_read != job->read_size)
     {
-        fprintf(stderr, "Invalid value type!\n");
-        return;
+        state->partial_reads++;
+        printf("[WARNING] Partial read at 0x%p (%zu/%zu bytes)\n", (LPVOID)job->address, bytes_read, job->read_size);
     }
 
-    // Refine the scan results
-    if (!refine_results(process_handle, &parsed_value, value_size))
+    // Scan the chunk content; only offsets owned by this job count, the tail is overlap
+    if (ctx->signatures)
     {
-        fprintf(stderr, "No matching values found!\n");
-        return;
+        // Signatures shorter than the longest one still match up to the end of the region
+        DynamicArray *hits = &ctx->signature_hits[job_index];
+        create_array(hits, 16, sizeof(SignatureMatch));
+        signature_set_find(ctx->signatures, buffer, min(job->size, bytes_read), bytes_read, job->address, hits);
     }
+    else if (bytes_read >= value_size)
+    {
+        SIZE_T last_offset = min(job->size, bytes_read - value_size + 1);
+        SIZE_T kernel_blocks = ctx->kernel || ctx->pattern_kernel ? last_offset / SCAN_BLOCK_SIZE : 0;
+        const BYTE *values = buffer + ctx->anchor_offset;
+        SIZE_T compared_size = ctx->group ? ctx->group->fields[ctx->group->anchor].size : value_size;
 
-    clear_results_table(table);
+        if (kernel_blocks > 0 && ctx->pattern_kernel)
+            ctx->pattern_kernel(buffer, kernel_blocks, ctx->pattern, state->masks);
+        else if (kernel_blocks > 0)
+            ctx->kernel(values, kernel_blocks, &ctx->operands, state->masks);
 
-    if (!load_results(process_handle, table, search_value, previous_search_value))
-    {
-        fprintf(stderr, "Failed to load results addresses!\n");
-        return;
+        for (SIZE_T block = kernel_blocks; block * SCAN_BLOCK_SIZE < last_offset; block++)
+        {
+            uint64_t mask = 0;
+            SIZE_T end = min(last_offset, (block + 1) * SCAN_BLOCK_SIZE);
+            for (SIZE_T i = block * SCAN_BLOCK_SIZE; i < end; i++)
+            {
+                bool hit = ctx->pattern ? compare_pattern(buffer + i, ctx->pattern)
+                                       : compare_value(ctx->number, ctx->op, values + i, &ctx->operands, compared_size);
+                mask |= (uint64_t)hit << (i % SCAN_BLOCK_SIZE);
+            }
+            state->masks[block] = mask;
+        }
+
+        if (ctx->group)
+            confirm_group_matches(ctx->group, buffer, last_offset, state->masks);
+
+        result_segment_from_masks(&ctx->segments[job_index], job->address + ctx->result_shift, last_offset, state->masks);
     }
 
-    strncpy_s(previous_search_value, sizeof(previous_search_value), search_value, _TRUNCATE);
+    state->scanned_chunks++;
 }
 
-bool refine_results(HANDLE process_handle, LPCVOID target_value, SIZE_T value_size)
+// A scan for a unique signature is over with its first match; the jobs in progress still finish
+static bool first_match_reached(ScanContext *ctx)
 {
-    printf("[DEBUG] Starting refine_results...\n");
+    return ctx->stop_at_first_match && platform_atomic_load64(&ctx->first_match_ns) != 0;
+}
 
-    // Parameter validation
-    if (process_handle == NULL)
+// Runs jobs_per_task consecutive jobs: while one chunk is scanned, the worker's read-ahead
+// thread copies the next one into the other buffer
+static void scan_jobs_task(void *context, size_t task_index, int worker_index)
+{
+    ScanContext *ctx = (ScanContext *)context;
+    ScanWorkerState *state = &ctx->workers[worker_index];
+    ReadAhead *reader = &scan_readers[worker_index];
+    size_t first = task_index * ctx->jobs_per_task;
+    size_t end = min(first + ctx->jobs_per_task, ctx->job_count);
+    int current = 0;
+
+    // After a cancel the remaining jobs are skipped, the whole scan is discarded anyway
+    if (scan_progress_cancelled(ctx->progress) || first_match_reached(ctx))
+        return;
+
+    read_ahead_issue(reader, ctx->process_handle, ctx->jobs[first].address, state->buffers[0], ctx->jobs[first].read_size);
+    for (size_t j = first; j < end; j++, current ^= 1)
     {
-        fprintf(stderr, "Error: Invalid process handle (NULL)\n");
-        return false;
+        const ScanJob *job = &ctx->jobs[j];
+        SIZE_T bytes_read = 0;
+        bool ok = read_ahead_wait(reader, &bytes_read);
+        DWORD error = reader->error;
+
+        // Nothing is left in flight once the worker stops here
+        if (scan_progress_cancelled(ctx->progress) || first_match_reached(ctx))
+            return;
+
+        if (j + 1 < end)
+            read_ahead_issue(reader, ctx->process_handle, job[1].address, state->buffers[current ^ 1], job[1].read_size);
+
+        scan_chunk(ctx, j, state, state->buffers[current], ok, bytes_read, error);
+        size_t match_count = ctx->signatures ? ctx->signature_hits[j].size : ctx->segments[j].count;
+        if (match_count > 0 && !ctx->signatures)
+        {
+            SIZE_T shown_size = ctx->group ? ctx->group->fields[0].size : ctx->value_size;
+            stream_chunk_matches(job->address + ctx->result_shift, state, state->buffers[current] + ctx->result_shift,
+                                 worker_index, match_count, shown_size);
+            platform_atomic_cas64(&ctx->first_match_ns, 0, (int64_t)platform_time_ns());
+        }
+        scan_progress_add(ctx->progress, job->size, bytes_read, match_count);
+        if (platform_atomic_add64(&ctx->region_jobs[job->region], -1) == 1)
+            scan_progress_region_done(ctx->progress);
     }
-    if (target_value == NULL)
-    {
-        fprintf(stderr, "Error: Target value pointer is NULL\n");
+}
+
+// Runs every job of ctx on the scan pool into ctx->segments; the worker counters are summed into totals
+static bool run_scan_jobs(ScanContext *ctx, ScanWorkerState *totals)
+{
+    ThreadPool *pool = get_scan_pool();
+    int worker_count = pool ? pool->worker_count : 1;
+
+    if (!prepare_scan_buffers(worker_count))
         return false;
-    }
-    if (value_size == 0 || value_size > 8)
+
+    ctx->workers = calloc((size_t)worker_count, sizeof(ScanWorkerState));
+    if (!ctx->workers)
     {
-        fprintf(stderr, "Error: Invalid value_size (%zu)\n", value_size);
+        fprintf(stderr, "[ERROR] Failed to allocate scan worker state\n");
         return false;
     }
 
-    printf("[DEBUG] Creating temporary array (capacity: %zu)\n", memory_addresses.capacity);
-    DynamicArray temp_array;
-    create_array(&temp_array, memory_addresses.capacity, sizeof(LPVOID));
-
-    size_t total_matches = 0;
-    size_t read_errors = 0;
-    size_t partial_reads = 0;
-
-    printf("[DEBUG] Scanning %zu addresses...\n", memory_addresses.size);
-    for (size_t i = 0; i < memory_addresses.size; i++)
+    for (int w = 0; w < worker_count; w++)
     {
-        LPVOID addr = *(LPVOID *)get(&memory_addresses, i);
-        uint8_t buffer[8] = {0};
-        SIZE_T bytes_read;
-
-        // printf("[DEBUG] Checking address: 0x%p\n", addr);
-
-        if (!ReadProcessMemory(process_handle, addr, buffer, value_size, &bytes_read))
+        ctx->workers[w].buffers[0] = buffer_pool_acquire(&chunk_buffers);
+        ctx->workers[w].buffers[1] = buffer_pool_acquire(&chunk_buffers);
+        ctx->workers[w].masks = malloc((scan_chunk_size / SCAN_BLOCK_SIZE + 1) * sizeof(uint64_t));
+        if (!ctx->workers[w].masks)
         {
-            DWORD error = GetLastError();
-            fprintf(stderr, "ReadProcessMemory failed at 0x%p (Error: 0x%lx : %s)\n", addr, error, get_error_string(error));
-            read_errors++;
-            continue;
+            perror("Failed to allocate chunk masks");
+            exit(EXIT_FAILURE);
         }
+    }
 
-        if (bytes_read != value_size)
-        {
-            fprintf(stderr, "Partial read at 0x%p (%zu/%zu bytes)\n",
-                    addr, bytes_read, value_size);
-            partial_reads++;
-            continue;
-        }
+    // Small enough tasks for the pool to balance, at least two jobs for the read-ahead to overlap
+    ctx->jobs_per_task = max(SCAN_TASK_BYTES / scan_chunk_size, 2);
+    size_t task_count = (ctx->job_count + ctx->jobs_per_task - 1) / ctx->jobs_per_task;
+    if (pool)
+    {
+        thread_pool_run(pool, task_count, scan_jobs_task, ctx);
+    }
+    else
+    {
+        for (size_t i = 0; i < task_count; i++)
+        {
+            scan_jobs_task(ctx, i, 0);
+        }
+    }
+
+    memset(totals, 0, sizeof(ScanWorkerState));
+    for (int w = 0; w < worker_count; w++)
+    {
+        totals->scanned_chunks += ctx->workers[w].scanned_chunks;
+        totals->read_errors += ctx->workers[w].read_errors;
+        totals->partial_reads += ctx->workers[w].partial_reads;
+        buffer_pool_release(&chunk_buffers, ctx->workers[w].buffers[0]);
+        buffer_pool_release(&chunk_buffers, ctx->workers[w].buffers[1]);
+        free(ctx->workers[w].masks);
+    }
+    free(ctx->workers);
+    ctx->workers = NULL;
+    return true;
+}
+
+// Splits [address, address + size) into chunk-sized jobs appended to jobs, returns the bytes they own
+static SIZE_T split_scan_jobs(DynamicArray *jobs, uintptr_t address, size_t size, size_t region, SIZE_T value_size)
+{
+    for (SIZE_T offset = 0; offset < size; offset += scan_chunk_size)
+    {
+        ScanJob job;
+        job.address = address + offset;
+        job.size = min(scan_chunk_size, size - offset);
+        job.read_size = min(job.size + value_size - 1, size - offset);
+        job.region = region;
+        append(jobs, &job);
+    }
+    return size;
+}
+
+// Maps a scan type to the comparison run by the kernels and packs its operands
+static bool prepare_comparison(ScanType scan_type, LPCVOID target_value, LPCVOID upper_value, SIZE_T value_size,
+                               ScanNumber number, CompareOp *op, ScanOperands *operands)
+{
+    memset(operands, 0, sizeof(ScanOperands));
+    memcpy(operands->value, target_value, value_size);
+
+    switch (scan_type)
+    {
+    case SCAN_EXACT_VALUE:
+        *op = COMPARE_EQUAL;
+        return true;
+    case SCAN_BIGGER_THAN:
+        *op = COMPARE_GREATER;
+        return true;
+    case SCAN_SMALLER_THAN:
+        *op = COMPARE_LESS;
+        return true;
+    case SCAN_VALUE_BETWEEN:
+        if (upper_value == NULL)
+            return false;
+        *op = COMPARE_BETWEEN;
+        memcpy(operands->upper, upper_value, value_size);
+
+        // Accept the bounds in either order
+        if (compare_value(number, COMPARE_LESS, operands->upper, operands, value_size))
+        {
+            uint8_t swap[8];
+            memcpy(swap, operands->value, sizeof(swap));
+            memcpy(operands->value, operands->upper, sizeof(swap));
+            memcpy(operands->upper, swap, sizeof(swap));
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Maps a "compared to the previous scan" type to its delta comparison. Floating point differences
+// are matched against [target_value, upper_value] (upper_value NULL: exactly target_value).
+static bool prepare_delta(ScanType scan_type, LPCVOID target_value, LPCVOID upper_value, SIZE_T value_size, ScanNumber number,
+                          DeltaOp *op, ScanOperands *operands)
+{
+    memset(operands, 0, sizeof(ScanOperands));
+
+    switch (scan_type)
+    {
+    case SCAN_CHANGED:
+        *op = DELTA_CHANGED;
+        return true;
+    case SCAN_UNCHANGED:
+        *op = DELTA_UNCHANGED;
+        return true;
+    case SCAN_INCREASED:
+        *op = DELTA_INCREASED;
+        return true;
+    case SCAN_DECREASED:
+        *op = DELTA_DECREASED;
+        return true;
+    case SCAN_INCREASED_BY:
+    case SCAN_DECREASED_BY:
+        if (target_value == NULL)
+            return false;
+        *op = scan_type == SCAN_INCREASED_BY ? DELTA_INCREASED_BY : DELTA_DECREASED_BY;
+        memcpy(operands->value, target_value, value_size);
+        if (number == SCAN_NUMBER_FLOAT)
+            memcpy(operands->upper, upper_value ? upper_value : target_value, value_size);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool prepare_filter(ScanType scan_type, LPCVOID target_value, LPCVOID upper_value, SIZE_T value_size, ScanNumber number,
+                           ScanFilter *filter)
+{
+    memset(filter, 0, sizeof(ScanFilter));
+    filter->number = number;
+    filter->delta = prepare_delta(scan_type, target_value, upper_value, value_size, number, &filter->delta_op, &filter->operands);
+    return filter->delta || prepare_comparison(scan_type, target_value, upper_value, value_size, number, &filter->compare, &filter->operands);
+}
+
+// Rough bits a field needs to match by chance: the significant bits of an integer, zero and small
+// counters being everywhere in memory, plus a little for its width; floats count half their width
+static int group_field_rarity(const GroupField *field)
+{
+    if (field->number == SCAN_NUMBER_FLOAT)
+        return (int)field->size * 4;
+
+    uint64_t value = 0;
+    memcpy(&value, field->operands.value, field->size);
+    if (field->number == SCAN_NUMBER_UNSIGNED_BE || field->number == SCAN_NUMBER_SIGNED_BE)
+        value = swap_integer(value, field->size);
+    if ((field->number == SCAN_NUMBER_SIGNED || field->number == SCAN_NUMBER_SIGNED_BE) && (value >> (field->size * 8 - 1) & 1))
+        value = ~value & (field->size == 8 ? ~0ull : ((uint64_t)1 << (field->size * 8)) - 1);
+
+    int bits = 0;
+    for (; value; value >>= 1)
+        bits++;
+    return bits + (int)field->size * 2;
+}
+
+// Parses one size:value[@offset] field of a group target
+static bool parse_group_field(const char *token, GroupField *field, bool *fixed)
+{
+    static const char sizes[] = "1248fd";
+    const char *kind = strchr(sizes, token[0]);
+    char value[MAX_NAME_LEN];
+
+    if (token[0] == '\0' || !kind || token[1] != ':')
+        return false;
+    snprintf(value, sizeof(value), "%s", token + 2);
+
+    char *at = strchr(value, '@');
+    char *end = NULL;
+    *fixed = at != NULL;
+    if (at)
+    {
+        *at = '\0';
+        long offset = strtol(at + 1, &end, 10);
+        if (end == at + 1 || *end != '\0' || offset < -SCAN_PATTERN_MAX || offset > SCAN_PATTERN_MAX)
+            return false;
+        field->first = field->last = (int32_t)offset;
+    }
+
+    ValueType type = token[0] == 'f' ? VALUE_FLOAT : token[0] == 'd' ? VALUE_DOUBLE
+                                                                        : get_integer_value_type((size_t)(token[0] - '0'), value[0] == '-', false);
+    uint64_t lower = 0, upper = 0;
+    field->number = get_value_number(type);
+    field->size = value_type_info[type].size;
+    if (field->number == SCAN_NUMBER_FLOAT)
+        return float_match_range(value, type, FLOAT_COMPARE_ROUNDED, 0, &lower, &upper) &&
+               prepare_comparison(SCAN_VALUE_BETWEEN, &lower, &upper, field->size, field->number, &field->op, &field->operands);
+    return parse_value(value, type, &lower) &&
+           prepare_comparison(SCAN_EXACT_VALUE, &lower, NULL, field->size, field->number, &field->op, &field->operands);
+}
+
+// Parses a VALUE_GROUP target, and anchors the group on the fixed field expected to match the
+// fewest offsets: every other field is only checked where it matched
+static bool parse_group(const char *text, ScanGroup *group)
+{
+    bool fixed[GROUP_FIELDS_MAX];
+    long window = GROUP_WINDOW_DEFAULT;
+
+    memset(group, 0, sizeof(ScanGroup));
+    for (const char *p = text; *p;)
+    {
+        char token[MAX_NAME_LEN];
+        size_t length = strcspn(p, " ");
+        if (length == 0)
+        {
+            p++;
+            continue;
+        }
+        if (length >= sizeof(token))
+            return false;
+        memcpy(token, p, length);
+        token[length] = '\0';
+        p += length;
+
+        if (token[0] == 'w' && token[1] == ':')
+        {
+            char *end = NULL;
+            window = strtol(token + 2, &end, 10);
+            if (end == token + 2 || *end != '\0' || window <= 0 || window > SCAN_PATTERN_MAX)
+                return false;
+        }
+        else if (group->count == GROUP_FIELDS_MAX || !parse_group_field(token, &group->fields[group->count], &fixed[group->count]))
+            return false;
+        else
+            group->count++;
+    }
+    if (group->count == 0)
+        return false;
+
+    // The first field is the address of the group
+    if (fixed[0] && group->fields[0].first != 0)
+        return false;
+    fixed[0] = true;
+
+    int32_t end = 0;
+    int best_rarity = -1;
+    for (int f = 0; f < group->count; f++)
+    {
+        GroupField *field = &group->fields[f];
+        if (!fixed[f])
+        {
+            if ((size_t)window < field->size)
+                return false;
+            field->first = 0;
+            field->last = (int32_t)(window - (long)field->size);
+        }
+        group->start = min(group->start, field->first);
+        end = max(end, field->last + (int32_t)field->size);
+
+        int rarity = group_field_rarity(field);
+        if (fixed[f] && rarity > best_rarity)
+        {
+            best_rarity = rarity;
+            group->anchor = f;
+        }
+    }
+
+    group->span = (size_t)(end - group->start);
+    if (group->span > SCAN_PATTERN_MAX)
+        return false;
+    for (int f = 0; f < group->count; f++)
+    {
+        size_t at = (size_t)(group->fields[f].first - group->start);
+        if (fixed[f])
+            group->fixed[at / 64] |= (uint64_t)1 << (at % 64);
+    }
+    return true;
+}
+
+bool scan_type_needs_value(ScanType scan_type)
+{
+    switch (scan_type)
+    {
+    case SCAN_UNKNOWN_INITIAL:
+    case SCAN_CHANGED:
+    case SCAN_UNCHANGED:
+    case SCAN_INCREASED:
+    case SCAN_DECREASED:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static void print_snapshot_stats(const char *stage, uint64_t elapsed_ns)
+{
+    printf("[DEBUG] %s complete\n"
+           "  Candidates: %llu in %zu blocks\n"
+           "  Bytes read: %llu (%zu read errors)\n"
+           "  Snapshot footprint: %.1f MiB (%.1f MiB data, %.1f MiB bitmaps)\n"
+           "  Time: %.3f s\n",
+           stage, (unsigned long long)scan_snapshot.candidate_count, scan_snapshot.blocks.size,
+           (unsigned long long)scan_snapshot.captured_bytes, scan_snapshot.read_errors,
+           snapshot_footprint(&scan_snapshot) / (1024.0 * 1024.0), scan_snapshot.data_bytes / (1024.0 * 1024.0),
+           scan_snapshot.bitmap_bytes / (1024.0 * 1024.0), elapsed_ns / 1e9);
+}
+
+// Once few candidates are left, plain address/value entries are cheaper than the snapshot blocks
+static void materialize_small_snapshot()
+{
+    if (!scan_snapshot.active || scan_snapshot.candidate_count > SNAPSHOT_LIST_THRESHOLD)
+        return;
+
+    result_set_clear(&scan_results, 1);
+    clear_array(&memory_values, (size_t)scan_snapshot.candidate_count + 1, sizeof(uint64_t));
+    snapshot_export(&scan_snapshot, &scan_results, &memory_values);
+
+    printf("[DEBUG] Snapshot released, %llu candidates kept as a result set (%.1f MiB)\n",
+           (unsigned long long)scan_results.count, result_set_footprint(&scan_results) / (1024.0 * 1024.0));
+    snapshot_free(&scan_snapshot);
+}
+
+// Unknown initial value: every readable offset is a candidate, kept as a snapshot of the regions
+static bool capture_snapshot(HANDLE process_handle, const DynamicArray *regions, SIZE_T value_size)
+{
+    uint64_t start = platform_time_ns();
+
+    snapshot_capture(&scan_snapshot, process_handle, regions, value_size, get_scan_pool(), &scan_progress);
+    print_snapshot_stats("Snapshot capture", platform_time_ns() - start);
+
+    if (scan_progress_cancelled(&scan_progress))
+    {
+        printf("[DEBUG] Snapshot capture cancelled\n");
+        snapshot_free(&scan_snapshot);
+        return false;
+    }
+
+    materialize_small_snapshot();
+    return scan_snapshot.candidate_count > 0 || scan_results.count > 0;
+}
+
+static bool refine_snapshot(HANDLE process_handle, const ScanFilter *filter, ValueType value_type)
+{
+    if (value_type != memory_value_type)
+    {
+        fprintf(stderr, "Error: Value type changed since the unknown initial value scan (%d, was %d)\n",
+                (int)value_type, (int)memory_value_type);
+        return false;
+    }
+
+    uint64_t start = platform_time_ns();
+
+    snapshot_refine(&scan_snapshot, process_handle, filter, get_scan_pool(), &scan_progress);
+    print_snapshot_stats("Snapshot refine", platform_time_ns() - start);
+
+    materialize_small_snapshot();
+    return scan_snapshot.candidate_count > 0 || scan_results.count > 0;
+}
+
+static void print_region_filter_stats(const RegionFilterStats *stats)
+{
+    printf("[DEBUG] Region filter kept %llu regions (%.1f MiB)\n", (unsigned long long)stats->kept_regions,
+           stats->kept_bytes / (1024.0 * 1024.0));
+    for (int rule = 0; rule < FILTER_RULE_COUNT; rule++)
+    {
+        if (stats->skipped_bytes[rule] > 0)
+            printf("  Skipped by %s: %llu regions, %.1f MiB\n", region_filter_rule_name((RegionFilterRule)rule),
+                   (unsigned long long)stats->skipped_regions[rule], stats->skipped_bytes[rule] / (1024.0 * 1024.0));
+    }
+}
+
+// Queries the regions of the process and keeps those scan_region_filter lets through, in ascending
+// order; total_regions counts them all
+static bool query_scan_regions(HANDLE process_handle, DynamicArray *regions, RegionFilterStats *filter_stats,
+                               SIZE_T *total_regions)
+{
+    printf("[DEBUG] Beginning memory enumeration...\n");
+
+    DynamicArray all_regions;
+    create_array(&all_regions, 256, sizeof(MemoryRegion));
+
+    if (!platform_query_regions(process_handle, &all_regions))
+    {
+        DWORD error = GetLastError();
+        fprintf(stderr, "[ERROR] Failed to enumerate memory regions (Error 0x%lx: %s)\n",
+                (unsigned long)error, get_error_string(error));
+        free_array(&all_regions);
+        return false;
+    }
+
+    // Drop the regions the filter rules out before anything is read
+    create_array(regions, all_regions.size + 1, sizeof(MemoryRegion));
+    bool filtered = region_filter_apply(&scan_region_filter, process_handle, &all_regions, regions, filter_stats);
+    *total_regions = all_regions.size;
+    free_array(&all_regions);
+    if (!filtered)
+    {
+        DWORD error = GetLastError();
+        fprintf(stderr, "[ERROR] Failed to list the modules for the region filter (Error 0x%lx: %s)\n",
+                (unsigned long)error, get_error_string(error));
+        free_array(regions);
+        return false;
+    }
+    return true;
+}
+
+// Splits every region into chunk-sized jobs, in ascending address order, and sets the progress
+// totals. Returns the number of jobs of every region, counted down as they are done.
+static volatile int64_t *plan_scan_jobs(const DynamicArray *regions, SIZE_T value_size, DynamicArray *jobs)
+{
+    SIZE_T total_bytes = 0;
+    create_array(jobs, regions->size * 4 + 1, sizeof(ScanJob));
+
+    for (size_t r = 0; r < regions->size; r++)
+    {
+        const MemoryRegion *region = (const MemoryRegion *)regions->data + r;
+
+        printf("[DEBUG] Region %zu: 0x%p-0x%p (%zu bytes) Protect: 0x%lx\n",
+               r + 1, (LPVOID)region->base, (LPVOID)(region->base + region->size),
+               region->size, (unsigned long)region->native_protect);
+        total_bytes += split_scan_jobs(jobs, region->base, region->size, r, value_size);
+    }
+
+    volatile int64_t *region_jobs = calloc(regions->size + 1, sizeof(int64_t));
+    if (!region_jobs)
+    {
+        perror("Failed to allocate region progress");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t j = 0; j < jobs->size; j++)
+        region_jobs[((const ScanJob *)jobs->data)[j].region]++;
+    scan_progress_set_totals(&scan_progress, total_bytes, regions->size);
+    return region_jobs;
+}
+
+bool scan_process_memory(HANDLE process_handle, ScanType scan_type, LPCVOID target_value, LPCVOID upper_value, ValueType value_type)
+{
+    SIZE_T value_size = 0;
+    ScanNumber number = get_value_number(value_type);
+
+    get_value_size(value_type, &value_size);
+    printf("[DEBUG] Starting memory scan for value size: %zu bytes\n", value_size);
+
+    // Parameter validation
+    if (process_handle == NULL || process_handle == INVALID_HANDLE_VALUE)
+    {
+        const char *handle_state = process_handle == NULL ? "NULL" : "INVALID_HANDLE_VALUE";
+        fprintf(stderr, "[ERROR] Invalid process handle (%s)\n", handle_state);
+        return false;
+    }
+
+    if (target_value == NULL && scan_type_needs_value(scan_type))
+    {
+        fprintf(stderr, "[ERROR] Target value pointer is NULL\n");
+        return false;
+    }
+
+    // Strings and signatures are searched for as byte patterns, whose length is the value size, and
+    // groups for their anchor field, the value size being the bytes the group covers
+    bool grouped = value_type == VALUE_GROUP;
+    bool text = is_text_target_type(value_type) && !grouped;
+    BytePattern pattern;
+    ScanGroup group;
+    if (is_text_target_type(value_type) && scan_type != SCAN_EXACT_VALUE)
+    {
+        fprintf(stderr, "[ERROR] Strings, signatures and groups can only be searched by exact value\n");
+        return false;
+    }
+    if (text && !text_pattern_for_type(&pattern, (const char *)target_value, value_type))
+    {
+        fprintf(stderr, "[ERROR] Invalid search %s (empty, over %d bytes or malformed)\n",
+                value_type == VALUE_SIGNATURE ? "signature" : "text", SCAN_PATTERN_MAX);
+        return false;
+    }
+    if (grouped && !parse_group((const char *)target_value, &group))
+    {
+        fprintf(stderr, "[ERROR] Invalid group (expected size:value[@offset] fields and w:window, at most %d fields over %d bytes)\n",
+                GROUP_FIELDS_MAX, SCAN_PATTERN_MAX);
+        return false;
+    }
+    if (text)
+        value_size = pattern.length;
+    else if (grouped)
+    {
+        const GroupField *anchor = &group.fields[group.anchor];
+        value_size = group.span;
+        number = anchor->number;
+        printf("[DEBUG] Group of %d fields over %zu bytes, anchored on field %d\n", group.count, group.span, group.anchor + 1);
+    }
+    else if (value_size == 0 || value_size > 8)
+    {
+        fprintf(stderr, "[ERROR] Invalid value type: %d\n", (int)value_type);
+        return false;
+    }
+
+    // A new first scan drops whatever the previous one kept
+    snapshot_free(&scan_snapshot);
+    memory_values.size = 0;
+    memory_value_type = value_type;
+
+    CompareOp op = COMPARE_EQUAL;
+    ScanOperands operands = {0};
+    if (grouped)
+    {
+        op = group.fields[group.anchor].op;
+        operands = group.fields[group.anchor].operands;
+    }
+    else if (!text && scan_type != SCAN_UNKNOWN_INITIAL &&
+             !prepare_comparison(scan_type, target_value, upper_value, value_size, number, &op, &operands))
+    {
+        fprintf(stderr, "[ERROR] Unsupported scan type for a value scan: %d\n", (int)scan_type);
+        return false;
+    }
+
+    SIZE_T total_regions = 0;
+    SIZE_T scanned_chunks = 0;
+    SIZE_T read_errors = 0;
+    SIZE_T matches_found = 0;
+    SIZE_T skipped_regions = 0;
+    SIZE_T partial_reads = 0;
+
+    DynamicArray regions;
+    RegionFilterStats filter_stats;
+    if (!query_scan_regions(process_handle, &regions, &filter_stats, &total_regions))
+        return false;
+    for (int rule = 0; rule < FILTER_RULE_COUNT; rule++)
+        skipped_regions += filter_stats.skipped_regions[rule];
+
+    if (scan_type == SCAN_UNKNOWN_INITIAL)
+    {
+        print_region_filter_stats(&filter_stats);
+        bool found = capture_snapshot(process_handle, &regions, value_size);
+        free_array(&regions);
+        return found;
+    }
+
+    DynamicArray jobs;
+    volatile int64_t *region_jobs = plan_scan_jobs(&regions, value_size, &jobs);
+    free_array(&regions);
+
+    ScanContext ctx = {
+        .process_handle = process_handle,
+        .number = number,
+        .op = op,
+        .operands = operands,
+        .value_size = value_size,
+        .kernel = text ? NULL : get_match_kernel(get_best_scan_isa(), number, op, grouped ? group.fields[group.anchor].size : value_size),
+        .pattern = text ? &pattern : NULL,
+        .group = grouped ? &group : NULL,
+        .anchor_offset = grouped ? (SIZE_T)(group.fields[group.anchor].first - group.start) : 0,
+        .result_shift = grouped ? (SIZE_T)-group.start : 0,
+        .pattern_kernel = text ? get_pattern_kernel(get_best_scan_isa()) : NULL,
+        .jobs = (const ScanJob *)jobs.data,
+        .job_count = jobs.size,
+        .segments = calloc(jobs.size + 1, sizeof(ResultSegment)),
+        .region_jobs = region_jobs,
+        .progress = &scan_progress,
+        .stop_at_first_match = scan_stop_at_first_match};
+
+    printf("[DEBUG] Scanning %zu chunks of %zu KiB on %d threads (%s kernels)\n", jobs.size, scan_chunk_size / 1024,
+           scan_worker_count(), ctx.kernel || ctx.pattern_kernel ? get_scan_isa_name(get_best_scan_isa()) : "scalar fallback");
+
+    ScanWorkerState totals;
+    uint64_t jobs_start = platform_time_ns();
+    if (!ctx.segments || !run_scan_jobs(&ctx, &totals))
+    {
+        fprintf(stderr, "[ERROR] Failed to allocate scan worker state\n");
+        free(ctx.segments);
+        free((void *)region_jobs);
+        free_array(&jobs);
+        return false;
+    }
+
+    // Job segments are already in address order; a cancelled scan keeps none of them
+    bool cancelled = scan_progress_cancelled(&scan_progress);
+    for (size_t j = 0; j < jobs.size; j++)
+    {
+        if (cancelled)
+        {
+            result_segment_free(&ctx.segments[j]);
+            continue;
+        }
+        matches_found += ctx.segments[j].count;
+        result_set_append(&scan_results, &ctx.segments[j]);
+    }
+
+    scanned_chunks = totals.scanned_chunks;
+    read_errors = totals.read_errors;
+    partial_reads = totals.partial_reads;
+    free(ctx.segments);
+    free((void *)region_jobs);
+    free_array(&jobs);
+
+    if (cancelled)
+    {
+        printf("[DEBUG] Memory scan cancelled\n");
+        return false;
+    }
+
+    if (ctx.stop_at_first_match && ctx.first_match_ns != 0)
+        printf("[DEBUG] Stopped at the first match, found after %.3f s\n", ((uint64_t)ctx.first_match_ns - jobs_start) / 1e9);
+
+    printf("[DEBUG] Memory scan complete\n"
+           "  Total regions processed: %zu\n"
+           "  Skipped regions: %zu\n"
+           "  Scanned chunks: %zu\n"
+           "  Read errors: %zu\n"
+           "  Partial reads: %zu\n"
+           "  Total matches found: %zu\n",
+           total_regions, skipped_regions, scanned_chunks,
+           read_errors, partial_reads, matches_found);
+    print_region_filter_stats(&filter_stats);
+
+    printf("Number of addresses found: %llu (%zu segments, %.1f MiB)\n", (unsigned long long)scan_results.count,
+           scan_results.segments.size, result_set_footprint(&scan_results) / (1024.0 * 1024.0));
+    return scan_results.count > 0;
+}
+
+bool scan_signatures(HANDLE process_handle, const SignatureSet *set, SignatureResults *results)
+{
+    if (process_handle == NULL || process_handle == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "[ERROR] Invalid process handle\n");
+        return false;
+    }
+    if (set->count == 0 || results->count != set->count)
+    {
+        fprintf(stderr, "[ERROR] Signature results sized for %zu signatures, the set has %zu\n", results->count, set->count);
+        return false;
+    }
+    printf("[DEBUG] Starting batch scan for %zu signatures (%zu table entries)\n", set->count, set->anchor_count);
+
+    SIZE_T total_regions = 0;
+    DynamicArray regions;
+    RegionFilterStats filter_stats;
+    if (!query_scan_regions(process_handle, &regions, &filter_stats, &total_regions))
+        return false;
+
+    // Jobs overlap by the longest signature, so every one is found by the job it starts in
+    DynamicArray jobs;
+    volatile int64_t *region_jobs = plan_scan_jobs(&regions, set->max_length, &jobs);
+    free_array(&regions);
+
+    ScanContext ctx = {
+        .process_handle = process_handle,
+        .value_size = set->max_length,
+        .signatures = set,
+        .signature_hits = calloc(jobs.size + 1, sizeof(DynamicArray)),
+        .jobs = (const ScanJob *)jobs.data,
+        .job_count = jobs.size,
+        .region_jobs = region_jobs,
+        .progress = &scan_progress};
+
+    printf("[DEBUG] Scanning %zu chunks of %zu KiB on %d threads\n", jobs.size, scan_chunk_size / 1024, scan_worker_count());
+
+    ScanWorkerState totals;
+    if (!ctx.signature_hits || !run_scan_jobs(&ctx, &totals))
+    {
+        fprintf(stderr, "[ERROR] Failed to allocate scan worker state\n");
+        free(ctx.signature_hits);
+        free((void *)region_jobs);
+        free_array(&jobs);
+        return false;
+    }
+
+    // Jobs are in address order and so are the hits of a signature within a job
+    bool cancelled = scan_progress_cancelled(&scan_progress);
+    SIZE_T matches_found = 0;
+    for (size_t j = 0; j < jobs.size; j++)
+    {
+        const SignatureMatch *hits = (const SignatureMatch *)ctx.signature_hits[j].data;
+        for (size_t h = 0; h < ctx.signature_hits[j].size && !cancelled; h++)
+            append(&results->addresses[hits[h].signature], &hits[h].address);
+        matches_found += ctx.signature_hits[j].size;
+        free_array(&ctx.signature_hits[j]);
+    }
+    free(ctx.signature_hits);
+    free((void *)region_jobs);
+    free_array(&jobs);
+
+    if (cancelled)
+    {
+        printf("[DEBUG] Signature scan cancelled\n");
+        return false;
+    }
+
+    size_t found_signatures = 0;
+    for (size_t i = 0; i < results->count; i++)
+        found_signatures += results->addresses[i].size > 0;
+
+    printf("[DEBUG] Signature scan complete\n"
+           "  Total regions processed: %zu\n"
+           "  Scanned chunks: %zu\n"
+           "  Read errors: %zu\n"
+           "  Partial reads: %zu\n"
+           "  Total matches found: %zu (%zu of %zu signatures)\n",
+           total_regions, totals.scanned_chunks, totals.read_errors, totals.partial_reads,
+           matches_found, found_signatures, set->count);
+    print_region_filter_stats(&filter_stats);
+    return found_signatures > 0;
+}
+
+// Times first scans of a buffer of this process for chunk sizes from 64 KiB to 4 MiB and keeps the
+// fastest in scan_chunk_size: small chunks stay in cache between the read and the scan, large ones
+// spend less on syscalls and task handoffs, and where the balance lies depends on the machine
+size_t calibrate_chunk_size()
+{
+    static const size_t candidates[] = {64 * 1024, 128 * 1024, 256 * 1024, 512 * 1024, 1024 * 1024, 2048 * 1024, 4096 * 1024};
+    size_t buffer_size = CALIBRATION_BYTES;
+    BYTE *buffer = platform_aligned_alloc(buffer_size, BUFFER_POOL_ALIGNMENT);
+
+    if (!buffer)
+    {
+        printf("[WARNING] No memory for the chunk size calibration, keeping %zu KiB chunks\n", scan_chunk_size / 1024);
+        return scan_chunk_size;
+    }
+    memset(buffer, 0x5A, buffer_size); // Never equal to the searched value: the scan finds nothing
+
+    uint32_t value = 0;
+    ScanProgress progress; // Private: the calibration does not show up in the UI's progress
+    ScanContext ctx = {
+        .process_handle = platform_current_process(),
+        .value_size = sizeof(value),
+        .progress = &progress};
+    prepare_comparison(SCAN_EXACT_VALUE, &value, &value, sizeof(value), ctx.number, &ctx.op, &ctx.operands);
+    ctx.kernel = get_match_kernel(get_best_scan_isa(), ctx.number, ctx.op, ctx.value_size);
+    scan_progress_begin(&progress);
+
+    size_t best_size = scan_chunk_size;
+    uint64_t best_ns = UINT64_MAX;
+
+    for (size_t c = 0; c < sizeof(candidates) / sizeof(candidates[0]); c++)
+    {
+        DynamicArray jobs;
+        volatile int64_t region_jobs = 0;
+        create_array(&jobs, buffer_size / candidates[c] + 1, sizeof(ScanJob));
+        scan_chunk_size = candidates[c];
+        split_scan_jobs(&jobs, (uintptr_t)buffer, buffer_size, 0, ctx.value_size);
+
+        ctx.jobs = (const ScanJob *)jobs.data;
+        ctx.job_count = jobs.size;
+        ctx.segments = calloc(jobs.size, sizeof(ResultSegment));
+        ctx.region_jobs = &region_jobs;
+        if (!ctx.segments)
+        {
+            perror("Failed to allocate calibration segments");
+            exit(EXIT_FAILURE);
+        }
+
+        // Best of two runs: the first one also pays for (re)allocating the chunk buffers
+        uint64_t elapsed = UINT64_MAX;
+        for (int run = 0; run < 2; run++)
+        {
+            ScanWorkerState totals;
+            region_jobs = (int64_t)jobs.size;
+            uint64_t start = platform_time_ns();
+            bool ok = run_scan_jobs(&ctx, &totals);
+            uint64_t end = platform_time_ns();
+
+            for (size_t j = 0; j < jobs.size; j++)
+                result_segment_free(&ctx.segments[j]);
+            if (ok && totals.read_errors == 0)
+                elapsed = min(elapsed, end - start);
+        }
+
+        if (elapsed != UINT64_MAX)
+        {
+            printf("[DEBUG] Chunk size %zu KiB: %.0f MiB/s\n", candidates[c] / 1024,
+                   buffer_size / (1024.0 * 1024.0) / (elapsed / 1e9));
+            if (elapsed < best_ns)
+            {
+                best_ns = elapsed;
+                best_size = candidates[c];
+            }
+        }
+        free(ctx.segments);
+        free_array(&jobs);
+    }
+
+    platform_aligned_free(buffer);
+    scan_chunk_size = best_size;
+    printf("[DEBUG] Chunk size calibrated to %zu KiB\n", scan_chunk_size / 1024);
+    return scan_chunk_size;
+}
+
+bool parse_value(const char *input, int type, void *output)
+{
+    char *endptr;
+    unsigned long long tmp;
+
+    // Floating point values, NaN never matches anything so it is refused
+    if (type == VALUE_FLOAT || type == VALUE_DOUBLE)
+    {
+        double number = strtod(input, &endptr);
+        if (endptr == input || *endptr != '\0' || number != number)
+            return false;
+        if (type == VALUE_DOUBLE)
+        {
+            memcpy(output, &number, sizeof(number));
+            return true;
+        }
+        float single = (float)number;
+        memcpy(output, &single, sizeof(single));
+        return true;
+    }
+
+    if (type < 0 || type >= VALUE_TYPE_COUNT || is_text_target_type(type))
+        return false;
+
+    size_t size = value_type_info[type].size;
+    uint64_t width_max = size == 8 ? UINT64_MAX : ((uint64_t)1 << (size * 8)) - 1;
+
+    // Hex is the raw bit pattern of the value, decimal is range checked for the type
+    if (input[0] == '0' && (input[1] == 'x' || input[1] == 'X'))
+    {
+        tmp = strtoull(input, &endptr, 16);
+        if (endptr == input || *endptr != '\0' || tmp > width_max)
+            return false;
+    }
+    else if (is_signed_type(type))
+    {
+        int64_t signed_max = (int64_t)(width_max >> 1);
+        errno = 0;
+        long long number = strtoll(input, &endptr, 10);
+        if (endptr == input || *endptr != '\0' || errno == ERANGE || number > signed_max || number < -signed_max - 1)
+            return false;
+        tmp = (uint64_t)number & width_max;
+    }
+    else
+    {
+        if (input[0] == '-')
+            return false;
+        errno = 0;
+        tmp = strtoull(input, &endptr, 10);
+        if (endptr == input || *endptr != '\0' || errno == ERANGE || tmp > width_max)
+            return false;
+    }
+
+    if (is_big_endian_type(type))
+        tmp = swap_integer(tmp, size);
+    memcpy(output, &tmp, size);
+    return true;
+}
+
+// Digits after the decimal point of a typed number, shifted by its exponent ("1.25" -> 2, "5e-3" -> 3)
+static int typed_decimals(const char *input)
+{
+    int decimals = 0;
+    const char *dot = strchr(input, '.');
+    const char *exponent = strpbrk(input, "eE");
+
+    if (dot)
+    {
+        for (const char *c = dot + 1; *c >= '0' && *c <= '9'; c++)
+            decimals++;
+    }
+    if (exponent && !(input[0] == '0' && (input[1] == 'x' || input[1] == 'X')))
+        decimals -= atoi(exponent + 1);
+    return max(-308, min(decimals, 17));
+}
+
+// Narrowest float range containing [lower, upper]: the bounds are rounded inwards so that no float
+// outside of the real interval is kept
+static void store_float_bounds(ValueType type, double lower, double upper, uint64_t *lower_bits, uint64_t *upper_bits)
+{
+    *lower_bits = 0;
+    *upper_bits = 0;
+    if (type == VALUE_DOUBLE)
+    {
+        memcpy(lower_bits, &lower, sizeof(lower));
+        memcpy(upper_bits, &upper, sizeof(upper));
+        return;
+    }
+
+    float low = (float)lower, high = (float)upper;
+    if ((double)low < lower)
+        low = nextafterf(low, INFINITY);
+    if ((double)high > upper)
+        high = nextafterf(high, -INFINITY);
+    memcpy(lower_bits, &low, sizeof(low));
+    memcpy(upper_bits, &high, sizeof(high));
+}
+
+bool float_match_range(const char *input, ValueType type, FloatCompareMode mode, double epsilon, uint64_t *lower, uint64_t *upper)
+{
+    double value;
+    uint64_t parsed = 0;
+
+    if ((type != VALUE_FLOAT && type != VALUE_DOUBLE) || !parse_value(input, type, &parsed))
+        return false;
+    // Centered on the typed decimal, not on its nearest float
+    value = strtod(input, NULL);
+
+    double step = pow(10.0, -typed_decimals(input));
+    switch (mode)
+    {
+    case FLOAT_COMPARE_ROUNDED:
+        // Rounds to the typed value: [value - step / 2, value + step / 2)
+        store_float_bounds(type, value - step / 2, nextafter(value + step / 2, -INFINITY), lower, upper);
+        return true;
+    case FLOAT_COMPARE_TRUNCATED:
+        // Truncates (towards zero) to the typed value
+        if (value > 0)
+            store_float_bounds(type, value, nextafter(value + step, -INFINITY), lower, upper);
+        else if (value < 0)
+            store_float_bounds(type, nextafter(value - step, INFINITY), value, lower, upper);
+        else
+            store_float_bounds(type, nextafter(-step, INFINITY), nextafter(step, -INFINITY), lower, upper);
+        return true;
+    case FLOAT_COMPARE_EPSILON:
+        store_float_bounds(type, value - fabs(epsilon), value + fabs(epsilon), lower, upper);
+        return true;
+    default:
+        *lower = parsed;
+        *upper = parsed;
+        return true;
+    }
+}
+
+bool get_value_size(int type, size_t *value_size)
+{
+    if (type < 0 || type >= VALUE_TYPE_COUNT)
+        return false;
+    *value_size = value_type_info[type].size;
+    return true;
+}
+
+static PlatformThread scan_thread;
+static bool scan_thread_started = false; // Owned by the thread that starts and polls scans
+static ScanRequest scan_request;
+static volatile int64_t scan_thread_found;
+
+static void scan_thread_proc(void *param)
+{
+    const ScanRequest *request = &scan_request;
+    LPCVOID target = is_text_target_type(request->value_type) ? (LPCVOID)request->text : (LPCVOID)&request->value;
+    bool found;
+
+    if (request->refine)
+        found = refine_results(request->process_handle, request->scan_type, target, &request->upper_value, request->value_type);
+    else
+        found = scan_process_memory(request->process_handle, request->scan_type, target, &request->upper_value, request->value_type);
+
+    platform_atomic_store64(&scan_thread_found, found);
+    scan_progress_end(&scan_progress);
+}
+
+bool start_scan_thread(const ScanRequest *request)
+{
+    if (scan_thread_started)
+        return false;
+
+    scan_request = *request;
+    prepare_result_stream();
+    scan_progress_begin(&scan_progress);
+    if (!platform_thread_start(&scan_thread, scan_thread_proc, NULL))
+    {
+        fprintf(stderr, "[ERROR] Failed to start scan thread\n");
+        scan_progress_end(&scan_progress);
+        return false;
+    }
+    scan_thread_started = true;
+    return true;
+}
+
+bool scan_thread_running()
+{
+    return scan_thread_started;
+}
+
+bool poll_scan_thread(bool *refine, bool *found)
+{
+    if (!scan_thread_started || platform_atomic_load64(&scan_progress.state) == SCAN_STATE_RUNNING)
+        return false;
+
+    platform_thread_join(&scan_thread);
+    scan_thread_started = false;
+    *refine = scan_request.refine;
+    *found = platform_atomic_load64(&scan_thread_found) != 0;
+    return true;
+}
+
+bool wait_scan_thread()
+{
+    if (!scan_thread_started)
+        return false;
+
+    platform_thread_join(&scan_thread);
+    scan_thread_started = false;
+    return platform_atomic_load64(&scan_thread_found) != 0;
+}
+
+void cancel_scan_thread()
+{
+    if (scan_thread_started)
+        scan_progress_cancel(&scan_progress);
+}
+
+// Builds the request for the values typed in the UI. Floating point values are matched under
+// selected_float_mode: an exact value scan or an increased/decreased by turns into a range.
+static bool prepare_scan_request(bool refine, HANDLE process_handle, ScanRequest *request)
+{
+    size_t value_size;
+
+    memset(request, 0, sizeof(ScanRequest));
+    request->refine = refine;
+    request->process_handle = process_handle;
+    request->scan_type = selected_scan_type;
+    request->value_type = selected_value_type;
+
+    // Text and signatures are parsed by the scan itself
+    if (is_text_target_type(selected_value_type))
+    {
+        strncpy_s(request->text, sizeof(request->text), search_value, _TRUNCATE);
+        return true;
+    }
+
+    // Parse input value
+    if (scan_type_needs_value(selected_scan_type) && !parse_value(search_value, selected_value_type, &request->value))
+    {
+        fprintf(stderr, "Invalid input value!\n");
+        return false;
+    }
+
+    if (selected_scan_type == SCAN_VALUE_BETWEEN && !parse_value(search_upper_value, selected_value_type, &request->upper_value))
+    {
+        fprintf(stderr, "Invalid upper bound value!\n");
+        return false;
+    }
+
+    if (!get_value_size(selected_value_type, &value_size))
+    {
+        fprintf(stderr, "Invalid value type!\n");
+        return false;
+    }
+
+    bool tolerant_type = selected_scan_type == SCAN_EXACT_VALUE || selected_scan_type == SCAN_INCREASED_BY ||
+                         selected_scan_type == SCAN_DECREASED_BY;
+    if (get_value_number(selected_value_type) == SCAN_NUMBER_FLOAT && tolerant_type)
+    {
+        double epsilon = strtod(search_epsilon, NULL);
+        if (!float_match_range(search_value, selected_value_type, selected_float_mode, epsilon, &request->value, &request->upper_value))
+        {
+            fprintf(stderr, "Invalid input value!\n");
+            return false;
+        }
+        if (selected_scan_type == SCAN_EXACT_VALUE && selected_float_mode != FLOAT_COMPARE_EXACT)
+            request->scan_type = SCAN_VALUE_BETWEEN;
+    }
+    return true;
+}
+
+void start_memory_scan(HANDLE process_handle, ResultsTable *table)
+{
+    ScanRequest request;
+    if (!prepare_scan_request(false, process_handle, &request))
+        return;
+
+    // Clear previous results, the table fills again as matches are streamed
+    clear_results_table(table);
+    result_set_clear(&scan_results, 1);
+    clear_array(&memory_values, 1, sizeof(uint64_t));
+    results_first_row = 0;
+
+    // Start the scan, its results are loaded by poll_memory_scan once it is done
+    if (!start_scan_thread(&request))
+        fprintf(stderr, "Failed to start the scan!\n");
+}
+
+void refine_memory_scan(HANDLE process_handle, ResultsTable *table)
+{
+    ScanRequest request;
+    if (!prepare_scan_request(true, process_handle, &request))
+        return;
+
+    // Refine the scan results in the background
+    clear_results_table(table);
+    results_first_row = 0;
+    if (!start_scan_thread(&request))
+        fprintf(stderr, "Failed to start the scan!\n");
+}
+
+// Adds the matches streamed since the last frame to the table, in the order they were found
+static void show_streamed_results(ResultsTable *table)
+{
+    StreamedResult streamed[64];
+    const char *previous = scan_request.refine ? previous_search_value : "N/A";
+    size_t count;
+
+    while (table->result_count < table->result_capacity &&
+           (count = result_stream_drain(&result_stream, streamed, min(64, table->result_capacity - table->result_count))) > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            char value_str[32];
+            format_value(&streamed[i].value, scan_request.value_type, value_str, sizeof(value_str));
+
+            // A string or signature match is the searched text
+            ResultEntry entry = {
+                .address = (LPVOID)streamed[i].address,
+                .value = _strdup(is_text_target_type(scan_request.value_type) ? scan_request.text : value_str),
+                .previous_value = _strdup(previous),
+                .type = scan_request.value_type};
+            table->results[table->result_count++] = entry;
+        }
+    }
+}
+
+void poll_memory_scan(ResultsTable *table)
+{
+    bool refine;
+    bool found;
+
+    if (scan_thread_running())
+        show_streamed_results(table);
+
+    if (!poll_scan_thread(&refine, &found))
+        return;
+
+    // The streamed rows are replaced by the first rows of the complete results, in address order
+    clear_results_table(table);
+
+    if (!found)
+    {
+        fprintf(stderr, "No matching values found!\n");
+        return;
+    }
+
+    // A first scan has no previous value to show
+    if (!load_results(scan_request.process_handle, table, search_value, refine ? previous_search_value : "N/A"))
+    {
+        fprintf(stderr, "Failed to load results addresses!\n");
+        return;
+    }
+
+    if (refine)
+        strncpy_s(previous_search_value, sizeof(previous_search_value), search_value, _TRUNCATE);
+}
+
+void show_results_page(HANDLE process_handle, ResultsTable *table, uint64_t first_row)
+{
+    results_first_row = first_row;
+    clear_results_table(table);
+
+    if (!load_results(process_handle, table, search_value, previous_search_value))
+        fprintf(stderr, "Failed to load results addresses!\n");
+}
+
+typedef struct
+{
+    ResultCursor first; // First candidate covered by the run
+    size_t candidate_count;
+} RefineRun;
+
+// Survivors of a refine, rebuilt segment by segment over the same chunks as the input set
+typedef struct
+{
+    ResultSetBuilder builder;
+    size_t segment; // Input segment the builder is filling
+    DynamicArray values;
+} RefineOutput;
+
+typedef struct
+{
+    SIZE_T total_matches;
+    SIZE_T read_errors;
+    SIZE_T partial_reads;
+    SIZE_T read_calls;
+    SIZE_T bytes_read;
+    SIZE_T dense_regions;
+    SIZE_T sparse_regions;
+    SIZE_T fallback_reads;
+} RefineStats;
+
+static uintptr_t page_floor(uintptr_t address)
+{
+    return address & ~(uintptr_t)(REFINE_PAGE_SIZE - 1);
+}
+
+static uintptr_t page_ceil(uintptr_t address)
+{
+    return (address + REFINE_PAGE_SIZE - 1) & ~(uintptr_t)(REFINE_PAGE_SIZE - 1);
+}
+
+static void keep_candidate(const ResultCursor *cursor, const BYTE *value, SIZE_T value_size, RefineOutput *output,
+                           RefineStats *stats)
+{
+    if (output->segment != cursor->segment)
+    {
+        const ResultSegment *segment = (const ResultSegment *)cursor->set->segments.data + cursor->segment;
+        result_builder_begin(&output->builder, segment->base, segment->slots);
+        output->segment = cursor->segment;
+    }
+
+    uint64_t recorded = 0;
+    uintptr_t address = result_cursor_address(cursor);
+    memcpy(&recorded, value, value_size);
+    result_builder_add(&output->builder, address);
+    append(&output->values, &recorded);
+    stream_result(result_stream.ring_count - 1, address, value, value_size);
+    stats->total_matches++;
+}
+
+// Reads one candidate on its own, used when the batched read of its run came back short
+static void refine_address_directly(HANDLE process_handle, const ResultCursor *cursor, const ScanFilter *filter,
+                                    const uint64_t *previous, SIZE_T value_size, RefineOutput *output, RefineStats *stats)
+{
+    uintptr_t addr = result_cursor_address(cursor);
+    uint8_t buffer[8] = {0};
+    SIZE_T bytes_read;
+
+    stats->fallback_reads++;
+    stats->read_calls++;
+
+    if (!platform_read_memory(process_handle, addr, buffer, value_size, &bytes_read))
+    {
+        stats->read_errors++;
+        return;
+    }
+
+    if (bytes_read != value_size)
+    {
+        stats->partial_reads++;
+        return;
+    }
+
+    if (filter_value(filter, buffer, (const uint8_t *)previous, value_size))
+    {
+        keep_candidate(cursor, buffer, value_size, output, stats);
+    }
+}
+
+// Decides how to read the candidates of one region: dense when at least half of the pages between
+// the first and the last candidate hold a candidate (read the span in big runs, gaps included),
+// sparse otherwise (read only touched pages, merging adjacent ones).
+static bool is_region_dense(ResultCursor cursor, uintptr_t region_end, SIZE_T value_size)
+{
+    size_t touched_pages = 0;
+    uintptr_t first_address = result_cursor_address(&cursor);
+    uintptr_t last_address = first_address;
+    uintptr_t last_page = page_floor(first_address);
+
+    for (; result_cursor_valid(&cursor); result_cursor_advance(&cursor))
+    {
+        uintptr_t address = result_cursor_address(&cursor);
+        if (address >= region_end)
+            break;
+
+        uintptr_t page = page_floor(address);
+        if (touched_pages == 0 || page != last_page)
+        {
+            touched_pages++;
+            last_page = page;
+        }
+        last_address = address;
+    }
+
+    uintptr_t span_start = page_floor(first_address);
+    uintptr_t span_end = page_ceil(last_address + value_size);
+    size_t span_pages = (span_end - span_start) / REFINE_PAGE_SIZE;
+
+    return touched_pages * 2 >= span_pages;
+}
+
+// Compares the candidates of one run inside its buffer. When candidates are packed tightly the
+// match kernel is run over the whole span and candidates just test their bit in the masks.
+// Delta filters compare every candidate against its own previous value instead.
+static void refine_run(const RefineRun *run, uintptr_t last_address, const MemoryReadRequest *request,
+                       HANDLE process_handle, const ScanFilter *filter, const uint64_t *previous, MatchKernel kernel,
+                       SIZE_T value_size, uint64_t *masks, RefineOutput *output, RefineStats *stats)
+{
+    const BYTE *run_buffer = (const BYTE *)request->buffer;
+    ResultCursor cursor = run->first;
+    size_t span_start = result_cursor_address(&cursor) - request->address;
+    size_t span_end = last_address - request->address + 1;
+    size_t mask_blocks = 0;
+
+    if (kernel && run->candidate_count * REFINE_KERNEL_DENSITY >= span_end - span_start &&
+        request->bytes_read >= span_start + value_size - 1)
+    {
+        size_t readable_offsets = request->bytes_read - value_size + 1 - span_start;
+        mask_blocks = min(span_end - span_start, readable_offsets) / SCAN_BLOCK_SIZE;
+        if (mask_blocks > 0)
+            kernel(run_buffer + span_start, mask_blocks, &filter->operands, masks);
+    }
+
+    for (size_t c = 0; c < run->candidate_count; c++, result_cursor_advance(&cursor))
+    {
+        const uint64_t *previous_value = previous ? &previous[cursor.ordinal] : NULL;
+        size_t offset = result_cursor_address(&cursor) - request->address;
+        size_t relative = offset - span_start;
+        bool hit;
+
+        if (relative / SCAN_BLOCK_SIZE < mask_blocks)
+        {
+            hit = (masks[relative / SCAN_BLOCK_SIZE] >> (relative % SCAN_BLOCK_SIZE)) & 1;
+        }
+        else if (offset + value_size <= request->bytes_read)
+        {
+            hit = filter_value(filter, run_buffer + offset, (const uint8_t *)previous_value, value_size);
+        }
+        else
+        {
+            refine_address_directly(process_handle, &cursor, filter, previous_value, value_size, output, stats);
+            continue;
+        }
+
+        if (hit)
+        {
+            keep_candidate(&cursor, run_buffer + offset, value_size, output, stats);
+        }
+    }
+}
+
+bool refine_results(HANDLE process_handle, ScanType scan_type, LPCVOID target_value, LPCVOID upper_value, ValueType value_type)
+{
+    SIZE_T value_size = 0;
+    ScanNumber number = get_value_number(value_type);
+
+    get_value_size(value_type, &value_size);
+    printf("[DEBUG] Starting refine_results...\n");
 
-        if (memcmp(buffer, target_value, value_size) == 0)
+    // Parameter validation
+    if (process_handle == NULL)
+    {
+        fprintf(stderr, "Error: Invalid process handle (NULL)\n");
+        return false;
+    }
+    if (target_value == NULL && scan_type_needs_value(scan_type))
+    {
+        fprintf(stderr, "Error: Target value pointer is NULL\n");
+        return false;
+    }
+    if (is_text_target_type(value_type))
+    {
+        fprintf(stderr, "Error: String and signature results cannot be refined, start a new scan\n");
+        return false;
+    }
+    if (value_size == 0 || value_size > 8)
+    {
+        fprintf(stderr, "Error: Invalid value type (%d)\n", (int)value_type);
+        return false;
+    }
+
+    ScanFilter filter;
+    if (!prepare_filter(scan_type, target_value, upper_value, value_size, number, &filter))
+    {
+        fprintf(stderr, "Error: Unsupported scan type for a refine (%d)\n", (int)scan_type);
+        return false;
+    }
+
+    if (scan_snapshot.active)
+        return refine_snapshot(process_handle, &filter, value_type);
+
+    const uint64_t *previous = NULL;
+    if (filter.delta)
+    {
+        if (memory_values.size != scan_results.count || memory_value_type != value_type)
+        {
+            fprintf(stderr, "Error: No previous values to compare with, start from an unknown initial value scan or refine once\n");
+            return false;
+        }
+        previous = (const uint64_t *)memory_values.data;
+    }
+    MatchKernel kernel = filter.delta ? NULL : get_match_kernel(get_best_scan_isa(), number, filter.compare, value_size);
+
+    DynamicArray regions;
+    create_array(&regions, 256, sizeof(MemoryRegion));
+    if (!platform_query_regions(process_handle, &regions))
+    {
+        DWORD error = GetLastError();
+        fprintf(stderr, "Error: Failed to enumerate memory regions (Error: 0x%lx : %s)\n",
+                (unsigned long)error, get_error_string(error));
+        free_array(&regions);
+        return false;
+    }
+
+    ResultSet survivors;
+    RefineOutput output = {.segment = (size_t)-1};
+    result_set_init(&survivors, scan_results.slot_size);
+    result_builder_init(&output.builder, &survivors);
+    create_array(&output.values, (size_t)min(scan_results.count, (uint64_t)100000) + 1, sizeof(uint64_t));
+
+    DynamicArray runs;
+    DynamicArray run_ends;
+    DynamicArray requests;
+    create_array(&runs, REFINE_MAX_BATCH_READS, sizeof(RefineRun));
+    create_array(&run_ends, REFINE_MAX_BATCH_READS, sizeof(uintptr_t));
+    create_array(&requests, REFINE_MAX_BATCH_READS, sizeof(MemoryReadRequest));
+
+    BYTE *batch_buffer = malloc(REFINE_BATCH_BYTES);
+    uint64_t *masks = malloc((REFINE_MAX_RUN / SCAN_BLOCK_SIZE) * sizeof(uint64_t));
+    if (!batch_buffer || !masks)
+    {
+        perror("Failed to allocate refine buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t count = scan_results.count;
+    RefineStats stats = {0};
+
+    printf("[DEBUG] Scanning %llu addresses...\n", (unsigned long long)count);
+    scan_progress_set_totals(&scan_progress, count, regions.size);
+
+    ResultCursor cursor;
+    result_cursor_init(&cursor, &scan_results);
+    size_t region_index = 0;
+    size_t density_region = (size_t)-1;
+    bool dense = false;
+
+    while (result_cursor_valid(&cursor) && !scan_progress_cancelled(&scan_progress))
+    {
+        size_t batch_bytes = 0;
+        runs.size = 0;
+        run_ends.size = 0;
+        requests.size = 0;
+
+        // Group consecutive candidates into page-aligned runs until the batch is full
+        while (result_cursor_valid(&cursor) && requests.size < REFINE_MAX_BATCH_READS)
+        {
+            uintptr_t addr = result_cursor_address(&cursor);
+
+            while (region_index < regions.size)
+            {
+                const MemoryRegion *region = (const MemoryRegion *)get(&regions, region_index);
+                if (region->base + region->size > addr)
+                    break;
+                region_index++;
+                scan_progress_region_done(&scan_progress);
+            }
+
+            const MemoryRegion *region = region_index < regions.size ? (const MemoryRegion *)get(&regions, region_index) : NULL;
+            if (!region || addr < region->base || (region->protection & REGION_READ) == 0 || (region->protection & REGION_GUARD))
+            {
+                // The page holding this candidate is gone or no longer readable
+                stats.read_errors++;
+                result_cursor_advance(&cursor);
+                continue;
+            }
+
+            uintptr_t region_end = region->base + region->size;
+            if (density_region != region_index)
+            {
+                density_region = region_index;
+                dense = is_region_dense(cursor, region_end, value_size);
+                if (dense)
+                    stats.dense_regions++;
+                else
+                    stats.sparse_regions++;
+            }
+
+            RefineRun run = {.first = cursor, .candidate_count = 1};
+            uintptr_t last_address = addr;
+            uintptr_t run_start = page_floor(addr);
+            uintptr_t run_end = min(page_ceil(addr + value_size), region_end);
+
+            for (result_cursor_advance(&cursor); result_cursor_valid(&cursor); result_cursor_advance(&cursor))
+            {
+                uintptr_t next = result_cursor_address(&cursor);
+                uintptr_t next_end = min(page_ceil(next + value_size), region_end);
+
+                if (next >= region_end)
+                    break;
+                if (!dense && page_floor(next) > run_end)
+                    break;
+                if (next_end - run_start > REFINE_MAX_RUN)
+                    break;
+                run_end = max(run_end, next_end);
+                last_address = next;
+                run.candidate_count++;
+            }
+
+            size_t run_size = run_end - run_start;
+            if (batch_bytes + run_size > REFINE_BATCH_BYTES)
+            {
+                // Does not fit anymore: it opens the next batch
+                cursor = run.first;
+                break;
+            }
+
+            MemoryReadRequest request = {.address = run_start, .buffer = batch_buffer + batch_bytes, .size = run_size, .bytes_read = 0};
+            append(&runs, &run);
+            append(&run_ends, &last_address);
+            append(&requests, &request);
+            batch_bytes += run_size;
+        }
+
+        if (requests.size == 0)
+            continue;
+
+        stats.read_calls += platform_read_memory_batch(process_handle, (MemoryReadRequest *)requests.data, requests.size);
+
+        // Compare every candidate in place inside its run
+        for (size_t r = 0; r < runs.size; r++)
+        {
+            const MemoryReadRequest *request = (const MemoryReadRequest *)get(&requests, r);
+            const RefineRun *run = (const RefineRun *)get(&runs, r);
+            SIZE_T matches_before = stats.total_matches;
+            stats.bytes_read += request->bytes_read;
+            refine_run(run, *(const uintptr_t *)get(&run_ends, r), request, process_handle,
+                       &filter, previous, kernel, value_size, masks, &output, &stats);
+            scan_progress_add(&scan_progress, run->candidate_count, request->bytes_read, stats.total_matches - matches_before);
+        }
+    }
+
+    // Candidates not reached before a cancel stay, with the value recorded for them when there is one
+    bool values_known = true;
+    if (result_cursor_valid(&cursor))
+    {
+        printf("[DEBUG] Refine cancelled, keeping the %llu candidates not compared yet\n",
+               (unsigned long long)(count - cursor.ordinal));
+        for (; result_cursor_valid(&cursor); result_cursor_advance(&cursor))
         {
-            printf("[MATCH] Found matching value at 0x%p\n", addr);
-            append(&temp_array, &addr);
-            total_matches++;
+            uint64_t recorded = previous ? previous[cursor.ordinal] : 0;
+            keep_candidate(&cursor, (const BYTE *)&recorded, value_size, &output, &stats);
         }
+        values_known = previous != NULL;
     }
 
     printf("[DEBUG] Scan complete. Results:\n"
-           "  Total addresses processed: %zu\n"
+           "  Total addresses processed: %llu\n"
            "  Successful matches: %zu\n"
            "  Read errors: %zu\n"
-           "  Partial reads: %zu\n",
-           memory_addresses.size, total_matches, read_errors, partial_reads);
-
-    printf("[DEBUG] Transferring results to main array\n");
-    transfer_array(&memory_addresses, &temp_array);
-    printf("[DEBUG] New address count: %zu\n", memory_addresses.size);
-
-    return memory_addresses.size > 0;
+           "  Partial reads: %zu\n"
+           "  Dense/sparse regions: %zu/%zu\n"
+           "  Read calls: %zu (%zu single-address fallbacks)\n"
+           "  Bytes read: %zu\n",
+           (unsigned long long)count, stats.total_matches, stats.read_errors, stats.partial_reads,
+           stats.dense_regions, stats.sparse_regions, stats.read_calls, stats.fallback_reads, stats.bytes_read);
+
+    free(batch_buffer);
+    free(masks);
+    free_array(&runs);
+    free_array(&run_ends);
+    free_array(&requests);
+    free_array(&regions);
+
+    result_builder_finish(&output.builder);
+    result_set_free(&scan_results);
+    scan_results = survivors;
+    free_array(&memory_values);
+    memory_values = output.values;
+    memory_value_type = value_type;
+    if (!values_known)
+        memory_values.size = 0;
+    printf("[DEBUG] New address count: %llu (%zu segments, %.1f MiB)\n", (unsigned long long)scan_results.count,
+           scan_results.segments.size, result_set_footprint(&scan_results) / (1024.0 * 1024.0));
+
+    return scan_results.count > 0;
 }
 
 bool load_results(HANDLE process_handle, ResultsTable *table, const char *search_value_str, const char *previous_search_value_str)
@@ -480,7 +2212,38 @@ bool load_results(HANDLE process_handle, ResultsTable *table, const char *search
         return false;
     }
 
-    size_t entries_to_show = min(MAX_RESULTS, memory_addresses.size);
+    // Candidates are only expanded for the rows on display
+    DynamicArray row_addresses;
+    DynamicArray row_values;
+    const uint64_t *values = NULL;
+    size_t available = 0;
+
+    create_array(&row_addresses, MAX_RESULTS, sizeof(LPVOID));
+    create_array(&row_values, MAX_RESULTS, sizeof(uint64_t));
+    if (scan_snapshot.active)
+    {
+        // Snapshots only show their first page
+        available = snapshot_collect(&scan_snapshot, MAX_RESULTS, &row_addresses, &row_values);
+        values = (const uint64_t *)row_values.data;
+    }
+    else
+    {
+        const uint64_t *recorded = memory_values.size == scan_results.count ? (const uint64_t *)memory_values.data : NULL;
+        ResultCursor cursor;
+        for (result_cursor_seek(&cursor, &scan_results, results_first_row); result_cursor_valid(&cursor) && available < MAX_RESULTS;
+             result_cursor_advance(&cursor), available++)
+        {
+            LPVOID address = (LPVOID)result_cursor_address(&cursor);
+            append(&row_addresses, &address);
+            if (recorded)
+                append(&row_values, &recorded[cursor.ordinal]);
+        }
+        values = recorded ? (const uint64_t *)row_values.data : NULL;
+    }
+    const LPVOID *addresses = (const LPVOID *)row_addresses.data;
+
+    size_t entries_to_show = min(MAX_RESULTS, available);
+    bool ok = true;
 
     for (size_t i = 0; i < entries_to_show; i++)
     {
@@ -489,12 +2252,18 @@ bool load_results(HANDLE process_handle, ResultsTable *table, const char *search
             break;
         }
 
-        LPVOID addr = *(LPVOID *)get(&memory_addresses, i);
+        LPVOID addr = addresses[i];
+
+        // Show the value read by the last scan when it was recorded, the searched value otherwise
+        char value_str[32];
+        if (values)
+            format_value(&values[i], memory_value_type, value_str, sizeof(value_str));
 
         ResultEntry entry = {
             .address = addr,
-            .value = _strdup(search_value_str),
-            .previous_value = _strdup(previous_search_value_str)};
+            .value = _strdup(values ? value_str : search_value_str),
+            .previous_value = _strdup(previous_search_value_str),
+            .type = memory_value_type};
 
         // Check for allocation errors
         if (!entry.value || !entry.previous_value)
@@ -502,48 +2271,132 @@ bool load_results(HANDLE process_handle, ResultsTable *table, const char *search
             fprintf(stderr, "Memory allocation failed for entry %zu\n", i);
             free(entry.value);
             free(entry.previous_value);
-            return false;
+            ok = false;
+            break;
         }
 
         table->results[table->result_count] = entry;
         table->result_count++;
     }
-    return true;
+
+    free_array(&row_addresses);
+    free_array(&row_values);
+    return ok;
 }
 
-bool change_process_memory(HANDLE hProcess, LPVOID address, const char *value_str, ValueType type)
+// Bytes written for value_str typed as type: a string as its encoded text without a terminator,
+// a number as its value_size bytes
+static bool encode_value(const char *value_str, ValueType type, uint8_t *bytes, size_t *size)
 {
-    SIZE_T bytesWritten;
-    size_t value_size;
-    uint64_t parsed_value = 0;
+    if (is_string_type(type))
+    {
+        BytePattern text;
+        if (!string_pattern_init(&text, value_str, value_type_info[type].utf16, true))
+        {
+            fprintf(stderr, "[ERROR] Failed to encode text '%s'.\n", value_str);
+            return false;
+        }
+        memcpy(bytes, text.bytes, text.length);
+        *size = text.length;
+        return true;
+    }
 
-    if (!get_value_size(type, &value_size))
+    uint64_t parsed_value = 0;
+    if (!get_value_size(type, size))
     {
         fprintf(stderr, "[ERROR] Invalid value type specified.\n");
         return false;
     }
-
     if (!parse_value(value_str, type, &parsed_value))
     {
         fprintf(stderr, "[ERROR] Failed to parse value '%s'.\n", value_str);
         return false;
     }
+    memcpy(bytes, &parsed_value, *size);
+    return true;
+}
+
+bool change_process_memory(HANDLE hProcess, LPVOID address, const char *value_str, ValueType type)
+{
+    SIZE_T bytesWritten;
+    size_t value_size;
+    uint8_t bytes[SCAN_PATTERN_MAX];
+
+    if (!encode_value(value_str, type, bytes, &value_size))
+        return false;
 
-    BOOL result = WriteProcessMemory(hProcess, address, &parsed_value, value_size, &bytesWritten);
+    bool result = platform_write_memory(hProcess, (uintptr_t)address, bytes, value_size, &bytesWritten);
     if (!result || bytesWritten != value_size)
     {
-        fprintf(stderr, "[ERROR] Failed to write to address %p. Error code: %lu\n", address, GetLastError());
+        fprintf(stderr, "[ERROR] Failed to write to address %p. Error code: %lu\n", address, (unsigned long)GetLastError());
         return false;
     }
 
-    printf("[INFO] Successfully wrote %llu (%zu bytes) to address %p\n", parsed_value, value_size, address);
+    printf("[INFO] Successfully wrote %s (%zu bytes) to address %p\n", value_str, value_size, address);
     return true;
 }
 
+bool write_selection_entry(HANDLE process_handle, SelectionEntry *entry)
+{
+    uintptr_t address = (uintptr_t)entry->address;
+    if (entry->chain && !freeze_chain_resolve(process_handle, entry->chain, &address))
+    {
+        fprintf(stderr, "[ERROR] Failed to follow the pointer chain of %p\n", entry->address);
+        return false;
+    }
+    entry->address = (void *)address;
+    return change_process_memory(process_handle, entry->address, entry->value, entry->type);
+}
+
+size_t compile_freeze_plan(HANDLE process_handle, const SelectionTable *table, FreezePlan *plan)
+{
+    size_t skipped = 0;
+
+    freeze_plan_init(plan, process_handle);
+    for (size_t i = 0; i < table->selection_count; i++)
+    {
+        const SelectionEntry *entry = &table->selection[i];
+        uint8_t bytes[SCAN_PATTERN_MAX];
+        size_t size;
+        if (!entry->freeze)
+            continue;
+        if (!encode_value(entry->value, entry->type, bytes, &size) || size == 0)
+            skipped++;
+        else if (entry->chain)
+            freeze_plan_add_chain(plan, entry->chain, bytes, size);
+        else
+            freeze_plan_add(plan, (uintptr_t)entry->address, bytes, size);
+    }
+    freeze_plan_finish(plan);
+    return skipped;
+}
+
+void update_freeze_plan(HANDLE process_handle)
+{
+    FreezePlan *plan = malloc(sizeof(FreezePlan));
+    if (!plan)
+    {
+        perror("Failed to allocate the freeze plan");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t skipped = compile_freeze_plan(process_handle, &selection_table, plan);
+    printf("[DEBUG] Freeze plan: %zu entries in %zu writes, %zu bytes, %zu pointer chains over %zu nodes, %zu entries skipped\n",
+           plan->entry_count, plan->writes.size, plan->bytes.size, plan->targets.size, plan->nodes.size, skipped);
+    freeze_engine_publish(&freeze_engine, plan);
+}
+
 const char *get_error_string(DWORD error_id)
 {
-    static char buffer[256];
+    // Scan workers report errors concurrently, so every thread formats into its own buffer
+    static PLATFORM_THREAD_LOCAL char buffer[256];
+#ifdef _WIN32
     FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
                    NULL, error_id, 0, buffer, sizeof(buffer), NULL);
+#else
+    // The XSI strerror_r: this file is not built with _GNU_SOURCE
+    if (strerror_r((int)error_id, buffer, sizeof(buffer)) != 0)
+        snprintf(buffer, sizeof(buffer), "Unknown error %lu", (unsigned long)error_id);
+#endif
     return buffer;
 }
\ No newline at end of file
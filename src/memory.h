@@ -3,24 +3,71 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "freeze.h"
 #include "process.h"
+#include "region_filter.h"
+#include "result_set.h"
+#include "scan_progress.h"
+#include "signature_set.h"
+#include "snapshot.h"
 
-#define CHUNK_SIZE (1024 * 1024)
+#define CHUNK_SIZE (1024 * 1024) // Default scan_chunk_size
 
-typedef struct
+#define REFINE_PAGE_SIZE 4096
+#define REFINE_MAX_RUN (256 * 1024)            // Largest single read issued by refine
+#define REFINE_BATCH_BYTES (4 * 1024 * 1024)   // Buffer shared by the reads of one batch
+#define REFINE_MAX_BATCH_READS 1024            // Reads per batch (one process_vm_readv on Linux)
+#define REFINE_KERNEL_DENSITY 16               // Use the match kernel on runs with a candidate every 16 bytes or less
+
+typedef enum
 {
-    void *address;
-    char *value;
-    char *previous_value;
-} ResultEntry;
+    SCAN_EXACT_VALUE,
+    SCAN_BIGGER_THAN,
+    SCAN_SMALLER_THAN,
+    SCAN_VALUE_BETWEEN,
+    SCAN_UNKNOWN_INITIAL,
+    SCAN_CHANGED, // Refinements against the previous scan
+    SCAN_UNCHANGED,
+    SCAN_INCREASED,
+    SCAN_DECREASED,
+    SCAN_INCREASED_BY,
+    SCAN_DECREASED_BY
+} ScanType;
+
+typedef enum
+{
+    VALUE_BYTE,
+    VALUE_2BYTES,
+    VALUE_4BYTES,
+    VALUE_8BYTES,
+    VALUE_FLOAT,
+    VALUE_DOUBLE,
+    VALUE_BYTE_SIGNED,
+    VALUE_2BYTES_SIGNED,
+    VALUE_4BYTES_SIGNED,
+    VALUE_8BYTES_SIGNED,
+    VALUE_2BYTES_BE, // Big-endian, as stored by network protocols and emulated consoles
+    VALUE_4BYTES_BE,
+    VALUE_8BYTES_BE,
+    VALUE_2BYTES_SIGNED_BE,
+    VALUE_4BYTES_SIGNED_BE,
+    VALUE_8BYTES_SIGNED_BE,
+    VALUE_STRING, // Text as typed (ASCII or UTF-8), searched by exact value scans only
+    VALUE_STRING_NOCASE,
+    VALUE_STRING_UTF16, // UTF-16LE text, as stored by Windows and most engines
+    VALUE_STRING_UTF16_NOCASE,
+    VALUE_SIGNATURE, // Array of bytes with wildcards ("48 8B 05 ?? ?? ?? ?? 89"), searched by exact value scans only
+    VALUE_GROUP,     // Values close to each other ("4:100 4:100@4 2:12 w:64"), searched by exact value scans only
+    VALUE_TYPE_COUNT
+} ValueType;
 
 typedef struct
 {
     void *address;
     char *value;
-    int length;
-    bool freeze;
-} SelectionEntry;
+    char *previous_value;
+    ValueType type; // Type the row was scanned as, not the one the combo box shows now
+} ResultEntry;
 
 typedef struct
 {
@@ -29,6 +76,16 @@ typedef struct
     size_t result_capacity;
 } ResultsTable;
 
+typedef struct
+{
+    void *address;      // Where chain last led, for an entry that follows one
+    char *value;        // MAX_NAME_LEN bytes, edited in place
+    int length;
+    bool freeze;
+    ValueType type;     // How value is written, chosen when the entry was added
+    FreezeChain *chain; // Pointer chain followed to the entry on every write, NULL for a fixed address
+} SelectionEntry;
+
 typedef struct
 {
     SelectionEntry *selection;
@@ -36,49 +93,103 @@ typedef struct
     size_t selection_capacity;
 } SelectionTable;
 
+// How a typed floating point value matches the values in memory
 typedef enum
 {
-    SCAN_EXACT_VALUE,
-    SCAN_BIGGER_THAN,
-    SCAN_SMALLER_THAN,
-    SCAN_VALUE_BETWEEN,
-    SCAN_UNKNOWN_INITIAL
-} ScanType;
+    FLOAT_COMPARE_EXACT,     // Same number (0.0 and -0.0 are the same, NaN matches nothing)
+    FLOAT_COMPARE_ROUNDED,   // Rounds to the typed value at the typed precision: 1.5 matches [1.45, 1.55)
+    FLOAT_COMPARE_TRUNCATED, // Truncates to the typed value at the typed precision: 1.5 matches [1.5, 1.6)
+    FLOAT_COMPARE_EPSILON    // Within the epsilon of the typed value
+} FloatCompareMode;
 
-typedef enum
-{
-    VALUE_BYTE,
-    VALUE_2BYTES,
-    VALUE_4BYTES,
-    VALUE_8BYTES
-} ValueType;
-
-extern DynamicArray memory_addresses;  // Dynamic array to store all memory addresses find with scan
+extern ResultSet scan_results;        // Addresses found by the scan, as per-chunk bitmaps or offset lists
+extern DynamicArray memory_values;     // Value of every result at the last refine (uint64_t, in result order), empty after a value scan
+extern MemorySnapshot scan_snapshot;   // Candidates of an unknown initial value scan until they fit in scan_results
+extern ScanProgress scan_progress;     // Status of the running (or last) scan, readable from any thread
+extern RegionFilter scan_region_filter; // Regions read by first scans (region_filter_init before the first scan)
 extern ResultsTable results_table;     // Memory table to store memory addresses displayed
 extern SelectionTable selection_table; // Memory table to store memory addresses selected by user
+extern FreezeEngine freeze_engine;     // Writes the frozen entries of selection_table (freeze_engine_init before use)
 
 extern char previous_search_value[MAX_NAME_LEN]; // Previous value trageted by scan
 extern char search_value[MAX_NAME_LEN];          // Value the scanner is looking for
 extern int search_value_len;                     // Length of the value string
-extern int selected_value_type;                  // Value type (0: Byte, 1: 2 Bytes, 2: 4 Bytes, 3: 8 Bytes)
-extern int selected_scan_type;                   // Scan type (0: Exact, 1: Bigger, 2. Smaller, 3: Range, 4: Unknown)
+extern char search_upper_value[MAX_NAME_LEN];    // Upper bound for "Value between" scans
+extern int search_upper_value_len;               // Length of the upper bound string
+extern int selected_value_type;                  // Value type (ValueType)
+extern int selected_float_mode;                  // Float and double matching (FloatCompareMode)
+extern char search_epsilon[MAX_NAME_LEN];        // Tolerance of FLOAT_COMPARE_EPSILON
+extern int search_epsilon_len;
+extern int selected_scan_type;                   // Scan type (ScanType)
+extern int scan_thread_count;                    // Scan worker threads (0: one per logical processor)
+extern bool scan_stop_at_first_match;            // First scans end with the first chunk that matched (unique signatures)
+extern size_t scan_chunk_size;                   // Bytes read and scanned at once by a first scan
+extern uint64_t results_first_row;               // Index of the first result shown in the results table
+
+// A scan run on the background scan thread
+typedef struct
+{
+    bool refine; // Next scan over the current results instead of a first scan
+    HANDLE process_handle;
+    ScanType scan_type;
+    uint64_t value;
+    uint64_t upper_value; // Also the upper bound of a floating point increased/decreased by
+    ValueType value_type;
+    char text[MAX_NAME_LEN]; // Searched text of string and signature value types
+} ScanRequest;
+
+// Scans are started, polled and waited for by one thread (the UI); scan_results, memory_values and
+// scan_snapshot belong to the scan thread until poll_scan_thread reported the end of the scan.
+// Progress and cancellation go through scan_progress.
+bool start_scan_thread(const ScanRequest *request);
+bool scan_thread_running();
+bool poll_scan_thread(bool *refine, bool *found); // True once, when the scan has ended (found: it kept results)
+bool wait_scan_thread();                          // Blocks until the scan ends, returns found
+void cancel_scan_thread();
 
 bool get_value_size(int type, size_t *value_size);
+ValueType get_integer_value_type(size_t value_size, bool is_signed, bool big_endian); // Big-endian bytes are just bytes
+ValueType get_string_value_type(bool utf16, bool case_sensitive);
+bool is_string_type(int type);
+bool is_text_target_type(int type); // String, signature and group scans take the typed text (const char *) as their target value
+bool scan_type_needs_value(ScanType scan_type);
 bool parse_value(const char *input, int type, void *output);
-bool refine_results(HANDLE process_handle, LPCVOID target_value, SIZE_T value_size);
-bool scan_process_memory(HANDLE process_handle, LPCVOID target_value, SIZE_T value_size);
+// Range [lower, upper] of the values input matches under mode (bounds stored as float or double bytes)
+bool float_match_range(const char *input, ValueType type, FloatCompareMode mode, double epsilon, uint64_t *lower, uint64_t *upper);
+bool refine_results(HANDLE process_handle, ScanType scan_type, LPCVOID target_value, LPCVOID upper_value, ValueType value_type);
+// A VALUE_GROUP target lists the fields of a structure as size:value, the size being 1, 2, 4, 8, f
+// (float) or d (double). The first field is at the address found. A field followed by @offset is
+// at that (signed) offset from it, any other field anywhere within the window of w:bytes (64 by
+// default) starting at it. Floats match the typed value at its precision, like rounded scans.
+bool scan_process_memory(HANDLE process_handle, ScanType scan_type, LPCVOID target_value, LPCVOID upper_value, ValueType value_type);
+// Finds every signature of set in one pass over the regions scan_region_filter keeps; results
+// (signature_results_init with set->count) gets the addresses of each. Leaves scan_results alone.
+bool scan_signatures(HANDLE process_handle, const SignatureSet *set, SignatureResults *results);
+size_t calibrate_chunk_size(); // Sets scan_chunk_size to the fastest size on this machine, returns it
 bool load_results(HANDLE process_handle, ResultsTable *table, const char *search_value_str, const char *previous_search_value_str);
 bool change_process_memory(HANDLE hProcess, LPVOID address, const char *value_str, ValueType type);
+// Writes the value of entry as its type, where its chain leads now for an entry that follows one
+bool write_selection_entry(HANDLE process_handle, SelectionEntry *entry);
+// Encodes the value of every frozen entry of table once, as the type of the entry; returns the
+// entries whose value does not parse
+size_t compile_freeze_plan(HANDLE process_handle, const SelectionTable *table, FreezePlan *plan);
+void update_freeze_plan(HANDLE process_handle); // Compiles selection_table and publishes it to freeze_engine
 
-void format_value(const void *value, size_t size, char *output, size_t output_size);
+void format_value(const void *value, ValueType type, char *output, size_t output_size);
 void refine_memory_scan(HANDLE process_handle, ResultsTable *table);
 void start_memory_scan(HANDLE process_handle, ResultsTable *table);
+void poll_memory_scan(ResultsTable *table);
+void show_results_page(HANDLE process_handle, ResultsTable *table, uint64_t first_row);
 void init_selection_table(SelectionTable *table);
+void add_selection_entry(SelectionTable *table, const SelectionEntry *entry); // Grows the table, which then owns entry->value and entry->chain
+// Adds an entry of type holding a copy of value, at address or, when chain is not NULL, wherever it leads
+bool add_selection_value(SelectionTable *table, void *address, const FreezeChain *chain, ValueType type, const char *value);
 void clear_selection_table(SelectionTable *table);
 void clear_results_table(ResultsTable *table);
 void init_results_table(ResultsTable *table);
 void start_freeze_thread();
 void stop_freeze_thread();
+void shutdown_scan_workers();
 
 const char *get_error_string(DWORD error_id);
 
@@ -0,0 +1,215 @@
+#include "packed_offsets.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define PACKED_SSE2 1
+#include <emmintrin.h>
+#else
+#define PACKED_SSE2 0
+#endif
+
+static size_t block_positions(size_t length)
+{
+    return (length + PACKED_LANES - 1) / PACKED_LANES;
+}
+
+// 32-bit words each lane needs for positions values of width bits
+static size_t lane_words(size_t positions, uint32_t bits)
+{
+    return (positions * bits + 31) / 32;
+}
+
+static uint32_t bit_width(uint32_t value)
+{
+    uint32_t bits = 0;
+    while (value)
+    {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+static size_t block_length(size_t count, size_t block)
+{
+    return min((size_t)PACKED_BLOCK_LENGTH, count - block * PACKED_BLOCK_LENGTH);
+}
+
+static void encode_block(PackedEncoder *encoder)
+{
+    const uint32_t *values = encoder->pending;
+    size_t length = encoder->pending_count;
+    size_t positions = block_positions(length);
+    uint32_t deltas[PACKED_BLOCK_LENGTH];
+    uint32_t widest = 0;
+
+    // Padding lanes of a short block repeat the last value, so their deltas are 0
+    for (size_t i = 0; i < positions * PACKED_LANES; i++)
+    {
+        uint32_t value = values[min(i, length - 1)];
+        uint32_t previous = i < PACKED_LANES ? values[0] : values[min(i - PACKED_LANES, length - 1)];
+        deltas[i] = value - previous;
+        widest |= deltas[i];
+    }
+
+    PackedBlock block = {.first = values[0], .offset = (uint32_t)encoder->words.size, .bits = bit_width(widest)};
+    size_t words = lane_words(positions, block.bits) * PACKED_LANES;
+    size_t base = encoder->words.size;
+
+    append(&encoder->blocks, &block);
+    reserve_array(&encoder->words, base + words);
+    uint32_t *packed = (uint32_t *)encoder->words.data + base;
+    memset(packed, 0, words * sizeof(uint32_t));
+    encoder->words.size = base + words;
+
+    for (size_t p = 0; p < positions && block.bits > 0; p++)
+    {
+        size_t bit = p * block.bits;
+        size_t word = bit / 32;
+        uint32_t shift = (uint32_t)(bit % 32);
+
+        for (size_t lane = 0; lane < PACKED_LANES; lane++)
+        {
+            uint32_t delta = deltas[p * PACKED_LANES + lane];
+            packed[word * PACKED_LANES + lane] |= delta << shift;
+            if (shift + block.bits > 32)
+                packed[(word + 1) * PACKED_LANES + lane] |= delta >> (32 - shift);
+        }
+    }
+
+    encoder->pending_count = 0;
+}
+
+void packed_encoder_init(PackedEncoder *encoder)
+{
+    create_array(&encoder->blocks, 16, sizeof(PackedBlock));
+    create_array(&encoder->words, 256, sizeof(uint32_t));
+    encoder->pending_count = 0;
+    encoder->count = 0;
+}
+
+void packed_encoder_push(PackedEncoder *encoder, uint32_t value)
+{
+    encoder->pending[encoder->pending_count++] = value;
+    encoder->count++;
+    if (encoder->pending_count == PACKED_BLOCK_LENGTH)
+        encode_block(encoder);
+}
+
+void *packed_encoder_finish(PackedEncoder *encoder, size_t *encoded_bytes)
+{
+    if (encoder->pending_count > 0)
+        encode_block(encoder);
+
+    size_t block_bytes = encoder->blocks.size * sizeof(PackedBlock);
+    size_t word_bytes = encoder->words.size * sizeof(uint32_t);
+    *encoded_bytes = block_bytes + word_bytes;
+    if (encoder->count == 0)
+        return NULL;
+
+    uint8_t *packed = malloc(block_bytes + word_bytes);
+    if (!packed)
+    {
+        perror("Failed to allocate packed offsets");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(packed, encoder->blocks.data, block_bytes);
+    memcpy(packed + block_bytes, encoder->words.data, word_bytes);
+    return packed;
+}
+
+void packed_encoder_free(PackedEncoder *encoder)
+{
+    free_array(&encoder->blocks);
+    free_array(&encoder->words);
+}
+
+size_t packed_block_count(size_t count)
+{
+    return (count + PACKED_BLOCK_LENGTH - 1) / PACKED_BLOCK_LENGTH;
+}
+
+size_t packed_encoded_bytes(const void *packed, size_t count)
+{
+    size_t blocks = packed_block_count(count);
+    if (blocks == 0)
+        return 0;
+
+    const PackedBlock *last = (const PackedBlock *)packed + blocks - 1;
+    size_t last_words = lane_words(block_positions(block_length(count, blocks - 1)), last->bits) * PACKED_LANES;
+    return blocks * sizeof(PackedBlock) + (last->offset + last_words) * sizeof(uint32_t);
+}
+
+size_t packed_decode_block(const void *packed, size_t count, size_t block, uint32_t *values)
+{
+    const PackedBlock *header = (const PackedBlock *)packed + block;
+    const uint32_t *words = (const uint32_t *)((const PackedBlock *)packed + packed_block_count(count)) + header->offset;
+    size_t length = block_length(count, block);
+    size_t positions = block_positions(length);
+    uint32_t bits = header->bits;
+    uint32_t mask = bits == 32 ? UINT32_MAX : (((uint32_t)1 << bits) - 1);
+
+#if PACKED_SSE2
+    __m128i sum = _mm_set1_epi32((int)header->first);
+    __m128i lane_mask = _mm_set1_epi32((int)mask);
+
+    for (size_t p = 0; p < positions; p++)
+    {
+        if (bits > 0)
+        {
+            size_t bit = p * bits;
+            size_t word = bit / 32;
+            uint32_t shift = (uint32_t)(bit % 32);
+
+            __m128i delta = _mm_srl_epi32(_mm_loadu_si128((const __m128i *)(words + word * PACKED_LANES)), _mm_cvtsi32_si128((int)shift));
+            if (shift + bits > 32)
+            {
+                __m128i high = _mm_loadu_si128((const __m128i *)(words + (word + 1) * PACKED_LANES));
+                delta = _mm_or_si128(delta, _mm_sll_epi32(high, _mm_cvtsi32_si128((int)(32 - shift))));
+            }
+            sum = _mm_add_epi32(sum, _mm_and_si128(delta, lane_mask));
+        }
+        _mm_storeu_si128((__m128i *)(values + p * PACKED_LANES), sum);
+    }
+#else
+    uint32_t sum[PACKED_LANES];
+    for (size_t lane = 0; lane < PACKED_LANES; lane++)
+        sum[lane] = header->first;
+
+    for (size_t p = 0; p < positions; p++)
+    {
+        size_t bit = p * bits;
+        size_t word = bit / 32;
+        uint32_t shift = (uint32_t)(bit % 32);
+
+        for (size_t lane = 0; lane < PACKED_LANES; lane++)
+        {
+            if (bits > 0)
+            {
+                uint32_t delta = words[word * PACKED_LANES + lane] >> shift;
+                if (shift + bits > 32)
+                    delta |= words[(word + 1) * PACKED_LANES + lane] << (32 - shift);
+                sum[lane] += delta & mask;
+            }
+            values[p * PACKED_LANES + lane] = sum[lane];
+        }
+    }
+#endif
+
+    return length;
+}
+
+size_t packed_find_block(const void *packed, size_t count, uint32_t value)
+{
+    const PackedBlock *blocks = (const PackedBlock *)packed;
+    size_t lo = 0, hi = packed_block_count(count);
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (blocks[mid].first <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo > 0 ? lo - 1 : 0;
+}
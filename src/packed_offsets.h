@@ -0,0 +1,46 @@
+#ifndef PACKED_OFFSETS_H
+#define PACKED_OFFSETS_H
+
+#include "platform.h"
+
+// Sorted uint32_t offsets compressed by blocks of 128: each value is stored as its distance to the
+// value 4 places before it (the block's first value for the first four), bit-packed with the
+// narrowest width of the block across 4 interleaved 32-bit lanes, so one SSE2 register decodes
+// four values per step and the prefix sum is a plain vector add.
+#define PACKED_BLOCK_LENGTH 128
+#define PACKED_LANES 4
+
+// Skip index entry, one per block, stored ahead of the packed words
+typedef struct
+{
+    uint32_t first;  // First value of the block
+    uint32_t offset; // Index of the block's first word
+    uint32_t bits;   // Width of every delta in the block (0-32)
+} PackedBlock;
+
+// Streaming encoder: values are pushed in ascending order and packed one block at a time
+typedef struct
+{
+    DynamicArray blocks; // PackedBlock
+    DynamicArray words;  // uint32_t
+    uint32_t pending[PACKED_BLOCK_LENGTH];
+    size_t pending_count;
+    size_t count;
+} PackedEncoder;
+
+void packed_encoder_init(PackedEncoder *encoder);
+void packed_encoder_push(PackedEncoder *encoder, uint32_t value);
+// Flushes the last block and returns the encoding as one allocation (blocks then words), NULL when empty
+void *packed_encoder_finish(PackedEncoder *encoder, size_t *encoded_bytes);
+void packed_encoder_free(PackedEncoder *encoder);
+
+size_t packed_block_count(size_t count);
+size_t packed_encoded_bytes(const void *packed, size_t count);
+
+// Decodes block index of a list of count values into values, returns how many it holds
+size_t packed_decode_block(const void *packed, size_t count, size_t block, uint32_t *values);
+
+// Index of the last block whose first value is <= value (0 when there is none)
+size_t packed_find_block(const void *packed, size_t count, uint32_t value);
+
+#endif
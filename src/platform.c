@@ -0,0 +1,648 @@
+#ifndef _WIN32
+#define _GNU_SOURCE
+#endif
+
+#include "platform.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+typedef struct
+{
+    PlatformThreadFunc func;
+    void *arg;
+} ThreadStart;
+
+#ifdef _WIN32
+
+HANDLE platform_current_process(void)
+{
+    return GetCurrentProcess();
+}
+
+HANDLE platform_open_process(uint32_t pid)
+{
+    return OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ | PROCESS_VM_WRITE | PROCESS_VM_OPERATION, FALSE, pid);
+}
+
+void platform_close_process(HANDLE process)
+{
+    if (process)
+        CloseHandle(process);
+}
+
+static uint32_t convert_protection(DWORD protect)
+{
+    uint32_t flags = 0;
+
+    switch (protect & 0xFF)
+    {
+    case PAGE_READONLY:
+        flags = REGION_READ;
+        break;
+    case PAGE_READWRITE:
+    case PAGE_WRITECOPY:
+        flags = REGION_READ | REGION_WRITE;
+        break;
+    case PAGE_EXECUTE:
+        flags = REGION_EXECUTE;
+        break;
+    case PAGE_EXECUTE_READ:
+        flags = REGION_READ | REGION_EXECUTE;
+        break;
+    case PAGE_EXECUTE_READWRITE:
+    case PAGE_EXECUTE_WRITECOPY:
+        flags = REGION_READ | REGION_WRITE | REGION_EXECUTE;
+        break;
+    }
+
+    if (protect & PAGE_GUARD)
+        flags |= REGION_GUARD;
+
+    return flags;
+}
+
+bool platform_query_regions(HANDLE process, DynamicArray *regions)
+{
+    MEMORY_BASIC_INFORMATION mbi;
+    LPVOID current_address = 0;
+
+    while (1)
+    {
+        SIZE_T bytes_returned = VirtualQueryEx(process, current_address, &mbi, sizeof(mbi));
+
+        if (bytes_returned == 0)
+        {
+            // ERROR_INVALID_PARAMETER marks the end of the address space
+            return GetLastError() == ERROR_INVALID_PARAMETER;
+        }
+
+        if (mbi.State == MEM_COMMIT)
+        {
+            MemoryRegion region = {
+                .base = (uintptr_t)mbi.BaseAddress,
+                .size = mbi.RegionSize,
+                .protection = convert_protection(mbi.Protect),
+                .native_protect = mbi.Protect,
+                .type = mbi.Type == MEM_IMAGE ? REGION_IMAGE : (mbi.Type == MEM_MAPPED ? REGION_MAPPED : REGION_PRIVATE)};
+            append(regions, &region);
+        }
+
+        current_address = (LPVOID)((ULONG_PTR)mbi.BaseAddress + mbi.RegionSize);
+    }
+}
+
+bool platform_query_modules(HANDLE process, DynamicArray *modules)
+{
+    HMODULE handles[1024];
+    DWORD bytes_needed = 0;
+
+    if (!EnumProcessModulesEx(process, handles, sizeof(handles), &bytes_needed, LIST_MODULES_ALL))
+        return false;
+
+    DWORD count = min(bytes_needed, (DWORD)sizeof(handles)) / sizeof(HMODULE);
+    for (DWORD i = 0; i < count; i++)
+    {
+        MODULEINFO info;
+        ModuleInfo module = {0};
+
+        if (!GetModuleInformation(process, handles[i], &info, sizeof(info)))
+            continue;
+        module.base = (uintptr_t)info.lpBaseOfDll;
+        module.size = info.SizeOfImage;
+        if (!GetModuleBaseNameA(process, handles[i], module.name, sizeof(module.name)))
+            continue;
+        append(modules, &module);
+    }
+    return true;
+}
+
+bool platform_read_memory(HANDLE process, uintptr_t address, void *buffer, size_t size, size_t *bytes_read)
+{
+    SIZE_T read = 0;
+    BOOL ok = ReadProcessMemory(process, (LPCVOID)address, buffer, size, &read);
+    if (bytes_read)
+        *bytes_read = read;
+    return ok || read > 0;
+}
+
+// Returns the number of system calls issued
+size_t platform_read_memory_batch(HANDLE process, MemoryReadRequest *requests, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        platform_read_memory(process, requests[i].address, requests[i].buffer, requests[i].size, &requests[i].bytes_read);
+    }
+    return count;
+}
+
+bool platform_write_memory(HANDLE process, uintptr_t address, const void *buffer, size_t size, size_t *bytes_written)
+{
+    SIZE_T written = 0;
+    BOOL ok = WriteProcessMemory(process, (LPVOID)address, buffer, size, &written);
+    if (bytes_written)
+        *bytes_written = written;
+    return ok && written == size;
+}
+
+// Returns the number of system calls issued
+size_t platform_write_memory_batch(HANDLE process, MemoryWriteRequest *requests, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        platform_write_memory(process, requests[i].address, requests[i].buffer, requests[i].size, &requests[i].bytes_written);
+    }
+    return count;
+}
+
+static DWORD WINAPI thread_trampoline(LPVOID param)
+{
+    ThreadStart start = *(ThreadStart *)param;
+    free(param);
+    start.func(start.arg);
+    return 0;
+}
+
+bool platform_thread_start(PlatformThread *thread, PlatformThreadFunc func, void *arg)
+{
+    ThreadStart *start = malloc(sizeof(ThreadStart));
+    if (!start)
+        return false;
+
+    start->func = func;
+    start->arg = arg;
+    thread->handle = CreateThread(NULL, 0, thread_trampoline, start, 0, NULL);
+    if (!thread->handle)
+    {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void platform_thread_join(PlatformThread *thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    thread->handle = NULL;
+}
+
+void platform_mutex_init(PlatformMutex *mutex) { InitializeSRWLock(mutex); }
+void platform_mutex_lock(PlatformMutex *mutex) { AcquireSRWLockExclusive(mutex); }
+void platform_mutex_unlock(PlatformMutex *mutex) { ReleaseSRWLockExclusive(mutex); }
+void platform_mutex_destroy(PlatformMutex *mutex) { (void)mutex; }
+void platform_cond_init(PlatformCond *cond) { InitializeConditionVariable(cond); }
+void platform_cond_wait(PlatformCond *cond, PlatformMutex *mutex) { SleepConditionVariableSRW(cond, mutex, INFINITE, 0); }
+void platform_cond_broadcast(PlatformCond *cond) { WakeAllConditionVariable(cond); }
+void platform_cond_destroy(PlatformCond *cond) { (void)cond; }
+
+int platform_cpu_count(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+uint64_t platform_time_ns(void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+}
+
+void platform_sleep_ms(uint32_t milliseconds)
+{
+    Sleep(milliseconds);
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+void platform_timer_create(PlatformTimer *timer)
+{
+    // High resolution where the system has them (Windows 10 1803 and later) instead of the 15.6 ms
+    // scheduler tick
+    *timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!*timer)
+        *timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+}
+
+void platform_timer_destroy(PlatformTimer *timer)
+{
+    if (*timer)
+        CloseHandle(*timer);
+    *timer = NULL;
+}
+
+void platform_sleep_until_ns(PlatformTimer *timer, uint64_t deadline_ns)
+{
+    uint64_t now = platform_time_ns();
+    if (deadline_ns <= now)
+        return;
+
+    LARGE_INTEGER due;
+    due.QuadPart = -(LONGLONG)((deadline_ns - now + 99) / 100); // Relative, in 100 ns units
+    if (*timer && SetWaitableTimer(*timer, &due, 0, NULL, NULL, FALSE))
+        WaitForSingleObject(*timer, INFINITE);
+    else
+        Sleep((DWORD)((deadline_ns - now + 999999) / 1000000));
+}
+
+void *platform_aligned_alloc(size_t size, size_t alignment)
+{
+    return _aligned_malloc(size, alignment);
+}
+
+void platform_aligned_free(void *memory)
+{
+    _aligned_free(memory);
+}
+
+const void *platform_map_file(const char *path, size_t *size)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER file_size;
+    const void *view = NULL;
+
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 && (uint64_t)file_size.QuadPart <= SIZE_MAX)
+    {
+        // The view keeps the mapping and the file open once their handles are closed
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)file_size.QuadPart;
+    }
+    CloseHandle(file);
+    return view;
+}
+
+void platform_unmap_file(const void *view, size_t size)
+{
+    (void)size;
+    if (view)
+        UnmapViewOfFile(view);
+}
+
+#else
+
+HANDLE platform_current_process(void)
+{
+    return (HANDLE)(intptr_t)getpid();
+}
+
+HANDLE platform_open_process(uint32_t pid)
+{
+    // There is no handle to open: probe that the pid exists and can be signalled
+    if (pid == 0 || kill((pid_t)pid, 0) != 0)
+        return NULL;
+    return (HANDLE)(intptr_t)pid;
+}
+
+void platform_close_process(HANDLE process)
+{
+    (void)process;
+}
+
+bool platform_query_regions(HANDLE process, DynamicArray *regions)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/maps", (int)(intptr_t)process);
+
+    FILE *maps = fopen(path, "r");
+    if (!maps)
+        return false;
+
+    char line[4096];
+    while (fgets(line, sizeof(line), maps))
+    {
+        unsigned long long start, end, file_offset;
+        unsigned long inode;
+        char perms[8] = {0};
+        char device[16] = {0};
+        int path_start = 0;
+
+        if (sscanf(line, "%llx-%llx %7s %llx %15s %lu %n", &start, &end, perms, &file_offset, device, &inode, &path_start) < 6)
+            continue;
+
+        const char *name = path_start > 0 ? line + path_start : "";
+        MemoryRegion region = {
+            .base = (uintptr_t)start,
+            .size = (size_t)(end - start),
+            .protection = 0,
+            .native_protect = (uint32_t)((perms[0] == 'r') | (perms[1] == 'w') << 1 | (perms[2] == 'x') << 2 | (perms[3] == 's') << 3),
+            .type = REGION_PRIVATE};
+
+        if (perms[0] == 'r')
+            region.protection |= REGION_READ;
+        if (perms[1] == 'w')
+            region.protection |= REGION_WRITE;
+        if (perms[2] == 'x')
+            region.protection |= REGION_EXECUTE;
+
+        // Kernel pseudo-mappings cannot be read through process_vm_readv
+        if (strncmp(name, "[vvar", 5) == 0 || strncmp(name, "[vsyscall]", 10) == 0)
+            region.protection = 0;
+
+        if (perms[3] == 's')
+            region.type = REGION_MAPPED;
+        else if (inode != 0)
+            region.type = REGION_IMAGE;
+
+        append(regions, &region);
+    }
+
+    fclose(maps);
+    return true;
+}
+
+// Every file mapped from a regular file counts as a module; the consecutive mappings of one file
+// (its text, data and bss) make a single module
+bool platform_query_modules(HANDLE process, DynamicArray *modules)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/maps", (int)(intptr_t)process);
+
+    FILE *maps = fopen(path, "r");
+    if (!maps)
+        return false;
+
+    char line[4096];
+    char last_path[4096] = {0};
+    while (fgets(line, sizeof(line), maps))
+    {
+        unsigned long long start, end, file_offset;
+        unsigned long inode;
+        char perms[8] = {0};
+        char device[16] = {0};
+        int path_start = 0;
+
+        line[strcspn(line, "\n")] = '\0';
+        if (sscanf(line, "%llx-%llx %7s %llx %15s %lu %n", &start, &end, perms, &file_offset, device, &inode, &path_start) < 6)
+            continue;
+        const char *file = path_start > 0 ? line + path_start : "";
+
+        // Anonymous mappings right after a module (its bss) belong to it as well
+        if (inode == 0 || file[0] != '/')
+        {
+            if (file[0] == '\0' && modules->size > 0 && last_path[0] != '\0')
+            {
+                ModuleInfo *last = (ModuleInfo *)get(modules, modules->size - 1);
+                if (last->base + last->size == (uintptr_t)start)
+                    last->size = (size_t)(end - last->base);
+            }
+            last_path[0] = '\0';
+            continue;
+        }
+
+        if (modules->size > 0 && strcmp(file, last_path) == 0)
+        {
+            ModuleInfo *last = (ModuleInfo *)get(modules, modules->size - 1);
+            last->size = (size_t)(end - last->base);
+            continue;
+        }
+
+        ModuleInfo module = {.base = (uintptr_t)start, .size = (size_t)(end - start)};
+        const char *name = strrchr(file, '/');
+        snprintf(module.name, sizeof(module.name), "%s", name ? name + 1 : file);
+        snprintf(last_path, sizeof(last_path), "%s", file);
+        append(modules, &module);
+    }
+
+    fclose(maps);
+    return true;
+}
+
+bool platform_read_memory(HANDLE process, uintptr_t address, void *buffer, size_t size, size_t *bytes_read)
+{
+    struct iovec local = {.iov_base = buffer, .iov_len = size};
+    struct iovec remote = {.iov_base = (void *)address, .iov_len = size};
+
+    ssize_t result = process_vm_readv((pid_t)(intptr_t)process, &local, 1, &remote, 1, 0);
+    if (bytes_read)
+        *bytes_read = result > 0 ? (size_t)result : 0;
+    return result > 0;
+}
+
+#define READ_BATCH_IOVECS 1024
+
+// Returns the number of system calls issued. process_vm_readv stops at the first remote range
+// that faults: that request keeps its partial count and the batch resumes after it.
+size_t platform_read_memory_batch(HANDLE process, MemoryReadRequest *requests, size_t count)
+{
+    struct iovec local[READ_BATCH_IOVECS];
+    struct iovec remote[READ_BATCH_IOVECS];
+    size_t calls = 0;
+    size_t i = 0;
+
+    while (i < count)
+    {
+        size_t n = min(count - i, (size_t)READ_BATCH_IOVECS);
+        for (size_t k = 0; k < n; k++)
+        {
+            local[k].iov_base = requests[i + k].buffer;
+            local[k].iov_len = requests[i + k].size;
+            remote[k].iov_base = (void *)requests[i + k].address;
+            remote[k].iov_len = requests[i + k].size;
+            requests[i + k].bytes_read = 0;
+        }
+
+        ssize_t result = process_vm_readv((pid_t)(intptr_t)process, local, (unsigned long)n, remote, (unsigned long)n, 0);
+        calls++;
+
+        size_t remaining = result > 0 ? (size_t)result : 0;
+        size_t k = 0;
+        while (k < n && remaining >= requests[i + k].size)
+        {
+            requests[i + k].bytes_read = requests[i + k].size;
+            remaining -= requests[i + k].size;
+            k++;
+        }
+
+        // Everything read, or keep what the faulting request got and resume after it
+        if (k < n)
+        {
+            requests[i + k].bytes_read = remaining;
+            k++;
+        }
+        i += k;
+    }
+    return calls;
+}
+
+bool platform_write_memory(HANDLE process, uintptr_t address, const void *buffer, size_t size, size_t *bytes_written)
+{
+    struct iovec local = {.iov_base = (void *)buffer, .iov_len = size};
+    struct iovec remote = {.iov_base = (void *)address, .iov_len = size};
+
+    ssize_t result = process_vm_writev((pid_t)(intptr_t)process, &local, 1, &remote, 1, 0);
+    if (bytes_written)
+        *bytes_written = result > 0 ? (size_t)result : 0;
+    return result == (ssize_t)size;
+}
+
+// Returns the number of system calls issued, resuming after a faulting request like
+// platform_read_memory_batch
+size_t platform_write_memory_batch(HANDLE process, MemoryWriteRequest *requests, size_t count)
+{
+    struct iovec local[READ_BATCH_IOVECS];
+    struct iovec remote[READ_BATCH_IOVECS];
+    size_t calls = 0;
+    size_t i = 0;
+
+    while (i < count)
+    {
+        size_t n = min(count - i, (size_t)READ_BATCH_IOVECS);
+        for (size_t k = 0; k < n; k++)
+        {
+            local[k].iov_base = (void *)requests[i + k].buffer;
+            local[k].iov_len = requests[i + k].size;
+            remote[k].iov_base = (void *)requests[i + k].address;
+            remote[k].iov_len = requests[i + k].size;
+            requests[i + k].bytes_written = 0;
+        }
+
+        ssize_t result = process_vm_writev((pid_t)(intptr_t)process, local, (unsigned long)n, remote, (unsigned long)n, 0);
+        calls++;
+
+        size_t remaining = result > 0 ? (size_t)result : 0;
+        size_t k = 0;
+        while (k < n && remaining >= requests[i + k].size)
+        {
+            requests[i + k].bytes_written = requests[i + k].size;
+            remaining -= requests[i + k].size;
+            k++;
+        }
+        if (k < n)
+        {
+            requests[i + k].bytes_written = remaining;
+            k++;
+        }
+        i += k;
+    }
+    return calls;
+}
+
+static void *thread_trampoline(void *param)
+{
+    ThreadStart start = *(ThreadStart *)param;
+    free(param);
+    start.func(start.arg);
+    return NULL;
+}
+
+bool platform_thread_start(PlatformThread *thread, PlatformThreadFunc func, void *arg)
+{
+    ThreadStart *start = malloc(sizeof(ThreadStart));
+    if (!start)
+        return false;
+
+    start->func = func;
+    start->arg = arg;
+    if (pthread_create(&thread->thread, NULL, thread_trampoline, start) != 0)
+    {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void platform_thread_join(PlatformThread *thread)
+{
+    pthread_join(thread->thread, NULL);
+}
+
+void platform_mutex_init(PlatformMutex *mutex) { pthread_mutex_init(mutex, NULL); }
+void platform_mutex_lock(PlatformMutex *mutex) { pthread_mutex_lock(mutex); }
+void platform_mutex_unlock(PlatformMutex *mutex) { pthread_mutex_unlock(mutex); }
+void platform_mutex_destroy(PlatformMutex *mutex) { pthread_mutex_destroy(mutex); }
+void platform_cond_init(PlatformCond *cond) { pthread_cond_init(cond, NULL); }
+void platform_cond_wait(PlatformCond *cond, PlatformMutex *mutex) { pthread_cond_wait(cond, mutex); }
+void platform_cond_broadcast(PlatformCond *cond) { pthread_cond_broadcast(cond); }
+void platform_cond_destroy(PlatformCond *cond) { pthread_cond_destroy(cond); }
+
+int platform_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+uint64_t platform_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void platform_sleep_ms(uint32_t milliseconds)
+{
+    struct timespec ts = {.tv_sec = milliseconds / 1000, .tv_nsec = (long)(milliseconds % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+void platform_timer_create(PlatformTimer *timer) { *timer = 0; }
+void platform_timer_destroy(PlatformTimer *timer) { (void)timer; }
+
+void platform_sleep_until_ns(PlatformTimer *timer, uint64_t deadline_ns)
+{
+    (void)timer;
+    struct timespec ts = {.tv_sec = (time_t)(deadline_ns / 1000000000ull), .tv_nsec = (long)(deadline_ns % 1000000000ull)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+void *platform_aligned_alloc(size_t size, size_t alignment)
+{
+    void *memory;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : NULL;
+}
+
+void platform_aligned_free(void *memory)
+{
+    free(memory);
+}
+
+const void *platform_map_file(const char *path, size_t *size)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    void *view = NULL;
+
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED)
+            view = NULL;
+        *size = (size_t)info.st_size;
+    }
+    close(fd);
+    return view;
+}
+
+void platform_unmap_file(const void *view, size_t size)
+{
+    if (view)
+        munmap((void *)view, size);
+}
+
+#endif
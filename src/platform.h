@@ -0,0 +1,315 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dynamic_array.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <intrin.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+
+// Minimal Win32 vocabulary so the scanner core builds headless on Linux.
+// A process HANDLE is the target pid cast to a pointer.
+typedef void *HANDLE;
+typedef void *LPVOID;
+typedef const void *LPCVOID;
+typedef size_t SIZE_T;
+typedef uintptr_t ULONG_PTR;
+typedef uint32_t DWORD;
+typedef uint8_t BYTE;
+typedef int BOOL;
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define _TRUNCATE ((size_t)-1)
+#define _strdup strdup
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define Sleep(ms) platform_sleep_ms(ms)
+#define GetLastError() ((DWORD)errno)
+
+static inline int strncpy_s(char *dest, size_t dest_size, const char *src, size_t count)
+{
+    if (!dest || dest_size == 0)
+        return EINVAL;
+    size_t len = strnlen(src, count == _TRUNCATE ? dest_size - 1 : min(count, dest_size - 1));
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+    return 0;
+}
+#endif
+
+// Protection flags of a region, normalized across platforms
+#define REGION_READ 0x1
+#define REGION_WRITE 0x2
+#define REGION_EXECUTE 0x4
+#define REGION_GUARD 0x8
+
+typedef enum
+{
+    REGION_PRIVATE,
+    REGION_IMAGE,
+    REGION_MAPPED
+} RegionType;
+
+typedef struct
+{
+    uintptr_t base;
+    size_t size;
+    uint32_t protection;     // REGION_* flags
+    uint32_t native_protect; // Raw protection as reported by the OS (for logs)
+    RegionType type;
+} MemoryRegion;
+
+#define MODULE_NAME_LEN 256
+
+// Executable image or shared library loaded in a process
+typedef struct
+{
+    uintptr_t base;
+    size_t size; // From base to the end of its last mapping
+    char name[MODULE_NAME_LEN]; // File name without the directory
+} ModuleInfo;
+
+// One read of a batch issued through platform_read_memory_batch
+typedef struct
+{
+    uintptr_t address;
+    void *buffer;
+    size_t size;
+    size_t bytes_read; // Filled in by the batch: size, a shorter partial count, or 0 on failure
+} MemoryReadRequest;
+
+// One write of a batch issued through platform_write_memory_batch
+typedef struct
+{
+    uintptr_t address;
+    const void *buffer;
+    size_t size;
+    size_t bytes_written; // Filled in by the batch like MemoryReadRequest.bytes_read
+} MemoryWriteRequest;
+
+typedef void (*PlatformThreadFunc)(void *arg);
+
+#ifdef _WIN32
+#define PLATFORM_THREAD_LOCAL __declspec(thread)
+#else
+#define PLATFORM_THREAD_LOCAL __thread
+#endif
+
+#ifdef _WIN32
+typedef struct
+{
+    HANDLE handle;
+} PlatformThread;
+typedef SRWLOCK PlatformMutex;
+typedef CONDITION_VARIABLE PlatformCond;
+typedef HANDLE PlatformTimer; // Waitable timer, NULL when none could be created
+#else
+typedef struct
+{
+    pthread_t thread;
+} PlatformThread;
+typedef pthread_mutex_t PlatformMutex;
+typedef pthread_cond_t PlatformCond;
+typedef int PlatformTimer; // clock_nanosleep needs no timer object
+#endif
+
+// Process access
+HANDLE platform_current_process(void); // Handle to this process, not to be closed
+HANDLE platform_open_process(uint32_t pid);
+void platform_close_process(HANDLE process);
+bool platform_query_regions(HANDLE process, DynamicArray *regions);
+bool platform_query_modules(HANDLE process, DynamicArray *modules); // ModuleInfo, in load order
+bool platform_read_memory(HANDLE process, uintptr_t address, void *buffer, size_t size, size_t *bytes_read);
+size_t platform_read_memory_batch(HANDLE process, MemoryReadRequest *requests, size_t count);
+bool platform_write_memory(HANDLE process, uintptr_t address, const void *buffer, size_t size, size_t *bytes_written);
+size_t platform_write_memory_batch(HANDLE process, MemoryWriteRequest *requests, size_t count);
+
+// Threads and synchronization
+bool platform_thread_start(PlatformThread *thread, PlatformThreadFunc func, void *arg);
+void platform_thread_join(PlatformThread *thread);
+void platform_mutex_init(PlatformMutex *mutex);
+void platform_mutex_lock(PlatformMutex *mutex);
+void platform_mutex_unlock(PlatformMutex *mutex);
+void platform_mutex_destroy(PlatformMutex *mutex);
+void platform_cond_init(PlatformCond *cond);
+void platform_cond_wait(PlatformCond *cond, PlatformMutex *mutex);
+void platform_cond_broadcast(PlatformCond *cond);
+void platform_cond_destroy(PlatformCond *cond);
+
+// System
+int platform_cpu_count(void);
+uint64_t platform_time_ns(void);
+void platform_sleep_ms(uint32_t milliseconds);
+// A timer belongs to the thread sleeping on it: created when the thread starts, destroyed before it ends
+void platform_timer_create(PlatformTimer *timer);
+void platform_timer_destroy(PlatformTimer *timer);
+void platform_sleep_until_ns(PlatformTimer *timer, uint64_t deadline_ns); // On the high resolution timer, deadline in platform_time_ns time
+void *platform_aligned_alloc(size_t size, size_t alignment); // alignment: a power of two, multiple of sizeof(void *)
+void platform_aligned_free(void *memory);
+
+// Read-only view of a whole file, NULL when it cannot be opened or is empty
+const void *platform_map_file(const char *path, size_t *size);
+void platform_unmap_file(const void *view, size_t size);
+
+// Bit scanning and byte swapping
+#ifdef _WIN32
+static inline int platform_ctz64(uint64_t value)
+{
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+}
+
+static inline int platform_popcount64(uint64_t value)
+{
+    return (int)__popcnt64(value);
+}
+
+static inline uint16_t platform_bswap16(uint16_t value)
+{
+    return _byteswap_ushort(value);
+}
+
+static inline uint32_t platform_bswap32(uint32_t value)
+{
+    return _byteswap_ulong(value);
+}
+
+static inline uint64_t platform_bswap64(uint64_t value)
+{
+    return _byteswap_uint64(value);
+}
+#else
+static inline int platform_ctz64(uint64_t value)
+{
+    return __builtin_ctzll(value);
+}
+
+static inline int platform_popcount64(uint64_t value)
+{
+    return __builtin_popcountll(value);
+}
+
+static inline uint16_t platform_bswap16(uint16_t value)
+{
+    return __builtin_bswap16(value);
+}
+
+static inline uint32_t platform_bswap32(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+static inline uint64_t platform_bswap64(uint64_t value)
+{
+    return __builtin_bswap64(value);
+}
+#endif
+
+// Atomics on 64-bit integers and pointers (acquire loads, release stores, full-barrier RMW)
+#ifdef _WIN32
+static inline int64_t platform_atomic_load64(volatile int64_t *p)
+{
+    int64_t value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void platform_atomic_store64(volatile int64_t *p, int64_t value)
+{
+    _ReadWriteBarrier();
+    *p = value;
+}
+
+static inline int64_t platform_atomic_add64(volatile int64_t *p, int64_t value)
+{
+    return InterlockedExchangeAdd64((volatile LONG64 *)p, value);
+}
+
+static inline bool platform_atomic_cas64(volatile int64_t *p, int64_t expected, int64_t desired)
+{
+    return InterlockedCompareExchange64((volatile LONG64 *)p, desired, expected) == expected;
+}
+
+static inline void *platform_atomic_load_ptr(void *volatile *p)
+{
+    void *value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void platform_atomic_store_ptr(void *volatile *p, void *value)
+{
+    _ReadWriteBarrier();
+    *p = value;
+}
+
+static inline void *platform_atomic_exchange_ptr(void *volatile *p, void *value)
+{
+    return InterlockedExchangePointer(p, value);
+}
+
+static inline void platform_atomic_fence(void)
+{
+    MemoryBarrier();
+}
+#else
+static inline int64_t platform_atomic_load64(volatile int64_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void platform_atomic_store64(volatile int64_t *p, int64_t value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+static inline int64_t platform_atomic_add64(volatile int64_t *p, int64_t value)
+{
+    return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline bool platform_atomic_cas64(volatile int64_t *p, int64_t expected, int64_t desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline void *platform_atomic_load_ptr(void *volatile *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void platform_atomic_store_ptr(void *volatile *p, void *value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+static inline void *platform_atomic_exchange_ptr(void *volatile *p, void *value)
+{
+    return __atomic_exchange_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline void platform_atomic_fence(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+#endif
+
+#endif
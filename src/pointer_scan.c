@@ -0,0 +1,789 @@
+#include "pointer_scan.h"
+
+// Pointers are read at their natural alignment, as the target (of the same pointer width) stores them
+#define POINTER_ALIGN sizeof(uintptr_t)
+#define POINTER_TASKS_PER_WORKER 16 // Search nodes handed to every worker, for the pool to balance
+#define POINTER_SLOT_SHIFT 32        // Values are first looked up by 4 GiB slot of the address space
+#define POINTER_SLOT_COUNT 65536     // Slots of a 48-bit address space, above which nothing is mapped
+#define POINTER_FILE_MAGIC 0x50414D5254504553ull // "SEPTRMAP"
+#define POINTER_FILE_VERSION 1
+#define POINTER_FILE_BATCH 65536      // Entries written at once
+#define POINTER_READ_BATCH 4096       // Trie nodes read by one revalidation task
+
+// Start of a pointer map file, followed by its modules, regions, entries and address index
+typedef struct
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t pointer_size; // sizeof(uintptr_t) of the build that wrote it, which sizes every section
+    uint64_t entry_count;
+    uint64_t module_count;
+    uint64_t region_count;
+    uint64_t scanned_bytes;
+} PointerMapFileHeader;
+
+typedef struct
+{
+    HANDLE process;
+    const AddressRange *chunks;     // Parts of the scanned regions, read one per task
+    const AddressRange *readable;   // Every readable region, merged and ascending: what pointers may point into
+    size_t readable_count;
+    uint64_t slots[POINTER_SLOT_COUNT / 64]; // Bit of every slot that holds readable memory
+    DynamicArray *found;            // PointerMapEntry of every chunk
+    uint8_t **buffers;              // One chunk buffer per worker
+    volatile int64_t scanned_bytes;
+} PointerMapBuild;
+
+static bool is_readable(const PointerMapBuild *build, uintptr_t value)
+{
+    size_t low = 0, high = build->readable_count;
+    uint64_t slot = (uint64_t)value >> POINTER_SLOT_SHIFT;
+
+    // Most values are not addresses at all, and fall in a slot without readable memory
+    if (slot >= POINTER_SLOT_COUNT || (build->slots[slot / 64] >> (slot % 64) & 1) == 0)
+        return false;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (build->readable[mid].end <= value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low < build->readable_count && build->readable[low].start <= value;
+}
+
+static void pointer_map_task(void *context, size_t task_index, int worker_index)
+{
+    PointerMapBuild *build = (PointerMapBuild *)context;
+    const AddressRange *chunk = &build->chunks[task_index];
+    uint8_t *buffer = build->buffers[worker_index];
+    DynamicArray *found = &build->found[task_index];
+    size_t bytes_read = 0;
+
+    create_array(found, 64, sizeof(PointerMapEntry));
+    platform_read_memory(build->process, chunk->start, buffer, chunk->end - chunk->start, &bytes_read);
+    for (size_t offset = 0; offset + sizeof(uintptr_t) <= bytes_read; offset += POINTER_ALIGN)
+    {
+        uintptr_t value;
+        memcpy(&value, buffer + offset, sizeof(value));
+        if (!is_readable(build, value))
+            continue;
+        if (found->size == found->capacity)
+            reserve_array(found, found->capacity * 2);
+        PointerMapEntry *entry = (PointerMapEntry *)found->data + found->size++;
+        entry->value = value;
+        entry->address = chunk->start + offset;
+    }
+    platform_atomic_add64(&build->scanned_bytes, (int64_t)bytes_read);
+}
+
+// Stable LSD radix sort by value, 16 bits per pass up to the highest value: entries gathered in
+// address order stay in address order for the same value. origins[i] starts as i and moves along
+// with entry i.
+static void sort_entries(PointerMapEntry *entries, uint32_t *origins, size_t count)
+{
+    PointerMapEntry *scratch = malloc((count + 1) * sizeof(PointerMapEntry));
+    uint32_t *origin_scratch = malloc((count + 1) * sizeof(uint32_t));
+    size_t *buckets = malloc(65536 * sizeof(size_t));
+    uintptr_t highest = 0;
+
+    if (!scratch || !origin_scratch || !buckets)
+    {
+        perror("Failed to allocate the pointer map sort");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < count; i++)
+        highest = max(highest, entries[i].value);
+
+    PointerMapEntry *from = entries, *to = scratch;
+    uint32_t *origins_from = origins, *origins_to = origin_scratch;
+    for (unsigned shift = 0; shift < sizeof(uintptr_t) * 8 && (highest >> shift) != 0; shift += 16)
+    {
+        memset(buckets, 0, 65536 * sizeof(size_t));
+        for (size_t i = 0; i < count; i++)
+            buckets[(from[i].value >> shift) & 0xFFFF]++;
+        for (size_t b = 0, total = 0; b < 65536; b++)
+        {
+            size_t bucket = buckets[b];
+            buckets[b] = total;
+            total += bucket;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t slot = buckets[(from[i].value >> shift) & 0xFFFF]++;
+            to[slot] = from[i];
+            origins_to[slot] = origins_from[i];
+        }
+
+        PointerMapEntry *swap = from;
+        from = to;
+        to = swap;
+        uint32_t *origins_swap = origins_from;
+        origins_from = origins_to;
+        origins_to = origins_swap;
+    }
+    if (from != entries)
+    {
+        memcpy(entries, from, count * sizeof(PointerMapEntry));
+        memcpy(origins, origins_from, count * sizeof(uint32_t));
+    }
+    free(scratch);
+    free(origin_scratch);
+    free(buckets);
+}
+
+// Readable regions, adjacent ones merged, as the ranges pointers may point into
+static void collect_readable(const DynamicArray *regions, DynamicArray *readable)
+{
+    for (size_t r = 0; r < regions->size; r++)
+    {
+        const MemoryRegion *region = (const MemoryRegion *)regions->data + r;
+        if ((region->protection & REGION_READ) == 0 || (region->protection & REGION_GUARD) != 0)
+            continue;
+
+        AddressRange *last = readable->size > 0 ? (AddressRange *)get(readable, readable->size - 1) : NULL;
+        if (last && last->end == region->base)
+            last->end = region->base + region->size;
+        else
+        {
+            AddressRange range = {region->base, region->base + region->size};
+            append(readable, &range);
+        }
+    }
+}
+
+bool pointer_map_build(HANDLE process, const RegionFilter *filter, ThreadPool *pool, PointerMap *map)
+{
+    DynamicArray regions, kept, readable, chunks;
+    RegionFilterStats stats;
+
+    memset(map, 0, sizeof(PointerMap));
+    create_array(&map->modules, 64, sizeof(ModuleInfo));
+    create_array(&map->regions, 256, sizeof(AddressRange));
+    create_array(&regions, 256, sizeof(MemoryRegion));
+    create_array(&kept, 256, sizeof(MemoryRegion));
+    create_array(&readable, 256, sizeof(AddressRange));
+    create_array(&chunks, 1024, sizeof(AddressRange));
+
+    if (!platform_query_regions(process, &regions) || !platform_query_modules(process, &map->modules) ||
+        !region_filter_apply(filter, process, &regions, &kept, &stats))
+    {
+        free_array(&regions);
+        free_array(&kept);
+        free_array(&readable);
+        free_array(&chunks);
+        pointer_map_free(map);
+        return false;
+    }
+    collect_readable(&regions, &readable);
+
+    // Aligned chunks of the kept regions, one task each
+    for (size_t r = 0; r < kept.size; r++)
+    {
+        const MemoryRegion *region = (const MemoryRegion *)kept.data + r;
+        AddressRange scanned = {region->base, region->base + region->size};
+        append(&map->regions, &scanned);
+        uintptr_t start = (region->base + POINTER_ALIGN - 1) & ~(uintptr_t)(POINTER_ALIGN - 1);
+        for (uintptr_t end = region->base + region->size; start < end; start += POINTER_MAP_CHUNK)
+        {
+            AddressRange chunk = {start, min(start + POINTER_MAP_CHUNK, end)};
+            append(&chunks, &chunk);
+        }
+    }
+
+    int worker_count = pool ? pool->worker_count : 1;
+    PointerMapBuild *build = calloc(1, sizeof(PointerMapBuild));
+    if (!build)
+    {
+        perror("Failed to allocate the pointer map build");
+        exit(EXIT_FAILURE);
+    }
+    *build = (PointerMapBuild){
+        .process = process,
+        .chunks = (const AddressRange *)chunks.data,
+        .readable = (const AddressRange *)readable.data,
+        .readable_count = readable.size,
+        .found = calloc(chunks.size + 1, sizeof(DynamicArray)),
+        .buffers = calloc((size_t)worker_count, sizeof(uint8_t *))};
+    for (size_t r = 0; r < readable.size; r++)
+    {
+        const AddressRange *range = (const AddressRange *)readable.data + r;
+        uint64_t last = min((uint64_t)(range->end - 1) >> POINTER_SLOT_SHIFT, POINTER_SLOT_COUNT - 1);
+        for (uint64_t slot = (uint64_t)range->start >> POINTER_SLOT_SHIFT; slot <= last; slot++)
+            build->slots[slot / 64] |= 1ull << (slot % 64);
+    }
+    if (!build->found || !build->buffers)
+    {
+        perror("Failed to allocate the pointer map build");
+        exit(EXIT_FAILURE);
+    }
+    for (int w = 0; w < worker_count; w++)
+    {
+        build->buffers[w] = malloc(POINTER_MAP_CHUNK);
+        if (!build->buffers[w])
+        {
+            perror("Failed to allocate a pointer map buffer");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (pool)
+        thread_pool_run(pool, chunks.size, pointer_map_task, build);
+    else
+    {
+        for (size_t i = 0; i < chunks.size; i++)
+            pointer_map_task(build, i, 0);
+    }
+
+    // Chunks are in address order, their pointers are sorted by value once gathered. Where each
+    // entry came from in that order gives the address index.
+    size_t count = 0;
+    for (size_t i = 0; i < chunks.size; i++)
+        count += build->found[i].size;
+    PointerMapEntry *entries = count <= UINT32_MAX ? malloc((count + 1) * sizeof(PointerMapEntry)) : NULL;
+    uint32_t *origins = count <= UINT32_MAX ? malloc((count + 1) * sizeof(uint32_t)) : NULL;
+    uint32_t *by_address = count <= UINT32_MAX ? malloc((count + 1) * sizeof(uint32_t)) : NULL;
+    if (count <= UINT32_MAX && (!entries || !origins || !by_address))
+    {
+        perror("Failed to allocate the pointer map");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0, offset = 0; i < chunks.size; i++)
+    {
+        if (entries)
+            memcpy(entries + offset, build->found[i].data, build->found[i].size * sizeof(PointerMapEntry));
+        offset += build->found[i].size;
+        free_array(&build->found[i]);
+    }
+    if (entries)
+    {
+        for (size_t i = 0; i < count; i++)
+            origins[i] = (uint32_t)i;
+        sort_entries(entries, origins, count);
+        for (size_t i = 0; i < count; i++)
+            by_address[origins[i]] = (uint32_t)i;
+    }
+    else
+        printf("[DEBUG] Pointer map of %zu pointers is over the 4G limit\n", count);
+    free(origins);
+    map->entries = entries;
+    map->by_address = by_address;
+    map->count = entries ? count : 0;
+    map->scanned_bytes = (size_t)build->scanned_bytes;
+
+    for (int w = 0; w < worker_count; w++)
+        free(build->buffers[w]);
+    free(build->buffers);
+    free(build->found);
+    free(build);
+    free_array(&regions);
+    free_array(&kept);
+    free_array(&readable);
+    free_array(&chunks);
+    if (!entries)
+        pointer_map_free(map);
+    return entries != NULL;
+}
+
+void pointer_map_free(PointerMap *map)
+{
+    if (map->file_view)
+        platform_unmap_file(map->file_view, map->file_size);
+    else
+    {
+        free((void *)map->entries);
+        free((void *)map->by_address);
+    }
+    free_array(&map->modules);
+    free_array(&map->regions);
+    memset(map, 0, sizeof(PointerMap));
+}
+
+bool pointer_map_save(const PointerMap *map, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    PointerMapFileHeader header = {POINTER_FILE_MAGIC, POINTER_FILE_VERSION, (uint32_t)sizeof(uintptr_t), map->count,
+                                   map->modules.size, map->regions.size, map->scanned_bytes};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(map->modules.data, sizeof(ModuleInfo), map->modules.size, file) == map->modules.size &&
+              fwrite(map->regions.data, sizeof(AddressRange), map->regions.size, file) == map->regions.size;
+
+    // Sections go out in batches, the file is never assembled in memory
+    for (size_t i = 0; ok && i < map->count; i += POINTER_FILE_BATCH)
+    {
+        size_t batch = min(map->count - i, (size_t)POINTER_FILE_BATCH);
+        ok = fwrite(map->entries + i, sizeof(PointerMapEntry), batch, file) == batch;
+    }
+    for (size_t i = 0; ok && i < map->count; i += POINTER_FILE_BATCH)
+    {
+        size_t batch = min(map->count - i, (size_t)POINTER_FILE_BATCH);
+        ok = fwrite(map->by_address + i, sizeof(uint32_t), batch, file) == batch;
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        remove(path);
+    return ok;
+}
+
+bool pointer_map_open(PointerMap *map, const char *path)
+{
+    memset(map, 0, sizeof(PointerMap));
+
+    size_t size = 0;
+    const uint8_t *view = platform_map_file(path, &size);
+    if (!view)
+        return false;
+
+    // Every section must be where the header says, and the file end with the last one
+    const PointerMapFileHeader *header = (const PointerMapFileHeader *)view;
+    uint64_t modules_at = sizeof(PointerMapFileHeader);
+    uint64_t regions_at = 0, entries_at = 0, index_at = 0, end = 0;
+    bool ok = size >= sizeof(PointerMapFileHeader) && header->magic == POINTER_FILE_MAGIC &&
+              header->version == POINTER_FILE_VERSION && header->pointer_size == sizeof(uintptr_t) &&
+              header->entry_count <= UINT32_MAX && header->module_count <= size && header->region_count <= size;
+    if (ok)
+    {
+        regions_at = modules_at + header->module_count * sizeof(ModuleInfo);
+        entries_at = regions_at + header->region_count * sizeof(AddressRange);
+        index_at = entries_at + header->entry_count * sizeof(PointerMapEntry);
+        end = index_at + header->entry_count * sizeof(uint32_t);
+        ok = end == size;
+    }
+    if (!ok)
+    {
+        platform_unmap_file(view, size);
+        return false;
+    }
+
+    map->file_view = view;
+    map->file_size = size;
+    map->count = (size_t)header->entry_count;
+    map->entries = (const PointerMapEntry *)(view + entries_at);
+    map->by_address = (const uint32_t *)(view + index_at);
+    map->scanned_bytes = (size_t)header->scanned_bytes;
+    create_array(&map->modules, (size_t)header->module_count + 1, sizeof(ModuleInfo));
+    create_array(&map->regions, (size_t)header->region_count + 1, sizeof(AddressRange));
+    append_many(&map->modules, view + modules_at, (size_t)header->module_count);
+    append_many(&map->regions, view + regions_at, (size_t)header->region_count);
+    return true;
+}
+
+bool pointer_map_read(const PointerMap *map, uintptr_t address, uintptr_t *value)
+{
+    size_t low = 0, high = map->count;
+
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        uint32_t index = map->by_address[mid];
+        if (index < map->count && map->entries[index].address < address)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == map->count || map->by_address[low] >= map->count)
+        return false;
+
+    const PointerMapEntry *entry = &map->entries[map->by_address[low]];
+    if (entry->address != address)
+        return false;
+    *value = entry->value;
+    return true;
+}
+
+// An address still to reach: the target, or where a pointer on the way to it is stored
+typedef struct
+{
+    uintptr_t address;
+    uint32_t depth;                      // Pointers between it and the target
+    int32_t offsets[POINTER_MAX_DEPTH];  // Added after each of them, the last one first
+} PointerNode;
+
+typedef struct
+{
+    uintptr_t base;
+    uintptr_t end;
+    uint32_t module;
+} ModuleSpan;
+
+typedef struct
+{
+    const PointerMap *map;
+    const PointerScanOptions *options;
+    const ModuleSpan *modules; // Ascending
+    size_t module_count;
+    const PointerNode *frontier;
+    DynamicArray *paths;       // PointerPath found by every worker
+    volatile int64_t found;
+} PointerSearch;
+
+static int compare_spans(const void *a, const void *b)
+{
+    uintptr_t x = ((const ModuleSpan *)a)->base, y = ((const ModuleSpan *)b)->base;
+    return x < y ? -1 : x > y;
+}
+
+// Module whose image holds address, or NULL for a dynamic address
+static const ModuleSpan *find_module(const PointerSearch *search, uintptr_t address)
+{
+    size_t low = 0, high = search->module_count;
+
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (search->modules[mid].end <= address)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low < search->module_count && search->modules[low].base <= address ? &search->modules[low] : NULL;
+}
+
+// First entry pointing at value or above
+static size_t lower_bound(const PointerMap *map, uintptr_t value)
+{
+    size_t low = 0, high = map->count;
+
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (map->entries[mid].value < value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+static bool search_full(PointerSearch *search)
+{
+    return search->options->max_paths > 0 && (size_t)platform_atomic_load64(&search->found) >= search->options->max_paths;
+}
+
+// Follows every pointer into [node->address - max_offset, node->address] back: those stored in a
+// module end a path, the others are searched from in turn, right away or by adding them to children
+static void visit_node(PointerSearch *search, const PointerNode *node, DynamicArray *paths, DynamicArray *children)
+{
+    const PointerMap *map = search->map;
+    uintptr_t lowest = node->address - min(node->address, (uintptr_t)search->options->max_offset);
+
+    for (size_t e = lower_bound(map, lowest); e < map->count && map->entries[e].value <= node->address; e++)
+    {
+        if (search_full(search))
+            return;
+
+        const PointerMapEntry *entry = &map->entries[e];
+        PointerNode next = *node;
+        next.address = entry->address;
+        next.offsets[next.depth++] = (int32_t)(node->address - entry->value);
+
+        const ModuleSpan *module = find_module(search, entry->address);
+        if (module)
+        {
+            PointerPath path = {module->module, next.depth, entry->address - module->base, {0}};
+            for (uint32_t level = 0; level < next.depth; level++)
+                path.offsets[level] = next.offsets[next.depth - 1 - level];
+            if (search->options->max_paths == 0 || (size_t)platform_atomic_add64(&search->found, 1) < search->options->max_paths)
+                append(paths, &path);
+        }
+        else if (next.depth < search->options->max_depth)
+        {
+            if (children)
+                append(children, &next);
+            else
+                visit_node(search, &next, paths, NULL);
+        }
+    }
+}
+
+static void pointer_search_task(void *context, size_t task_index, int worker_index)
+{
+    PointerSearch *search = (PointerSearch *)context;
+    visit_node(search, &search->frontier[task_index], &search->paths[worker_index], NULL);
+}
+
+static int compare_paths(const void *a, const void *b)
+{
+    const PointerPath *x = (const PointerPath *)a, *y = (const PointerPath *)b;
+    if (x->depth != y->depth)
+        return x->depth < y->depth ? -1 : 1;
+    if (x->module != y->module)
+        return x->module < y->module ? -1 : 1;
+    if (x->base_offset != y->base_offset)
+        return x->base_offset < y->base_offset ? -1 : 1;
+    return memcmp(x->offsets, y->offsets, sizeof(x->offsets));
+}
+
+size_t pointer_scan_find(const PointerMap *map, uintptr_t target, const PointerScanOptions *options, ThreadPool *pool,
+                         DynamicArray *paths)
+{
+    int worker_count = pool ? pool->worker_count : 1;
+    DynamicArray modules, frontier, next;
+    size_t first_path = paths->size;
+
+    create_array(&modules, map->modules.size + 1, sizeof(ModuleSpan));
+    for (size_t m = 0; m < map->modules.size; m++)
+    {
+        const ModuleInfo *module = (const ModuleInfo *)map->modules.data + m;
+        ModuleSpan span = {module->base, module->base + module->size, (uint32_t)m};
+        append(&modules, &span);
+    }
+    qsort(modules.data, modules.size, sizeof(ModuleSpan), compare_spans);
+
+    PointerScanOptions limits = *options;
+    limits.max_depth = min(max(limits.max_depth, 1), POINTER_MAX_DEPTH);
+    PointerSearch search = {
+        .map = map,
+        .options = &limits,
+        .modules = (const ModuleSpan *)modules.data,
+        .module_count = modules.size,
+        .paths = calloc((size_t)worker_count, sizeof(DynamicArray))};
+    if (!search.paths)
+    {
+        perror("Failed to allocate pointer search results");
+        exit(EXIT_FAILURE);
+    }
+    for (int w = 0; w < worker_count; w++)
+        create_array(&search.paths[w], 64, sizeof(PointerPath));
+
+    // Breadth first on this thread until there are enough nodes to keep every worker busy, then
+    // depth first from each of them on the pool
+    PointerNode root = {.address = target};
+    create_array(&frontier, 64, sizeof(PointerNode));
+    create_array(&next, 64, sizeof(PointerNode));
+    append(&frontier, &root);
+    while (frontier.size > 0 && frontier.size < (size_t)worker_count * POINTER_TASKS_PER_WORKER && !search_full(&search))
+    {
+        next.size = 0;
+        for (size_t n = 0; n < frontier.size; n++)
+            visit_node(&search, (const PointerNode *)frontier.data + n, &search.paths[0], &next);
+        DynamicArray swap = frontier;
+        frontier = next;
+        next = swap;
+    }
+
+    search.frontier = (const PointerNode *)frontier.data;
+    if (pool && frontier.size > 0)
+        thread_pool_run(pool, frontier.size, pointer_search_task, &search);
+    else
+    {
+        for (size_t n = 0; n < frontier.size; n++)
+            pointer_search_task(&search, n, 0);
+    }
+
+    for (int w = 0; w < worker_count; w++)
+    {
+        append_many(paths, search.paths[w].data, search.paths[w].size);
+        free_array(&search.paths[w]);
+    }
+    qsort((PointerPath *)paths->data + first_path, paths->size - first_path, sizeof(PointerPath), compare_paths);
+
+    free(search.paths);
+    free_array(&modules);
+    free_array(&frontier);
+    free_array(&next);
+    return paths->size - first_path;
+}
+
+// Base of every module of modules among loaded, by name, 0 when it is not loaded there
+static uintptr_t *match_module_bases(const DynamicArray *modules, const DynamicArray *loaded)
+{
+    uintptr_t *bases = calloc(modules->size + 1, sizeof(uintptr_t));
+    if (!bases)
+    {
+        perror("Failed to allocate pointer path bases");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t m = 0; m < modules->size; m++)
+    {
+        const char *name = ((const ModuleInfo *)modules->data)[m].name;
+        for (size_t l = 0; l < loaded->size && bases[m] == 0; l++)
+        {
+            const ModuleInfo *module = (const ModuleInfo *)loaded->data + l;
+            if (strcmp(module->name, name) == 0)
+                bases[m] = module->base;
+        }
+    }
+    return bases;
+}
+
+size_t pointer_paths_intersect(DynamicArray *paths, const DynamicArray *modules, const PointerMap *other, uintptr_t target)
+{
+    uintptr_t *bases = match_module_bases(modules, &other->modules);
+
+    size_t kept = 0;
+    for (size_t p = 0; p < paths->size; p++)
+    {
+        const PointerPath *path = (const PointerPath *)paths->data + p;
+        bool leads = path->module < modules->size && bases[path->module] != 0 && path->depth <= POINTER_MAX_DEPTH;
+        uintptr_t current = leads ? bases[path->module] + path->base_offset : 0;
+        for (uint32_t level = 0; leads && level < path->depth; level++)
+        {
+            uintptr_t pointer = 0;
+            leads = pointer_map_read(other, current, &pointer);
+            current = pointer + (intptr_t)path->offsets[level];
+        }
+        if (leads && current == target)
+            ((PointerPath *)paths->data)[kept++] = *path;
+    }
+    paths->size = kept;
+    free(bases);
+    return kept;
+}
+
+typedef struct
+{
+    HANDLE process;
+    MemoryReadRequest *requests; // One per trie node of the level
+    size_t count;
+    volatile int64_t system_calls;
+} PointerLevelRead;
+
+static void pointer_level_task(void *context, size_t task_index, int worker_index)
+{
+    PointerLevelRead *level = (PointerLevelRead *)context;
+    size_t first = task_index * POINTER_READ_BATCH;
+    size_t calls = platform_read_memory_batch(level->process, level->requests + first, min(level->count - first, (size_t)POINTER_READ_BATCH));
+    platform_atomic_add64(&level->system_calls, (int64_t)calls);
+    (void)worker_index;
+}
+
+// Trie order: paths with the same module, base offset and first offsets are next to each other
+static int compare_trie_order(const void *a, const void *b)
+{
+    const PointerPath *x = *(const PointerPath *const *)a, *y = *(const PointerPath *const *)b;
+    if (x->module != y->module)
+        return x->module < y->module ? -1 : 1;
+    if (x->base_offset != y->base_offset)
+        return x->base_offset < y->base_offset ? -1 : 1;
+    int order = memcmp(x->offsets, y->offsets, sizeof(x->offsets));
+    return order != 0 ? order : (x->depth > y->depth) - (x->depth < y->depth);
+}
+
+// Whether two paths reach the same node at level: the same pointers were read on the way
+static bool same_trie_node(const PointerPath *x, const PointerPath *y, uint32_t level)
+{
+    return x->module == y->module && x->base_offset == y->base_offset && memcmp(x->offsets, y->offsets, level * sizeof(int32_t)) == 0;
+}
+
+size_t pointer_paths_revalidate(HANDLE process, const DynamicArray *modules, const DynamicArray *paths, ThreadPool *pool,
+                                uintptr_t *resolved, PointerRevalidateStats *stats)
+{
+    const PointerPath *all = (const PointerPath *)paths->data;
+    size_t count = paths->size;
+    DynamicArray loaded;
+
+    memset(stats, 0, sizeof(PointerRevalidateStats));
+    create_array(&loaded, 64, sizeof(ModuleInfo));
+    platform_query_modules(process, &loaded);
+    uintptr_t *bases = match_module_bases(modules, &loaded);
+
+    const PointerPath **order = malloc((count + 1) * sizeof(const PointerPath *));
+    size_t *path_node = malloc((count + 1) * sizeof(size_t));
+    uintptr_t *values = malloc((count + 1) * sizeof(uintptr_t));
+    MemoryReadRequest *requests = malloc((count + 1) * sizeof(MemoryReadRequest));
+    if (!order || !path_node || !values || !requests)
+    {
+        perror("Failed to allocate pointer path revalidation");
+        exit(EXIT_FAILURE);
+    }
+
+    // resolved[i] holds the address path i reads next, until its last offset makes it the result
+    for (size_t i = 0; i < count; i++)
+    {
+        const PointerPath *path = &all[i];
+        bool valid = path->module < modules->size && bases[path->module] != 0 && path->depth > 0 && path->depth <= POINTER_MAX_DEPTH;
+        resolved[i] = valid ? bases[path->module] + path->base_offset : 0;
+        stats->path_reads += valid ? path->depth : 0;
+        order[i] = path;
+    }
+    qsort(order, count, sizeof(const PointerPath *), compare_trie_order);
+
+    for (uint32_t level = 0; level < POINTER_MAX_DEPTH; level++)
+    {
+        // One read for every run of live paths in trie order that reached the same node
+        PointerLevelRead read = {process, requests, 0, 0};
+        const PointerPath *previous = NULL;
+        for (size_t o = 0; o < count; o++)
+        {
+            const PointerPath *path = order[o];
+            size_t i = (size_t)(path - all);
+            path_node[i] = SIZE_MAX;
+            if (path->depth <= level || resolved[i] == 0)
+                continue;
+            if (!previous || !same_trie_node(previous, path, level))
+            {
+                requests[read.count] = (MemoryReadRequest){resolved[i], &values[read.count], sizeof(uintptr_t), 0};
+                read.count++;
+            }
+            path_node[i] = read.count - 1;
+            previous = path;
+        }
+        if (read.count == 0)
+            break;
+
+        size_t task_count = (read.count + POINTER_READ_BATCH - 1) / POINTER_READ_BATCH;
+        if (pool)
+            thread_pool_run(pool, task_count, pointer_level_task, &read);
+        else
+        {
+            for (size_t t = 0; t < task_count; t++)
+                pointer_level_task(&read, t, 0);
+        }
+        stats->reads[level] = read.count;
+        stats->system_calls += (size_t)read.system_calls;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t node = path_node[i];
+            if (node != SIZE_MAX)
+                resolved[i] = requests[node].bytes_read == sizeof(uintptr_t) ? values[node] + (intptr_t)all[i].offsets[level] : 0;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+        stats->survivors += resolved[i] != 0;
+
+    free(order);
+    free(path_node);
+    free(values);
+    free(requests);
+    free(bases);
+    free_array(&loaded);
+    return stats->survivors;
+}
+
+bool pointer_path_resolve(HANDLE process, const DynamicArray *modules, const PointerPath *path, uintptr_t *address)
+{
+    if (path->module >= modules->size || path->depth == 0 || path->depth > POINTER_MAX_DEPTH)
+        return false;
+
+    uintptr_t current = ((const ModuleInfo *)modules->data)[path->module].base + path->base_offset;
+    for (uint32_t level = 0; level < path->depth; level++)
+    {
+        uintptr_t pointer = 0;
+        size_t bytes_read = 0;
+        if (!platform_read_memory(process, current, &pointer, sizeof(pointer), &bytes_read) || bytes_read != sizeof(pointer))
+            return false;
+        current = pointer + (intptr_t)path->offsets[level];
+    }
+    *address = current;
+    return true;
+}
+
+void format_pointer_path(const DynamicArray *modules, const PointerPath *path, char *output, size_t output_size)
+{
+    const char *name = path->module < modules->size ? ((const ModuleInfo *)modules->data)[path->module].name : "?";
+    size_t length = (size_t)snprintf(output, output_size, "%s+%llX", name, (unsigned long long)path->base_offset);
+
+    for (uint32_t level = 0; level < path->depth && length < output_size; level++)
+    {
+        int32_t offset = path->offsets[level];
+        length += (size_t)snprintf(output + length, output_size - length, " -> %c%X", offset < 0 ? '-' : '+',
+                                   (unsigned)(offset < 0 ? -(int64_t)offset : offset));
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef POINTER_SCAN_H
+#define POINTER_SCAN_H
+
+#include "platform.h"
+#include "region_filter.h"
+#include "thread_pool.h"
+
+#define POINTER_MAX_DEPTH 8
+#define POINTER_MAP_CHUNK (1024 * 1024) // Bytes read at once while building a map
+
+// An aligned pointer-sized value stored at address, pointing into a readable region
+typedef struct
+{
+    uintptr_t value;
+    uintptr_t address;
+} PointerMapEntry;
+
+// Reverse pointer map of a process: every pointer of the regions it was built from, sorted by the
+// address it points to, so the pointers into [target - max_offset, target] are one range. A map
+// opened from a file reads its entries and index straight from the file view.
+typedef struct
+{
+    const PointerMapEntry *entries;
+    const uint32_t *by_address; // Indexes of the entries in ascending order of the address they are stored at
+    size_t count;
+    DynamicArray modules;       // ModuleInfo when the map was built, the static bases of pointer paths
+    DynamicArray regions;       // AddressRange of the regions scanned, ascending
+    size_t scanned_bytes;
+    const void *file_view;      // Mapped file of an opened map, NULL for a built one
+    size_t file_size;
+} PointerMap;
+
+// Static pointer path: read the pointer at module base + base_offset, add offsets[0], read the
+// pointer there, add offsets[1] ... until offsets[depth - 1] gives the target
+typedef struct
+{
+    uint32_t module; // Index in the modules of the map
+    uint32_t depth;  // Pointers read
+    uintptr_t base_offset;
+    int32_t offsets[POINTER_MAX_DEPTH];
+} PointerPath;
+
+typedef struct
+{
+    size_t survivors;                // Paths followed to the end
+    size_t reads[POINTER_MAX_DEPTH]; // Distinct pointers read at every level
+    size_t path_reads;               // Reads the same paths take resolved one by one
+    size_t system_calls;
+} PointerRevalidateStats;
+
+typedef struct
+{
+    uint32_t max_depth;  // Pointers read by the longest path, up to POINTER_MAX_DEPTH
+    uint32_t max_offset; // Largest offset added after each pointer
+    size_t max_paths;    // The search stops after that many paths, 0 for no limit
+} PointerScanOptions;
+
+// Builds the map from the regions filter keeps (pointers to any readable region count), reading
+// and sorting on pool when it is not NULL. Returns false when the process could not be listed or
+// holds more than 4G pointers.
+bool pointer_map_build(HANDLE process, const RegionFilter *filter, ThreadPool *pool, PointerMap *map);
+void pointer_map_free(PointerMap *map);
+
+// Pointer map file: a header, the module table, the region table, the entries by value and the
+// address index, written section after section and opened as a read-only mapping of the file.
+// Files are only opened by builds of the same pointer width.
+bool pointer_map_save(const PointerMap *map, const char *path);
+bool pointer_map_open(PointerMap *map, const char *path);
+
+// Pointer stored at address when the map was built, false when there was none there
+bool pointer_map_read(const PointerMap *map, uintptr_t address, uintptr_t *value);
+
+// Appends to paths (PointerPath) the static paths of at most options->max_depth pointers that lead
+// to target, searching backward from it on pool, and returns how many were found. Paths end at the
+// first static address, sorted by depth, module and offsets.
+size_t pointer_scan_find(const PointerMap *map, uintptr_t target, const PointerScanOptions *options, ThreadPool *pool,
+                         DynamicArray *paths);
+
+// Keeps in paths, found with modules, only those that also lead to target in other, the map of
+// another run of the process: modules are matched by name and every pointer the paths read is
+// looked up in other instead of the live process. Returns how many paths are kept.
+size_t pointer_paths_intersect(DynamicArray *paths, const DynamicArray *modules, const PointerMap *other, uintptr_t target);
+
+// Follows paths, whose modules are matched by name with those loaded now, in the process as it is
+// now. Paths sharing their module, base offset and first offsets share a node of a trie, whose
+// pointer is read once for all of them; the nodes of a level are read in batches on pool before
+// the next level. resolved[i] gets where path i leads, 0 when one of its pointers cannot be read.
+// Returns the survivors.
+size_t pointer_paths_revalidate(HANDLE process, const DynamicArray *modules, const DynamicArray *paths, ThreadPool *pool,
+                                uintptr_t *resolved, PointerRevalidateStats *stats);
+
+// Follows path in the process as it is now, modules being those the path's module index refers to
+bool pointer_path_resolve(HANDLE process, const DynamicArray *modules, const PointerPath *path, uintptr_t *address);
+// "game.exe+1A2B0 -> +40 -> +18" (hexadecimal offsets)
+void format_pointer_path(const DynamicArray *modules, const PointerPath *path, char *output, size_t output_size);
+
+#endif
@@ -1,60 +1,382 @@
 #include "process.h"
 
-ProcessInfo processes[MAX_PROCESSES];
-int process_count = 0;
-int selected_process = -1;
+#ifndef _WIN32
+#include <ctype.h>
+#include <dirent.h>
+#include <unistd.h>
+#endif
 
-void get_running_processes()
+ProcessCatalog process_catalog;
+DynamicArray process_list;
+int64_t process_list_version = 0;
+ProcessInfo current_process;
+HANDLE current_process_handle = NULL;
+
+#ifdef _WIN32
+#define SYSTEM_PROCESS_INFORMATION_CLASS 5
+#define STATUS_INFO_LENGTH_MISMATCH ((LONG)0xC0000004L)
+
+typedef LONG(NTAPI *QuerySystemInformationFunc)(ULONG information_class, PVOID buffer, ULONG length, PULONG needed);
+
+// Head of a SystemProcessInformation record, up to the fields read here (the thread records follow)
+typedef struct
 {
-    cleanup_process_handles();
+    ULONG NextEntryOffset;
+    ULONG NumberOfThreads;
+    LARGE_INTEGER WorkingSetPrivateSize;
+    ULONG HardFaultCount;
+    ULONG NumberOfThreadsHighWatermark;
+    ULONGLONG CycleTime;
+    LARGE_INTEGER CreateTime; // The creation time GetProcessTimes gives
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER KernelTime;
+    struct
+    {
+        USHORT Length; // In bytes
+        USHORT MaximumLength;
+        PWSTR Buffer;
+    } ImageName; // File name of the executable, empty for the idle process
+    LONG BasePriority;
+    HANDLE UniqueProcessId;
+} ProcessRecord;
 
-    DWORD process_ids[MAX_PROCESSES], bytes_returned;
-    process_count = 0;
+// Every process with its start time, from one snapshot of the system kept in catalog->snapshot:
+// no handle is opened, so protected and elevated processes are listed as well
+static bool list_processes(ProcessCatalog *catalog)
+{
+    static QuerySystemInformationFunc query_system_information;
+    if (!query_system_information)
+        query_system_information = (QuerySystemInformationFunc)GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtQuerySystemInformation");
+    if (!query_system_information)
+    {
+        fprintf(stderr, "Failed to enumerate processes.\n");
+        return false;
+    }
 
-    if (!EnumProcesses(process_ids, sizeof(process_ids), &bytes_returned))
+    // Processes may start between the size query and the copy: leave them some room
+    ULONG needed = 0;
+    LONG status;
+    while ((status = query_system_information(SYSTEM_PROCESS_INFORMATION_CLASS, catalog->snapshot.data,
+                                              (ULONG)catalog->snapshot.capacity, &needed)) == STATUS_INFO_LENGTH_MISMATCH)
+        reserve_array(&catalog->snapshot, (size_t)needed + needed / 4 + 4096);
+    if (status < 0)
     {
         fprintf(stderr, "Failed to enumerate processes.\n");
-        return;
+        return false;
+    }
+
+    const BYTE *snapshot = (const BYTE *)catalog->snapshot.data;
+    size_t offset = 0;
+    while (1)
+    {
+        const ProcessRecord *record = (const ProcessRecord *)(snapshot + offset);
+        ListedProcess listed = {(uint32_t)(uintptr_t)record->UniqueProcessId, (uint64_t)record->CreateTime.QuadPart, offset};
+        append(&catalog->listed, &listed);
+        if (record->NextEntryOffset == 0)
+            break;
+        offset += record->NextEntryOffset;
     }
+    return true;
+}
 
-    int count = bytes_returned / sizeof(DWORD);
-    for (int i = 0; i < count && process_count < MAX_PROCESSES; ++i)
+// Name of a listed process, read from the same snapshot
+static bool name_process(ProcessCatalog *catalog, const ListedProcess *listed, ProcessInfo *info)
+{
+    const ProcessRecord *record = (const ProcessRecord *)((const BYTE *)catalog->snapshot.data + listed->source);
+    int length = 0;
+
+    if (record->ImageName.Length > 0)
+        length = WideCharToMultiByte(CP_UTF8, 0, record->ImageName.Buffer, (int)(record->ImageName.Length / sizeof(WCHAR)),
+                                     info->name, (int)sizeof(info->name) - 1, NULL, NULL);
+    if (length > 0)
+        info->name[length] = '\0';
+    else
+        strncpy_s(info->name, sizeof(info->name), listed->pid == 0 ? "System Idle Process" : "<unknown>", _TRUNCATE);
+    return true;
+}
+
+// Start time of the process a handle was opened to; the handle keeps that process, whatever its pid
+// is handed out to later
+static bool query_handle_start_time(HANDLE process, uint32_t pid, uint64_t *start_time)
+{
+    FILETIME creation, exit_time, kernel, user;
+
+    (void)pid;
+    if (!GetProcessTimes(process, &creation, &exit_time, &kernel, &user))
+        return false;
+    *start_time = ((uint64_t)creation.dwHighDateTime << 32) | creation.dwLowDateTime;
+    return true;
+}
+
+#else
+// Start time from /proc/<pid>/stat, in clock ticks since boot, and when name is not NULL the file
+// name of the executable (the command name when it cannot be read)
+static bool query_process(uint32_t pid, uint64_t *start_time, char *name, size_t name_size)
+{
+    char path[64], stat[1024];
+    snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return false;
+    size_t length = fread(stat, 1, sizeof(stat) - 1, file);
+    fclose(file);
+    stat[length] = '\0';
+
+    // The command name may hold spaces and parentheses: fields resume after the last ')'
+    char *open = strchr(stat, '('), *close = strrchr(stat, ')');
+    if (!open || !close || close < open)
+        return false;
+    char *field = close + 2;
+    for (int skip = 0; skip < 19 && field; skip++) // State is field 3, start time field 22
     {
-        DWORD pid = process_ids[i];
-        HANDLE hProcess = OpenProcess(PROCESS_VM_READ | PROCESS_VM_WRITE | PROCESS_VM_OPERATION, FALSE, pid);
+        field = strchr(field, ' ');
+        field = field ? field + 1 : NULL;
+    }
+    if (!field)
+        return false;
+    *start_time = strtoull(field, NULL, 10);
 
-        if (hProcess)
+    if (name)
+    {
+        char exe[4096];
+        snprintf(path, sizeof(path), "/proc/%u/exe", pid);
+        ssize_t exe_length = readlink(path, exe, sizeof(exe) - 1);
+        if (exe_length > 0)
         {
-            char name[MAX_NAME_LEN] = "<unknown>";
-            HMODULE hModule;
-            DWORD bytes_needed;
-
-            // Get process name
-            if (EnumProcessModules(hProcess, &hModule, sizeof(hModule), &bytes_needed))
-            {
-                GetModuleBaseName(hProcess, hModule, name, sizeof(name) / sizeof(char));
-            }
-
-            strncpy_s(processes[process_count].name, sizeof(processes[process_count].name), name, MAX_NAME_LEN);
-            processes[process_count].name[MAX_NAME_LEN - 1] = '\0';
-            processes[process_count].handle = hProcess;
-            process_count++;
+            exe[exe_length] = '\0';
+            const char *base = strrchr(exe, '/');
+            strncpy_s(name, name_size, base ? base + 1 : exe, _TRUNCATE);
         }
         else
         {
-            CloseHandle(hProcess);
+            *close = '\0';
+            strncpy_s(name, name_size, open + 1, _TRUNCATE);
         }
     }
+    return true;
 }
 
-void cleanup_process_handles()
+static bool list_processes(ProcessCatalog *catalog)
 {
-    for (int i = 0; i < process_count; i++)
+    DIR *proc = opendir("/proc");
+    if (!proc)
     {
-        if (processes[i].handle)
+        fprintf(stderr, "Failed to enumerate processes.\n");
+        return false;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(proc)) != NULL)
+    {
+        if (!isdigit((unsigned char)entry->d_name[0]))
+            continue;
+        ListedProcess listed = {(uint32_t)strtoul(entry->d_name, NULL, 10), 0, 0};
+        if (query_process(listed.pid, &listed.start_time, NULL, 0))
+            append(&catalog->listed, &listed);
+    }
+    closedir(proc);
+    return true;
+}
+
+// False when the process is gone since it was listed
+static bool name_process(ProcessCatalog *catalog, const ListedProcess *listed, ProcessInfo *info)
+{
+    uint64_t start_time;
+    return query_process(listed->pid, &start_time, info->name, sizeof(info->name)) && start_time == listed->start_time;
+}
+
+// The handle is the pid itself here, so the process holding the pid now is the one it reaches
+static bool query_handle_start_time(HANDLE process, uint32_t pid, uint64_t *start_time)
+{
+    (void)process;
+    return query_process(pid, start_time, NULL, 0);
+}
+#endif
+
+static int compare_pids(const void *a, const void *b)
+{
+    uint32_t x = ((const ListedProcess *)a)->pid, y = ((const ListedProcess *)b)->pid;
+    return x < y ? -1 : x > y;
+}
+
+void process_catalog_init(ProcessCatalog *catalog)
+{
+    memset(catalog, 0, sizeof(ProcessCatalog));
+    catalog->interval_ms = CATALOG_REFRESH_MS;
+    create_array(&catalog->entries, 256, sizeof(ProcessInfo));
+    create_array(&catalog->listed, 256, sizeof(ListedProcess));
+    create_array(&catalog->snapshot, CATALOG_SNAPSHOT_BYTES, 1);
+    create_array(&catalog->next, 256, sizeof(ProcessInfo));
+    create_array(&catalog->published, 256, sizeof(ProcessInfo));
+    platform_mutex_init(&catalog->lock);
+}
+
+void process_catalog_destroy(ProcessCatalog *catalog)
+{
+    process_catalog_stop(catalog);
+    free_array(&catalog->entries);
+    free_array(&catalog->listed);
+    free_array(&catalog->snapshot);
+    free_array(&catalog->next);
+    free_array(&catalog->published);
+    platform_mutex_destroy(&catalog->lock);
+}
+
+bool process_catalog_refresh(ProcessCatalog *catalog)
+{
+    uint64_t start = platform_time_ns();
+
+    catalog->listed.size = 0;
+    if (!list_processes(catalog))
+        return false;
+    qsort(catalog->listed.data, catalog->listed.size, sizeof(ListedProcess), compare_pids);
+
+    // Merge of the listed processes with the known entries, both by ascending pid
+    const ListedProcess *listed = (const ListedProcess *)catalog->listed.data;
+    const ProcessInfo *known = (const ProcessInfo *)catalog->entries.data;
+    size_t known_count = catalog->entries.size, k = 0, kept = 0;
+    catalog->next.size = 0;
+    for (size_t p = 0; p < catalog->listed.size; p++)
+    {
+        while (k < known_count && known[k].pid < listed[p].pid)
+            k++;
+
+        // Only a pid not seen before, or reused by a process started since, gets its name looked up
+        if (k < known_count && known[k].pid == listed[p].pid && known[k].start_time == listed[p].start_time)
         {
-            CloseHandle(processes[i].handle);
-            processes[i].handle = NULL;
+            append(&catalog->next, &known[k]);
+            kept++;
+            continue;
         }
+        ProcessInfo info = {listed[p].pid, listed[p].start_time, ""};
+        if (name_process(catalog, &listed[p], &info))
+            append(&catalog->next, &info);
+    }
+
+    size_t added = catalog->next.size - kept, removed = known_count - kept;
+    DynamicArray swap = catalog->entries;
+    catalog->entries = catalog->next;
+    catalog->next = swap;
+
+    if (added > 0 || removed > 0 || platform_atomic_load64(&catalog->stats.refreshes) == 0)
+    {
+        platform_mutex_lock(&catalog->lock);
+        catalog->published.size = 0;
+        append_many(&catalog->published, catalog->entries.data, catalog->entries.size);
+        platform_atomic_add64(&catalog->version, 1);
+        platform_mutex_unlock(&catalog->lock);
+    }
+
+    ProcessCatalogStats *stats = &catalog->stats;
+    int64_t elapsed = (int64_t)(platform_time_ns() - start);
+    platform_atomic_store64(&stats->processes, (int64_t)catalog->entries.size);
+    platform_atomic_add64(&stats->added, (int64_t)added);
+    platform_atomic_add64(&stats->removed, (int64_t)removed);
+    platform_atomic_store64(&stats->last_refresh_ns, elapsed);
+    platform_atomic_add64(&stats->total_refresh_ns, elapsed);
+    platform_atomic_add64(&stats->refreshes, 1);
+    return true;
+}
+
+static void catalog_thread_proc(void *param)
+{
+    ProcessCatalog *catalog = (ProcessCatalog *)param;
+
+    while (platform_atomic_load64(&catalog->running))
+    {
+        process_catalog_refresh(catalog);
+
+        // Slept in slices so a stop does not wait for a whole interval
+        uint64_t wake = platform_time_ns() + (uint64_t)platform_atomic_load64(&catalog->interval_ms) * 1000000;
+        while (platform_atomic_load64(&catalog->running) && platform_time_ns() < wake)
+            platform_sleep_ms(min((uint64_t)CATALOG_STOP_SLICE_MS, (wake - platform_time_ns()) / 1000000 + 1));
+    }
+}
+
+bool process_catalog_start(ProcessCatalog *catalog, uint32_t interval_ms)
+{
+    platform_atomic_store64(&catalog->interval_ms, max(interval_ms, 1));
+    if (platform_atomic_load64(&catalog->running))
+        return true;
+
+    printf("[DEBUG] Starting process catalog thread \n");
+    platform_atomic_store64(&catalog->running, 1);
+    if (!platform_thread_start(&catalog->thread, catalog_thread_proc, catalog))
+    {
+        fprintf(stderr, "[ERROR] Failed to start process catalog thread\n");
+        platform_atomic_store64(&catalog->running, 0);
+        return false;
+    }
+    return true;
+}
+
+void process_catalog_stop(ProcessCatalog *catalog)
+{
+    if (!platform_atomic_load64(&catalog->running))
+        return;
+
+    printf("[DEBUG] Stopping process catalog thread \n");
+    platform_atomic_store64(&catalog->running, 0);
+    platform_thread_join(&catalog->thread);
+}
+
+bool process_catalog_poll(ProcessCatalog *catalog, DynamicArray *list, int64_t *version)
+{
+    if (platform_atomic_load64(&catalog->version) == *version)
+        return false;
+
+    platform_mutex_lock(&catalog->lock);
+    list->size = 0;
+    append_many(list, catalog->published.data, catalog->published.size);
+    *version = platform_atomic_load64(&catalog->version);
+    platform_mutex_unlock(&catalog->lock);
+    return true;
+}
+
+void init_process_list()
+{
+    process_catalog_init(&process_catalog);
+    create_array(&process_list, 256, sizeof(ProcessInfo));
+    process_list_version = 0;
+    memset(&current_process, 0, sizeof(ProcessInfo));
+}
+
+bool open_current_process(const ProcessInfo *info)
+{
+    HANDLE handle = platform_open_process(info->pid);
+    if (!handle)
+    {
+        fprintf(stderr, "[ERROR] Failed to open process %u (%s)\n", info->pid, info->name);
+        return false;
     }
-}
\ No newline at end of file
+
+    // The process listed may have exited since the last refresh and its pid been reused
+    uint64_t start_time;
+    if (!query_handle_start_time(handle, info->pid, &start_time) || start_time != info->start_time)
+    {
+        fprintf(stderr, "[ERROR] Process %u (%s) is gone, its pid now belongs to another process\n", info->pid, info->name);
+        platform_close_process(handle);
+        return false;
+    }
+
+    close_current_process();
+    current_process = *info;
+    current_process_handle = handle;
+    printf("[DEBUG] Opened process %u (%s)\n", info->pid, info->name);
+    return true;
+}
+
+void close_current_process()
+{
+    platform_close_process(current_process_handle);
+    current_process_handle = NULL;
+    memset(&current_process, 0, sizeof(ProcessInfo));
+}
+
+void cleanup_process_handles()
+{
+    close_current_process();
+    process_catalog_destroy(&process_catalog);
+    free_array(&process_list);
+}
@@ -1,28 +1,91 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
-#include <windows.h>
-#include <psapi.h>
 #include <string.h>
 
 #include "dynamic_array.h"
+#include "platform.h"
 
 #define MAX_RESULTS 1024
 #define MAX_PROCESSES 1024
 #define MAX_NAME_LEN 256
+#define CATALOG_REFRESH_MS 1000 // Default interval of the catalog thread
+#define CATALOG_STOP_SLICE_MS 50 // The catalog thread notices a stop request within this time
+#ifdef _WIN32
+#define CATALOG_SNAPSHOT_BYTES (256 * 1024) // First size of the system process snapshot, grown as needed
+#else
+#define CATALOG_SNAPSHOT_BYTES 1 // No snapshot: /proc is read process by process
+#endif
 
 typedef struct
 {
+    uint32_t pid;
+    uint64_t start_time; // Tells the process apart from a later one reusing its pid
     char name[MAX_NAME_LEN];
-    HANDLE handle;
 } ProcessInfo;
 
-extern ProcessInfo processes[MAX_PROCESSES];
+// A process as listed by a refresh, before its name is looked up
+typedef struct
+{
+    uint32_t pid;
+    uint64_t start_time;
+    size_t source; // Windows: offset of its record in the system snapshot, unused on Linux
+} ListedProcess;
+
+// Figures of the catalog refreshes, written by the refreshing thread and read by anyone without locking
+typedef struct
+{
+    volatile int64_t refreshes;
+    volatile int64_t processes; // Listed by the last refresh
+    volatile int64_t added;     // New processes, whose names were looked up, since the start
+    volatile int64_t removed;
+    volatile int64_t last_refresh_ns;
+    volatile int64_t total_refresh_ns;
+} ProcessCatalogStats;
+
+// Processes running, refreshed on a background thread at a low rate. Every refresh lists the pids
+// and their start times, and only looks up the names of the processes it did not know by pid and
+// start time. A refresh that changed the list publishes a copy of it for the UI to poll. Listing
+// opens no process handle: Linux reads /proc, Windows takes one NtQuerySystemInformation snapshot
+// that holds the pid, creation time and image name of every process.
+typedef struct
+{
+    PlatformThread thread;
+    volatile int64_t running;
+    volatile int64_t interval_ms;
+    DynamicArray entries;   // ProcessInfo by ascending pid, only touched by the refreshing thread
+    DynamicArray listed;    // ListedProcess, scratch of a refresh
+    DynamicArray snapshot;  // BYTE, Windows: the system process information of the last refresh
+    DynamicArray next;      // ProcessInfo, scratch of a refresh
+    PlatformMutex lock;     // Guards published and version
+    DynamicArray published; // ProcessInfo, the list as of the last change
+    volatile int64_t version; // Bumped by every refresh that changed the list
+    ProcessCatalogStats stats;
+} ProcessCatalog;
+
+void process_catalog_init(ProcessCatalog *catalog);
+void process_catalog_destroy(ProcessCatalog *catalog); // Stops the thread
+// One refresh on the calling thread, while the catalog thread is not running; returns false when
+// the processes could not be listed
+bool process_catalog_refresh(ProcessCatalog *catalog);
+bool process_catalog_start(ProcessCatalog *catalog, uint32_t interval_ms); // Does nothing when it runs already
+void process_catalog_stop(ProcessCatalog *catalog);
+// Copies the published list into list (ProcessInfo) when it is newer than *version, which it
+// updates; returns whether it did
+bool process_catalog_poll(ProcessCatalog *catalog, DynamicArray *list, int64_t *version);
 
-extern int process_count;
-extern int selected_process;
+extern ProcessCatalog process_catalog; // Refreshed while the process selector is open
+extern DynamicArray process_list;      // ProcessInfo shown by the process selector
+extern int64_t process_list_version;
+extern ProcessInfo current_process;    // Opened by the user, pid 0 for none
+extern HANDLE current_process_handle;  // NULL when no process is open
 
-void get_running_processes();
+void init_process_list();
+// Opens info as the current process, closing the one opened before; false when it cannot be opened
+// or its pid now belongs to a process started after info was listed. Whoever uses the current
+// handle on another thread must have let go of it first.
+bool open_current_process(const ProcessInfo *info);
+void close_current_process(); // Same as for open_current_process about the threads using the handle
 void cleanup_process_handles();
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,85 @@
+#include "read_ahead.h"
+
+static void read_ahead_proc(void *param)
+{
+    ReadAhead *reader = (ReadAhead *)param;
+
+    platform_mutex_lock(&reader->lock);
+    while (1)
+    {
+        while (!reader->pending && !reader->quit)
+            platform_cond_wait(&reader->wake, &reader->lock);
+        if (reader->quit)
+            break;
+
+        platform_mutex_unlock(&reader->lock);
+        size_t bytes_read = 0;
+        bool ok = platform_read_memory(reader->process_handle, reader->address, reader->buffer, reader->size, &bytes_read);
+        DWORD error = ok ? 0 : GetLastError();
+        platform_mutex_lock(&reader->lock);
+
+        reader->error = error;
+        reader->bytes_read = bytes_read;
+        reader->ok = ok;
+        reader->pending = false;
+        platform_cond_broadcast(&reader->wake);
+    }
+    platform_mutex_unlock(&reader->lock);
+}
+
+bool read_ahead_start(ReadAhead *reader)
+{
+    memset(reader, 0, sizeof(ReadAhead));
+    platform_mutex_init(&reader->lock);
+    platform_cond_init(&reader->wake);
+    reader->started = platform_thread_start(&reader->thread, read_ahead_proc, reader);
+    return reader->started;
+}
+
+void read_ahead_stop(ReadAhead *reader)
+{
+    if (reader->started)
+    {
+        platform_mutex_lock(&reader->lock);
+        reader->quit = true;
+        platform_cond_broadcast(&reader->wake);
+        platform_mutex_unlock(&reader->lock);
+        platform_thread_join(&reader->thread);
+        reader->started = false;
+    }
+    platform_cond_destroy(&reader->wake);
+    platform_mutex_destroy(&reader->lock);
+}
+
+void read_ahead_issue(ReadAhead *reader, HANDLE process_handle, uintptr_t address, void *buffer, size_t size)
+{
+    if (!reader->started)
+    {
+        reader->ok = platform_read_memory(process_handle, address, buffer, size, &reader->bytes_read);
+        reader->error = reader->ok ? 0 : GetLastError();
+        return;
+    }
+
+    platform_mutex_lock(&reader->lock);
+    reader->process_handle = process_handle;
+    reader->address = address;
+    reader->buffer = buffer;
+    reader->size = size;
+    reader->pending = true;
+    platform_cond_broadcast(&reader->wake);
+    platform_mutex_unlock(&reader->lock);
+}
+
+bool read_ahead_wait(ReadAhead *reader, size_t *bytes_read)
+{
+    if (reader->started)
+    {
+        platform_mutex_lock(&reader->lock);
+        while (reader->pending)
+            platform_cond_wait(&reader->wake, &reader->lock);
+        platform_mutex_unlock(&reader->lock);
+    }
+
+    *bytes_read = reader->bytes_read;
+    return reader->ok;
+}
@@ -0,0 +1,34 @@
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include "platform.h"
+
+// Helper thread doing one process memory read at a time on behalf of a scan worker, so the worker
+// scans the chunk it already has while the next one is being copied. Without a thread (start
+// failed), reads are done in place by read_ahead_issue.
+typedef struct
+{
+    PlatformThread thread;
+    PlatformMutex lock;
+    PlatformCond wake; // Signals a new request to the thread and a finished read to the worker
+    bool started;
+    bool quit;
+    bool pending; // A request is waiting or being read
+    HANDLE process_handle;
+    uintptr_t address;
+    void *buffer;
+    size_t size;
+    size_t bytes_read;
+    bool ok;
+    DWORD error; // GetLastError() of a failed read
+} ReadAhead;
+
+bool read_ahead_start(ReadAhead *reader);
+void read_ahead_stop(ReadAhead *reader);
+
+// Starts reading size bytes at address into buffer, the previous read must have been waited for
+void read_ahead_issue(ReadAhead *reader, HANDLE process_handle, uintptr_t address, void *buffer, size_t size);
+// Waits for the issued read, returns what platform_read_memory returned for it (error in reader->error)
+bool read_ahead_wait(ReadAhead *reader, size_t *bytes_read);
+
+#endif
@@ -0,0 +1,234 @@
+#include "region_filter.h"
+
+#include <ctype.h>
+
+void region_filter_init(RegionFilter *filter)
+{
+    filter->writable_only = false;
+    filter->exclude_executable = false;
+    filter->executable_only = false;
+    filter->types = REGION_TYPES_ALL;
+    create_array(&filter->include_modules, 4, MODULE_NAME_LEN);
+    create_array(&filter->exclude_modules, 4, MODULE_NAME_LEN);
+    create_array(&filter->ranges, 4, sizeof(AddressRange));
+}
+
+void region_filter_free(RegionFilter *filter)
+{
+    free_array(&filter->include_modules);
+    free_array(&filter->exclude_modules);
+    free_array(&filter->ranges);
+}
+
+void region_filter_reset(RegionFilter *filter)
+{
+    filter->writable_only = false;
+    filter->exclude_executable = false;
+    filter->executable_only = false;
+    filter->types = REGION_TYPES_ALL;
+    filter->include_modules.size = 0;
+    filter->exclude_modules.size = 0;
+    filter->ranges.size = 0;
+}
+
+static void add_module_name(DynamicArray *names, const char *name)
+{
+    char entry[MODULE_NAME_LEN] = {0};
+    snprintf(entry, sizeof(entry), "%s", name);
+    append(names, entry);
+}
+
+void region_filter_include_module(RegionFilter *filter, const char *name)
+{
+    add_module_name(&filter->include_modules, name);
+}
+
+void region_filter_exclude_module(RegionFilter *filter, const char *name)
+{
+    add_module_name(&filter->exclude_modules, name);
+}
+
+void region_filter_add_range(RegionFilter *filter, uintptr_t start, uintptr_t end)
+{
+    if (start < end)
+    {
+        AddressRange range = {start, end};
+        append(&filter->ranges, &range);
+    }
+}
+
+const char *region_filter_rule_name(RegionFilterRule rule)
+{
+    switch (rule)
+    {
+    case FILTER_RULE_PROTECTION:
+        return "unreadable/guard";
+    case FILTER_RULE_TYPE:
+        return "region type";
+    case FILTER_RULE_NOT_WRITABLE:
+        return "not writable";
+    case FILTER_RULE_EXECUTABLE:
+        return "executable";
+    case FILTER_RULE_NOT_EXECUTABLE:
+        return "not executable";
+    case FILTER_RULE_MODULE:
+        return "module";
+    case FILTER_RULE_RANGE:
+        return "address range";
+    default:
+        return "unknown";
+    }
+}
+
+static bool same_module_name(const char *a, const char *b)
+{
+    for (; *a && *b; a++, b++)
+    {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b))
+            return false;
+    }
+    return *a == *b;
+}
+
+// Address spans of the modules of process named in names
+static void resolve_modules(const DynamicArray *modules, const DynamicArray *names, DynamicArray *spans)
+{
+    for (size_t m = 0; m < modules->size; m++)
+    {
+        const ModuleInfo *module = (const ModuleInfo *)modules->data + m;
+        for (size_t n = 0; n < names->size; n++)
+        {
+            if (same_module_name(module->name, (const char *)names->data + n * MODULE_NAME_LEN))
+            {
+                AddressRange span = {module->base, module->base + module->size};
+                append(spans, &span);
+                break;
+            }
+        }
+    }
+}
+
+static bool overlaps_any(const DynamicArray *spans, uintptr_t start, uintptr_t end)
+{
+    for (size_t i = 0; i < spans->size; i++)
+    {
+        const AddressRange *span = (const AddressRange *)spans->data + i;
+        if (span->start < end && start < span->end)
+            return true;
+    }
+    return false;
+}
+
+static int compare_ranges(const void *a, const void *b)
+{
+    uintptr_t start_a = ((const AddressRange *)a)->start;
+    uintptr_t start_b = ((const AddressRange *)b)->start;
+    return start_a < start_b ? -1 : start_a > start_b;
+}
+
+// Sorts ranges and merges the overlapping ones, so clipped regions come out in ascending order
+static void normalize_ranges(DynamicArray *ranges)
+{
+    if (ranges->size == 0)
+        return;
+
+    AddressRange *range = (AddressRange *)ranges->data;
+    size_t merged = 0;
+
+    qsort(range, ranges->size, sizeof(AddressRange), compare_ranges);
+    for (size_t i = 1; i < ranges->size; i++)
+    {
+        if (range[i].start <= range[merged].end)
+            range[merged].end = max(range[merged].end, range[i].end);
+        else
+            range[++merged] = range[i];
+    }
+    ranges->size = merged + 1;
+}
+
+static void skip(RegionFilterStats *stats, RegionFilterRule rule, size_t bytes)
+{
+    stats->skipped_regions[rule]++;
+    stats->skipped_bytes[rule] += bytes;
+}
+
+static void keep(DynamicArray *kept, RegionFilterStats *stats, const MemoryRegion *region, uintptr_t start, uintptr_t end)
+{
+    MemoryRegion part = *region;
+    part.base = start;
+    part.size = end - start;
+    append(kept, &part);
+    stats->kept_regions++;
+    stats->kept_bytes += part.size;
+}
+
+bool region_filter_apply(const RegionFilter *filter, HANDLE process, const DynamicArray *regions,
+                         DynamicArray *kept, RegionFilterStats *stats)
+{
+    DynamicArray included, excluded, ranges;
+    bool ok = true;
+
+    memset(stats, 0, sizeof(RegionFilterStats));
+    create_array(&included, 16, sizeof(AddressRange));
+    create_array(&excluded, 16, sizeof(AddressRange));
+    create_array(&ranges, filter->ranges.size + 1, sizeof(AddressRange));
+    append_many(&ranges, filter->ranges.data, filter->ranges.size);
+    normalize_ranges(&ranges);
+
+    if (filter->include_modules.size > 0 || filter->exclude_modules.size > 0)
+    {
+        DynamicArray modules;
+        create_array(&modules, 64, sizeof(ModuleInfo));
+        ok = platform_query_modules(process, &modules);
+        resolve_modules(&modules, &filter->include_modules, &included);
+        resolve_modules(&modules, &filter->exclude_modules, &excluded);
+        free_array(&modules);
+    }
+
+    for (size_t r = 0; r < regions->size; r++)
+    {
+        const MemoryRegion *region = (const MemoryRegion *)regions->data + r;
+        uintptr_t start = region->base;
+        uintptr_t end = region->base + region->size;
+
+        if ((region->protection & REGION_READ) == 0 || (region->protection & REGION_GUARD) != 0)
+            skip(stats, FILTER_RULE_PROTECTION, region->size);
+        else if ((filter->types & REGION_TYPE_BIT(region->type)) == 0)
+            skip(stats, FILTER_RULE_TYPE, region->size);
+        else if (filter->writable_only && (region->protection & REGION_WRITE) == 0)
+            skip(stats, FILTER_RULE_NOT_WRITABLE, region->size);
+        else if (filter->exclude_executable && (region->protection & REGION_EXECUTE) != 0)
+            skip(stats, FILTER_RULE_EXECUTABLE, region->size);
+        else if (filter->executable_only && (region->protection & REGION_EXECUTE) == 0)
+            skip(stats, FILTER_RULE_NOT_EXECUTABLE, region->size);
+        else if ((filter->include_modules.size > 0 && !overlaps_any(&included, start, end)) || overlaps_any(&excluded, start, end))
+            skip(stats, FILTER_RULE_MODULE, region->size);
+        else if (ranges.size == 0)
+            keep(kept, stats, region, start, end);
+        else
+        {
+            // Clip the region to the ranges; whatever falls outside of them is skipped
+            size_t clipped = 0;
+            for (size_t i = 0; i < ranges.size; i++)
+            {
+                const AddressRange *range = (const AddressRange *)ranges.data + i;
+                uintptr_t part_start = max(start, range->start);
+                uintptr_t part_end = min(end, range->end);
+                if (part_start < part_end)
+                {
+                    keep(kept, stats, region, part_start, part_end);
+                    clipped += part_end - part_start;
+                }
+            }
+            if (clipped == 0)
+                skip(stats, FILTER_RULE_RANGE, region->size);
+            else
+                stats->skipped_bytes[FILTER_RULE_RANGE] += region->size - clipped;
+        }
+    }
+
+    free_array(&included);
+    free_array(&excluded);
+    free_array(&ranges);
+    return ok;
+}
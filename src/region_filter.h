@@ -0,0 +1,65 @@
+#ifndef REGION_FILTER_H
+#define REGION_FILTER_H
+
+#include "platform.h"
+
+// Rules in the order they are evaluated; a skipped region is counted against the first rule that rejects it
+typedef enum
+{
+    FILTER_RULE_PROTECTION,     // Unreadable or guard pages, always skipped
+    FILTER_RULE_TYPE,           // Private, image or mapped memory not selected
+    FILTER_RULE_NOT_WRITABLE,   // Read-only memory while writable_only is set
+    FILTER_RULE_EXECUTABLE,     // Code while exclude_executable is set
+    FILTER_RULE_NOT_EXECUTABLE, // Anything but code while executable_only is set
+    FILTER_RULE_MODULE,         // Outside the included modules, or inside an excluded one
+    FILTER_RULE_RANGE,          // Outside the explicit address ranges
+    FILTER_RULE_COUNT
+} RegionFilterRule;
+
+#define REGION_TYPE_BIT(type) (1u << (type))
+#define REGION_TYPES_ALL (REGION_TYPE_BIT(REGION_PRIVATE) | REGION_TYPE_BIT(REGION_IMAGE) | REGION_TYPE_BIT(REGION_MAPPED))
+
+typedef struct
+{
+    uintptr_t start;
+    uintptr_t end; // Exclusive
+} AddressRange;
+
+// Which regions of a process a first scan reads. Evaluated once per region, before any read.
+typedef struct
+{
+    bool writable_only;
+    bool exclude_executable;
+    bool executable_only;         // Signature scans over code, usually along with types set to images only
+    uint32_t types;               // REGION_TYPE_BIT of every region type scanned
+    DynamicArray include_modules; // char[MODULE_NAME_LEN]: when not empty, only memory of these modules is scanned
+    DynamicArray exclude_modules; // char[MODULE_NAME_LEN]
+    DynamicArray ranges;          // AddressRange: when not empty, regions are clipped to these ranges
+} RegionFilter;
+
+typedef struct
+{
+    uint64_t skipped_regions[FILTER_RULE_COUNT];
+    uint64_t skipped_bytes[FILTER_RULE_COUNT];
+    uint64_t kept_regions;
+    uint64_t kept_bytes;
+} RegionFilterStats;
+
+// The default filter keeps every readable region, like the scans did before filters existed
+void region_filter_init(RegionFilter *filter);
+void region_filter_free(RegionFilter *filter);
+void region_filter_reset(RegionFilter *filter);
+
+// Module names are file names (game.exe, libc.so.6), compared without case
+void region_filter_include_module(RegionFilter *filter, const char *name);
+void region_filter_exclude_module(RegionFilter *filter, const char *name);
+void region_filter_add_range(RegionFilter *filter, uintptr_t start, uintptr_t end);
+
+// Appends to kept the parts of regions (MemoryRegion, ascending) that pass the filter, in ascending
+// order. Returns false when the modules of the process could not be listed for a module rule.
+bool region_filter_apply(const RegionFilter *filter, HANDLE process, const DynamicArray *regions,
+                         DynamicArray *kept, RegionFilterStats *stats);
+
+const char *region_filter_rule_name(RegionFilterRule rule);
+
+#endif
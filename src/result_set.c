@@ -0,0 +1,423 @@
+#include "result_set.h"
+
+static size_t bitmap_words(size_t slots)
+{
+    return (slots + 63) / 64;
+}
+
+// A bitmap wins once the matches would take more than one bit per slot as 32-bit indices
+static bool prefer_bitmap(size_t slots, size_t count)
+{
+    return count * sizeof(uint32_t) > bitmap_words(slots) * sizeof(uint64_t);
+}
+
+// Packed deltas between distinct slots 4 apart take at least 3 bits, plus one skip entry per block:
+// only worth encoding when even that bound beats the other two representations
+static bool may_pack(size_t slots, size_t count)
+{
+    size_t smallest = min(bitmap_words(slots) * sizeof(uint64_t), count * sizeof(uint32_t));
+    return count * 3 / 8 + packed_block_count(count) * sizeof(PackedBlock) < smallest;
+}
+
+// Keeps the packed encoding when it came out smaller than the other two representations
+static bool take_packed(ResultSegment *segment, PackedEncoder *encoder, size_t slots, size_t count)
+{
+    size_t encoded_bytes;
+    void *packed = packed_encoder_finish(encoder, &encoded_bytes);
+    packed_encoder_free(encoder);
+
+    if (encoded_bytes >= min(bitmap_words(slots) * sizeof(uint64_t), count * sizeof(uint32_t)))
+    {
+        free(packed);
+        return false;
+    }
+    segment->kind = RESULT_SEGMENT_PACKED;
+    segment->data = packed;
+    return true;
+}
+
+// Linear search of a decoded packed block
+static bool packed_contains(const ResultSegment *segment, uint32_t slot)
+{
+    uint32_t values[PACKED_BLOCK_LENGTH];
+    size_t block = packed_find_block(segment->data, segment->count, slot);
+    size_t length = packed_decode_block(segment->data, segment->count, block, values);
+
+    for (size_t i = 0; i < length && values[i] <= slot; i++)
+    {
+        if (values[i] == slot)
+            return true;
+    }
+    return false;
+}
+
+static void *allocate_segment_data(size_t size)
+{
+    void *data = malloc(size);
+    if (!data)
+    {
+        perror("Failed to allocate result segment");
+        exit(EXIT_FAILURE);
+    }
+    return data;
+}
+
+void result_set_init(ResultSet *set, size_t slot_size)
+{
+    create_array(&set->segments, 64, sizeof(ResultSegment));
+    set->slot_size = slot_size;
+    set->count = 0;
+}
+
+void result_set_clear(ResultSet *set, size_t slot_size)
+{
+    result_set_free(set);
+    result_set_init(set, slot_size);
+}
+
+void result_set_free(ResultSet *set)
+{
+    ResultSegment *segments = (ResultSegment *)set->segments.data;
+    for (size_t i = 0; i < set->segments.size; i++)
+        result_segment_free(&segments[i]);
+    free_array(&set->segments);
+    set->count = 0;
+}
+
+size_t result_set_footprint(const ResultSet *set)
+{
+    const ResultSegment *segments = (const ResultSegment *)set->segments.data;
+    size_t bytes = set->segments.capacity * sizeof(ResultSegment);
+
+    for (size_t i = 0; i < set->segments.size; i++)
+    {
+        if (segments[i].kind == RESULT_SEGMENT_BITMAP)
+            bytes += bitmap_words(segments[i].slots) * sizeof(uint64_t);
+        else if (segments[i].kind == RESULT_SEGMENT_PACKED)
+            bytes += packed_encoded_bytes(segments[i].data, segments[i].count);
+        else
+            bytes += segments[i].count * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+bool result_set_contains(const ResultSet *set, uintptr_t address)
+{
+    const ResultSegment *segments = (const ResultSegment *)set->segments.data;
+    size_t lo = 0, hi = set->segments.size;
+
+    // Last segment starting at or before the address
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (segments[mid].base <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return false;
+
+    const ResultSegment *segment = &segments[lo - 1];
+    uintptr_t delta = address - segment->base;
+    if (delta % set->slot_size != 0 || delta / set->slot_size >= segment->slots)
+        return false;
+
+    size_t slot = delta / set->slot_size;
+    if (segment->kind == RESULT_SEGMENT_BITMAP)
+        return (((const uint64_t *)segment->data)[slot / 64] >> (slot % 64)) & 1;
+    if (segment->kind == RESULT_SEGMENT_PACKED)
+        return packed_contains(segment, (uint32_t)slot);
+
+    const uint32_t *offsets = (const uint32_t *)segment->data;
+    size_t first = 0, last = segment->count;
+    while (first < last)
+    {
+        size_t mid = first + (last - first) / 2;
+        if (offsets[mid] < slot)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return first < segment->count && offsets[first] == slot;
+}
+
+bool result_segment_from_masks(ResultSegment *segment, uintptr_t base, size_t slots, const uint64_t *masks)
+{
+    size_t words = bitmap_words(slots);
+    size_t count = 0;
+
+    for (size_t w = 0; w < words; w++)
+        count += (size_t)platform_popcount64(masks[w]);
+
+    memset(segment, 0, sizeof(ResultSegment));
+    if (count == 0)
+        return false;
+
+    segment->base = base;
+    segment->slots = (uint32_t)slots;
+    segment->count = (uint32_t)count;
+
+    if (may_pack(slots, count))
+    {
+        PackedEncoder encoder;
+        packed_encoder_init(&encoder);
+        for (size_t w = 0; w < words; w++)
+        {
+            for (uint64_t bits = masks[w]; bits; bits &= bits - 1)
+                packed_encoder_push(&encoder, (uint32_t)(w * 64 + (size_t)platform_ctz64(bits)));
+        }
+        if (take_packed(segment, &encoder, slots, count))
+            return true;
+    }
+
+    if (prefer_bitmap(slots, count))
+    {
+        segment->kind = RESULT_SEGMENT_BITMAP;
+        segment->data = allocate_segment_data(words * sizeof(uint64_t));
+        memcpy(segment->data, masks, words * sizeof(uint64_t));
+        return true;
+    }
+
+    uint32_t *offsets = allocate_segment_data(count * sizeof(uint32_t));
+    size_t n = 0;
+    for (size_t w = 0; w < words; w++)
+    {
+        for (uint64_t bits = masks[w]; bits; bits &= bits - 1)
+            offsets[n++] = (uint32_t)(w * 64 + (size_t)platform_ctz64(bits));
+    }
+    segment->kind = RESULT_SEGMENT_OFFSETS;
+    segment->data = offsets;
+    return true;
+}
+
+bool result_segment_from_offsets(ResultSegment *segment, uintptr_t base, size_t slots, const uint32_t *offsets, size_t count)
+{
+    memset(segment, 0, sizeof(ResultSegment));
+    if (count == 0)
+        return false;
+
+    segment->base = base;
+    segment->slots = (uint32_t)slots;
+    segment->count = (uint32_t)count;
+
+    if (may_pack(slots, count))
+    {
+        PackedEncoder encoder;
+        packed_encoder_init(&encoder);
+        for (size_t i = 0; i < count; i++)
+            packed_encoder_push(&encoder, offsets[i]);
+        if (take_packed(segment, &encoder, slots, count))
+            return true;
+    }
+
+    if (prefer_bitmap(slots, count))
+    {
+        size_t words = bitmap_words(slots);
+        uint64_t *bits = allocate_segment_data(words * sizeof(uint64_t));
+        memset(bits, 0, words * sizeof(uint64_t));
+        for (size_t i = 0; i < count; i++)
+            bits[offsets[i] / 64] |= (uint64_t)1 << (offsets[i] % 64);
+        segment->kind = RESULT_SEGMENT_BITMAP;
+        segment->data = bits;
+        return true;
+    }
+
+    segment->kind = RESULT_SEGMENT_OFFSETS;
+    segment->data = allocate_segment_data(count * sizeof(uint32_t));
+    memcpy(segment->data, offsets, count * sizeof(uint32_t));
+    return true;
+}
+
+void result_segment_free(ResultSegment *segment)
+{
+    free(segment->data);
+    segment->data = NULL;
+    segment->count = 0;
+}
+
+void result_set_append(ResultSet *set, ResultSegment *segment)
+{
+    if (segment->count == 0)
+    {
+        result_segment_free(segment);
+        return;
+    }
+    segment->ordinal = set->count;
+    append(&set->segments, segment);
+    set->count += segment->count;
+}
+
+/* Cursor */
+
+// Index of the first set bit at or after from, or slots when there is none
+static size_t next_set_bit(const ResultSegment *segment, size_t from)
+{
+    const uint64_t *bits = (const uint64_t *)segment->data;
+    size_t words = bitmap_words(segment->slots);
+    size_t word = from / 64;
+
+    if (word >= words)
+        return segment->slots;
+
+    uint64_t current = bits[word] & (UINT64_MAX << (from % 64));
+    while (!current)
+    {
+        if (++word >= words)
+            return segment->slots;
+        current = bits[word];
+    }
+    return word * 64 + (size_t)platform_ctz64(current);
+}
+
+// Moves to the first match at or after the cursor position, skipping to later segments
+static void settle_cursor(ResultCursor *cursor)
+{
+    const ResultSegment *segments = (const ResultSegment *)cursor->set->segments.data;
+
+    while (cursor->segment < cursor->set->segments.size)
+    {
+        const ResultSegment *segment = &segments[cursor->segment];
+        if (segment->kind == RESULT_SEGMENT_BITMAP)
+        {
+            cursor->position = next_set_bit(segment, cursor->position);
+            if (cursor->position < segment->slots)
+                return;
+        }
+        else if (cursor->position < segment->count)
+        {
+            size_t block = cursor->position / PACKED_BLOCK_LENGTH;
+            if (segment->kind == RESULT_SEGMENT_PACKED && (cursor->decoded_segment != cursor->segment || cursor->decoded_block != block))
+            {
+                packed_decode_block(segment->data, segment->count, block, cursor->decoded);
+                cursor->decoded_segment = cursor->segment;
+                cursor->decoded_block = block;
+            }
+            return;
+        }
+        cursor->segment++;
+        cursor->position = 0;
+    }
+}
+
+void result_cursor_init(ResultCursor *cursor, const ResultSet *set)
+{
+    cursor->set = set;
+    cursor->segment = 0;
+    cursor->position = 0;
+    cursor->ordinal = 0;
+    cursor->decoded_segment = SIZE_MAX;
+    settle_cursor(cursor);
+}
+
+bool result_cursor_valid(const ResultCursor *cursor)
+{
+    return cursor->segment < cursor->set->segments.size;
+}
+
+uintptr_t result_cursor_address(const ResultCursor *cursor)
+{
+    const ResultSegment *segment = (const ResultSegment *)cursor->set->segments.data + cursor->segment;
+    size_t slot;
+
+    if (segment->kind == RESULT_SEGMENT_BITMAP)
+        slot = cursor->position;
+    else if (segment->kind == RESULT_SEGMENT_PACKED)
+        slot = cursor->decoded[cursor->position % PACKED_BLOCK_LENGTH];
+    else
+        slot = ((const uint32_t *)segment->data)[cursor->position];
+    return segment->base + slot * cursor->set->slot_size;
+}
+
+void result_cursor_advance(ResultCursor *cursor)
+{
+    cursor->position++;
+    cursor->ordinal++;
+    settle_cursor(cursor);
+}
+
+void result_cursor_seek(ResultCursor *cursor, const ResultSet *set, uint64_t ordinal)
+{
+    const ResultSegment *segments = (const ResultSegment *)set->segments.data;
+    size_t lo = 0, hi = set->segments.size;
+
+    result_cursor_init(cursor, set);
+    if (ordinal >= set->count)
+    {
+        cursor->segment = set->segments.size;
+        cursor->ordinal = set->count;
+        return;
+    }
+
+    // Last segment starting at or before the ordinal
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (segments[mid].ordinal <= ordinal)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    const ResultSegment *segment = &segments[lo - 1];
+    size_t rank = (size_t)(ordinal - segment->ordinal);
+    cursor->segment = lo - 1;
+    cursor->ordinal = ordinal;
+    cursor->position = rank;
+
+    if (segment->kind == RESULT_SEGMENT_BITMAP)
+    {
+        // Skip whole words by population count, then the remaining bits of the word holding the match
+        const uint64_t *bits = (const uint64_t *)segment->data;
+        size_t word = 0;
+        while ((size_t)platform_popcount64(bits[word]) <= rank)
+            rank -= (size_t)platform_popcount64(bits[word++]);
+
+        uint64_t current = bits[word];
+        for (; rank > 0; rank--)
+            current &= current - 1;
+        cursor->position = word * 64 + (size_t)platform_ctz64(current);
+    }
+    settle_cursor(cursor);
+}
+
+/* Builder */
+
+void result_builder_init(ResultSetBuilder *builder, ResultSet *set)
+{
+    builder->set = set;
+    builder->open = false;
+    create_array(&builder->offsets, 1024, sizeof(uint32_t));
+}
+
+static void flush_builder(ResultSetBuilder *builder)
+{
+    if (builder->open)
+    {
+        ResultSegment segment;
+        if (result_segment_from_offsets(&segment, builder->base, builder->slots, (const uint32_t *)builder->offsets.data, builder->offsets.size))
+            result_set_append(builder->set, &segment);
+        builder->offsets.size = 0;
+        builder->open = false;
+    }
+}
+
+void result_builder_begin(ResultSetBuilder *builder, uintptr_t base, size_t slots)
+{
+    flush_builder(builder);
+    builder->base = base;
+    builder->slots = slots;
+    builder->open = true;
+}
+
+void result_builder_add(ResultSetBuilder *builder, uintptr_t address)
+{
+    uint32_t slot = (uint32_t)((address - builder->base) / builder->set->slot_size);
+    append(&builder->offsets, &slot);
+}
+
+void result_builder_finish(ResultSetBuilder *builder)
+{
+    flush_builder(builder);
+    free_array(&builder->offsets);
+}
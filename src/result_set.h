@@ -0,0 +1,82 @@
+#ifndef RESULT_SET_H
+#define RESULT_SET_H
+
+#include "packed_offsets.h"
+#include "platform.h"
+
+typedef enum
+{
+    RESULT_SEGMENT_BITMAP,  // One bit per slot
+    RESULT_SEGMENT_OFFSETS, // Sorted slot indices (uint32_t)
+    RESULT_SEGMENT_PACKED,  // Sorted slot indices, delta encoded and bit-packed (packed_offsets.h)
+} ResultSegmentKind;
+
+// Matches inside one scanned chunk of a region
+typedef struct
+{
+    uintptr_t base; // Address of slot 0
+    uint32_t slots; // Slots covered
+    uint32_t count; // Matches
+    ResultSegmentKind kind;
+    uint64_t ordinal; // Index in the set of the segment's first match
+    void *data;       // uint64_t bitmap words, uint32_t slot indices or packed slot indices
+} ResultSegment;
+
+typedef struct
+{
+    DynamicArray segments; // ResultSegment in ascending address order, none empty
+    size_t slot_size;      // Bytes between two consecutive slots
+    uint64_t count;
+} ResultSet;
+
+// Walks the matches of a set in address order
+typedef struct
+{
+    const ResultSet *set;
+    size_t segment;
+    size_t position;  // Bit index in a bitmap, entry index in an offset list
+    uint64_t ordinal; // Index of the current match in the whole set
+    size_t decoded_segment; // Packed block held in decoded
+    size_t decoded_block;
+    uint32_t decoded[PACKED_BLOCK_LENGTH];
+} ResultCursor;
+
+// Collects ascending addresses one segment at a time, e.g. the survivors of a refine
+typedef struct
+{
+    ResultSet *set;
+    uintptr_t base;
+    size_t slots;
+    bool open;
+    DynamicArray offsets; // Slot indices of the open segment
+} ResultSetBuilder;
+
+void result_set_init(ResultSet *set, size_t slot_size);
+void result_set_clear(ResultSet *set, size_t slot_size);
+void result_set_free(ResultSet *set);
+size_t result_set_footprint(const ResultSet *set);
+bool result_set_contains(const ResultSet *set, uintptr_t address);
+
+// Segment from per-slot masks (the scan kernel layout, bits past slots cleared) or from sorted slot
+// indices, in whichever of the three representations is smallest. Return false, allocating nothing,
+// when empty.
+bool result_segment_from_masks(ResultSegment *segment, uintptr_t base, size_t slots, const uint64_t *masks);
+bool result_segment_from_offsets(ResultSegment *segment, uintptr_t base, size_t slots, const uint32_t *offsets, size_t count);
+void result_segment_free(ResultSegment *segment);
+
+// Takes ownership of segment, which must lie after every segment already in the set
+void result_set_append(ResultSet *set, ResultSegment *segment);
+
+void result_cursor_init(ResultCursor *cursor, const ResultSet *set);
+bool result_cursor_valid(const ResultCursor *cursor);
+uintptr_t result_cursor_address(const ResultCursor *cursor);
+void result_cursor_advance(ResultCursor *cursor);
+// Moves to the match at index ordinal of the set (invalid past the end), e.g. the first row of a page
+void result_cursor_seek(ResultCursor *cursor, const ResultSet *set, uint64_t ordinal);
+
+void result_builder_init(ResultSetBuilder *builder, ResultSet *set);
+void result_builder_begin(ResultSetBuilder *builder, uintptr_t base, size_t slots);
+void result_builder_add(ResultSetBuilder *builder, uintptr_t address);
+void result_builder_finish(ResultSetBuilder *builder);
+
+#endif
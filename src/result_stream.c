@@ -0,0 +1,80 @@
+#include "result_stream.h"
+
+void result_stream_init(ResultStream *stream, int producer_count, size_t limit)
+{
+    stream->rings = calloc((size_t)producer_count, sizeof(ResultRing));
+    if (!stream->rings)
+    {
+        perror("Failed to allocate result rings");
+        exit(EXIT_FAILURE);
+    }
+    stream->ring_count = producer_count;
+    stream->published = 0;
+    stream->limit = (int64_t)limit;
+}
+
+void result_stream_free(ResultStream *stream)
+{
+    free(stream->rings);
+    stream->rings = NULL;
+    stream->ring_count = 0;
+}
+
+void result_stream_reset(ResultStream *stream)
+{
+    for (int r = 0; r < stream->ring_count; r++)
+    {
+        platform_atomic_store64(&stream->rings[r].head, 0);
+        platform_atomic_store64(&stream->rings[r].tail, 0);
+    }
+    platform_atomic_store64(&stream->published, 0);
+}
+
+size_t result_stream_reserve(ResultStream *stream, size_t wanted)
+{
+    int64_t published = platform_atomic_load64(&stream->published);
+
+    // Plain load first: once the budget is spent, producers never write the shared counter again
+    while (published < stream->limit && wanted > 0)
+    {
+        int64_t claimed = min((int64_t)wanted, stream->limit - published);
+        if (platform_atomic_cas64(&stream->published, published, published + claimed))
+            return (size_t)claimed;
+        published = platform_atomic_load64(&stream->published);
+    }
+    return 0;
+}
+
+bool result_stream_push(ResultStream *stream, int producer, uintptr_t address, uint64_t value)
+{
+    if (producer < 0 || producer >= stream->ring_count)
+        return false;
+
+    ResultRing *ring = &stream->rings[producer];
+    int64_t tail = ring->tail; // Only this producer writes it
+    if (tail - platform_atomic_load64(&ring->head) >= RESULT_RING_CAPACITY)
+        return false;
+
+    StreamedResult *entry = &ring->entries[tail & (RESULT_RING_CAPACITY - 1)];
+    entry->address = address;
+    entry->value = value;
+    platform_atomic_store64(&ring->tail, tail + 1);
+    return true;
+}
+
+size_t result_stream_drain(ResultStream *stream, StreamedResult *results, size_t max_count)
+{
+    size_t drained = 0;
+
+    for (int r = 0; r < stream->ring_count && drained < max_count; r++)
+    {
+        ResultRing *ring = &stream->rings[r];
+        int64_t head = ring->head; // Only the consumer writes it
+        int64_t tail = platform_atomic_load64(&ring->tail);
+
+        while (head < tail && drained < max_count)
+            results[drained++] = ring->entries[head++ & (RESULT_RING_CAPACITY - 1)];
+        platform_atomic_store64(&ring->head, head);
+    }
+    return drained;
+}
@@ -0,0 +1,48 @@
+#ifndef RESULT_STREAM_H
+#define RESULT_STREAM_H
+
+#include "platform.h"
+
+#define RESULT_RING_CAPACITY 1024 // Entries per ring, a power of two
+#define RESULT_RING_PADDING 64    // Keeps the producer and consumer indices on their own cache lines
+
+// A match published while the scan is still running
+typedef struct
+{
+    uintptr_t address;
+    uint64_t value; // Little-endian bytes of the value read, zero-extended
+} StreamedResult;
+
+// Single-producer single-consumer ring: the producer only writes tail, the consumer only writes head
+typedef struct
+{
+    volatile int64_t head;
+    uint8_t head_padding[RESULT_RING_PADDING - sizeof(int64_t)];
+    volatile int64_t tail;
+    uint8_t tail_padding[RESULT_RING_PADDING - sizeof(int64_t)];
+    StreamedResult entries[RESULT_RING_CAPACITY];
+} ResultRing;
+
+// One ring per scan worker, plus a budget shared by all of them: only the first limit matches of a
+// scan are streamed (the rows the results table can show), the rest only counts
+typedef struct
+{
+    ResultRing *rings;
+    int ring_count;
+    volatile int64_t published;
+    int64_t limit;
+} ResultStream;
+
+void result_stream_init(ResultStream *stream, int producer_count, size_t limit);
+void result_stream_free(ResultStream *stream);
+// Empties the rings and restores the budget; only while no producer and no consumer runs
+void result_stream_reset(ResultStream *stream);
+
+// Producer side: claims up to wanted entries of the budget, then pushes at most that many
+size_t result_stream_reserve(ResultStream *stream, size_t wanted);
+bool result_stream_push(ResultStream *stream, int producer, uintptr_t address, uint64_t value);
+
+// Consumer side: moves up to max_count published entries from every ring to results
+size_t result_stream_drain(ResultStream *stream, StreamedResult *results, size_t max_count);
+
+#endif
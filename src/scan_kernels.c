@@ -0,0 +1,2088 @@
+#include "scan_kernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#ifndef _MSC_VER
+#include <cpuid.h>
+#endif
+#else
+#define SCAN_KERNELS_X86 0
+#endif
+
+// MSVC compiles any intrinsic without flags; GCC/Clang need per-function target attributes
+#ifdef _MSC_VER
+#define FORCE_INLINE __forceinline
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#endif
+
+// The vector emitters store 64-bit addresses straight into the match array
+#define VECTOR_EMIT (SCAN_KERNELS_X86 && UINTPTR_MAX == UINT64_MAX)
+
+static int size_index(size_t value_size)
+{
+    switch (value_size)
+    {
+    case 1:
+        return 0;
+    case 2:
+        return 1;
+    case 4:
+        return 2;
+    case 8:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+static FORCE_INLINE uint64_t load_value(const uint8_t *p, size_t size)
+{
+    uint64_t value = 0;
+    memcpy(&value, p, size);
+    return value;
+}
+
+static FORCE_INLINE uint64_t width_mask(size_t size)
+{
+    return size >= 8 ? UINT64_MAX : (((uint64_t)1 << (size * 8)) - 1);
+}
+
+static FORCE_INLINE bool is_signed_number(ScanNumber number)
+{
+    return number == SCAN_NUMBER_SIGNED || number == SCAN_NUMBER_SIGNED_BE;
+}
+
+static FORCE_INLINE bool is_swapped_number(ScanNumber number)
+{
+    return number == SCAN_NUMBER_UNSIGNED_BE || number == SCAN_NUMBER_SIGNED_BE;
+}
+
+static FORCE_INLINE uint64_t sign_bit(size_t size)
+{
+    return (uint64_t)1 << (size * 8 - 1);
+}
+
+static FORCE_INLINE uint64_t swap_value(uint64_t value, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return value;
+    case 2:
+        return platform_bswap16((uint16_t)value);
+    case 4:
+        return platform_bswap32((uint32_t)value);
+    default:
+        return platform_bswap64(value);
+    }
+}
+
+// Integers of every ScanNumber are compared as unsigned keys with the same order: big-endian
+// values are byte-swapped, signed ones get their sign bit flipped. Flipping the sign bit adds
+// 2^(n-1), so wrapping differences of keys equal the differences of the values.
+static FORCE_INLINE uint64_t load_key(const uint8_t *p, ScanNumber number, size_t size)
+{
+    uint64_t value = load_value(p, size);
+    if (is_swapped_number(number))
+        value = swap_value(value, size);
+    if (is_signed_number(number))
+        value ^= sign_bit(size);
+    return value;
+}
+
+// Differences (DELTA_*_BY operands) are byte-swapped like values but have no sign bit to flip
+static FORCE_INLINE uint64_t load_difference(const uint8_t *p, ScanNumber number, size_t size)
+{
+    uint64_t value = load_value(p, size);
+    return is_swapped_number(number) ? swap_value(value, size) : value;
+}
+
+// Range comparisons are all reduced to one unsigned "greater than" on keys: LESS swaps the
+// operands and BETWEEN tests (key - lower) <= (upper - lower) in wrapping arithmetic.
+static FORCE_INLINE uint64_t between_range(const ScanOperands *operands, ScanNumber number, size_t size)
+{
+    return (load_key(operands->upper, number, size) - load_key(operands->value, number, size)) & width_mask(size);
+}
+
+// Bit set at the first byte of every lane of a given width
+static FORCE_INLINE uint64_t lane_starts(size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return UINT64_MAX;
+    case 2:
+        return 0x5555555555555555ull;
+    case 4:
+        return 0x1111111111111111ull;
+    default:
+        return 0x0101010101010101ull;
+    }
+}
+
+/* Scalar */
+
+static FORCE_INLINE void scalar_exact(const uint8_t *data, size_t block_count, const uint8_t *value, uint64_t *masks, size_t size)
+{
+    uint64_t target = load_value(value, size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++)
+        {
+            mask |= (uint64_t)(load_value(p + i, size) == target) << i;
+        }
+        masks[b] = mask;
+    }
+}
+
+static FORCE_INLINE void scalar_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                      ScanNumber number, CompareOp op, size_t size)
+{
+    uint64_t x = load_key(operands->value, number, size);
+    uint64_t range = between_range(operands, number, size);
+    uint64_t wmask = width_mask(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++)
+        {
+            uint64_t v = load_key(p + i, number, size);
+            uint64_t hit = op == COMPARE_GREATER ? v > x : (op == COMPARE_LESS ? v < x : ((v - x) & wmask) <= range);
+            mask |= hit << i;
+        }
+        masks[b] = mask;
+    }
+}
+
+static FORCE_INLINE bool delta_hit(DeltaOp op, uint64_t v, uint64_t p, uint64_t n, uint64_t wmask)
+{
+    switch (op)
+    {
+    case DELTA_CHANGED:
+        return v != p;
+    case DELTA_UNCHANGED:
+        return v == p;
+    case DELTA_INCREASED:
+        return v > p;
+    case DELTA_DECREASED:
+        return v < p;
+    case DELTA_INCREASED_BY:
+        return ((v - p) & wmask) == n;
+    default:
+        return ((p - v) & wmask) == n;
+    }
+}
+
+static FORCE_INLINE void scalar_delta(const uint8_t *current, const uint8_t *previous, size_t block_count, const ScanOperands *operands,
+                                      uint64_t *masks, ScanNumber number, DeltaOp op, size_t size)
+{
+    uint64_t n = load_difference(operands->value, number, size);
+    uint64_t wmask = width_mask(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++)
+        {
+            mask |= (uint64_t)delta_hit(op, load_key(c + i, number, size), load_key(p + i, number, size), n, wmask) << i;
+        }
+        masks[b] = mask;
+    }
+}
+
+#if SCAN_KERNELS_X86
+
+/* SSE2: 16 offsets per compare */
+
+static FORCE_INLINE uint64_t sse2_equal64(const uint8_t *p, __m128i needle)
+{
+    uint64_t m0 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), needle));
+    uint64_t m1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 16)), needle));
+    uint64_t m2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 32)), needle));
+    uint64_t m3 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 48)), needle));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+
+// Every exact kernel filters on the first and last byte of the value, then only
+// confirms the inner bytes for blocks where that pair matched somewhere.
+static FORCE_INLINE void sse2_exact(const uint8_t *data, size_t block_count, const uint8_t *value, uint64_t *masks, size_t size)
+{
+    __m128i needles[8];
+    for (size_t j = 0; j < size; j++)
+        needles[j] = _mm_set1_epi8((char)value[j]);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = sse2_equal64(p, needles[0]);
+
+        if (size > 1)
+            mask &= sse2_equal64(p + size - 1, needles[size - 1]);
+        for (size_t j = 1; mask && j + 1 < size; j++)
+            mask &= sse2_equal64(p + j, needles[j]);
+
+        masks[b] = mask;
+    }
+}
+
+static FORCE_INLINE __m128i sse2_set1(uint64_t value, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return _mm_set1_epi8((char)value);
+    case 2:
+        return _mm_set1_epi16((short)value);
+    case 4:
+        return _mm_set1_epi32((int)value);
+    default:
+        return _mm_set1_epi64x((long long)value);
+    }
+}
+
+static FORCE_INLINE __m128i sse2_sub(__m128i a, __m128i b, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return _mm_sub_epi8(a, b);
+    case 2:
+        return _mm_sub_epi16(a, b);
+    case 4:
+        return _mm_sub_epi32(a, b);
+    default:
+        return _mm_sub_epi64(a, b);
+    }
+}
+
+// Bytes of each lane reversed: SSE2 has no byte shuffle, so the 16-bit words are reordered first
+// and then the bytes of every word swapped
+static FORCE_INLINE __m128i sse2_swap(__m128i v, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return v;
+    case 2:
+        break;
+    case 4:
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        break;
+    default:
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+        break;
+    }
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static FORCE_INLINE __m128i sse2_key(__m128i v, ScanNumber number, size_t size)
+{
+    if (is_swapped_number(number))
+        v = sse2_swap(v, size);
+    if (is_signed_number(number))
+        v = _mm_xor_si128(v, sse2_set1(sign_bit(size), size));
+    return v;
+}
+
+// Unsigned a > b per lane: flip the sign bits and use the signed compare. SSE2 has no 64-bit
+// compare, so 64-bit lanes combine the high dword result with the low one when the highs are equal.
+static FORCE_INLINE __m128i sse2_greater(__m128i a, __m128i b, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+    {
+        __m128i bias = _mm_set1_epi8((char)0x80);
+        return _mm_cmpgt_epi8(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+    }
+    case 2:
+    {
+        __m128i bias = _mm_set1_epi16((short)0x8000);
+        return _mm_cmpgt_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+    }
+    case 4:
+    {
+        __m128i bias = _mm_set1_epi32((int)0x80000000);
+        return _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+    }
+    default:
+    {
+        __m128i bias = _mm_set1_epi32((int)0x80000000);
+        __m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+        __m128i eq = _mm_cmpeq_epi32(a, b);
+        __m128i gt_high = _mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1));
+        __m128i gt_low = _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128i eq_high = _mm_shuffle_epi32(eq, _MM_SHUFFLE(3, 3, 1, 1));
+        return _mm_or_si128(gt_high, _mm_and_si128(eq_high, gt_low));
+    }
+    }
+}
+
+static FORCE_INLINE __m128i sse2_compare(__m128i v, __m128i x, __m128i range, CompareOp op, size_t size)
+{
+    switch (op)
+    {
+    case COMPARE_GREATER:
+        return sse2_greater(v, x, size);
+    case COMPARE_LESS:
+        return sse2_greater(x, v, size);
+    default:
+        return _mm_andnot_si128(sse2_greater(sse2_sub(v, x, size), range, size), _mm_set1_epi8(-1));
+    }
+}
+
+// Lanes can only compare values that start size bytes apart, so each block is compared once
+// per phase (lanes starting at offset r, r + size, ...) and the lane-start bits are merged.
+static FORCE_INLINE void sse2_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                    ScanNumber number, CompareOp op, size_t size)
+{
+    __m128i x = sse2_set1(load_key(operands->value, number, size), size);
+    __m128i range = sse2_set1(between_range(operands, number, size), size);
+    uint32_t starts = (uint32_t)(lane_starts(size) & 0xFFFF);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 16; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m128i values = sse2_key(_mm_loadu_si128((const __m128i *)(p + v * 16 + r)), number, size);
+                bits |= (uint64_t)((uint32_t)_mm_movemask_epi8(sse2_compare(values, x, range, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 16);
+        }
+        masks[b] = mask;
+    }
+}
+
+static FORCE_INLINE uint64_t sse2_same64(const uint8_t *a, const uint8_t *b)
+{
+    uint64_t mask = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + k * 16)), _mm_loadu_si128((const __m128i *)(b + k * 16)));
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(eq) << (k * 16);
+    }
+    return mask;
+}
+
+static FORCE_INLINE __m128i sse2_lane_equal(__m128i a, __m128i b, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return _mm_cmpeq_epi8(a, b);
+    case 2:
+        return _mm_cmpeq_epi16(a, b);
+    case 4:
+        return _mm_cmpeq_epi32(a, b);
+    default:
+    {
+        __m128i eq = _mm_cmpeq_epi32(a, b);
+        return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+    }
+}
+
+static FORCE_INLINE __m128i sse2_delta_compare(__m128i v, __m128i p, __m128i n, DeltaOp op, size_t size)
+{
+    switch (op)
+    {
+    case DELTA_INCREASED:
+        return sse2_greater(v, p, size);
+    case DELTA_DECREASED:
+        return sse2_greater(p, v, size);
+    case DELTA_INCREASED_BY:
+        return sse2_lane_equal(sse2_sub(v, p, size), n, size);
+    default:
+        return sse2_lane_equal(sse2_sub(p, v, size), n, size);
+    }
+}
+
+// Changed/unchanged only need byte equality: a value is unchanged when all of its bytes are,
+// which is the exact kernel with the previous buffer as needle. The other comparisons run per phase.
+static FORCE_INLINE void sse2_delta(const uint8_t *current, const uint8_t *previous, size_t block_count, const ScanOperands *operands,
+                                    uint64_t *masks, ScanNumber number, DeltaOp op, size_t size)
+{
+    if (op == DELTA_CHANGED || op == DELTA_UNCHANGED)
+    {
+        for (size_t b = 0; b < block_count; b++)
+        {
+            const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+            const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+            uint64_t mask = sse2_same64(c, p);
+
+            for (size_t j = 1; mask && j < size; j++)
+                mask &= sse2_same64(c + j, p + j);
+
+            masks[b] = op == DELTA_CHANGED ? ~mask : mask;
+        }
+        return;
+    }
+
+    __m128i n = sse2_set1(load_difference(operands->value, number, size), size);
+    uint32_t starts = (uint32_t)(lane_starts(size) & 0xFFFF);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 16; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m128i now = sse2_key(_mm_loadu_si128((const __m128i *)(c + v * 16 + r)), number, size);
+                __m128i before = sse2_key(_mm_loadu_si128((const __m128i *)(p + v * 16 + r)), number, size);
+                bits |= (uint64_t)((uint32_t)_mm_movemask_epi8(sse2_delta_compare(now, before, n, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 16);
+        }
+        masks[b] = mask;
+    }
+}
+
+/* AVX2: 32 offsets per compare */
+
+TARGET_AVX2 static FORCE_INLINE uint64_t avx2_equal64(const uint8_t *p, __m256i needle)
+{
+    uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), needle));
+    uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 32)), needle));
+    return m0 | (m1 << 32);
+}
+
+TARGET_AVX2 static FORCE_INLINE void avx2_exact(const uint8_t *data, size_t block_count, const uint8_t *value, uint64_t *masks, size_t size)
+{
+    __m256i needles[8];
+    for (size_t j = 0; j < size; j++)
+        needles[j] = _mm256_set1_epi8((char)value[j]);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = avx2_equal64(p, needles[0]);
+
+        if (size > 1)
+            mask &= avx2_equal64(p + size - 1, needles[size - 1]);
+        for (size_t j = 1; mask && j + 1 < size; j++)
+            mask &= avx2_equal64(p + j, needles[j]);
+
+        masks[b] = mask;
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_set1(uint64_t value, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return _mm256_set1_epi8((char)value);
+    case 2:
+        return _mm256_set1_epi16((short)value);
+    case 4:
+        return _mm256_set1_epi32((int)value);
+    default:
+        return _mm256_set1_epi64x((long long)value);
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_sub(__m256i a, __m256i b, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return _mm256_sub_epi8(a, b);
+    case 2:
+        return _mm256_sub_epi16(a, b);
+    case 4:
+        return _mm256_sub_epi32(a, b);
+    default:
+        return _mm256_sub_epi64(a, b);
+    }
+}
+
+// Byte shuffle reversing every lane of size bytes (the same in each 128-bit half)
+static FORCE_INLINE __m128i swap_pattern(size_t size)
+{
+    switch (size)
+    {
+    case 2:
+        return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    case 4:
+        return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    default:
+        return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_key(__m256i v, ScanNumber number, size_t size)
+{
+    if (is_swapped_number(number) && size > 1)
+        v = _mm256_shuffle_epi8(v, _mm256_broadcastsi128_si256(swap_pattern(size)));
+    if (is_signed_number(number))
+        v = _mm256_xor_si256(v, avx2_set1(sign_bit(size), size));
+    return v;
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_greater(__m256i a, __m256i b, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+    {
+        __m256i bias = _mm256_set1_epi8((char)0x80);
+        return _mm256_cmpgt_epi8(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+    }
+    case 2:
+    {
+        __m256i bias = _mm256_set1_epi16((short)0x8000);
+        return _mm256_cmpgt_epi16(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+    }
+    case 4:
+    {
+        __m256i bias = _mm256_set1_epi32((int)0x80000000);
+        return _mm256_cmpgt_epi32(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+    }
+    default:
+    {
+        __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ull);
+        return _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+    }
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_compare(__m256i v, __m256i x, __m256i range, CompareOp op, size_t size)
+{
+    switch (op)
+    {
+    case COMPARE_GREATER:
+        return avx2_greater(v, x, size);
+    case COMPARE_LESS:
+        return avx2_greater(x, v, size);
+    default:
+        return _mm256_andnot_si256(avx2_greater(avx2_sub(v, x, size), range, size), _mm256_set1_epi8(-1));
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE void avx2_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                                ScanNumber number, CompareOp op, size_t size)
+{
+    __m256i x = avx2_set1(load_key(operands->value, number, size), size);
+    __m256i range = avx2_set1(between_range(operands, number, size), size);
+    uint32_t starts = (uint32_t)lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 32; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m256i values = avx2_key(_mm256_loadu_si256((const __m256i *)(p + v * 32 + r)), number, size);
+                bits |= (uint64_t)((uint32_t)_mm256_movemask_epi8(avx2_compare(values, x, range, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 32);
+        }
+        masks[b] = mask;
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE uint64_t avx2_same64(const uint8_t *a, const uint8_t *b)
+{
+    __m256i eq0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)a), _mm256_loadu_si256((const __m256i *)b));
+    __m256i eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + 32)), _mm256_loadu_si256((const __m256i *)(b + 32)));
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8(eq0) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(eq1) << 32);
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_lane_equal(__m256i a, __m256i b, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return _mm256_cmpeq_epi8(a, b);
+    case 2:
+        return _mm256_cmpeq_epi16(a, b);
+    case 4:
+        return _mm256_cmpeq_epi32(a, b);
+    default:
+        return _mm256_cmpeq_epi64(a, b);
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_delta_compare(__m256i v, __m256i p, __m256i n, DeltaOp op, size_t size)
+{
+    switch (op)
+    {
+    case DELTA_INCREASED:
+        return avx2_greater(v, p, size);
+    case DELTA_DECREASED:
+        return avx2_greater(p, v, size);
+    case DELTA_INCREASED_BY:
+        return avx2_lane_equal(avx2_sub(v, p, size), n, size);
+    default:
+        return avx2_lane_equal(avx2_sub(p, v, size), n, size);
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE void avx2_delta(const uint8_t *current, const uint8_t *previous, size_t block_count, const ScanOperands *operands,
+                                                uint64_t *masks, ScanNumber number, DeltaOp op, size_t size)
+{
+    if (op == DELTA_CHANGED || op == DELTA_UNCHANGED)
+    {
+        for (size_t b = 0; b < block_count; b++)
+        {
+            const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+            const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+            uint64_t mask = avx2_same64(c, p);
+
+            for (size_t j = 1; mask && j < size; j++)
+                mask &= avx2_same64(c + j, p + j);
+
+            masks[b] = op == DELTA_CHANGED ? ~mask : mask;
+        }
+        return;
+    }
+
+    __m256i n = avx2_set1(load_difference(operands->value, number, size), size);
+    uint32_t starts = (uint32_t)lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 32; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m256i now = avx2_key(_mm256_loadu_si256((const __m256i *)(c + v * 32 + r)), number, size);
+                __m256i before = avx2_key(_mm256_loadu_si256((const __m256i *)(p + v * 32 + r)), number, size);
+                bits |= (uint64_t)((uint32_t)_mm256_movemask_epi8(avx2_delta_compare(now, before, n, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 32);
+        }
+        masks[b] = mask;
+    }
+}
+
+/* AVX-512BW: 64 offsets per compare, straight into a mask register */
+
+TARGET_AVX512 static FORCE_INLINE uint64_t avx512_equal64(const uint8_t *p, __m512i needle)
+{
+    return (uint64_t)_mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void *)p), needle);
+}
+
+TARGET_AVX512 static FORCE_INLINE void avx512_exact(const uint8_t *data, size_t block_count, const uint8_t *value, uint64_t *masks, size_t size)
+{
+    __m512i needles[8];
+    for (size_t j = 0; j < size; j++)
+        needles[j] = _mm512_set1_epi8((char)value[j]);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = avx512_equal64(p, needles[0]);
+
+        if (size > 1)
+            mask &= avx512_equal64(p + size - 1, needles[size - 1]);
+        for (size_t j = 1; mask && j + 1 < size; j++)
+            mask &= avx512_equal64(p + j, needles[j]);
+
+        masks[b] = mask;
+    }
+}
+
+TARGET_AVX512 static FORCE_INLINE __m512i avx512_set1(uint64_t value, size_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return _mm512_set1_epi8((char)value);
+    case 2:
+        return _mm512_set1_epi16((short)value);
+    case 4:
+        return _mm512_set1_epi32((int)value);
+    default:
+        return _mm512_set1_epi64((long long)value);
+    }
+}
+
+TARGET_AVX512 static FORCE_INLINE __m512i avx512_key(__m512i v, ScanNumber number, size_t size)
+{
+    if (is_swapped_number(number) && size > 1)
+        v = _mm512_shuffle_epi8(v, _mm512_broadcast_i32x4(swap_pattern(size)));
+    if (is_signed_number(number))
+        v = _mm512_xor_si512(v, avx512_set1(sign_bit(size), size));
+    return v;
+}
+
+// AVX-512 compares unsigned lanes natively; the lane mask is widened back to one bit per byte
+// (via a masked move) so that every width produces the same byte-offset mask layout.
+TARGET_AVX512 static FORCE_INLINE uint64_t avx512_compare(__m512i v, __m512i x, __m512i range, CompareOp op, size_t size)
+{
+    const int predicate = op == COMPARE_GREATER ? _MM_CMPINT_NLE : (op == COMPARE_LESS ? _MM_CMPINT_LT : _MM_CMPINT_LE);
+    const __m512i ones = _mm512_set1_epi8(-1);
+
+    switch (size)
+    {
+    case 1:
+    {
+        __m512i lhs = op == COMPARE_BETWEEN ? _mm512_sub_epi8(v, x) : v;
+        return (uint64_t)_mm512_cmp_epu8_mask(lhs, op == COMPARE_BETWEEN ? range : x, predicate);
+    }
+    case 2:
+    {
+        __m512i lhs = op == COMPARE_BETWEEN ? _mm512_sub_epi16(v, x) : v;
+        __mmask32 lanes = _mm512_cmp_epu16_mask(lhs, op == COMPARE_BETWEEN ? range : x, predicate);
+        return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi16(lanes, ones));
+    }
+    case 4:
+    {
+        __m512i lhs = op == COMPARE_BETWEEN ? _mm512_sub_epi32(v, x) : v;
+        __mmask16 lanes = _mm512_cmp_epu32_mask(lhs, op == COMPARE_BETWEEN ? range : x, predicate);
+        return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi32(lanes, ones));
+    }
+    default:
+    {
+        __m512i lhs = op == COMPARE_BETWEEN ? _mm512_sub_epi64(v, x) : v;
+        __mmask8 lanes = _mm512_cmp_epu64_mask(lhs, op == COMPARE_BETWEEN ? range : x, predicate);
+        return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi64(lanes, ones));
+    }
+    }
+}
+
+TARGET_AVX512 static FORCE_INLINE void avx512_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                                    ScanNumber number, CompareOp op, size_t size)
+{
+    __m512i x = avx512_set1(load_key(operands->value, number, size), size);
+    __m512i range = avx512_set1(between_range(operands, number, size), size);
+    uint64_t starts = lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t r = 0; r < size; r++)
+        {
+            __m512i values = avx512_key(_mm512_loadu_si512((const void *)(p + r)), number, size);
+            mask |= (avx512_compare(values, x, range, op, size) & starts) << r;
+        }
+        masks[b] = mask;
+    }
+}
+
+TARGET_AVX512 static FORCE_INLINE uint64_t avx512_delta_compare(__m512i v, __m512i p, __m512i n, DeltaOp op, size_t size)
+{
+    const int predicate = op == DELTA_INCREASED ? _MM_CMPINT_NLE : (op == DELTA_DECREASED ? _MM_CMPINT_LT : _MM_CMPINT_EQ);
+    const bool by = op == DELTA_INCREASED_BY || op == DELTA_DECREASED_BY;
+    const __m512i ones = _mm512_set1_epi8(-1);
+    __m512i a = op == DELTA_DECREASED_BY ? p : v;
+    __m512i b = op == DELTA_DECREASED_BY ? v : p;
+
+    switch (size)
+    {
+    case 1:
+        return (uint64_t)_mm512_cmp_epu8_mask(by ? _mm512_sub_epi8(a, b) : v, by ? n : p, predicate);
+    case 2:
+    {
+        __mmask32 lanes = _mm512_cmp_epu16_mask(by ? _mm512_sub_epi16(a, b) : v, by ? n : p, predicate);
+        return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi16(lanes, ones));
+    }
+    case 4:
+    {
+        __mmask16 lanes = _mm512_cmp_epu32_mask(by ? _mm512_sub_epi32(a, b) : v, by ? n : p, predicate);
+        return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi32(lanes, ones));
+    }
+    default:
+    {
+        __mmask8 lanes = _mm512_cmp_epu64_mask(by ? _mm512_sub_epi64(a, b) : v, by ? n : p, predicate);
+        return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi64(lanes, ones));
+    }
+    }
+}
+
+TARGET_AVX512 static FORCE_INLINE void avx512_delta(const uint8_t *current, const uint8_t *previous, size_t block_count, const ScanOperands *operands,
+                                                    uint64_t *masks, ScanNumber number, DeltaOp op, size_t size)
+{
+    if (op == DELTA_CHANGED || op == DELTA_UNCHANGED)
+    {
+        for (size_t b = 0; b < block_count; b++)
+        {
+            const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+            const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+            uint64_t mask = (uint64_t)_mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void *)c), _mm512_loadu_si512((const void *)p));
+
+            for (size_t j = 1; mask && j < size; j++)
+                mask &= (uint64_t)_mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void *)(c + j)), _mm512_loadu_si512((const void *)(p + j)));
+
+            masks[b] = op == DELTA_CHANGED ? ~mask : mask;
+        }
+        return;
+    }
+
+    __m512i n = avx512_set1(load_difference(operands->value, number, size), size);
+    uint64_t starts = lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t r = 0; r < size; r++)
+        {
+            __m512i now = avx512_key(_mm512_loadu_si512((const void *)(c + r)), number, size);
+            __m512i before = avx512_key(_mm512_loadu_si512((const void *)(p + r)), number, size);
+            mask |= (avx512_delta_compare(now, before, n, op, size) & starts) << r;
+        }
+        masks[b] = mask;
+    }
+}
+
+#endif
+
+/* Floating point: IEEE comparisons on float (size 4) and double (size 8) values. NaN compares
+   false to everything (so it only ever counts as changed), and the comparisons never flush
+   denormals: nothing here touches MXCSR, so they compare exactly like the scalar code. Every
+   tolerance mode is reduced to COMPARE_BETWEEN [value, upper] by the caller, the *_BY deltas test
+   the difference against [value, upper] the same way. */
+
+static FORCE_INLINE double load_float(const uint8_t *p, size_t size)
+{
+    if (size == 4)
+    {
+        float value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    double value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static FORCE_INLINE bool float_hit(CompareOp op, double v, double x, double upper)
+{
+    switch (op)
+    {
+    case COMPARE_EQUAL:
+        return v == x;
+    case COMPARE_GREATER:
+        return v > x;
+    case COMPARE_LESS:
+        return v < x;
+    default:
+        return x <= v && v <= upper;
+    }
+}
+
+// Differences are computed at the width of the values, like the vector kernels do
+static FORCE_INLINE bool float_delta_hit(DeltaOp op, const uint8_t *current, const uint8_t *previous, const ScanOperands *operands, size_t size)
+{
+    double v = load_float(current, size);
+    double p = load_float(previous, size);
+    double difference = size == 4 ? (double)(op == DELTA_DECREASED_BY ? (float)p - (float)v : (float)v - (float)p)
+                                  : (op == DELTA_DECREASED_BY ? p - v : v - p);
+
+    switch (op)
+    {
+    case DELTA_CHANGED:
+        return !(v == p);
+    case DELTA_UNCHANGED:
+        return v == p;
+    case DELTA_INCREASED:
+        return v > p;
+    case DELTA_DECREASED:
+        return v < p;
+    default:
+        return load_float(operands->value, size) <= difference && difference <= load_float(operands->upper, size);
+    }
+}
+
+static FORCE_INLINE void scalar_float_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                            CompareOp op, size_t size)
+{
+    double x = load_float(operands->value, size);
+    double upper = load_float(operands->upper, size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++)
+        {
+            mask |= (uint64_t)float_hit(op, load_float(p + i, size), x, upper) << i;
+        }
+        masks[b] = mask;
+    }
+}
+
+static FORCE_INLINE void scalar_float_delta(const uint8_t *current, const uint8_t *previous, size_t block_count, const ScanOperands *operands,
+                                            uint64_t *masks, DeltaOp op, size_t size)
+{
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++)
+        {
+            mask |= (uint64_t)float_delta_hit(op, c + i, p + i, operands, size) << i;
+        }
+        masks[b] = mask;
+    }
+}
+
+#if SCAN_KERNELS_X86
+
+static FORCE_INLINE __m128i sse2_float_compare(__m128i v, __m128i x, __m128i upper, CompareOp op, size_t size)
+{
+    if (size == 4)
+    {
+        __m128 a = _mm_castsi128_ps(v), b = _mm_castsi128_ps(x);
+        switch (op)
+        {
+        case COMPARE_EQUAL:
+            return _mm_castps_si128(_mm_cmpeq_ps(a, b));
+        case COMPARE_GREATER:
+            return _mm_castps_si128(_mm_cmpgt_ps(a, b));
+        case COMPARE_LESS:
+            return _mm_castps_si128(_mm_cmplt_ps(a, b));
+        default:
+            return _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(a, b), _mm_cmple_ps(a, _mm_castsi128_ps(upper))));
+        }
+    }
+
+    __m128d a = _mm_castsi128_pd(v), b = _mm_castsi128_pd(x);
+    switch (op)
+    {
+    case COMPARE_EQUAL:
+        return _mm_castpd_si128(_mm_cmpeq_pd(a, b));
+    case COMPARE_GREATER:
+        return _mm_castpd_si128(_mm_cmpgt_pd(a, b));
+    case COMPARE_LESS:
+        return _mm_castpd_si128(_mm_cmplt_pd(a, b));
+    default:
+        return _mm_castpd_si128(_mm_and_pd(_mm_cmpge_pd(a, b), _mm_cmple_pd(a, _mm_castsi128_pd(upper))));
+    }
+}
+
+static FORCE_INLINE __m128i sse2_float_delta_compare(__m128i v, __m128i p, __m128i lower, __m128i upper, DeltaOp op, size_t size)
+{
+    if (size == 4)
+    {
+        __m128 a = _mm_castsi128_ps(v), b = _mm_castsi128_ps(p);
+        __m128 difference = op == DELTA_DECREASED_BY ? _mm_sub_ps(b, a) : _mm_sub_ps(a, b);
+        switch (op)
+        {
+        case DELTA_CHANGED:
+            return _mm_castps_si128(_mm_cmpneq_ps(a, b));
+        case DELTA_UNCHANGED:
+            return _mm_castps_si128(_mm_cmpeq_ps(a, b));
+        case DELTA_INCREASED:
+            return _mm_castps_si128(_mm_cmpgt_ps(a, b));
+        case DELTA_DECREASED:
+            return _mm_castps_si128(_mm_cmplt_ps(a, b));
+        default:
+            return _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(difference, _mm_castsi128_ps(lower)),
+                                               _mm_cmple_ps(difference, _mm_castsi128_ps(upper))));
+        }
+    }
+
+    __m128d a = _mm_castsi128_pd(v), b = _mm_castsi128_pd(p);
+    __m128d difference = op == DELTA_DECREASED_BY ? _mm_sub_pd(b, a) : _mm_sub_pd(a, b);
+    switch (op)
+    {
+    case DELTA_CHANGED:
+        return _mm_castpd_si128(_mm_cmpneq_pd(a, b));
+    case DELTA_UNCHANGED:
+        return _mm_castpd_si128(_mm_cmpeq_pd(a, b));
+    case DELTA_INCREASED:
+        return _mm_castpd_si128(_mm_cmpgt_pd(a, b));
+    case DELTA_DECREASED:
+        return _mm_castpd_si128(_mm_cmplt_pd(a, b));
+    default:
+        return _mm_castpd_si128(_mm_and_pd(_mm_cmpge_pd(difference, _mm_castsi128_pd(lower)),
+                                           _mm_cmple_pd(difference, _mm_castsi128_pd(upper))));
+    }
+}
+
+// Same phase layout as sse2_range: one pass per starting offset within a lane
+static FORCE_INLINE void sse2_float_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                          CompareOp op, size_t size)
+{
+    __m128i x = sse2_set1(load_value(operands->value, size), size);
+    __m128i upper = sse2_set1(load_value(operands->upper, size), size);
+    uint32_t starts = (uint32_t)(lane_starts(size) & 0xFFFF);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 16; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m128i values = _mm_loadu_si128((const __m128i *)(p + v * 16 + r));
+                bits |= (uint64_t)((uint32_t)_mm_movemask_epi8(sse2_float_compare(values, x, upper, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 16);
+        }
+        masks[b] = mask;
+    }
+}
+
+static FORCE_INLINE void sse2_float_delta(const uint8_t *current, const uint8_t *previous, size_t block_count, const ScanOperands *operands,
+                                          uint64_t *masks, DeltaOp op, size_t size)
+{
+    __m128i lower = sse2_set1(load_value(operands->value, size), size);
+    __m128i upper = sse2_set1(load_value(operands->upper, size), size);
+    uint32_t starts = (uint32_t)(lane_starts(size) & 0xFFFF);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 16; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m128i now = _mm_loadu_si128((const __m128i *)(c + v * 16 + r));
+                __m128i before = _mm_loadu_si128((const __m128i *)(p + v * 16 + r));
+                bits |= (uint64_t)((uint32_t)_mm_movemask_epi8(sse2_float_delta_compare(now, before, lower, upper, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 16);
+        }
+        masks[b] = mask;
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_float_compare(__m256i v, __m256i x, __m256i upper, CompareOp op, size_t size)
+{
+    if (size == 4)
+    {
+        __m256 a = _mm256_castsi256_ps(v), b = _mm256_castsi256_ps(x);
+        switch (op)
+        {
+        case COMPARE_EQUAL:
+            return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+        case COMPARE_GREATER:
+            return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ));
+        case COMPARE_LESS:
+            return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ));
+        default:
+            return _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ), _mm256_cmp_ps(a, _mm256_castsi256_ps(upper), _CMP_LE_OQ)));
+        }
+    }
+
+    __m256d a = _mm256_castsi256_pd(v), b = _mm256_castsi256_pd(x);
+    switch (op)
+    {
+    case COMPARE_EQUAL:
+        return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_EQ_OQ));
+    case COMPARE_GREATER:
+        return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_GT_OQ));
+    case COMPARE_LESS:
+        return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_LT_OQ));
+    default:
+        return _mm256_castpd_si256(_mm256_and_pd(_mm256_cmp_pd(a, b, _CMP_GE_OQ), _mm256_cmp_pd(a, _mm256_castsi256_pd(upper), _CMP_LE_OQ)));
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE __m256i avx2_float_delta_compare(__m256i v, __m256i p, __m256i lower, __m256i upper, DeltaOp op, size_t size)
+{
+    const bool by = op == DELTA_INCREASED_BY || op == DELTA_DECREASED_BY;
+
+    if (size == 4)
+    {
+        __m256 a = _mm256_castsi256_ps(v), b = _mm256_castsi256_ps(p);
+        if (!by)
+        {
+            switch (op)
+            {
+            case DELTA_CHANGED:
+                return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_NEQ_UQ));
+            case DELTA_UNCHANGED:
+                return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+            case DELTA_INCREASED:
+                return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ));
+            default:
+                return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ));
+            }
+        }
+        __m256 difference = op == DELTA_DECREASED_BY ? _mm256_sub_ps(b, a) : _mm256_sub_ps(a, b);
+        return _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(difference, _mm256_castsi256_ps(lower), _CMP_GE_OQ),
+                                                 _mm256_cmp_ps(difference, _mm256_castsi256_ps(upper), _CMP_LE_OQ)));
+    }
+
+    __m256d a = _mm256_castsi256_pd(v), b = _mm256_castsi256_pd(p);
+    if (!by)
+    {
+        switch (op)
+        {
+        case DELTA_CHANGED:
+            return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_NEQ_UQ));
+        case DELTA_UNCHANGED:
+            return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_EQ_OQ));
+        case DELTA_INCREASED:
+            return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_GT_OQ));
+        default:
+            return _mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_LT_OQ));
+        }
+    }
+    __m256d difference = op == DELTA_DECREASED_BY ? _mm256_sub_pd(b, a) : _mm256_sub_pd(a, b);
+    return _mm256_castpd_si256(_mm256_and_pd(_mm256_cmp_pd(difference, _mm256_castsi256_pd(lower), _CMP_GE_OQ),
+                                             _mm256_cmp_pd(difference, _mm256_castsi256_pd(upper), _CMP_LE_OQ)));
+}
+
+TARGET_AVX2 static FORCE_INLINE void avx2_float_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                                      CompareOp op, size_t size)
+{
+    __m256i x = avx2_set1(load_value(operands->value, size), size);
+    __m256i upper = avx2_set1(load_value(operands->upper, size), size);
+    uint32_t starts = (uint32_t)lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 32; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m256i values = _mm256_loadu_si256((const __m256i *)(p + v * 32 + r));
+                bits |= (uint64_t)((uint32_t)_mm256_movemask_epi8(avx2_float_compare(values, x, upper, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 32);
+        }
+        masks[b] = mask;
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE void avx2_float_delta(const uint8_t *current, const uint8_t *previous, size_t block_count, const ScanOperands *operands,
+                                                      uint64_t *masks, DeltaOp op, size_t size)
+{
+    __m256i lower = avx2_set1(load_value(operands->value, size), size);
+    __m256i upper = avx2_set1(load_value(operands->upper, size), size);
+    uint32_t starts = (uint32_t)lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t v = 0; v < SCAN_BLOCK_SIZE / 32; v++)
+        {
+            uint64_t bits = 0;
+            for (size_t r = 0; r < size; r++)
+            {
+                __m256i now = _mm256_loadu_si256((const __m256i *)(c + v * 32 + r));
+                __m256i before = _mm256_loadu_si256((const __m256i *)(p + v * 32 + r));
+                bits |= (uint64_t)((uint32_t)_mm256_movemask_epi8(avx2_float_delta_compare(now, before, lower, upper, op, size)) & starts) << r;
+            }
+            mask |= bits << (v * 32);
+        }
+        masks[b] = mask;
+    }
+}
+
+// Lane masks are widened to one bit per byte like avx512_compare does
+TARGET_AVX512 static FORCE_INLINE uint64_t avx512_widen(uint16_t lanes32, uint8_t lanes64, size_t size)
+{
+    const __m512i ones = _mm512_set1_epi8(-1);
+    if (size == 4)
+        return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi32(lanes32, ones));
+    return (uint64_t)_mm512_movepi8_mask(_mm512_maskz_mov_epi64(lanes64, ones));
+}
+
+TARGET_AVX512 static FORCE_INLINE uint64_t avx512_float_compare(__m512i v, __m512i x, __m512i upper, CompareOp op, size_t size)
+{
+    if (size == 4)
+    {
+        __m512 a = _mm512_castsi512_ps(v), b = _mm512_castsi512_ps(x);
+        __mmask16 lanes = op == COMPARE_BETWEEN ? _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ) & _mm512_cmp_ps_mask(a, _mm512_castsi512_ps(upper), _CMP_LE_OQ)
+                        : op == COMPARE_EQUAL   ? _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)
+                        : op == COMPARE_GREATER ? _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ)
+                                                : _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+        return avx512_widen(lanes, 0, size);
+    }
+
+    __m512d a = _mm512_castsi512_pd(v), b = _mm512_castsi512_pd(x);
+    __mmask8 lanes = op == COMPARE_BETWEEN ? _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ) & _mm512_cmp_pd_mask(a, _mm512_castsi512_pd(upper), _CMP_LE_OQ)
+                   : op == COMPARE_EQUAL   ? _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ)
+                   : op == COMPARE_GREATER ? _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ)
+                                           : _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+    return avx512_widen(0, lanes, size);
+}
+
+TARGET_AVX512 static FORCE_INLINE uint64_t avx512_float_delta_compare(__m512i v, __m512i p, __m512i lower, __m512i upper, DeltaOp op, size_t size)
+{
+    const bool by = op == DELTA_INCREASED_BY || op == DELTA_DECREASED_BY;
+
+    if (size == 4)
+    {
+        __m512 a = _mm512_castsi512_ps(v), b = _mm512_castsi512_ps(p);
+        __m512 difference = op == DELTA_DECREASED_BY ? _mm512_sub_ps(b, a) : _mm512_sub_ps(a, b);
+        __mmask16 lanes = by ? _mm512_cmp_ps_mask(difference, _mm512_castsi512_ps(lower), _CMP_GE_OQ) &
+                                   _mm512_cmp_ps_mask(difference, _mm512_castsi512_ps(upper), _CMP_LE_OQ)
+                        : op == DELTA_CHANGED   ? _mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ)
+                        : op == DELTA_UNCHANGED ? _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)
+                        : op == DELTA_INCREASED ? _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ)
+                                                : _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+        return avx512_widen(lanes, 0, size);
+    }
+
+    __m512d a = _mm512_castsi512_pd(v), b = _mm512_castsi512_pd(p);
+    __m512d difference = op == DELTA_DECREASED_BY ? _mm512_sub_pd(b, a) : _mm512_sub_pd(a, b);
+    __mmask8 lanes = by ? _mm512_cmp_pd_mask(difference, _mm512_castsi512_pd(lower), _CMP_GE_OQ) &
+                              _mm512_cmp_pd_mask(difference, _mm512_castsi512_pd(upper), _CMP_LE_OQ)
+                   : op == DELTA_CHANGED   ? _mm512_cmp_pd_mask(a, b, _CMP_NEQ_UQ)
+                   : op == DELTA_UNCHANGED ? _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ)
+                   : op == DELTA_INCREASED ? _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ)
+                                           : _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+    return avx512_widen(0, lanes, size);
+}
+
+TARGET_AVX512 static FORCE_INLINE void avx512_float_range(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks,
+                                                          CompareOp op, size_t size)
+{
+    __m512i x = avx512_set1(load_value(operands->value, size), size);
+    __m512i upper = avx512_set1(load_value(operands->upper, size), size);
+    uint64_t starts = lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t r = 0; r < size; r++)
+        {
+            __m512i values = _mm512_loadu_si512((const void *)(p + r));
+            mask |= (avx512_float_compare(values, x, upper, op, size) & starts) << r;
+        }
+        masks[b] = mask;
+    }
+}
+
+TARGET_AVX512 static FORCE_INLINE void avx512_float_delta(const uint8_t *current, const uint8_t *previous, size_t block_count,
+                                                          const ScanOperands *operands, uint64_t *masks, DeltaOp op, size_t size)
+{
+    __m512i lower = avx512_set1(load_value(operands->value, size), size);
+    __m512i upper = avx512_set1(load_value(operands->upper, size), size);
+    uint64_t starts = lane_starts(size);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *c = current + b * SCAN_BLOCK_SIZE;
+        const uint8_t *p = previous + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t r = 0; r < size; r++)
+        {
+            __m512i now = _mm512_loadu_si512((const void *)(c + r));
+            __m512i before = _mm512_loadu_si512((const void *)(p + r));
+            mask |= (avx512_float_delta_compare(now, before, lower, upper, op, size) & starts) << r;
+        }
+        masks[b] = mask;
+    }
+}
+
+#endif
+
+// One kernel per (ISA, number, comparison, value size) so that all of them are compile-time
+// constants. Exact and changed/unchanged kernels only compare bytes, so every integer number
+// shares them; the others are generated per number under its tag.
+#define DEFINE_EXACT_KERNEL(prefix, target, size)                                                                                \
+    target static void prefix##_equal_##size(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks) \
+    {                                                                                                                            \
+        prefix##_exact(data, block_count, operands->value, masks, size);                                                         \
+    }
+
+#define DEFINE_RANGE_KERNEL(prefix, target, tag, number, name, op, size)                                                                     \
+    target static void prefix##_##tag##_##name##_##size(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks) \
+    {                                                                                                                                        \
+        prefix##_range(data, block_count, operands, masks, number, op, size);                                                                \
+    }
+
+#define DEFINE_OP_KERNELS(prefix, target, tag, number, name, op)  \
+    DEFINE_RANGE_KERNEL(prefix, target, tag, number, name, op, 1) \
+    DEFINE_RANGE_KERNEL(prefix, target, tag, number, name, op, 2) \
+    DEFINE_RANGE_KERNEL(prefix, target, tag, number, name, op, 4) \
+    DEFINE_RANGE_KERNEL(prefix, target, tag, number, name, op, 8)
+
+#define DEFINE_NUMBER_KERNELS(prefix, target, tag, number)                   \
+    DEFINE_OP_KERNELS(prefix, target, tag, number, greater, COMPARE_GREATER) \
+    DEFINE_OP_KERNELS(prefix, target, tag, number, less, COMPARE_LESS)       \
+    DEFINE_OP_KERNELS(prefix, target, tag, number, between, COMPARE_BETWEEN)
+
+#define DEFINE_KERNELS(prefix, target)                                             \
+    DEFINE_EXACT_KERNEL(prefix, target, 1)                                         \
+    DEFINE_EXACT_KERNEL(prefix, target, 2)                                         \
+    DEFINE_EXACT_KERNEL(prefix, target, 4)                                         \
+    DEFINE_EXACT_KERNEL(prefix, target, 8)                                         \
+    DEFINE_NUMBER_KERNELS(prefix, target, unsigned, SCAN_NUMBER_UNSIGNED)          \
+    DEFINE_NUMBER_KERNELS(prefix, target, signed, SCAN_NUMBER_SIGNED)              \
+    DEFINE_NUMBER_KERNELS(prefix, target, unsigned_be, SCAN_NUMBER_UNSIGNED_BE)    \
+    DEFINE_NUMBER_KERNELS(prefix, target, signed_be, SCAN_NUMBER_SIGNED_BE)
+
+#define DEFINE_DELTA_KERNEL(prefix, target, tag, number, name, op, size)                                                      \
+    target static void prefix##_##tag##_##name##_##size(const uint8_t *current, const uint8_t *previous, size_t block_count, \
+                                                        const ScanOperands *operands, uint64_t *masks)                       \
+    {                                                                                                                        \
+        prefix##_delta(current, previous, block_count, operands, masks, number, op, size);                                   \
+    }
+
+#define DEFINE_DELTA_OP_KERNELS(prefix, target, tag, number, name, op) \
+    DEFINE_DELTA_KERNEL(prefix, target, tag, number, name, op, 1)      \
+    DEFINE_DELTA_KERNEL(prefix, target, tag, number, name, op, 2)      \
+    DEFINE_DELTA_KERNEL(prefix, target, tag, number, name, op, 4)      \
+    DEFINE_DELTA_KERNEL(prefix, target, tag, number, name, op, 8)
+
+#define DEFINE_DELTA_NUMBER_KERNELS(prefix, target, tag, number)                             \
+    DEFINE_DELTA_OP_KERNELS(prefix, target, tag, number, increased, DELTA_INCREASED)         \
+    DEFINE_DELTA_OP_KERNELS(prefix, target, tag, number, decreased, DELTA_DECREASED)         \
+    DEFINE_DELTA_OP_KERNELS(prefix, target, tag, number, increased_by, DELTA_INCREASED_BY)   \
+    DEFINE_DELTA_OP_KERNELS(prefix, target, tag, number, decreased_by, DELTA_DECREASED_BY)
+
+#define DEFINE_DELTA_KERNELS(prefix, target)                                                     \
+    DEFINE_DELTA_OP_KERNELS(prefix, target, any, SCAN_NUMBER_UNSIGNED, changed, DELTA_CHANGED)     \
+    DEFINE_DELTA_OP_KERNELS(prefix, target, any, SCAN_NUMBER_UNSIGNED, unchanged, DELTA_UNCHANGED) \
+    DEFINE_DELTA_NUMBER_KERNELS(prefix, target, unsigned, SCAN_NUMBER_UNSIGNED)                    \
+    DEFINE_DELTA_NUMBER_KERNELS(prefix, target, signed, SCAN_NUMBER_SIGNED)                        \
+    DEFINE_DELTA_NUMBER_KERNELS(prefix, target, unsigned_be, SCAN_NUMBER_UNSIGNED_BE)              \
+    DEFINE_DELTA_NUMBER_KERNELS(prefix, target, signed_be, SCAN_NUMBER_SIGNED_BE)
+
+// Floating point kernels only exist for 4 and 8 byte values
+#define DEFINE_FLOAT_KERNEL(prefix, target, name, op, size)                                                                               \
+    target static void prefix##_float_##name##_##size(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks) \
+    {                                                                                                                                     \
+        prefix##_float_range(data, block_count, operands, masks, op, size);                                                               \
+    }
+
+#define DEFINE_FLOAT_OP_KERNELS(prefix, target, name, op)  \
+    DEFINE_FLOAT_KERNEL(prefix, target, name, op, 4) \
+    DEFINE_FLOAT_KERNEL(prefix, target, name, op, 8)
+
+#define DEFINE_FLOAT_KERNELS(prefix, target)                          \
+    DEFINE_FLOAT_OP_KERNELS(prefix, target, equal, COMPARE_EQUAL)     \
+    DEFINE_FLOAT_OP_KERNELS(prefix, target, greater, COMPARE_GREATER) \
+    DEFINE_FLOAT_OP_KERNELS(prefix, target, less, COMPARE_LESS)       \
+    DEFINE_FLOAT_OP_KERNELS(prefix, target, between, COMPARE_BETWEEN)
+
+#define DEFINE_FLOAT_DELTA_KERNEL(prefix, target, name, op, size)                                                          \
+    target static void prefix##_float_##name##_##size(const uint8_t *current, const uint8_t *previous, size_t block_count, \
+                                                      const ScanOperands *operands, uint64_t *masks)                       \
+    {                                                                                                                      \
+        prefix##_float_delta(current, previous, block_count, operands, masks, op, size);                                   \
+    }
+
+#define DEFINE_FLOAT_DELTA_OP_KERNELS(prefix, target, name, op) \
+    DEFINE_FLOAT_DELTA_KERNEL(prefix, target, name, op, 4)      \
+    DEFINE_FLOAT_DELTA_KERNEL(prefix, target, name, op, 8)
+
+#define DEFINE_FLOAT_DELTA_KERNELS(prefix, target)                                  \
+    DEFINE_FLOAT_DELTA_OP_KERNELS(prefix, target, changed, DELTA_CHANGED)           \
+    DEFINE_FLOAT_DELTA_OP_KERNELS(prefix, target, unchanged, DELTA_UNCHANGED)       \
+    DEFINE_FLOAT_DELTA_OP_KERNELS(prefix, target, increased, DELTA_INCREASED)       \
+    DEFINE_FLOAT_DELTA_OP_KERNELS(prefix, target, decreased, DELTA_DECREASED)       \
+    DEFINE_FLOAT_DELTA_OP_KERNELS(prefix, target, increased_by, DELTA_INCREASED_BY) \
+    DEFINE_FLOAT_DELTA_OP_KERNELS(prefix, target, decreased_by, DELTA_DECREASED_BY)
+
+#define KERNEL_ROW(prefix, tag, name) {prefix##_##tag##_##name##_1, prefix##_##tag##_##name##_2, prefix##_##tag##_##name##_4, prefix##_##tag##_##name##_8}
+#define EXACT_ROW(prefix) {prefix##_equal_1, prefix##_equal_2, prefix##_equal_4, prefix##_equal_8}
+#define FLOAT_ROW(prefix, name) {NULL, NULL, prefix##_float_##name##_4, prefix##_float_##name##_8}
+#define COMPARE_ROWS(prefix, tag) {EXACT_ROW(prefix), KERNEL_ROW(prefix, tag, greater), KERNEL_ROW(prefix, tag, less), KERNEL_ROW(prefix, tag, between)}
+#define FLOAT_COMPARE_ROWS(prefix) {FLOAT_ROW(prefix, equal), FLOAT_ROW(prefix, greater), FLOAT_ROW(prefix, less), FLOAT_ROW(prefix, between)}
+#define DELTA_ROWS(prefix, tag)                                                                                                  \
+    {KERNEL_ROW(prefix, any, changed), KERNEL_ROW(prefix, any, unchanged), KERNEL_ROW(prefix, tag, increased),                  \
+     KERNEL_ROW(prefix, tag, decreased), KERNEL_ROW(prefix, tag, increased_by), KERNEL_ROW(prefix, tag, decreased_by)}
+#define FLOAT_DELTA_ROWS(prefix)                                                                                                 \
+    {FLOAT_ROW(prefix, changed), FLOAT_ROW(prefix, unchanged), FLOAT_ROW(prefix, increased), FLOAT_ROW(prefix, decreased),      \
+     FLOAT_ROW(prefix, increased_by), FLOAT_ROW(prefix, decreased_by)}
+#define KERNEL_TABLE(prefix)                                                                                                     \
+    {[SCAN_NUMBER_UNSIGNED] = COMPARE_ROWS(prefix, unsigned), [SCAN_NUMBER_FLOAT] = FLOAT_COMPARE_ROWS(prefix),                \
+     [SCAN_NUMBER_SIGNED] = COMPARE_ROWS(prefix, signed), [SCAN_NUMBER_UNSIGNED_BE] = COMPARE_ROWS(prefix, unsigned_be),       \
+     [SCAN_NUMBER_SIGNED_BE] = COMPARE_ROWS(prefix, signed_be)}
+#define DELTA_KERNEL_TABLE(prefix)                                                                                               \
+    {[SCAN_NUMBER_UNSIGNED] = DELTA_ROWS(prefix, unsigned), [SCAN_NUMBER_FLOAT] = FLOAT_DELTA_ROWS(prefix),                    \
+     [SCAN_NUMBER_SIGNED] = DELTA_ROWS(prefix, signed), [SCAN_NUMBER_UNSIGNED_BE] = DELTA_ROWS(prefix, unsigned_be),           \
+     [SCAN_NUMBER_SIGNED_BE] = DELTA_ROWS(prefix, signed_be)}
+
+DEFINE_KERNELS(scalar, )
+DEFINE_DELTA_KERNELS(scalar, )
+DEFINE_FLOAT_KERNELS(scalar, )
+DEFINE_FLOAT_DELTA_KERNELS(scalar, )
+#if SCAN_KERNELS_X86
+DEFINE_KERNELS(sse2, )
+DEFINE_DELTA_KERNELS(sse2, )
+DEFINE_FLOAT_KERNELS(sse2, )
+DEFINE_FLOAT_DELTA_KERNELS(sse2, )
+DEFINE_KERNELS(avx2, TARGET_AVX2)
+DEFINE_DELTA_KERNELS(avx2, TARGET_AVX2)
+DEFINE_FLOAT_KERNELS(avx2, TARGET_AVX2)
+DEFINE_FLOAT_DELTA_KERNELS(avx2, TARGET_AVX2)
+DEFINE_KERNELS(avx512, TARGET_AVX512)
+DEFINE_DELTA_KERNELS(avx512, TARGET_AVX512)
+DEFINE_FLOAT_KERNELS(avx512, TARGET_AVX512)
+DEFINE_FLOAT_DELTA_KERNELS(avx512, TARGET_AVX512)
+#endif
+
+static const MatchKernel match_kernels[SCAN_ISA_COUNT][SCAN_NUMBER_COUNT][COMPARE_OP_COUNT][4] = {
+    KERNEL_TABLE(scalar),
+#if SCAN_KERNELS_X86
+    KERNEL_TABLE(sse2),
+    KERNEL_TABLE(avx2),
+    KERNEL_TABLE(avx512),
+#endif
+};
+
+static const DeltaKernel delta_kernels[SCAN_ISA_COUNT][SCAN_NUMBER_COUNT][DELTA_OP_COUNT][4] = {
+    DELTA_KERNEL_TABLE(scalar),
+#if SCAN_KERNELS_X86
+    DELTA_KERNEL_TABLE(sse2),
+    DELTA_KERNEL_TABLE(avx2),
+    DELTA_KERNEL_TABLE(avx512),
+#endif
+};
+
+/* Byte patterns: a two byte filter per block, candidates confirmed against the whole pattern */
+
+static FORCE_INLINE bool pattern_verify(const uint8_t *data, const BytePattern *pattern)
+{
+    size_t k = 0;
+
+    for (; k + 8 <= pattern->length; k += 8)
+    {
+        if ((load_value(data + k, 8) & load_value(pattern->mask + k, 8)) != load_value(pattern->bytes + k, 8))
+            return false;
+    }
+    for (; k < pattern->length; k++)
+    {
+        if ((data[k] & pattern->mask[k]) != pattern->bytes[k])
+            return false;
+    }
+    return true;
+}
+
+// Keeps the candidates of mask (offsets from p) where the whole pattern matches
+static FORCE_INLINE uint64_t pattern_confirm(const uint8_t *p, uint64_t mask, const BytePattern *pattern)
+{
+    uint64_t confirmed = 0;
+
+    for (; mask; mask &= mask - 1)
+    {
+        int i = platform_ctz64(mask);
+        if (pattern_verify(p + i, pattern))
+            confirmed |= (uint64_t)1 << i;
+    }
+    return confirmed;
+}
+
+static void scalar_pattern(const uint8_t *data, size_t block_count, const BytePattern *pattern, uint64_t *masks)
+{
+    size_t a0 = pattern->anchors[0], a1 = pattern->anchors[1];
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++)
+        {
+            if ((p[i + a0] & pattern->mask[a0]) == pattern->bytes[a0] && (p[i + a1] & pattern->mask[a1]) == pattern->bytes[a1])
+                mask |= (uint64_t)1 << i;
+        }
+        masks[b] = mask ? pattern_confirm(p, mask, pattern) : 0;
+    }
+}
+
+#if SCAN_KERNELS_X86
+static FORCE_INLINE uint64_t sse2_anchor64(const uint8_t *p, __m128i mask, __m128i needle)
+{
+    uint64_t m0 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i *)p), mask), needle));
+    uint64_t m1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i *)(p + 16)), mask), needle));
+    uint64_t m2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i *)(p + 32)), mask), needle));
+    uint64_t m3 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i *)(p + 48)), mask), needle));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+
+static void sse2_pattern(const uint8_t *data, size_t block_count, const BytePattern *pattern, uint64_t *masks)
+{
+    size_t a0 = pattern->anchors[0], a1 = pattern->anchors[1];
+    __m128i needle0 = _mm_set1_epi8((char)pattern->bytes[a0]), mask0 = _mm_set1_epi8((char)pattern->mask[a0]);
+    __m128i needle1 = _mm_set1_epi8((char)pattern->bytes[a1]), mask1 = _mm_set1_epi8((char)pattern->mask[a1]);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = sse2_anchor64(p + a0, mask0, needle0) & sse2_anchor64(p + a1, mask1, needle1);
+        masks[b] = mask ? pattern_confirm(p, mask, pattern) : 0;
+    }
+}
+
+TARGET_AVX2 static FORCE_INLINE uint64_t avx2_anchor64(const uint8_t *p, __m256i mask, __m256i needle)
+{
+    uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)p), mask), needle));
+    uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(p + 32)), mask), needle));
+    return m0 | (m1 << 32);
+}
+
+TARGET_AVX2 static void avx2_pattern(const uint8_t *data, size_t block_count, const BytePattern *pattern, uint64_t *masks)
+{
+    size_t a0 = pattern->anchors[0], a1 = pattern->anchors[1];
+    __m256i needle0 = _mm256_set1_epi8((char)pattern->bytes[a0]), mask0 = _mm256_set1_epi8((char)pattern->mask[a0]);
+    __m256i needle1 = _mm256_set1_epi8((char)pattern->bytes[a1]), mask1 = _mm256_set1_epi8((char)pattern->mask[a1]);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = avx2_anchor64(p + a0, mask0, needle0) & avx2_anchor64(p + a1, mask1, needle1);
+        masks[b] = mask ? pattern_confirm(p, mask, pattern) : 0;
+    }
+}
+
+TARGET_AVX512 static FORCE_INLINE uint64_t avx512_anchor64(const uint8_t *p, __m512i mask, __m512i needle)
+{
+    return (uint64_t)_mm512_cmpeq_epi8_mask(_mm512_and_si512(_mm512_loadu_si512((const void *)p), mask), needle);
+}
+
+TARGET_AVX512 static void avx512_pattern(const uint8_t *data, size_t block_count, const BytePattern *pattern, uint64_t *masks)
+{
+    size_t a0 = pattern->anchors[0], a1 = pattern->anchors[1];
+    __m512i needle0 = _mm512_set1_epi8((char)pattern->bytes[a0]), mask0 = _mm512_set1_epi8((char)pattern->mask[a0]);
+    __m512i needle1 = _mm512_set1_epi8((char)pattern->bytes[a1]), mask1 = _mm512_set1_epi8((char)pattern->mask[a1]);
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        const uint8_t *p = data + b * SCAN_BLOCK_SIZE;
+        uint64_t mask = avx512_anchor64(p + a0, mask0, needle0) & avx512_anchor64(p + a1, mask1, needle1);
+        masks[b] = mask ? pattern_confirm(p, mask, pattern) : 0;
+    }
+}
+#endif
+
+static const PatternKernel pattern_kernels[SCAN_ISA_COUNT] = {
+    scalar_pattern,
+#if SCAN_KERNELS_X86
+    sse2_pattern,
+    avx2_pattern,
+    avx512_pattern,
+#endif
+};
+
+/* Match emission */
+
+// Positions of the set bits of every byte value, padded to 8 entries
+static uint8_t bit_positions[256][8];
+
+static void init_bit_positions()
+{
+    for (int byte = 0; byte < 256; byte++)
+    {
+        int count = 0;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            if (byte & (1 << bit))
+                bit_positions[byte][count++] = (uint8_t)bit;
+        }
+    }
+}
+
+// Enough free slots for one whole mask, since the emitters store full groups of 8 addresses
+static void reserve_for_mask(DynamicArray *matches)
+{
+    if (matches->size + SCAN_BLOCK_SIZE + 8 > matches->capacity)
+        reserve_array(matches, matches->capacity + matches->capacity / 2 + SCAN_BLOCK_SIZE + 8);
+}
+
+typedef size_t (*EmitFunc)(const uint64_t *masks, size_t block_count, uintptr_t base_address, DynamicArray *matches);
+
+// Table driven: every mask byte writes 8 addresses unconditionally and advances by its popcount
+static size_t scalar_emit(const uint64_t *masks, size_t block_count, uintptr_t base_address, DynamicArray *matches)
+{
+    size_t found = 0;
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        uint64_t mask = masks[b];
+        if (!mask)
+            continue;
+
+        reserve_for_mask(matches);
+        LPVOID *out = (LPVOID *)matches->data + matches->size;
+        uintptr_t block_address = base_address + b * SCAN_BLOCK_SIZE;
+        size_t n = 0;
+
+        for (int byte = 0; byte < 8; byte++)
+        {
+            uint8_t bits = (uint8_t)(mask >> (byte * 8));
+            const uint8_t *positions = bit_positions[bits];
+            uintptr_t byte_address = block_address + (uintptr_t)byte * 8;
+            for (int k = 0; k < 8; k++)
+                out[n + k] = (LPVOID)(byte_address + positions[k]);
+            n += (size_t)platform_popcount64(bits);
+        }
+        matches->size += n;
+        found += n;
+    }
+    return found;
+}
+
+#if VECTOR_EMIT
+TARGET_AVX2 static size_t avx2_emit(const uint64_t *masks, size_t block_count, uintptr_t base_address, DynamicArray *matches)
+{
+    size_t found = 0;
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        uint64_t mask = masks[b];
+        if (!mask)
+            continue;
+
+        reserve_for_mask(matches);
+        uint64_t *out = (uint64_t *)matches->data + matches->size;
+        uintptr_t block_address = base_address + b * SCAN_BLOCK_SIZE;
+        size_t n = 0;
+
+        for (int byte = 0; byte < 8; byte++)
+        {
+            uint8_t bits = (uint8_t)(mask >> (byte * 8));
+            __m256i base = _mm256_set1_epi64x((long long)(block_address + (uintptr_t)byte * 8));
+            __m128i positions = _mm_loadl_epi64((const __m128i *)bit_positions[bits]);
+            __m256i low = _mm256_add_epi64(base, _mm256_cvtepu8_epi64(positions));
+            __m256i high = _mm256_add_epi64(base, _mm256_cvtepu8_epi64(_mm_srli_si128(positions, 4)));
+            _mm256_storeu_si256((__m256i *)(out + n), low);
+            _mm256_storeu_si256((__m256i *)(out + n + 4), high);
+            n += (size_t)platform_popcount64(bits);
+        }
+        matches->size += n;
+        found += n;
+    }
+    return found;
+}
+
+// Compresses the 8 candidate addresses of every mask byte with vpcompressq
+TARGET_AVX512 static size_t avx512_emit(const uint64_t *masks, size_t block_count, uintptr_t base_address, DynamicArray *matches)
+{
+    const __m512i lane_offsets = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    size_t found = 0;
+
+    for (size_t b = 0; b < block_count; b++)
+    {
+        uint64_t mask = masks[b];
+        if (!mask)
+            continue;
+
+        reserve_for_mask(matches);
+        uint64_t *out = (uint64_t *)matches->data + matches->size;
+        __m512i addresses = _mm512_add_epi64(_mm512_set1_epi64((long long)(base_address + b * SCAN_BLOCK_SIZE)), lane_offsets);
+        const __m512i step = _mm512_set1_epi64(8);
+        size_t n = 0;
+
+        for (int byte = 0; byte < 8; byte++)
+        {
+            __mmask8 bits = (__mmask8)(mask >> (byte * 8));
+            _mm512_storeu_si512((void *)(out + n), _mm512_maskz_compress_epi64(bits, addresses));
+            n += (size_t)platform_popcount64(bits);
+            addresses = _mm512_add_epi64(addresses, step);
+        }
+        matches->size += n;
+        found += n;
+    }
+    return found;
+}
+#endif
+
+/* Runtime dispatch */
+
+#if SCAN_KERNELS_X86
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int *)regs, (int)leaf, (int)subleaf);
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+static uint64_t read_xcr0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+static ScanIsa detect_isa()
+{
+#if SCAN_KERNELS_X86
+    uint32_t regs[4];
+    ScanIsa isa = SCAN_ISA_SSE2;
+
+    cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    if (!osxsave || max_leaf < 7)
+        return isa;
+
+    // The OS must save the YMM (and for AVX-512 the opmask/ZMM) state on context switches
+    uint64_t xcr0 = read_xcr0();
+    cpuid(7, 0, regs);
+
+    if ((xcr0 & 0x6) == 0x6 && (regs[1] & (1u << 5)))
+        isa = SCAN_ISA_AVX2;
+
+    if ((xcr0 & 0xE6) == 0xE6 && (regs[1] & (1u << 16)) && (regs[1] & (1u << 30)))
+        isa = SCAN_ISA_AVX512;
+
+    return isa;
+#else
+    return SCAN_ISA_SCALAR;
+#endif
+}
+
+static int best_isa = -1;
+static EmitFunc emit_func = scalar_emit;
+
+ScanIsa get_best_scan_isa()
+{
+    // Initialization is idempotent, so a race between first callers is harmless
+    if (best_isa < 0)
+    {
+        init_bit_positions();
+        ScanIsa isa = detect_isa();
+#if VECTOR_EMIT
+        if (isa >= SCAN_ISA_AVX512)
+            emit_func = avx512_emit;
+        else if (isa >= SCAN_ISA_AVX2)
+            emit_func = avx2_emit;
+#endif
+        best_isa = (int)isa;
+    }
+    return (ScanIsa)best_isa;
+}
+
+bool is_scan_isa_supported(ScanIsa isa)
+{
+    return isa >= SCAN_ISA_SCALAR && isa <= get_best_scan_isa();
+}
+
+const char *get_scan_isa_name(ScanIsa isa)
+{
+    static const char *names[SCAN_ISA_COUNT] = {"scalar", "sse2", "avx2", "avx512"};
+    return isa >= 0 && isa < SCAN_ISA_COUNT ? names[isa] : "unknown";
+}
+
+MatchKernel get_match_kernel(ScanIsa isa, ScanNumber number, CompareOp op, size_t value_size)
+{
+    int index = size_index(value_size);
+    if (index < 0 || number < 0 || number >= SCAN_NUMBER_COUNT || op < 0 || op >= COMPARE_OP_COUNT || !is_scan_isa_supported(isa))
+        return NULL;
+    return match_kernels[isa][number][op][index];
+}
+
+DeltaKernel get_delta_kernel(ScanIsa isa, ScanNumber number, DeltaOp op, size_t value_size)
+{
+    int index = size_index(value_size);
+    if (index < 0 || number < 0 || number >= SCAN_NUMBER_COUNT || op < 0 || op >= DELTA_OP_COUNT || !is_scan_isa_supported(isa))
+        return NULL;
+    return delta_kernels[isa][number][op][index];
+}
+
+PatternKernel get_pattern_kernel(ScanIsa isa)
+{
+    return is_scan_isa_supported(isa) ? pattern_kernels[isa] : NULL;
+}
+
+// Next code point of UTF-8 text, 0 at its end and -1 on an invalid or overlong sequence
+static int32_t next_code_point(const char **text)
+{
+    const uint8_t *p = (const uint8_t *)*text;
+    int32_t code;
+    int count;
+
+    if (p[0] < 0x80)
+        code = p[0], count = 0;
+    else if ((p[0] & 0xE0) == 0xC0)
+        code = p[0] & 0x1F, count = 1;
+    else if ((p[0] & 0xF0) == 0xE0)
+        code = p[0] & 0x0F, count = 2;
+    else if ((p[0] & 0xF8) == 0xF0)
+        code = p[0] & 0x07, count = 3;
+    else
+        return -1;
+
+    for (int i = 1; i <= count; i++)
+    {
+        if ((p[i] & 0xC0) != 0x80)
+            return -1;
+        code = (code << 6) | (p[i] & 0x3F);
+    }
+
+    static const int32_t smallest[4] = {0, 0x80, 0x800, 0x10000};
+    if (code < smallest[count] || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+        return -1;
+    *text += count + 1;
+    return code;
+}
+
+static bool append_pattern_byte(BytePattern *pattern, uint8_t byte, uint8_t mask)
+{
+    if (pattern->length >= SCAN_PATTERN_MAX)
+        return false;
+    pattern->bytes[pattern->length] = byte & mask;
+    pattern->mask[pattern->length] = mask;
+    pattern->length++;
+    return true;
+}
+
+// Clearing bit 5 folds the ASCII letters, and only them, to uppercase
+static bool append_text_byte(BytePattern *pattern, uint8_t byte, bool fold)
+{
+    bool letter = fold && ((byte >= 'A' && byte <= 'Z') || (byte >= 'a' && byte <= 'z'));
+    return append_pattern_byte(pattern, byte, letter ? 0xDF : 0xFF);
+}
+
+static bool append_text_unit(BytePattern *pattern, uint16_t unit, bool fold)
+{
+    return append_text_byte(pattern, (uint8_t)unit, fold && unit < 0x80) && append_text_byte(pattern, (uint8_t)(unit >> 8), false);
+}
+
+bool string_pattern_init(BytePattern *pattern, const char *text, bool utf16, bool case_sensitive)
+{
+    memset(pattern, 0, sizeof(BytePattern));
+
+    if (!utf16)
+    {
+        // Single byte text is searched as typed; the bytes of UTF-8 sequences are never folded
+        for (; *text; text++)
+        {
+            if (!append_text_byte(pattern, (uint8_t)*text, !case_sensitive))
+                return false;
+        }
+    }
+    else
+    {
+        for (int32_t code; (code = next_code_point(&text)) != 0;)
+        {
+            if (code < 0)
+                return false;
+            if (code < 0x10000)
+            {
+                if (!append_text_unit(pattern, (uint16_t)code, !case_sensitive))
+                    return false;
+            }
+            else if (!append_text_unit(pattern, (uint16_t)(0xD800 + ((code - 0x10000) >> 10)), false) ||
+                     !append_text_unit(pattern, (uint16_t)(0xDC00 + ((code - 0x10000) & 0x3FF)), false))
+                return false;
+        }
+    }
+
+    // The second anchor is the last byte that is not 0, UTF-16 ASCII ends in one
+    size_t last = pattern->length > 0 ? pattern->length - 1 : 0;
+    while (last > 0 && pattern->bytes[last] == 0)
+        last--;
+    pattern->anchors[1] = last;
+    return pattern->length > 0;
+}
+
+// Rank of the most frequent bytes of x86-64 code and data, most frequent first; anything else is rarer
+static const uint8_t common_bytes[] = {0x00, 0xFF, 0x48, 0x8B, 0x89, 0x24, 0x0F, 0x4C, 0x44, 0xE8, 0x85, 0xC0,
+                                       0x01, 0x83, 0x8D, 0x45, 0x74, 0x10, 0x08, 0x20, 0x75, 0x41, 0x49, 0xC3,
+                                       0xCC, 0x90, 0x18, 0x28, 0x30, 0x40, 0x4D, 0x84, 0xEB, 0x02, 0x04, 0x03};
+
+// Higher for the bytes expected to match fewer offsets: fixed bytes by their rank, then wildcard nibbles
+static int anchor_score(uint8_t byte, uint8_t mask)
+{
+    if (mask != 0xFF)
+        return platform_popcount64(mask);
+
+    int count = (int)(sizeof(common_bytes) / sizeof(common_bytes[0]));
+    for (int rank = 0; rank < count; rank++)
+    {
+        if (common_bytes[rank] == byte)
+            return 16 + rank;
+    }
+    return 16 + count;
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return c == '?' ? -1 : -2;
+}
+
+bool signature_pattern_init(BytePattern *pattern, const char *signature)
+{
+    memset(pattern, 0, sizeof(BytePattern));
+
+    for (const char *p = signature; *p;)
+    {
+        if (*p == ' ')
+        {
+            p++;
+            continue;
+        }
+
+        // A lone '?' is a whole wildcard byte, like "??"
+        int high = hex_nibble(p[0]);
+        int low = p[1] == ' ' || p[1] == '\0' ? (high == -1 ? -1 : -2) : hex_nibble(p[1]);
+        if (high == -2 || low == -2)
+            return false;
+
+        uint8_t byte = (uint8_t)(((high < 0 ? 0 : high) << 4) | (low < 0 ? 0 : low));
+        uint8_t mask = (uint8_t)((high < 0 ? 0 : 0xF0) | (low < 0 ? 0 : 0x0F));
+        if (!append_pattern_byte(pattern, byte, mask))
+            return false;
+        p += p[1] == ' ' || p[1] == '\0' ? 1 : 2;
+    }
+
+    // Filter on the two rarest bytes, the first one alone decides most offsets
+    int best[2] = {0, 0};
+    for (size_t k = 0; k < pattern->length; k++)
+    {
+        int score = anchor_score(pattern->bytes[k], pattern->mask[k]);
+        if (score > best[0])
+        {
+            best[1] = best[0];
+            pattern->anchors[1] = pattern->anchors[0];
+            best[0] = score;
+            pattern->anchors[0] = k;
+        }
+        else if (score > best[1])
+        {
+            best[1] = score;
+            pattern->anchors[1] = k;
+        }
+    }
+    if (best[1] == 0)
+        pattern->anchors[1] = pattern->anchors[0];
+    return best[0] > 0;
+}
+
+bool compare_pattern(const uint8_t *data, const BytePattern *pattern)
+{
+    return pattern_verify(data, pattern);
+}
+
+bool compare_value(ScanNumber number, CompareOp op, const uint8_t *data, const ScanOperands *operands, size_t value_size)
+{
+    if (number == SCAN_NUMBER_FLOAT)
+        return (value_size == 4 || value_size == 8) && op >= 0 && op < COMPARE_OP_COUNT &&
+               float_hit(op, load_float(data, value_size), load_float(operands->value, value_size), load_float(operands->upper, value_size));
+
+    uint64_t v = load_key(data, number, value_size);
+    uint64_t x = load_key(operands->value, number, value_size);
+
+    switch (op)
+    {
+    case COMPARE_EQUAL:
+        return v == x;
+    case COMPARE_GREATER:
+        return v > x;
+    case COMPARE_LESS:
+        return v < x;
+    case COMPARE_BETWEEN:
+        return ((v - x) & width_mask(value_size)) <= between_range(operands, number, value_size);
+    default:
+        return false;
+    }
+}
+
+bool compare_delta(ScanNumber number, DeltaOp op, const uint8_t *current, const uint8_t *previous, const ScanOperands *operands, size_t value_size)
+{
+    if (number == SCAN_NUMBER_FLOAT)
+        return (value_size == 4 || value_size == 8) && float_delta_hit(op, current, previous, operands, value_size);
+    return delta_hit(op, load_key(current, number, value_size), load_key(previous, number, value_size),
+                     load_difference(operands->value, number, value_size), width_mask(value_size));
+}
+
+bool filter_value(const ScanFilter *filter, const uint8_t *current, const uint8_t *previous, size_t value_size)
+{
+    if (filter->delta)
+        return compare_delta(filter->number, filter->delta_op, current, previous, &filter->operands, value_size);
+    return compare_value(filter->number, filter->compare, current, &filter->operands, value_size);
+}
+
+size_t emit_match_addresses(const uint64_t *masks, size_t block_count, uintptr_t base_address, DynamicArray *matches)
+{
+    get_best_scan_isa();
+    return emit_func(masks, block_count, base_address, matches);
+}
+
+size_t find_matches(MatchKernel kernel, ScanNumber number, CompareOp op, const uint8_t *data, size_t offset_count,
+                    const ScanOperands *operands, size_t value_size, uintptr_t base_address, DynamicArray *matches)
+{
+    uint64_t masks[64];
+    size_t block_total = offset_count / SCAN_BLOCK_SIZE;
+    size_t found = 0;
+
+    for (size_t block = 0; block < block_total; block += 64)
+    {
+        size_t count = min(64, block_total - block);
+        kernel(data + block * SCAN_BLOCK_SIZE, count, operands, masks);
+        found += emit_match_addresses(masks, count, base_address + block * SCAN_BLOCK_SIZE, matches);
+    }
+
+    // Offsets that do not fill a whole block
+    for (size_t i = block_total * SCAN_BLOCK_SIZE; i < offset_count; i++)
+    {
+        if (compare_value(number, op, data + i, operands, value_size))
+        {
+            LPVOID address = (LPVOID)(base_address + i);
+            append(matches, &address);
+            found++;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,126 @@
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+#include "platform.h"
+
+// Offsets handled per match mask
+#define SCAN_BLOCK_SIZE 64
+
+// Longest searched pattern (encoded text or signature), in bytes
+#define SCAN_PATTERN_MAX 256
+
+typedef enum
+{
+    SCAN_ISA_SCALAR,
+    SCAN_ISA_SSE2,
+    SCAN_ISA_AVX2,
+    SCAN_ISA_AVX512,
+    SCAN_ISA_COUNT
+} ScanIsa;
+
+// How the bytes of a value are read
+typedef enum
+{
+    SCAN_NUMBER_UNSIGNED,    // Unsigned little-endian integer of 1, 2, 4 or 8 bytes
+    SCAN_NUMBER_FLOAT,       // IEEE float (4 bytes) or double (8 bytes)
+    SCAN_NUMBER_SIGNED,      // Two's complement little-endian integer
+    SCAN_NUMBER_UNSIGNED_BE, // Unsigned big-endian integer
+    SCAN_NUMBER_SIGNED_BE,   // Two's complement big-endian integer
+    SCAN_NUMBER_COUNT
+} ScanNumber;
+
+// Comparisons on values read as a ScanNumber
+typedef enum
+{
+    COMPARE_EQUAL,   // value == operands.value
+    COMPARE_GREATER, // value > operands.value
+    COMPARE_LESS,    // value < operands.value
+    COMPARE_BETWEEN, // operands.value <= value <= operands.upper
+    COMPARE_OP_COUNT
+} CompareOp;
+
+// Comparisons of the current value against the previous one at the same address
+typedef enum
+{
+    DELTA_CHANGED,      // current != previous
+    DELTA_UNCHANGED,    // current == previous
+    DELTA_INCREASED,    // current > previous
+    DELTA_DECREASED,    // current < previous
+    DELTA_INCREASED_BY, // current == previous + operands.value (wrapping)
+    DELTA_DECREASED_BY, // current == previous - operands.value (wrapping)
+    DELTA_OP_COUNT
+} DeltaOp;
+
+// Operands are stored like the values they are compared to (a float operand is float bytes, a
+// big-endian operand is big-endian bytes)
+typedef struct
+{
+    uint8_t value[8]; // Compared value, lower bound for COMPARE_BETWEEN, difference for DELTA_*_BY
+    uint8_t upper[8]; // Inclusive upper bound for COMPARE_BETWEEN, and for the difference of floating point DELTA_*_BY
+} ScanOperands;
+
+// Refinement criterion: a comparison against fixed operands, or against the previous value
+typedef struct
+{
+    bool delta;
+    ScanNumber number;
+    CompareOp compare;
+    DeltaOp delta_op;
+    ScanOperands operands;
+} ScanFilter;
+
+// Fills masks[b] for block_count blocks of SCAN_BLOCK_SIZE consecutive offsets:
+// bit i of masks[b] is set when the value at data + b * 64 + i satisfies the comparison.
+// Reads exactly block_count * 64 + value_size - 1 bytes.
+typedef void (*MatchKernel)(const uint8_t *data, size_t block_count, const ScanOperands *operands, uint64_t *masks);
+
+// Same mask layout as MatchKernel, comparing current against previous offset by offset.
+// Reads exactly block_count * 64 + value_size - 1 bytes from both buffers.
+typedef void (*DeltaKernel)(const uint8_t *current, const uint8_t *previous, size_t block_count,
+                            const ScanOperands *operands, uint64_t *masks);
+
+// Bytes searched by a string or signature scan. Offset i matches when (data[i + k] & mask[k]) == bytes[k]
+// for every k < length: mask is 0xDF on the ASCII letters of a case-insensitive string (whose bytes
+// are then uppercase), 0xF0, 0x0F or 0 on the wildcards of a signature.
+typedef struct
+{
+    uint8_t bytes[SCAN_PATTERN_MAX];
+    uint8_t mask[SCAN_PATTERN_MAX];
+    size_t length;
+    size_t anchors[2]; // Offsets of the two bytes every offset is filtered on before it is verified
+} BytePattern;
+
+// Same mask layout as MatchKernel for a BytePattern. Reads exactly block_count * 64 + length - 1 bytes.
+typedef void (*PatternKernel)(const uint8_t *data, size_t block_count, const BytePattern *pattern, uint64_t *masks);
+
+ScanIsa get_best_scan_isa();
+bool is_scan_isa_supported(ScanIsa isa);
+const char *get_scan_isa_name(ScanIsa isa);
+// NULL when there is no kernel for the combination (floating point values of 1 or 2 bytes)
+MatchKernel get_match_kernel(ScanIsa isa, ScanNumber number, CompareOp op, size_t value_size);
+DeltaKernel get_delta_kernel(ScanIsa isa, ScanNumber number, DeltaOp op, size_t value_size);
+PatternKernel get_pattern_kernel(ScanIsa isa);
+
+// Encodes UTF-8 text as bytes (utf16: UTF-16LE), anchored on its first and last non-zero byte.
+// False when the text is empty, too long or not UTF-8.
+bool string_pattern_init(BytePattern *pattern, const char *text, bool utf16, bool case_sensitive);
+// Parses a signature such as "48 8B 05 ?? ?? ?? ?? 89": '?' is a wildcard nibble, a lone '?' a
+// wildcard byte. Anchored on its two rarest fixed bytes. False when malformed or only wildcards.
+bool signature_pattern_init(BytePattern *pattern, const char *signature);
+
+// Scalar comparison of one value, for tails and isolated candidates
+bool compare_value(ScanNumber number, CompareOp op, const uint8_t *data, const ScanOperands *operands, size_t value_size);
+bool compare_delta(ScanNumber number, DeltaOp op, const uint8_t *current, const uint8_t *previous, const ScanOperands *operands,
+                   size_t value_size);
+bool filter_value(const ScanFilter *filter, const uint8_t *current, const uint8_t *previous, size_t value_size);
+bool compare_pattern(const uint8_t *data, const BytePattern *pattern);
+
+// Appends (LPVOID)(base_address + b * 64 + i) to matches for every bit i set in masks[b]
+size_t emit_match_addresses(const uint64_t *masks, size_t block_count, uintptr_t base_address, DynamicArray *matches);
+
+// Appends (LPVOID)(base_address + i) to matches for every offset i in [0, offset_count) that
+// satisfies the comparison. data must hold offset_count + value_size - 1 bytes. Returns the match count.
+size_t find_matches(MatchKernel kernel, ScanNumber number, CompareOp op, const uint8_t *data, size_t offset_count,
+                    const ScanOperands *operands, size_t value_size, uintptr_t base_address, DynamicArray *matches);
+
+#endif
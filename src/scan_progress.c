@@ -0,0 +1,75 @@
+#include "scan_progress.h"
+
+void scan_progress_begin(ScanProgress *progress)
+{
+    platform_atomic_store64(&progress->work_total, 0);
+    platform_atomic_store64(&progress->work_done, 0);
+    platform_atomic_store64(&progress->bytes_done, 0);
+    platform_atomic_store64(&progress->regions_total, 0);
+    platform_atomic_store64(&progress->regions_done, 0);
+    platform_atomic_store64(&progress->matches, 0);
+    platform_atomic_store64(&progress->end_ns, 0);
+    platform_atomic_store64(&progress->start_ns, (int64_t)platform_time_ns());
+    platform_atomic_store64(&progress->cancel_requested, 0);
+    platform_atomic_store64(&progress->state, SCAN_STATE_RUNNING);
+}
+
+void scan_progress_end(ScanProgress *progress)
+{
+    bool cancelled = platform_atomic_load64(&progress->cancel_requested) != 0;
+
+    platform_atomic_store64(&progress->end_ns, (int64_t)platform_time_ns());
+    platform_atomic_store64(&progress->cancel_requested, 0);
+    platform_atomic_store64(&progress->state, cancelled ? SCAN_STATE_CANCELLED : SCAN_STATE_DONE);
+}
+
+void scan_progress_set_totals(ScanProgress *progress, uint64_t work_total, uint64_t regions_total)
+{
+    platform_atomic_store64(&progress->work_total, (int64_t)work_total);
+    platform_atomic_store64(&progress->regions_total, (int64_t)regions_total);
+}
+
+void scan_progress_add(ScanProgress *progress, uint64_t work, uint64_t bytes, uint64_t matches)
+{
+    if (work)
+        platform_atomic_add64(&progress->work_done, (int64_t)work);
+    if (bytes)
+        platform_atomic_add64(&progress->bytes_done, (int64_t)bytes);
+    if (matches)
+        platform_atomic_add64(&progress->matches, (int64_t)matches);
+}
+
+void scan_progress_region_done(ScanProgress *progress)
+{
+    platform_atomic_add64(&progress->regions_done, 1);
+}
+
+void scan_progress_cancel(ScanProgress *progress)
+{
+    platform_atomic_store64(&progress->cancel_requested, 1);
+}
+
+bool scan_progress_cancelled(ScanProgress *progress)
+{
+    return platform_atomic_load64(&progress->cancel_requested) != 0;
+}
+
+void scan_progress_read(ScanProgress *progress, ScanProgressView *view)
+{
+    int64_t start = platform_atomic_load64(&progress->start_ns);
+    int64_t end = platform_atomic_load64(&progress->end_ns);
+    int64_t work_total = platform_atomic_load64(&progress->work_total);
+    int64_t work_done = platform_atomic_load64(&progress->work_done);
+
+    view->state = (ScanState)platform_atomic_load64(&progress->state);
+    view->bytes_done = (uint64_t)platform_atomic_load64(&progress->bytes_done);
+    view->regions_total = (uint64_t)platform_atomic_load64(&progress->regions_total);
+    view->regions_done = (uint64_t)platform_atomic_load64(&progress->regions_done);
+    view->matches = (uint64_t)platform_atomic_load64(&progress->matches);
+
+    int64_t now = end ? end : (int64_t)platform_time_ns();
+    view->elapsed = start ? (now - start) / 1e9 : 0.0;
+    view->fraction = work_total > 0 ? min(1.0, (double)work_done / (double)work_total) : 0.0;
+    view->throughput = view->elapsed > 0 ? view->bytes_done / view->elapsed : 0.0;
+    view->eta = view->fraction > 0 ? view->elapsed * (1.0 - view->fraction) / view->fraction : -1.0;
+}
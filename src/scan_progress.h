@@ -0,0 +1,59 @@
+#ifndef SCAN_PROGRESS_H
+#define SCAN_PROGRESS_H
+
+#include "platform.h"
+
+typedef enum
+{
+    SCAN_STATE_IDLE,
+    SCAN_STATE_RUNNING,
+    SCAN_STATE_DONE,
+    SCAN_STATE_CANCELLED,
+} ScanState;
+
+// Status of the running scan. Written by the scan workers and read by anyone (the UI every frame)
+// without locking: every field is a 64-bit atomic updated on its own.
+typedef struct
+{
+    volatile int64_t state; // ScanState
+    volatile int64_t cancel_requested;
+    volatile int64_t start_ns;
+    volatile int64_t end_ns;
+    volatile int64_t work_total; // Bytes to scan for a first scan or capture, candidates for a next scan
+    volatile int64_t work_done;
+    volatile int64_t bytes_done; // Bytes read from the process
+    volatile int64_t regions_total;
+    volatile int64_t regions_done;
+    volatile int64_t matches;    // Matches (or surviving candidates) so far
+} ScanProgress;
+
+// Consistent-enough copy of a ScanProgress with the derived figures
+typedef struct
+{
+    ScanState state;
+    uint64_t bytes_done;
+    uint64_t regions_total;
+    uint64_t regions_done;
+    uint64_t matches;
+    double fraction;   // 0-1 of the work done
+    double elapsed;    // Seconds since the scan started (until it ended)
+    double throughput; // Bytes read per second
+    double eta;        // Seconds left at the current pace, negative while unknown
+} ScanProgressView;
+
+// Job side: begin clears the counters and any stale cancel request, end records the final state
+// (cancelled when a cancel arrived meanwhile) and clears the request
+void scan_progress_begin(ScanProgress *progress);
+void scan_progress_end(ScanProgress *progress);
+
+// Scan side: totals once known, then increments as the work goes
+void scan_progress_set_totals(ScanProgress *progress, uint64_t work_total, uint64_t regions_total);
+void scan_progress_add(ScanProgress *progress, uint64_t work, uint64_t bytes, uint64_t matches);
+void scan_progress_region_done(ScanProgress *progress);
+
+void scan_progress_cancel(ScanProgress *progress);
+bool scan_progress_cancelled(ScanProgress *progress);
+
+void scan_progress_read(ScanProgress *progress, ScanProgressView *view);
+
+#endif
@@ -0,0 +1,333 @@
+#include "signature_set.h"
+
+#define SIGNATURE_CACHE_MAGIC 0x5445534749534553ull // "SESIGSET"
+#define SIGNATURE_CACHE_VERSION 1
+
+// Start of a cache file, followed by the patterns, pair_start and anchors of the set
+typedef struct
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t pattern_size; // sizeof(BytePattern), differs between builds that changed SCAN_PATTERN_MAX
+    uint64_t count;
+    uint64_t anchor_count;
+    uint64_t source_hash;
+} SignatureCacheHeader;
+
+// FNV-1a over every signature text, terminators included so "48 8B" "05" and "48 8B 05" differ
+static uint64_t hash_signatures(const char *const *signatures, size_t count)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        for (const char *p = signatures[i];; p++)
+        {
+            hash = (hash ^ (uint8_t)*p) * 0x100000001B3ull;
+            if (*p == '\0')
+                break;
+        }
+    }
+    return hash;
+}
+
+// Offset of the pair of consecutive bytes the pattern is indexed by: the fewest wildcard bits,
+// since every value they hide is one more entry of the table, then the pair holding the rarest byte
+static size_t choose_anchor_pair(const BytePattern *pattern)
+{
+    size_t best = 0;
+    int best_cost = 1 << 30;
+
+    for (size_t k = 0; k + 1 < pattern->length; k++)
+    {
+        int cost = (16 - platform_popcount64(pattern->mask[k]) - platform_popcount64(pattern->mask[k + 1])) * 4;
+        if (k != pattern->anchors[0] && k + 1 != pattern->anchors[0])
+            cost += 2;
+        if (k != pattern->anchors[1] && k + 1 != pattern->anchors[1])
+            cost += 1;
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            best = k;
+        }
+    }
+    return best;
+}
+
+// Writes every value (low byte first) the pair at offset matches into pairs, returns their count
+static size_t expand_anchor_pair(const BytePattern *pattern, size_t offset, uint16_t *pairs)
+{
+    size_t count = 0;
+
+    for (uint32_t low = 0; low < 256; low++)
+    {
+        if ((low & pattern->mask[offset]) != pattern->bytes[offset])
+            continue;
+        for (uint32_t high = 0; high < 256; high++)
+        {
+            if ((high & pattern->mask[offset + 1]) == pattern->bytes[offset + 1])
+                pairs[count++] = (uint16_t)(low | high << 8);
+        }
+    }
+    return count;
+}
+
+// Derives pair_bits, max_length and max_anchor from the patterns and the pair index
+static bool finish_signature_set(SignatureSet *set)
+{
+    set->pair_bits = calloc(SIGNATURE_PAIR_COUNT / 64, sizeof(uint64_t));
+    if (!set->pair_bits)
+        return false;
+
+    for (size_t pair = 0; pair < SIGNATURE_PAIR_COUNT; pair++)
+    {
+        if (set->pair_start[pair + 1] > set->pair_start[pair])
+            set->pair_bits[pair / 64] |= (uint64_t)1 << (pair % 64);
+    }
+
+    set->max_length = 0;
+    set->max_anchor = 0;
+    for (size_t i = 0; i < set->count; i++)
+        set->max_length = max(set->max_length, set->patterns[i].length);
+    for (size_t a = 0; a < set->anchor_count; a++)
+        set->max_anchor = max(set->max_anchor, (size_t)set->anchors[a].offset);
+    return true;
+}
+
+bool signature_set_compile(SignatureSet *set, const char *const *signatures, size_t count, size_t *bad_index)
+{
+    memset(set, 0, sizeof(SignatureSet));
+    set->count = count;
+    set->source_hash = hash_signatures(signatures, count);
+    set->patterns = malloc((count + 1) * sizeof(BytePattern));
+    set->pair_start = calloc(SIGNATURE_PAIR_COUNT + 1, sizeof(uint32_t));
+
+    uint32_t *anchor_offsets = malloc((count + 1) * sizeof(uint32_t));
+    uint32_t *next = malloc(SIGNATURE_PAIR_COUNT * sizeof(uint32_t));
+    uint16_t *pairs = malloc(SIGNATURE_PAIR_COUNT * sizeof(uint16_t));
+    if (!set->patterns || !set->pair_start || !anchor_offsets || !next || !pairs)
+    {
+        perror("Failed to allocate a signature set");
+        exit(EXIT_FAILURE);
+    }
+
+    // Count the anchors of every pair value, then place them in signature order
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; i++)
+    {
+        BytePattern *pattern = &set->patterns[i];
+        ok = signature_pattern_init(pattern, signatures[i]) && pattern->length >= 2;
+        if (!ok)
+        {
+            if (bad_index)
+                *bad_index = i;
+            break;
+        }
+        anchor_offsets[i] = (uint32_t)choose_anchor_pair(pattern);
+        size_t pair_count = expand_anchor_pair(pattern, anchor_offsets[i], pairs);
+        for (size_t p = 0; p < pair_count; p++)
+            set->pair_start[pairs[p] + 1]++;
+        set->anchor_count += pair_count;
+    }
+
+    if (ok)
+    {
+        for (size_t pair = 0; pair < SIGNATURE_PAIR_COUNT; pair++)
+            set->pair_start[pair + 1] += set->pair_start[pair];
+        memcpy(next, set->pair_start, SIGNATURE_PAIR_COUNT * sizeof(uint32_t));
+
+        set->anchors = malloc((set->anchor_count + 1) * sizeof(SignatureAnchor));
+        if (!set->anchors)
+        {
+            perror("Failed to allocate signature anchors");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t pair_count = expand_anchor_pair(&set->patterns[i], anchor_offsets[i], pairs);
+            for (size_t p = 0; p < pair_count; p++)
+            {
+                SignatureAnchor anchor = {(uint32_t)i, anchor_offsets[i]};
+                set->anchors[next[pairs[p]]++] = anchor;
+            }
+        }
+        ok = finish_signature_set(set);
+    }
+
+    free(anchor_offsets);
+    free(next);
+    free(pairs);
+    if (!ok)
+        signature_set_free(set);
+    return ok;
+}
+
+void signature_set_free(SignatureSet *set)
+{
+    free(set->patterns);
+    free(set->pair_bits);
+    free(set->pair_start);
+    free(set->anchors);
+    memset(set, 0, sizeof(SignatureSet));
+}
+
+bool signature_set_save(const SignatureSet *set, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    SignatureCacheHeader header = {SIGNATURE_CACHE_MAGIC, SIGNATURE_CACHE_VERSION, (uint32_t)sizeof(BytePattern),
+                                   set->count, set->anchor_count, set->source_hash};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(set->patterns, sizeof(BytePattern), set->count, file) == set->count &&
+              fwrite(set->pair_start, sizeof(uint32_t), SIGNATURE_PAIR_COUNT + 1, file) == SIGNATURE_PAIR_COUNT + 1 &&
+              fwrite(set->anchors, sizeof(SignatureAnchor), set->anchor_count, file) == set->anchor_count;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        remove(path);
+    return ok;
+}
+
+// A cache is only trusted as far as its indexes stay inside the set
+static bool signature_set_valid(const SignatureSet *set)
+{
+    if (set->pair_start[0] != 0 || set->pair_start[SIGNATURE_PAIR_COUNT] != set->anchor_count)
+        return false;
+    for (size_t pair = 0; pair < SIGNATURE_PAIR_COUNT; pair++)
+    {
+        if (set->pair_start[pair + 1] < set->pair_start[pair])
+            return false;
+    }
+    for (size_t i = 0; i < set->count; i++)
+    {
+        if (set->patterns[i].length < 2 || set->patterns[i].length > SCAN_PATTERN_MAX)
+            return false;
+    }
+    for (size_t a = 0; a < set->anchor_count; a++)
+    {
+        const SignatureAnchor *anchor = &set->anchors[a];
+        if (anchor->signature >= set->count || anchor->offset + 1 >= set->patterns[anchor->signature].length)
+            return false;
+    }
+    return true;
+}
+
+bool signature_set_load(SignatureSet *set, const char *path, const char *const *signatures, size_t count)
+{
+    memset(set, 0, sizeof(SignatureSet));
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    SignatureCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == SIGNATURE_CACHE_MAGIC &&
+              header.version == SIGNATURE_CACHE_VERSION && header.pattern_size == sizeof(BytePattern) &&
+              header.count == count && header.source_hash == hash_signatures(signatures, count) &&
+              header.anchor_count <= (uint64_t)count * SIGNATURE_PAIR_COUNT;
+    if (ok)
+    {
+        set->count = count;
+        set->anchor_count = (size_t)header.anchor_count;
+        set->source_hash = header.source_hash;
+        set->patterns = malloc((count + 1) * sizeof(BytePattern));
+        set->pair_start = malloc((SIGNATURE_PAIR_COUNT + 1) * sizeof(uint32_t));
+        set->anchors = malloc((set->anchor_count + 1) * sizeof(SignatureAnchor));
+        ok = set->patterns && set->pair_start && set->anchors &&
+             fread(set->patterns, sizeof(BytePattern), count, file) == count &&
+             fread(set->pair_start, sizeof(uint32_t), SIGNATURE_PAIR_COUNT + 1, file) == SIGNATURE_PAIR_COUNT + 1 &&
+             fread(set->anchors, sizeof(SignatureAnchor), set->anchor_count, file) == set->anchor_count &&
+             signature_set_valid(set) && finish_signature_set(set);
+    }
+    fclose(file);
+
+    if (!ok)
+        signature_set_free(set);
+    return ok;
+}
+
+bool signature_set_load_or_compile(SignatureSet *set, const char *path, const char *const *signatures, size_t count)
+{
+    if (signature_set_load(set, path, signatures, count))
+    {
+        printf("[DEBUG] Loaded %zu compiled signatures from %s\n", count, path);
+        return true;
+    }
+
+    size_t bad_index = 0;
+    if (!signature_set_compile(set, signatures, count, &bad_index))
+    {
+        fprintf(stderr, "[ERROR] Invalid signature %zu: %s\n", bad_index, signatures[bad_index]);
+        return false;
+    }
+    if (!signature_set_save(set, path))
+        printf("[WARNING] Failed to cache the compiled signatures in %s\n", path);
+    return true;
+}
+
+// Appends the matches of the signatures anchored on the pair at q
+static size_t verify_anchors(const SignatureSet *set, const uint8_t *data, size_t q, uint32_t pair, size_t offset_count,
+                             size_t data_size, uintptr_t base_address, DynamicArray *matches)
+{
+    size_t found = 0;
+
+    for (uint32_t a = set->pair_start[pair]; a < set->pair_start[pair + 1]; a++)
+    {
+        const SignatureAnchor *anchor = &set->anchors[a];
+        const BytePattern *pattern = &set->patterns[anchor->signature];
+        size_t start = q - anchor->offset;
+
+        // Starts before data belong to the previous job, which read this pair in its overlap
+        if (q < anchor->offset || start >= offset_count || start + pattern->length > data_size ||
+            !compare_pattern(data + start, pattern))
+            continue;
+
+        SignatureMatch match = {anchor->signature, base_address + start};
+        append(matches, &match);
+        found++;
+    }
+    return found;
+}
+
+size_t signature_set_find(const SignatureSet *set, const uint8_t *data, size_t offset_count, size_t data_size,
+                          uintptr_t base_address, DynamicArray *matches)
+{
+    size_t found = 0;
+
+    if (data_size < 2)
+        return 0;
+
+    // Pairs up to max_anchor bytes past the last offset still anchor signatures starting at it
+    const uint64_t *pair_bits = set->pair_bits;
+    size_t pair_end = min(data_size - 1, offset_count + set->max_anchor);
+    for (size_t q = 0; q < pair_end; q++)
+    {
+        uint32_t pair = data[q] | (uint32_t)data[q + 1] << 8;
+        if (pair_bits[pair / 64] & (uint64_t)1 << (pair % 64))
+            found += verify_anchors(set, data, q, pair, offset_count, data_size, base_address, matches);
+    }
+    return found;
+}
+
+void signature_results_init(SignatureResults *results, size_t count)
+{
+    results->count = count;
+    results->addresses = malloc((count + 1) * sizeof(DynamicArray));
+    if (!results->addresses)
+    {
+        perror("Failed to allocate signature results");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < count; i++)
+        create_array(&results->addresses[i], 4, sizeof(uintptr_t));
+}
+
+void signature_results_free(SignatureResults *results)
+{
+    for (size_t i = 0; i < results->count; i++)
+        free_array(&results->addresses[i]);
+    free(results->addresses);
+    results->addresses = NULL;
+    results->count = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef SIGNATURE_SET_H
+#define SIGNATURE_SET_H
+
+#include "platform.h"
+#include "scan_kernels.h"
+
+#define SIGNATURE_PAIR_COUNT 65536 // Values of the two consecutive bytes every signature is anchored on
+
+// A signature anchored on the byte pair at offset
+typedef struct
+{
+    uint32_t signature; // Index of the signature in the set
+    uint32_t offset;    // Offset of the pair in the signature
+} SignatureAnchor;
+
+// Signatures compiled for a single pass over memory. Every signature is anchored on its pair of
+// consecutive bytes with the fewest wildcard bits, and entered under every value that pair can
+// take. The pass looks the two bytes at each offset up in pair_bits, and only verifies the
+// signatures anchored on the pairs that are set.
+typedef struct
+{
+    size_t count;
+    BytePattern *patterns;     // Compiled signatures, in the order they were given
+    size_t max_length;         // Longest signature: the bytes scan jobs read past their end
+    size_t max_anchor;         // Largest anchor offset
+    uint64_t *pair_bits;       // SIGNATURE_PAIR_COUNT bits, set for the pairs with anchors
+    uint32_t *pair_start;      // SIGNATURE_PAIR_COUNT + 1 indexes: the anchors of pair p are [pair_start[p], pair_start[p + 1])
+    SignatureAnchor *anchors;
+    size_t anchor_count;
+    uint64_t source_hash;      // Of the signature texts, tells whether a cached set is still theirs
+} SignatureSet;
+
+typedef struct
+{
+    uint32_t signature;
+    uintptr_t address;
+} SignatureMatch;
+
+// Addresses found for every signature of a set: addresses[id] holds uintptr_t in ascending order
+typedef struct
+{
+    size_t count;
+    DynamicArray *addresses;
+} SignatureResults;
+
+// Signatures use the syntax of signature_pattern_init and are at least two bytes long. On failure
+// *bad_index is the first signature that could not be compiled.
+bool signature_set_compile(SignatureSet *set, const char *const *signatures, size_t count, size_t *bad_index);
+void signature_set_free(SignatureSet *set);
+
+// Binary cache of a compiled set, only valid for the same signature texts on the same build
+bool signature_set_save(const SignatureSet *set, const char *path);
+bool signature_set_load(SignatureSet *set, const char *path, const char *const *signatures, size_t count);
+// Loads path when it caches these signatures; otherwise compiles them and rewrites path
+bool signature_set_load_or_compile(SignatureSet *set, const char *path, const char *const *signatures, size_t count);
+
+// Appends a SignatureMatch for every signature starting at an offset in [0, offset_count) of data,
+// whose first byte is at base_address. data holds data_size bytes: offset_count + max_length - 1,
+// or fewer at the end of a region. Matches of one signature come in ascending address order.
+size_t signature_set_find(const SignatureSet *set, const uint8_t *data, size_t offset_count, size_t data_size,
+                          uintptr_t base_address, DynamicArray *matches);
+
+void signature_results_init(SignatureResults *results, size_t count);
+void signature_results_free(SignatureResults *results);
+
+#endif
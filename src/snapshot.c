@@ -0,0 +1,579 @@
+#include "snapshot.h"
+
+#define SNAPSHOT_MASK_WORDS (SNAPSHOT_BLOCK_SIZE / SCAN_BLOCK_SIZE + 1)
+
+typedef struct
+{
+    uint8_t *buffer;   // Live bytes of the block being processed
+    uint8_t *previous; // Expanded bytes of fill blocks, for delta comparisons
+    uint64_t *masks;
+    size_t read_errors;
+    uint64_t bytes_read;
+} SnapshotWorker;
+
+typedef struct
+{
+    HANDLE process_handle;
+    MemorySnapshot *snapshot;
+    const ScanFilter *filter;
+    MatchKernel match_kernel;
+    DeltaKernel delta_kernel;
+    SnapshotWorker *workers;
+    ScanProgress *progress; // NULL when nobody follows the pass
+} SnapshotContext;
+
+static size_t block_offset_count(size_t size, size_t stored_size, size_t value_size)
+{
+    return stored_size >= value_size ? min(size, stored_size - value_size + 1) : 0;
+}
+
+static size_t block_mask_words(const SnapshotBlock *block)
+{
+    return (block->offset_count + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE;
+}
+
+// Candidate bits of one mask word, also for blocks without a bitmap (every offset)
+static uint64_t block_candidates(const SnapshotBlock *block, size_t word)
+{
+    if (block->candidates)
+        return block->candidates[word];
+
+    size_t remaining = block->offset_count - word * SCAN_BLOCK_SIZE;
+    return remaining >= SCAN_BLOCK_SIZE ? UINT64_MAX : (((uint64_t)1 << remaining) - 1);
+}
+
+// Keeps the bytes of a block, collapsing blocks made of a single repeated byte (mostly
+// untouched zero pages) to that byte
+static void store_block_data(SnapshotBlock *block, const uint8_t *bytes)
+{
+    size_t size = block->stored_size;
+
+    if (size == 1 || memcmp(bytes, bytes + 1, size - 1) == 0)
+    {
+        free(block->data);
+        block->data = NULL;
+        block->encoding = SNAPSHOT_BLOCK_FILL;
+        block->fill = bytes[0];
+        return;
+    }
+
+    if (!block->data)
+    {
+        block->data = malloc(size);
+        if (!block->data)
+        {
+            perror("Failed to allocate snapshot block");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(block->data, bytes, size);
+    block->encoding = SNAPSHOT_BLOCK_RAW;
+}
+
+static size_t block_data_bytes(const SnapshotBlock *block, size_t value_size)
+{
+    switch (block->encoding)
+    {
+    case SNAPSHOT_BLOCK_RAW:
+        return block->stored_size;
+    case SNAPSHOT_BLOCK_SPARSE:
+        return block->candidate_count * (sizeof(uint16_t) + value_size);
+    default:
+        return 0;
+    }
+}
+
+// Replaces the bytes and bitmap of a block by the offsets and current values of its candidates
+static void make_block_sparse(SnapshotBlock *block, const uint64_t *masks, size_t mask_words, const uint8_t *live, size_t value_size)
+{
+    uint8_t *data = malloc(block->candidate_count * (sizeof(uint16_t) + value_size));
+    if (!data)
+    {
+        perror("Failed to allocate sparse snapshot block");
+        exit(EXIT_FAILURE);
+    }
+
+    uint16_t *offsets = (uint16_t *)data;
+    uint8_t *values = data + block->candidate_count * sizeof(uint16_t);
+    size_t n = 0;
+
+    for (size_t word = 0; word < mask_words; word++)
+    {
+        for (uint64_t bits = masks[word]; bits; bits &= bits - 1)
+        {
+            size_t offset = word * SCAN_BLOCK_SIZE + (size_t)platform_ctz64(bits);
+            offsets[n] = (uint16_t)offset;
+            memcpy(values + n * value_size, live + offset, value_size);
+            n++;
+        }
+    }
+
+    free(block->data);
+    free(block->candidates);
+    block->data = data;
+    block->candidates = NULL;
+    block->encoding = SNAPSHOT_BLOCK_SPARSE;
+}
+
+// Sparse blocks compare candidate by candidate and compact the survivors in place
+static void refine_sparse_block(SnapshotBlock *block, const uint8_t *live, const ScanFilter *filter, size_t value_size, uint64_t *hits)
+{
+    uint16_t *offsets = (uint16_t *)block->data;
+    const uint8_t *previous = block->data + block->candidate_count * sizeof(uint16_t);
+    size_t count = block->candidate_count;
+    size_t kept = 0;
+
+    memset(hits, 0, ((count + 63) / 64) * sizeof(uint64_t));
+    for (size_t c = 0; c < count; c++)
+    {
+        if (filter_value(filter, live + offsets[c], previous + c * value_size, value_size))
+            hits[c / 64] |= (uint64_t)1 << (c % 64);
+    }
+
+    for (size_t c = 0; c < count; c++)
+    {
+        if ((hits[c / 64] >> (c % 64)) & 1)
+            offsets[kept++] = offsets[c];
+    }
+
+    // The values area now starts right after the kept offsets; they take the current values
+    uint8_t *values = block->data + kept * sizeof(uint16_t);
+    for (size_t k = 0; k < kept; k++)
+        memcpy(values + k * value_size, live + offsets[k], value_size);
+
+    block->candidate_count = (uint32_t)kept;
+}
+
+static void capture_block(SnapshotContext *ctx, SnapshotBlock *block, SnapshotWorker *worker)
+{
+    size_t value_size = ctx->snapshot->value_size;
+    SIZE_T bytes_read = 0;
+
+    if (!platform_read_memory(ctx->process_handle, block->address, worker->buffer, block->stored_size, &bytes_read) ||
+        bytes_read < value_size)
+    {
+        worker->read_errors++;
+        block->candidate_count = 0;
+        return;
+    }
+
+    worker->bytes_read += bytes_read;
+    block->stored_size = (uint32_t)bytes_read;
+    block->size = (uint32_t)min(block->size, bytes_read);
+    block->offset_count = (uint32_t)block_offset_count(block->size, block->stored_size, value_size);
+    block->candidate_count = block->offset_count;
+    store_block_data(block, worker->buffer);
+}
+
+static void refine_block(SnapshotContext *ctx, SnapshotBlock *block, SnapshotWorker *worker)
+{
+    const ScanFilter *filter = ctx->filter;
+    size_t value_size = ctx->snapshot->value_size;
+    SIZE_T bytes_read = 0;
+
+    if (!platform_read_memory(ctx->process_handle, block->address, worker->buffer, block->stored_size, &bytes_read) ||
+        bytes_read < block->stored_size)
+    {
+        // Unmapped or shrunk since the last scan: its candidates are gone
+        worker->read_errors++;
+        block->candidate_count = 0;
+        return;
+    }
+    worker->bytes_read += bytes_read;
+
+    if (block->encoding == SNAPSHOT_BLOCK_SPARSE)
+    {
+        refine_sparse_block(block, worker->buffer, filter, value_size, worker->masks);
+        return;
+    }
+
+    const uint8_t *previous = block->data;
+    if (filter->delta && block->encoding == SNAPSHOT_BLOCK_FILL)
+    {
+        memset(worker->previous, block->fill, block->stored_size);
+        previous = worker->previous;
+    }
+
+    size_t mask_words = block_mask_words(block);
+    size_t kernel_words = block->offset_count / SCAN_BLOCK_SIZE;
+    uint64_t *masks = worker->masks;
+
+    if (filter->delta ? !ctx->delta_kernel : !ctx->match_kernel)
+        kernel_words = 0;
+
+    if (kernel_words > 0)
+    {
+        if (filter->delta)
+            ctx->delta_kernel(worker->buffer, previous, kernel_words, &filter->operands, masks);
+        else
+            ctx->match_kernel(worker->buffer, kernel_words, &filter->operands, masks);
+    }
+
+    // Offsets that do not fill a whole mask word
+    for (size_t word = kernel_words; word < mask_words; word++)
+    {
+        uint64_t mask = 0;
+        size_t end = min(block->offset_count, (word + 1) * SCAN_BLOCK_SIZE);
+        for (size_t i = word * SCAN_BLOCK_SIZE; i < end; i++)
+            mask |= (uint64_t)filter_value(filter, worker->buffer + i, previous + i, value_size) << (i % SCAN_BLOCK_SIZE);
+        masks[word] = mask;
+    }
+
+    uint64_t count = 0;
+    for (size_t word = 0; word < mask_words; word++)
+    {
+        masks[word] &= block_candidates(block, word);
+        count += (uint64_t)platform_popcount64(masks[word]);
+    }
+
+    block->candidate_count = (uint32_t)count;
+    if (count == 0)
+        return;
+
+    if (count * (sizeof(uint16_t) + value_size) * SNAPSHOT_SPARSE_RATIO <= block->stored_size)
+    {
+        make_block_sparse(block, masks, mask_words, worker->buffer, value_size);
+        return;
+    }
+
+    // Candidates only ever disappear, so a block keeps no bitmap exactly while all offsets survive
+    if (count < block->offset_count)
+    {
+        if (!block->candidates)
+        {
+            block->candidates = malloc(mask_words * sizeof(uint64_t));
+            if (!block->candidates)
+            {
+                perror("Failed to allocate snapshot bitmap");
+                exit(EXIT_FAILURE);
+            }
+        }
+        memcpy(block->candidates, masks, mask_words * sizeof(uint64_t));
+    }
+
+    // The next refinement compares against the values seen now
+    store_block_data(block, worker->buffer);
+}
+
+static void capture_block_task(void *context, size_t task_index, int worker_index)
+{
+    SnapshotContext *ctx = (SnapshotContext *)context;
+    SnapshotBlock *block = (SnapshotBlock *)ctx->snapshot->blocks.data + task_index;
+    SnapshotWorker *worker = &ctx->workers[worker_index];
+
+    // A cancelled capture is thrown away, blocks past the cancel are just left empty
+    if (ctx->progress && scan_progress_cancelled(ctx->progress))
+    {
+        block->candidate_count = 0;
+        return;
+    }
+
+    uint64_t bytes_before = worker->bytes_read;
+    uint32_t size = block->size;
+    capture_block(ctx, block, worker);
+    if (ctx->progress)
+        scan_progress_add(ctx->progress, size, worker->bytes_read - bytes_before, block->candidate_count);
+}
+
+static void refine_block_task(void *context, size_t task_index, int worker_index)
+{
+    SnapshotContext *ctx = (SnapshotContext *)context;
+    SnapshotBlock *block = (SnapshotBlock *)ctx->snapshot->blocks.data + task_index;
+    SnapshotWorker *worker = &ctx->workers[worker_index];
+
+    // Blocks not reached before a cancel keep their candidates and values untouched
+    if (ctx->progress && scan_progress_cancelled(ctx->progress))
+        return;
+
+    uint64_t bytes_before = worker->bytes_read;
+    uint32_t size = block->size;
+    refine_block(ctx, block, worker);
+    if (ctx->progress)
+        scan_progress_add(ctx->progress, size, worker->bytes_read - bytes_before, block->candidate_count);
+}
+
+// Bytes owned by all the blocks, the work unit of the progress of a pass
+static uint64_t snapshot_block_bytes(const MemorySnapshot *snapshot)
+{
+    const SnapshotBlock *blocks = (const SnapshotBlock *)snapshot->blocks.data;
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < snapshot->blocks.size; i++)
+        total += blocks[i].size;
+    return total;
+}
+
+static void run_snapshot_pass(SnapshotContext *ctx, ThreadPool *pool, ThreadPoolTask task)
+{
+    int worker_count = pool ? pool->worker_count : 1;
+
+    ctx->workers = calloc((size_t)worker_count, sizeof(SnapshotWorker));
+    if (!ctx->workers)
+    {
+        perror("Failed to allocate snapshot workers");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int w = 0; w < worker_count; w++)
+    {
+        ctx->workers[w].buffer = malloc(SNAPSHOT_BLOCK_SIZE + 8);
+        ctx->workers[w].previous = malloc(SNAPSHOT_BLOCK_SIZE + 8);
+        ctx->workers[w].masks = malloc(SNAPSHOT_MASK_WORDS * sizeof(uint64_t));
+        if (!ctx->workers[w].buffer || !ctx->workers[w].previous || !ctx->workers[w].masks)
+        {
+            perror("Failed to allocate snapshot buffers");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    size_t block_count = ctx->snapshot->blocks.size;
+    if (pool)
+    {
+        thread_pool_run(pool, block_count, task, ctx);
+    }
+    else
+    {
+        for (size_t i = 0; i < block_count; i++)
+            task(ctx, i, 0);
+    }
+
+    ctx->snapshot->captured_bytes = 0;
+    ctx->snapshot->read_errors = 0;
+    for (int w = 0; w < worker_count; w++)
+    {
+        ctx->snapshot->captured_bytes += ctx->workers[w].bytes_read;
+        ctx->snapshot->read_errors += ctx->workers[w].read_errors;
+        free(ctx->workers[w].buffer);
+        free(ctx->workers[w].previous);
+        free(ctx->workers[w].masks);
+    }
+    free(ctx->workers);
+    ctx->workers = NULL;
+}
+
+// Releases blocks left without candidates and recomputes the totals
+static void compact_blocks(MemorySnapshot *snapshot)
+{
+    SnapshotBlock *blocks = (SnapshotBlock *)snapshot->blocks.data;
+    size_t kept = 0;
+
+    snapshot->candidate_count = 0;
+    snapshot->data_bytes = 0;
+    snapshot->bitmap_bytes = 0;
+
+    for (size_t i = 0; i < snapshot->blocks.size; i++)
+    {
+        SnapshotBlock *block = &blocks[i];
+        if (block->candidate_count == 0)
+        {
+            free(block->data);
+            free(block->candidates);
+            continue;
+        }
+
+        snapshot->candidate_count += block->candidate_count;
+        snapshot->data_bytes += block_data_bytes(block, snapshot->value_size);
+        if (block->candidates)
+            snapshot->bitmap_bytes += block_mask_words(block) * sizeof(uint64_t);
+        blocks[kept++] = *block;
+    }
+    snapshot->blocks.size = kept;
+}
+
+bool snapshot_capture(MemorySnapshot *snapshot, HANDLE process_handle, const DynamicArray *regions, size_t value_size, ThreadPool *pool,
+                      ScanProgress *progress)
+{
+    snapshot_free(snapshot);
+    snapshot->value_size = value_size;
+    create_array(&snapshot->blocks, 1024, sizeof(SnapshotBlock));
+
+    const MemoryRegion *region_list = (const MemoryRegion *)regions->data;
+    for (size_t r = 0; r < regions->size; r++)
+    {
+        const MemoryRegion *region = &region_list[r];
+        if ((region->protection & REGION_READ) == 0 || (region->protection & REGION_GUARD) != 0)
+            continue;
+
+        for (size_t offset = 0; offset < region->size; offset += SNAPSHOT_BLOCK_SIZE)
+        {
+            SnapshotBlock block = {0};
+            block.address = region->base + offset;
+            block.size = (uint32_t)min(SNAPSHOT_BLOCK_SIZE, region->size - offset);
+            block.stored_size = (uint32_t)min(block.size + value_size - 1, region->size - offset);
+            append(&snapshot->blocks, &block);
+        }
+    }
+
+    if (progress)
+        scan_progress_set_totals(progress, snapshot_block_bytes(snapshot), 0);
+
+    SnapshotContext ctx = {.process_handle = process_handle, .snapshot = snapshot, .progress = progress};
+    run_snapshot_pass(&ctx, pool, capture_block_task);
+    compact_blocks(snapshot);
+
+    snapshot->active = true;
+    return snapshot->candidate_count > 0;
+}
+
+bool snapshot_refine(MemorySnapshot *snapshot, HANDLE process_handle, const ScanFilter *filter, ThreadPool *pool, ScanProgress *progress)
+{
+    if (!snapshot->active)
+        return false;
+
+    ScanIsa isa = get_best_scan_isa();
+    SnapshotContext ctx = {
+        .process_handle = process_handle,
+        .snapshot = snapshot,
+        .filter = filter,
+        .match_kernel = filter->delta ? NULL : get_match_kernel(isa, filter->number, filter->compare, snapshot->value_size),
+        .delta_kernel = filter->delta ? get_delta_kernel(isa, filter->number, filter->delta_op, snapshot->value_size) : NULL,
+        .progress = progress};
+
+    if (progress)
+        scan_progress_set_totals(progress, snapshot_block_bytes(snapshot), 0);
+    run_snapshot_pass(&ctx, pool, refine_block_task);
+    compact_blocks(snapshot);
+
+    return snapshot->candidate_count > 0;
+}
+
+size_t snapshot_collect(const MemorySnapshot *snapshot, size_t max_count, DynamicArray *addresses, DynamicArray *values)
+{
+    const SnapshotBlock *blocks = (const SnapshotBlock *)snapshot->blocks.data;
+    size_t value_size = snapshot->value_size;
+    size_t collected = 0;
+
+    if (!snapshot->active)
+        return 0;
+
+    size_t expected = (size_t)min((uint64_t)max_count, snapshot->candidate_count);
+    reserve_array(addresses, addresses->size + expected);
+    if (values)
+        reserve_array(values, values->size + expected);
+
+    for (size_t b = 0; b < snapshot->blocks.size && collected < max_count; b++)
+    {
+        const SnapshotBlock *block = &blocks[b];
+        size_t mask_words = block_mask_words(block);
+
+        if (block->encoding == SNAPSHOT_BLOCK_SPARSE)
+        {
+            const uint16_t *offsets = (const uint16_t *)block->data;
+            const uint8_t *sparse_values = block->data + block->candidate_count * sizeof(uint16_t);
+
+            for (size_t c = 0; c < block->candidate_count && collected < max_count; c++)
+            {
+                LPVOID address = (LPVOID)(block->address + offsets[c]);
+                append(addresses, &address);
+                if (values)
+                {
+                    uint64_t value = 0;
+                    memcpy(&value, sparse_values + c * value_size, value_size);
+                    append(values, &value);
+                }
+                collected++;
+            }
+            continue;
+        }
+
+        for (size_t word = 0; word < mask_words && collected < max_count; word++)
+        {
+            uint64_t bits = block_candidates(block, word);
+            while (bits && collected < max_count)
+            {
+                size_t offset = word * SCAN_BLOCK_SIZE + (size_t)platform_ctz64(bits);
+                LPVOID address = (LPVOID)(block->address + offset);
+                bits &= bits - 1;
+
+                append(addresses, &address);
+                if (values)
+                {
+                    uint64_t value = 0;
+                    if (block->encoding == SNAPSHOT_BLOCK_RAW)
+                        memcpy(&value, block->data + offset, value_size);
+                    else
+                        memset(&value, block->fill, value_size);
+                    append(values, &value);
+                }
+                collected++;
+            }
+        }
+    }
+    return collected;
+}
+
+void snapshot_export(const MemorySnapshot *snapshot, ResultSet *results, DynamicArray *values)
+{
+    const SnapshotBlock *blocks = (const SnapshotBlock *)snapshot->blocks.data;
+    size_t value_size = snapshot->value_size;
+    uint64_t masks[SNAPSHOT_MASK_WORDS];
+
+    if (!snapshot->active)
+        return;
+
+    reserve_array(values, values->size + (size_t)snapshot->candidate_count);
+
+    for (size_t b = 0; b < snapshot->blocks.size; b++)
+    {
+        const SnapshotBlock *block = &blocks[b];
+        ResultSegment segment;
+
+        if (block->encoding == SNAPSHOT_BLOCK_SPARSE)
+        {
+            const uint16_t *offsets = (const uint16_t *)block->data;
+            const uint8_t *sparse_values = block->data + block->candidate_count * sizeof(uint16_t);
+            uint32_t slots[SNAPSHOT_BLOCK_SIZE / SNAPSHOT_SPARSE_RATIO];
+
+            for (size_t c = 0; c < block->candidate_count; c++)
+            {
+                uint64_t value = 0;
+                memcpy(&value, sparse_values + c * value_size, value_size);
+                append(values, &value);
+                slots[c] = offsets[c];
+            }
+            if (result_segment_from_offsets(&segment, block->address, block->offset_count, slots, block->candidate_count))
+                result_set_append(results, &segment);
+            continue;
+        }
+
+        size_t mask_words = block_mask_words(block);
+        for (size_t word = 0; word < mask_words; word++)
+        {
+            masks[word] = block_candidates(block, word);
+            for (uint64_t bits = masks[word]; bits; bits &= bits - 1)
+            {
+                size_t offset = word * SCAN_BLOCK_SIZE + (size_t)platform_ctz64(bits);
+                uint64_t value = 0;
+                if (block->encoding == SNAPSHOT_BLOCK_RAW)
+                    memcpy(&value, block->data + offset, value_size);
+                else
+                    memset(&value, block->fill, value_size);
+                append(values, &value);
+            }
+        }
+        if (result_segment_from_masks(&segment, block->address, block->offset_count, masks))
+            result_set_append(results, &segment);
+    }
+}
+
+size_t snapshot_footprint(const MemorySnapshot *snapshot)
+{
+    if (!snapshot->active)
+        return 0;
+    return snapshot->data_bytes + snapshot->bitmap_bytes + snapshot->blocks.capacity * sizeof(SnapshotBlock);
+}
+
+void snapshot_free(MemorySnapshot *snapshot)
+{
+    if (snapshot->blocks.data)
+    {
+        SnapshotBlock *blocks = (SnapshotBlock *)snapshot->blocks.data;
+        for (size_t i = 0; i < snapshot->blocks.size; i++)
+        {
+            free(blocks[i].data);
+            free(blocks[i].candidates);
+        }
+        free_array(&snapshot->blocks);
+    }
+    memset(snapshot, 0, sizeof(MemorySnapshot));
+}
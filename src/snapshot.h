@@ -0,0 +1,63 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "platform.h"
+#include "result_set.h"
+#include "scan_kernels.h"
+#include "scan_progress.h"
+#include "thread_pool.h"
+
+#define SNAPSHOT_BLOCK_SIZE (64 * 1024)        // Bytes of a region owned by one snapshot block
+#define SNAPSHOT_LIST_THRESHOLD (1024 * 1024)  // Switch to an address list below this many candidates
+#define SNAPSHOT_SPARSE_RATIO 4                // Keep only candidate values once they take under 1/4 of the block bytes
+
+// How a block keeps its bytes
+typedef enum
+{
+    SNAPSHOT_BLOCK_RAW,    // data holds the bytes
+    SNAPSHOT_BLOCK_FILL,   // Every byte equals fill (zeroed pages, memset buffers), no data kept
+    SNAPSHOT_BLOCK_SPARSE, // data holds candidate_count uint16_t offsets, then the value at each of them
+} SnapshotEncoding;
+
+typedef struct
+{
+    uintptr_t address;
+    uint32_t size;           // Bytes owned by the block: candidate offsets are [0, size)
+    uint32_t stored_size;    // Bytes kept: size plus the overlap read by values straddling the next block
+    uint32_t offset_count;   // Offsets that can hold a whole value
+    uint32_t candidate_count;
+    SnapshotEncoding encoding;
+    uint8_t fill;
+    uint8_t *data;           // stored_size bytes when raw, offsets and values when sparse, NULL when filled
+    uint64_t *candidates;    // One bit per offset in mask layout, NULL while every offset is a candidate (or sparse)
+} SnapshotBlock;
+
+typedef struct
+{
+    bool active;
+    size_t value_size;
+    DynamicArray blocks;     // SnapshotBlock in ascending address order, only blocks with candidates
+    uint64_t candidate_count;
+    uint64_t captured_bytes; // Bytes read from the process by the last capture or refine
+    size_t data_bytes;       // Bytes held by raw and sparse blocks
+    size_t bitmap_bytes;     // Bytes held by candidate bitmaps
+    size_t read_errors;
+} MemorySnapshot;
+
+// Both report to progress when not NULL (bytes only, no regions) and stop at its cancel request: a
+// cancelled capture leaves blocks empty, a cancelled refine leaves the blocks it had not reached as they were
+bool snapshot_capture(MemorySnapshot *snapshot, HANDLE process_handle, const DynamicArray *regions, size_t value_size, ThreadPool *pool,
+                      ScanProgress *progress);
+bool snapshot_refine(MemorySnapshot *snapshot, HANDLE process_handle, const ScanFilter *filter, ThreadPool *pool, ScanProgress *progress);
+
+// Appends up to max_count candidates (address, then value zero-extended to 64 bits) in address order
+size_t snapshot_collect(const MemorySnapshot *snapshot, size_t max_count, DynamicArray *addresses, DynamicArray *values);
+
+// Appends every candidate to results, one segment per block, and its value (uint64_t) to values
+void snapshot_export(const MemorySnapshot *snapshot, ResultSet *results, DynamicArray *values);
+
+// Total heap memory held by the snapshot, metadata included
+size_t snapshot_footprint(const MemorySnapshot *snapshot);
+void snapshot_free(MemorySnapshot *snapshot);
+
+#endif
@@ -0,0 +1,269 @@
+#include "thread_pool.h"
+
+// Every worker owns a bounded work-stealing deque (Chase-Lev without growth, since the
+// whole task range is known when a run starts). The owner pops from the bottom, idle
+// workers steal from the top. Tasks are dealt out in contiguous blocks so each worker
+// walks neighbouring indices (neighbouring memory) until it runs dry and starts stealing.
+struct ThreadPoolWorker
+{
+    volatile int64_t top;
+    char top_padding[64 - sizeof(int64_t)];
+    volatile int64_t bottom;
+    char bottom_padding[64 - sizeof(int64_t)];
+
+    size_t *tasks;
+    size_t task_capacity;
+
+    ThreadPool *pool;
+    int index;
+    uint32_t rng;
+    uint64_t seen_generation;
+    PlatformThread thread;
+};
+
+typedef enum
+{
+    STEAL_EMPTY,
+    STEAL_ABORT,
+    STEAL_SUCCESS
+} StealResult;
+
+static bool take_task(ThreadPoolWorker *worker, size_t *task)
+{
+    int64_t bottom = platform_atomic_load64(&worker->bottom) - 1;
+    platform_atomic_store64(&worker->bottom, bottom);
+    platform_atomic_fence();
+    int64_t top = platform_atomic_load64(&worker->top);
+
+    if (top > bottom)
+    {
+        platform_atomic_store64(&worker->bottom, bottom + 1);
+        return false;
+    }
+
+    *task = worker->tasks[bottom];
+    if (top == bottom)
+    {
+        // Last task: race the thieves for it
+        bool won = platform_atomic_cas64(&worker->top, top, top + 1);
+        platform_atomic_store64(&worker->bottom, bottom + 1);
+        return won;
+    }
+    return true;
+}
+
+static StealResult steal_task(ThreadPoolWorker *victim, size_t *task)
+{
+    int64_t top = platform_atomic_load64(&victim->top);
+    platform_atomic_fence();
+    int64_t bottom = platform_atomic_load64(&victim->bottom);
+
+    if (top >= bottom)
+        return STEAL_EMPTY;
+
+    size_t value = victim->tasks[top];
+    if (!platform_atomic_cas64(&victim->top, top, top + 1))
+        return STEAL_ABORT;
+
+    *task = value;
+    return STEAL_SUCCESS;
+}
+
+static bool steal_any(ThreadPoolWorker *worker, size_t *task)
+{
+    ThreadPool *pool = worker->pool;
+
+    while (1)
+    {
+        bool contended = false;
+
+        // xorshift32 picks where to start probing so thieves spread over victims
+        worker->rng ^= worker->rng << 13;
+        worker->rng ^= worker->rng >> 17;
+        worker->rng ^= worker->rng << 5;
+        int start = (int)(worker->rng % (uint32_t)pool->worker_count);
+
+        for (int i = 0; i < pool->worker_count; i++)
+        {
+            ThreadPoolWorker *victim = &pool->workers[(start + i) % pool->worker_count];
+            if (victim == worker)
+                continue;
+
+            StealResult result = steal_task(victim, task);
+            if (result == STEAL_SUCCESS)
+                return true;
+            if (result == STEAL_ABORT)
+                contended = true;
+        }
+
+        // No task is ever added during a run, so one clean pass over empty deques means we are done
+        if (!contended)
+            return false;
+    }
+}
+
+static void run_tasks(ThreadPoolWorker *worker, ThreadPoolTask task, void *context)
+{
+    size_t index;
+
+    while (1)
+    {
+        if (!take_task(worker, &index) && !steal_any(worker, &index))
+            break;
+        task(context, index, worker->index);
+    }
+}
+
+static void worker_main(void *arg)
+{
+    ThreadPoolWorker *worker = (ThreadPoolWorker *)arg;
+    ThreadPool *pool = worker->pool;
+
+    while (1)
+    {
+        platform_mutex_lock(&pool->lock);
+        while (!pool->shutting_down && pool->generation == worker->seen_generation)
+        {
+            platform_cond_wait(&pool->wake, &pool->lock);
+        }
+
+        if (pool->shutting_down)
+        {
+            platform_mutex_unlock(&pool->lock);
+            return;
+        }
+
+        worker->seen_generation = pool->generation;
+        ThreadPoolTask task = pool->task;
+        void *context = pool->context;
+        platform_mutex_unlock(&pool->lock);
+
+        run_tasks(worker, task, context);
+
+        platform_mutex_lock(&pool->lock);
+        if (--pool->active_workers == 0)
+        {
+            platform_cond_broadcast(&pool->done);
+        }
+        platform_mutex_unlock(&pool->lock);
+    }
+}
+
+bool thread_pool_create(ThreadPool *pool, int worker_count)
+{
+    memset(pool, 0, sizeof(ThreadPool));
+
+    if (worker_count < 1)
+        worker_count = 1;
+
+    pool->workers = calloc((size_t)worker_count, sizeof(ThreadPoolWorker));
+    if (!pool->workers)
+    {
+        fprintf(stderr, "[ERROR] Failed to allocate %d thread pool workers\n", worker_count);
+        return false;
+    }
+
+    platform_mutex_init(&pool->run_lock);
+    platform_mutex_init(&pool->lock);
+    platform_cond_init(&pool->wake);
+    platform_cond_init(&pool->done);
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        ThreadPoolWorker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->rng = 0x9E3779B9u * (uint32_t)(i + 1);
+
+        if (!platform_thread_start(&worker->thread, worker_main, worker))
+        {
+            fprintf(stderr, "[ERROR] Failed to start thread pool worker %d\n", i);
+            pool->worker_count = i;
+            thread_pool_destroy(pool);
+            return false;
+        }
+        pool->worker_count = i + 1;
+    }
+
+    printf("[DEBUG] Thread pool started with %d workers\n", pool->worker_count);
+    return true;
+}
+
+void thread_pool_run(ThreadPool *pool, size_t task_count, ThreadPoolTask task, void *context)
+{
+    if (task_count == 0)
+        return;
+
+    platform_mutex_lock(&pool->run_lock);
+
+    // Deal the task range out in contiguous blocks; the block is stored reversed so that the
+    // owner pops indices in ascending order while thieves take the far end
+    for (int w = 0; w < pool->worker_count; w++)
+    {
+        ThreadPoolWorker *worker = &pool->workers[w];
+        size_t first = task_count * (size_t)w / (size_t)pool->worker_count;
+        size_t last = task_count * (size_t)(w + 1) / (size_t)pool->worker_count;
+        size_t count = last - first;
+
+        if (count > worker->task_capacity)
+        {
+            size_t *tasks = realloc(worker->tasks, count * sizeof(size_t));
+            if (!tasks)
+            {
+                perror("Failed to allocate thread pool deque");
+                exit(EXIT_FAILURE);
+            }
+            worker->tasks = tasks;
+            worker->task_capacity = count;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            worker->tasks[i] = last - 1 - i;
+        }
+
+        worker->top = 0;
+        worker->bottom = (int64_t)count;
+    }
+
+    platform_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->active_workers = pool->worker_count;
+    pool->generation++;
+    platform_cond_broadcast(&pool->wake);
+
+    while (pool->active_workers > 0)
+    {
+        platform_cond_wait(&pool->done, &pool->lock);
+    }
+    platform_mutex_unlock(&pool->lock);
+
+    platform_mutex_unlock(&pool->run_lock);
+}
+
+void thread_pool_destroy(ThreadPool *pool)
+{
+    if (!pool->workers)
+        return;
+
+    platform_mutex_lock(&pool->lock);
+    pool->shutting_down = true;
+    platform_cond_broadcast(&pool->wake);
+    platform_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->worker_count; i++)
+    {
+        platform_thread_join(&pool->workers[i].thread);
+        free(pool->workers[i].tasks);
+    }
+
+    free(pool->workers);
+    pool->workers = NULL;
+    pool->worker_count = 0;
+
+    platform_mutex_destroy(&pool->run_lock);
+    platform_mutex_destroy(&pool->lock);
+    platform_cond_destroy(&pool->wake);
+    platform_cond_destroy(&pool->done);
+}
@@ -0,0 +1,32 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "platform.h"
+
+// Task callback: called once for every index in [0, task_count) on one of the workers
+typedef void (*ThreadPoolTask)(void *context, size_t task_index, int worker_index);
+
+typedef struct ThreadPoolWorker ThreadPoolWorker;
+
+typedef struct
+{
+    int worker_count;
+    ThreadPoolWorker *workers;
+
+    PlatformMutex run_lock; // Serializes thread_pool_run callers
+    PlatformMutex lock;     // Protects the fields below
+    PlatformCond wake;
+    PlatformCond done;
+    uint64_t generation;
+    int active_workers;
+    bool shutting_down;
+
+    ThreadPoolTask task;
+    void *context;
+} ThreadPool;
+
+bool thread_pool_create(ThreadPool *pool, int worker_count);
+void thread_pool_run(ThreadPool *pool, size_t task_count, ThreadPoolTask task, void *context);
+void thread_pool_destroy(ThreadPool *pool);
+
+#endif